@@ -0,0 +1,75 @@
+import nvisii
+import time
+
+opt = lambda : None
+opt.spp = 256
+opt.width = 1024
+opt.height = 1024
+opt.snapshot = "25_scene_snapshot.nvss"
+opt.out = "25_scene_snapshot.png"
+
+# # # # # # # # # # # # # # # # # # # # # # # # #
+nvisii.initialize(headless=True, verbose=True)
+
+nvisii.enable_denoiser()
+
+# # # # # # # # # # # # # # # # # # # # # # # # #
+
+# Importing a scene parses the file, decodes every texture,
+# and welds and generates tangents for every mesh.
+start = time.time()
+sdb = nvisii.import_scene(
+    file_path = 'content/salle_de_bain_separated/salle_de_bain_separated.obj',
+    position = (1,0,0),
+    scale = (1.0, 1.0, 1.0),
+    rotation = nvisii.angleAxis(3.14 * .5, (1,0,0))
+)
+import_time = time.time() - start
+
+# A snapshot stores every component exactly as it is held in memory.
+# When many processes load the same scene (eg on a render farm),
+# import it once, save a snapshot, and have every process load the snapshot.
+start = time.time()
+nvisii.save_scene_snapshot(opt.snapshot)
+save_time = time.time() - start
+
+nvisii.clear_all()
+
+start = time.time()
+sdb = nvisii.load_scene_snapshot(opt.snapshot)
+load_time = time.time() - start
+
+print(f"import_scene:        {import_time:.3f}s")
+print(f"save_scene_snapshot: {save_time:.3f}s")
+print(f"load_scene_snapshot: {load_time:.3f}s ({import_time / max(load_time, 1e-6):.1f}x faster than importing)")
+print(f"loaded {len(sdb.entities)} entities, {len(sdb.meshes)} meshes, {len(sdb.textures)} textures")
+
+# # # # # # # # # # # # # # # # # # # # # # # # #
+
+camera = nvisii.entity.create(
+    name = "camera",
+    transform = nvisii.transform.create("camera"),
+    camera = nvisii.camera.create(
+        name = "camera",
+        aspect = float(opt.width)/float(opt.height)
+    )
+)
+
+camera.get_transform().look_at(
+    at = (-5,0,12), # look at (world coordinate)
+    up = (0,0,1), # up vector
+    eye = (5,-15,18)
+)
+nvisii.set_camera_entity(camera)
+
+nvisii.set_dome_light_intensity(1)
+
+nvisii.render_to_file(
+    width=opt.width,
+    height=opt.height,
+    samples_per_pixel=opt.spp,
+    file_path=opt.out
+)
+
+# let's clean up the GPU
+nvisii.deinitialize()
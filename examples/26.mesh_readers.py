@@ -0,0 +1,67 @@
+import nvisii
+import numpy as np
+import time
+
+opt = lambda : None
+opt.resolution = 2048 # the benchmark mesh is a resolution x resolution grid
+opt.repeats = 3
+
+# # # # # # # # # # # # # # # # # # # # # # # # #
+nvisii.initialize(headless=True, verbose=True)
+
+# # # # # # # # # # # # # # # # # # # # # # # # #
+
+# Write out a large, wavy grid as both an OBJ and a binary PLY file.
+# (Large scans are usually distributed in one of these two formats.)
+n = opt.resolution
+u, v = np.meshgrid(np.linspace(0, 1, n, dtype=np.float32), np.linspace(0, 1, n, dtype=np.float32))
+positions = np.stack([u, v, 0.05 * np.sin(20 * u) * np.cos(20 * v)], -1).reshape(-1, 3)
+texcoords = np.stack([u, v], -1).reshape(-1, 2)
+quads = (np.arange(n - 1)[None, :] + n * np.arange(n - 1)[:, None]).reshape(-1)
+indices = np.stack([quads, quads + 1, quads + n + 1, quads, quads + n + 1, quads + n], -1).reshape(-1, 3)
+
+with open("26_mesh.obj", "w") as f:
+    np.savetxt(f, positions, fmt="v %.6f %.6f %.6f")
+    np.savetxt(f, texcoords, fmt="vt %.6f %.6f")
+    np.savetxt(f, np.repeat(indices + 1, 2, axis=1), fmt="f %d/%d %d/%d %d/%d")
+
+with open("26_mesh.ply", "wb") as f:
+    f.write((
+        "ply\nformat binary_little_endian 1.0\n"
+        f"element vertex {len(positions)}\nproperty float x\nproperty float y\nproperty float z\n"
+        "property float u\nproperty float v\n"
+        f"element face {len(indices)}\nproperty list uchar int vertex_indices\nend_header\n"
+    ).encode("ascii"))
+    vertices = np.concatenate([positions, texcoords], -1).astype("<f4")
+    faces = np.zeros(len(indices), dtype=[("count", "u1"), ("indices", "<i4", 3)])
+    faces["count"] = 3
+    faces["indices"] = indices
+    f.write(vertices.tobytes())
+    f.write(faces.tobytes())
+
+# # # # # # # # # # # # # # # # # # # # # # # # #
+
+# mesh.create_from_file reads OBJ and PLY files with the built in multithreaded readers,
+# while import_scene reads every format through assimp.
+def benchmark(path):
+    native, imported = [], []
+    for i in range(opt.repeats):
+        start = time.time()
+        mesh = nvisii.mesh.create_from_file("mesh", path)
+        native.append(time.time() - start)
+        tris = mesh.get_triangle_indices()
+        nvisii.clear_all()
+
+        start = time.time()
+        nvisii.import_scene(path)
+        imported.append(time.time() - start)
+        nvisii.clear_all()
+    print(f"{path}: {len(tris) // 3} triangles")
+    print(f"    native reader: {min(native):.3f}s")
+    print(f"    assimp:        {min(imported):.3f}s ({min(imported) / max(min(native), 1e-6):.1f}x slower)")
+
+benchmark("26_mesh.obj")
+benchmark("26_mesh.ply")
+
+# let's clean up the GPU
+nvisii.deinitialize()
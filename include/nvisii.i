@@ -91,6 +91,10 @@ import_array();
 
 
 %apply (float* INPLACE_ARRAY_FLAT, int DIM_FLAT) {(const float* data, uint32_t length)};
+%apply (float** ARGOUTVIEW_ARRAY2, int* DIM1, int* DIM2) {(float** data, int* rows, int* cols)};
+%apply (unsigned int** ARGOUTVIEW_ARRAY1, int* DIM1) {(uint32_t** data, int* length)};
+%apply (float* IN_ARRAY2, int DIM1, int DIM2) {(const float* uvs, int uv_count, int uv_components)};
+%apply (float** ARGOUTVIEWM_ARRAY2, int* DIM1, int* DIM2) {(float** samples, int* sample_count, int* sample_components)};
 
 
 /* -------- GLM Vector Math Library --------------*/
@@ -123,6 +127,7 @@ namespace std {
   %template(FloatVector) vector<float>;
   %template(Float3Vector) vector<array<float, 3>>;
   %template(Float4Vector) vector<array<float, 4>>;
+  %template(UINT8Vector) vector<uint8_t>;
   %template(UINT32Vector) vector<uint32_t>;
   %template(StringVector) vector<string>;
   %template(EntityVector) vector<nvisii::Entity*>;
@@ -189,6 +194,7 @@ namespace std {
 
 %ignore nvisii::Mesh::Mesh();
 %ignore nvisii::Mesh::Mesh(std::string name, uint32_t id);
+%ignore nvisii::Mesh::decodeVertexData;
 
 %ignore nvisii::Light::Light();
 %ignore nvisii::Light::Light(std::string name, uint32_t id);
@@ -279,6 +285,10 @@ namespace std {
 %include "nvisii/material.h"
 %include "nvisii/mesh.h"
 
+namespace std {
+  %template(TextureOperationVector) vector<nvisii::TextureOperation>;
+}
+
 using namespace nvisii;
 
 // void registerPreRenderCallback(std::function<void()> callback);
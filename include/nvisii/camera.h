@@ -19,6 +19,7 @@ class Camera : public StaticFactory
 {
 	friend class StaticFactory;
     friend class Entity;
+    friend class SceneSnapshot;
 private:
   	/** Prevents multiple components from simultaneously being added and/or removed from the component list */
 		static std::shared_ptr<std::recursive_mutex> editMutex;
@@ -33,7 +34,7 @@ private:
 		static std::vector<CameraStruct> cameraStructs;
 
 		/* A lookup table of name to camera id */
-		static std::map<std::string, uint32_t> lookupTable;
+		static LookupTable lookupTable;
 
     /* Indicates that one of the components has been edited */
     static bool anyDirty;
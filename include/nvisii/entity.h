@@ -29,6 +29,7 @@ class Volume;
  */
 class Entity : public StaticFactory {
 	friend class StaticFactory;
+	friend class SceneSnapshot;
 private:
 	/** If an entity isn't active, its callbacks aren't called */
 	bool active = true;
@@ -46,7 +47,7 @@ private:
 	static std::vector<EntityStruct> entityStructs;
 
     /** A lookup table where, given the name of a component, returns the primary key of that component */
-	static std::map<std::string, uint32_t> lookupTable;
+	static LookupTable lookupTable;
 	
 	static std::set<Entity*> dirtyEntities;
 	static std::set<Entity*> renderableEntities;
@@ -89,6 +90,31 @@ public:
 		Volume* volume = nullptr
 	);
 
+	/**
+	 * Constructs many Entities at once. This is much faster than calling "create" in a loop, 
+	 * since the entity table is only locked once for the whole batch.
+	 * 
+	 * Each component list is optional, and may either be empty, contain a single component 
+	 * shared by all entities, or contain one component per entity. 
+	 * 
+	 * @param names A list of unique names, one per entity to create.
+	 * @param transforms (optional) A list of transform components to place the entities into the scene.
+	 * @param materials (optional) A list of material components describing how the entities should look when rendered.
+	 * @param meshes (optional) A list of mesh components describing surfaces to be rendered.
+	 * @param lights (optional) A list of light components, turning any connected geometry into light sources.
+	 * @param cameras (optional) A list of camera components, which can be used to view into the scene.
+	 * @param volumes (optional) A list of volume components describing volumetric particles to be rendered.
+	 * @returns a list of references to the created Entities, in the same order as names
+	 */
+	static std::vector<Entity*> createMany(std::vector<std::string> names, 
+		std::vector<Transform*> transforms = std::vector<Transform*>(), 
+		std::vector<Material*> materials = std::vector<Material*>(),
+		std::vector<Mesh*> meshes = std::vector<Mesh*>(),
+		std::vector<Light*> lights = std::vector<Light*>(),
+		std::vector<Camera*> cameras = std::vector<Camera*>(),
+		std::vector<Volume*> volumes = std::vector<Volume*>()
+	);
+
 	/**
      * @param name The name of the entity to get
 	 * @returns an Entity who's name matches the given name 
@@ -0,0 +1,14 @@
+/* File shared by both host and device */
+#pragma once
+
+#include <stdint.h>
+
+/* 
+ * One cell of an environment map alias table. A cell is sampled in constant time by picking 
+ * an entry uniformly, then keeping that entry with the given probability, or taking its alias. 
+ */
+struct EnvironmentAliasStruct {
+    float probability = 1.f;
+    uint32_t alias = 0;
+    float cellProbability = 0.f; // the probability of sampling this cell
+};
@@ -18,6 +18,7 @@ class Texture;
 class Light : public StaticFactory {
     friend class StaticFactory;
     friend class Entity;
+    friend class SceneSnapshot;
 public:
     /**
       * Instantiates a null Light. Used to mark a row in the table as null. 
@@ -224,7 +225,7 @@ private:
     static std::vector<LightStruct> lightStructs;
 
     /* A lookup table of name to light id */
-    static std::map<std::string, uint32_t> lookupTable;
+    static LookupTable lookupTable;
 
     /* Indicates that one of the components has been edited */
     static bool anyDirty;
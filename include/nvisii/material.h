@@ -39,6 +39,7 @@ class Material : public StaticFactory
 {
   friend class StaticFactory;
   friend class Entity;
+  friend class SceneSnapshot;
   public:
 
     /**
@@ -97,6 +98,23 @@ class Material : public StaticFactory
       float clearcoat = 0.f,
       float clearcoat_roughness = .03f);
 
+    /**
+     * Constructs many materials at once. This is much faster than calling "create" in a loop, 
+     * since the material table is only locked once for the whole batch. 
+     * Only the base color, roughness and metallic constants can be given here. Any other parameters take 
+     * on the same defaults as "create", and can be set per material afterwards.
+     * 
+     * @returns a list of references to the created material components, in the same order as names
+     * @param names A list of unique names, one per material to create.
+     * @param base_colors (optional) A flattened list of (r, g, b) base colors, either one per material or a single color shared by all.
+     * @param roughness (optional) A list of roughness values, either one per material or a single value shared by all.
+     * @param metallic (optional) A list of metallic values, either one per material or a single value shared by all.
+    */
+    static std::vector<Material*> createMany(std::vector<std::string> names,
+      std::vector<float> base_colors = std::vector<float>(),
+      std::vector<float> roughness = std::vector<float>(),
+      std::vector<float> metallic = std::vector<float>());
+
     /**
      * Gets a material by name 
      * 
@@ -150,7 +168,11 @@ class Material : public StaticFactory
     /** Tags the current component as being modified since the previous frame. */
     void markDirty();
 
-    /** Returns the simplified struct used to represent the current component */
+    /** 
+     * Returns the simplified struct used to represent the current component. 
+     * Constant parameters are stored in this struct, so their getters and setters go through it as well,
+     * and all of them throw an exception once the material has been removed.
+    */
 	  MaterialStruct &getStruct();
 
     /** Tags the current component as being unmodified since the previous frame. */
@@ -659,32 +681,13 @@ class Material : public StaticFactory
     static std::vector<MaterialStruct> materialStructs;
 
     /* A lookup table of name to material id */
-    static std::map<std::string, uint32_t> lookupTable;
+    static LookupTable lookupTable;
     
     /* Indicates that one of the components has been edited */
     static bool anyDirty;
 
     /* Indicates this component has been edited */
     bool dirty = true;
-
-    // constant material data for when textures aren't set.
-    glm::vec4 base_color = glm::vec4(0.f);
-    glm::vec4 subsurface_radius = glm::vec4(0.f);
-    glm::vec4 subsurface_color = glm::vec4(0.f);
-    float subsurface = 0.f;
-    float metallic = 0.f;
-    float specular = 0.5f;
-    float specular_tint = 0.f;
-    float roughness = 0.f;
-    float anisotropic = 0.f;
-    float anisotropic_rotation = 0.f;
-    float sheen = 0.f;
-    float sheen_tint = 0.f;
-    float clearcoat = 0.f;
-    float clearcoat_roughness = 0.f;
-    float ior = 0.f;
-    float transmission = 0.f;
-    float transmission_roughness = 0.f;
 };
 
 };
@@ -21,6 +21,7 @@
 #include <nvisii/utilities/static_factory.h>
 #include <nvisii/mesh_struct.h>
 #include <nvisii/utilities/hash_combiner.h>
+#include <nvisii/utilities/vertex_compression.h>
 
 namespace nvisii {
 
@@ -72,6 +73,8 @@ class Mesh : public StaticFactory
 {
     friend class StaticFactory;
     friend class Entity;
+    friend class SceneSnapshot;
+    friend class SceneImporter;
     public:
         /**
          * Instantiates a null Mesh. Used to mark a row in the table as null. 
@@ -673,6 +676,10 @@ class Mesh : public StaticFactory
          * OPENGEX PLY MS3D COB BLEND IFC XGL FBX Q3D Q3BSP RAW SIB SMD STL 
          * TERRAGEN 3D X X3D GLTF 3MF MMD
          * 
+         * OBJ and PLY (ASCII and binary) files are read with built in multithreaded readers, 
+         * which are much faster than the generic importer for large files. Polygons are split 
+         * into triangle fans. All other formats are read with assimp.
+         * 
          * @param name The name (used as a primary key) for this mesh component
          * @param path A path to the file.
         */
@@ -706,6 +713,10 @@ class Mesh : public StaticFactory
          * @param texcoords A list of 2D per-vertex texture coordinates. If indices aren't supplied, this must be a multiple of 3.
          * @param texcoord_dimensions The number of floats per texcoord. Valid numbers are 2. (3 might be supported later for 3D textures...)
          * @param indices A list of integer indices connecting vertex positions in a counterclockwise ordering to form triangles. If supplied, indices must be a multiple of 3.
+         * @param weld_epsilon If indices aren't supplied, identical vertices are welded together. When this is greater than zero,
+         * a vertex is also welded to an earlier vertex whose position, normal, tangent, color and texcoord are each within this
+         * distance of its own, which can merge nearly duplicate vertices from scanned or exported triangle soups. Throws if 
+         * the epsilon is too small for the range of the positions.
          * @returns a reference to the mesh component
         */
         static Mesh* createFromData(
@@ -720,7 +731,8 @@ class Mesh : public StaticFactory
             uint32_t color_dimensions = 4, 
             std::vector<float> texcoords = std::vector<float>(), 
             uint32_t texcoord_dimensions = 2, 
-            std::vector<uint32_t> indices = std::vector<uint32_t>());
+            std::vector<uint32_t> indices = std::vector<uint32_t>(),
+            float weld_epsilon = 0.f);
 
         /**
          * @param name The name of the Mesh to get
@@ -785,25 +797,61 @@ class Mesh : public StaticFactory
          */
         // std::vector<float> getVertices(uint32_t vertex_dimensions = 3);
         
-        std::vector<std::array<float, 3>> getVertices();
+        const std::vector<std::array<float, 3>> &getVertices();
 
         /** @returns a list of per vertex colors */
-        std::vector<glm::vec4> getColors();
+        const std::vector<glm::vec4> &getColors();
 
         /** @returns a list of per vertex normals */
-        std::vector<glm::vec4> getNormals();
+        const std::vector<glm::vec4> &getNormals();
 
         /** @returns a list of per vertex tangents */
-        std::vector<glm::vec4> getTangents();
+        const std::vector<glm::vec4> &getTangents();
 
         /** @returns a list of per vertex texture coordinates */
-        std::vector<glm::vec2> getTexCoords();
+        const std::vector<glm::vec2> &getTexCoords();
 
         // /* Returns a list of edge indices */
         // std::vector<uint32_t> get_edge_indices();
 
         /** @returns a list of triangle indices */
-        std::vector<uint32_t> getTriangleIndices();
+        const std::vector<uint32_t> &getTriangleIndices();
+
+        /** 
+         * @returns an N by 3 array of per vertex positions which references the mesh's memory directly (no copy is made).
+         * The returned array is only valid until the mesh is modified or removed. 
+         */
+        void getVerticesView(float** data, int* rows, int* cols);
+
+        /** 
+         * @returns an N by 4 array of per vertex colors which references the mesh's memory directly (no copy is made).
+         * The returned array is only valid until the mesh is modified or removed. 
+         */
+        void getColorsView(float** data, int* rows, int* cols);
+
+        /** 
+         * @returns an N by 4 array of per vertex normals which references the mesh's memory directly (no copy is made).
+         * The returned array is only valid until the mesh is modified or removed. 
+         */
+        void getNormalsView(float** data, int* rows, int* cols);
+
+        /** 
+         * @returns an N by 4 array of per vertex tangents which references the mesh's memory directly (no copy is made).
+         * The returned array is only valid until the mesh is modified or removed. 
+         */
+        void getTangentsView(float** data, int* rows, int* cols);
+
+        /** 
+         * @returns an N by 2 array of per vertex texture coordinates which references the mesh's memory directly (no copy is made).
+         * The returned array is only valid until the mesh is modified or removed. 
+         */
+        void getTexCoordsView(float** data, int* rows, int* cols);
+
+        /** 
+         * @returns a flat array of triangle indices which references the mesh's memory directly (no copy is made).
+         * The returned array is only valid until the mesh is modified or removed. 
+         */
+        void getTriangleIndicesView(uint32_t** data, int* length);
 
         // /* Returns a list of tetrahedra indices */
         // std::vector<uint32_t> get_tetrahedra_indices();		
@@ -862,6 +910,14 @@ class Mesh : public StaticFactory
         /** @returns the radius of a sphere centered at the centroid which completely contains the mesh */
         float getBoundingSphereRadius();
 
+        /** 
+         * Computes a bounding sphere using Ritter's algorithm, which is typically much tighter 
+         * than the centroid centered sphere given by getBoundingSphereRadius, at the cost of 
+         * a few more passes over the vertices.
+         * @returns the center of the sphere in xyz, and the radius of the sphere in w
+        */
+        glm::vec4 computeTightBoundingSphere();
+
         // /* If mesh editing is enabled, replaces the position at the given index with a new position */
         // void edit_position(uint32_t index, glm::vec4 new_position);
 
@@ -876,14 +932,49 @@ class Mesh : public StaticFactory
 
         /**
          * Replaces any existing normals with per-vertex smooth normals computed by 
-         * averaging neighboring geometric face normals together. 
-         * Note that this does not take into account the surface area of each triangular face.
+         * averaging neighboring geometric face normals together, weighted by the 
+         * surface area of each face and by the angle of that face at the vertex.
         */
         void generateSmoothNormals();
 
         // experimental
         void generateSmoothTangents();
 
+        /**
+         * Stores the per vertex data of this mesh in a compact layout, to reduce the memory used by 
+         * very large scenes. Normals and tangents are octahedral encoded into two 16 bit values, and 
+         * texture coordinates are stored as half floats. Normals and tangents are kept as unit vectors, 
+         * and their w components are dropped. 
+         * Accessing the per vertex data of a compressed mesh (eg through getVertices) decompresses it.
+         * 
+         * @param quantize_positions If True, positions are also stored as 16 bit offsets into a grid spanning 
+         * the mesh's bounding box. The error along each axis is at most 1/131070th of the box's extent.
+         * @param keep_colors If True, per vertex colors are kept as 8 bit values. Otherwise, they are discarded.
+        */
+        void compress(bool quantize_positions = false, bool keep_colors = false);
+
+        /** Restores the per vertex data of a compressed mesh to floats. Precision lost by compression is not recovered. */
+        void decompress();
+
+        /** @returns True if the per vertex data of this mesh is stored in the compact layout */
+        bool isCompressed();
+
+        /** @returns the number of bytes of memory used by the per vertex data of this mesh, divided by the number of vertices */
+        float getBytesPerVertex();
+
+        /** 
+         * For internal use. If the mesh is compressed, decodes its per vertex data into the given lists, leaving 
+         * the mesh compressed, and returns the decoded positions. Positions that weren't quantized are not copied, 
+         * so the mesh's own positions are returned instead of positions_. If the mesh isn't compressed, returns 
+         * nullptr and leaves the lists untouched. The caller must hold the mesh edit mutex.
+        */
+        const std::vector<std::array<float, 3>>* decodeVertexData(
+            std::vector<std::array<float, 3>> &positions_,
+            std::vector<glm::vec4> &normals_,
+            std::vector<glm::vec4> &tangents_,
+            std::vector<glm::vec4> &colors_,
+            std::vector<glm::vec2> &texCoords_);
+
         // /* If mesh editing is enabled, replaces the vertex color at the given index with a new vertex color */
         // void edit_vertex_color(uint32_t index, glm::vec4 new_color);
 
@@ -930,7 +1021,7 @@ class Mesh : public StaticFactory
         static std::vector<MeshStruct> meshStructs;
 
         /** A lookup table of name to mesh id */
-        static std::map<std::string, uint32_t> lookupTable;
+        static LookupTable lookupTable;
 
         // /* Lists of per vertex data. These might not match GPU memory if editing is disabled. */
         std::vector<std::array<float, 3>> positions;
@@ -942,6 +1033,15 @@ class Mesh : public StaticFactory
         std::vector<uint32_t> triangleIndices;
         // std::vector<uint32_t> edge_indices;
 
+        /* The per vertex data of a compressed mesh, which replaces the lists above. See compress(). */
+        bool compressed = false;
+        PositionGrid positionGrid;
+        std::vector<std::array<uint16_t, 3>> quantizedPositions;
+        std::vector<uint32_t> packedNormals;
+        std::vector<uint32_t> packedTangents;
+        std::vector<uint32_t> packedColors;
+        std::vector<std::array<uint16_t, 2>> packedTexCoords;
+
         // /* A handle to the buffer containing per vertex positions */
         // vk::Buffer pointBuffer;
         // vk::DeviceMemory pointBufferMemory;
@@ -1022,7 +1122,8 @@ class Mesh : public StaticFactory
             uint32_t color_dimensions,
             std::vector<float> &texcoords_, 
             uint32_t texcoord_dimensions,
-            std::vector<uint32_t> indices_
+            std::vector<uint32_t> indices_,
+            float weld_epsilon = 0.f
         );
         
         /** Creates a procedural mesh from the given mesh generator, and copies per vertex to the GPU */
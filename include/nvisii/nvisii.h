@@ -137,12 +137,27 @@ void setDomeLightColor(glm::vec3 color);
  * @param atmosphere_thickness effects Rayleigh scattering. Thin atmospheres look more 
  * like space, and thick atmospheres see more Rayleigh scattering.
  * @param saturation causes the sky to appear more or less "vibrant"
+ * @param width The width in texels of the latitude/longitude map the sky is baked into.
+ * @param height The height in texels of the latitude/longitude map the sky is baked into.
+ * 
+ * Recently used skies are cached (see setDomeLightSkyCacheSize), so switching back to 
+ * previously used parameters does not bake the sky again.
  */ 
 void setDomeLightSky(
     glm::vec3 sun_position, 
     glm::vec3 sky_tint = vec3(.5f, .5f, .5f), 
     float atmosphere_thickness = 1.0f,
-    float saturation = 1.0f);
+    float saturation = 1.0f,
+    uint32_t width = 512,
+    uint32_t height = 256);
+
+/** 
+ * Sets how many baked procedural skies are kept for reuse by setDomeLightSky.
+ * Each cached sky uses width * height * 16 bytes of host memory.
+ * 
+ * @param size The maximum number of cached skies. Zero disables the cache.
+ */ 
+void setDomeLightSkyCacheSize(uint32_t size);
 
 /** 
  * Sets the texture used to color the dome light (aka the environment). 
@@ -151,9 +166,15 @@ void setDomeLightSky(
  * @param texture The texture to sample for the dome light.
  * @param enable_cdf If True, reduces noise of sampling a dome light texture, 
  * but at the expense of frame rate. Useful for dome lights with bright lights 
- * that should cast shadows.
+ * that should cast shadows. The sampling tables are built on a background thread, 
+ * and the dome light is sampled uniformly until they are ready.
+ * @param cdf_max_width If non-zero, the sampling tables are built from a grid at most this wide, 
+ * averaging neighboring texels. Smaller grids build faster and use less memory, but concentrate 
+ * samples less tightly around small, bright lights. 
+ * @param alias_table If True, also builds an alias table, which picks texels for sampling in 
+ * constant time rather than with two binary searches.
  */ 
-void setDomeLightTexture(Texture* texture, bool enable_cdf = false);
+void setDomeLightTexture(Texture* texture, bool enable_cdf = false, uint32_t cdf_max_width = 0, bool alias_table = false);
 
 /** Disconnects the dome light texture, reverting back to any existing constant dome light color */
 void clearDomeLightTexture();
@@ -360,6 +381,7 @@ struct Scene {
   std::vector<Mesh*> meshes;
   std::vector<Light*> lights;
   std::vector<Camera*> cameras;
+  std::vector<Volume*> volumes;
 };
 
 /**
@@ -383,7 +405,12 @@ struct Scene {
  * @param rotation A change in rotation to apply to all entities generated by this function
  * @param args A list of optional arguments that can effect the importer. 
  * Possible options include: 
- * "verbose" - print out information related to loading the scene. Useful for debugging!
+ * "verbose" - print out information related to loading the scene, including how long each texture took to decode. Useful for debugging!
+ * "texture_threads=N" - decode textures using N worker threads. By default, one thread per hardware thread is used.
+ * "mesh_threads=N" - decode meshes using N worker threads. By default, one thread per hardware thread is used.
+ * "deduplicate_meshes" - meshes with identical vertex and index data share a single mesh component, so that repeated geometry
+ * (eg bolts or leaves) is only stored and uploaded to the GPU once. Prints how many meshes and bytes were saved.
+ * "compress_meshes" - stores the per vertex data of every mesh in a compact layout, see Mesh::compress.
 */
 Scene importScene(
         std::string file_path,
@@ -392,6 +419,29 @@ Scene importScene(
         glm::quat rotation = glm::angleAxis(0.0f, glm::vec3(1.0f, 0.0f, 0.0f)),
         std::vector<std::string> args = std::vector<std::string>());
 
+/**
+ * Saves every entity, transform, mesh, texture, material, light, camera and volume to a single binary file. 
+ * Component data is stored exactly as it is held in memory, so loading a snapshot with loadSceneSnapshot 
+ * skips importing, decoding, welding and tangent generation entirely. Useful when the same scene is loaded 
+ * by many processes. Renderer settings, like the dome light, are not included.
+ * 
+ * Snapshots are only compatible with builds of nvisii whose component layouts match the build that wrote them.
+ * 
+ * @param file_path The path of the snapshot file to write
+*/
+void saveSceneSnapshot(std::string file_path);
+
+/**
+ * Loads the components saved by saveSceneSnapshot. The file is memory mapped and its data copied directly 
+ * into the new components. Components are recreated with the names they were saved with, and references 
+ * between them (eg an entity's mesh, or a material's textures) are restored. Throws if any component 
+ * with the same name already exists, in which case nothing is created.
+ * 
+ * @param file_path The path of the snapshot file to load
+ * @returns the components that were created
+*/
+Scene loadSceneSnapshot(std::string file_path);
+
 /** @returns the minimum axis aligned bounding box position for the axis aligned bounding box containing all scene geometry*/
 glm::vec3 getSceneMinAabbCorner();
 
@@ -401,6 +451,33 @@ glm::vec3 getSceneMaxAabbCorner();
 /** @returns the center of the aligned bounding box for the axis aligned bounding box containing all scene geometry*/
 glm::vec3 getSceneAabbCenter();
 
+/** 
+ * @returns the number of bytes uploaded to the GPU by the most recent scene update, summed over all GPUs. 
+ * Only modified components are uploaded, so this is useful for measuring the cost of scene edits. 
+*/
+size_t getUploadedByteCount();
+
+/** 
+ * @returns statistics for GPU texture objects as a dictionary. "created" and "destroyed" count the 
+ * texture objects created and destroyed by the most recent scene update, and "allocated" counts 
+ * all texture objects currently in use. Only textures allocate texture objects. Constant material 
+ * parameters are stored directly in the material. 
+*/
+std::map<std::string, uint32_t> getTextureObjectStatistics();
+
+/** 
+ * Enables refitting the top level acceleration structure. When the only scene edits between frames are 
+ * transform changes (eg objects driven by a physics simulation), instance transforms are updated in place
+ * and the existing acceleration structure is refit, rather than rebuilt along with the shader binding table.
+ * Adding, removing, or changing the mesh, volume, or visibility of any entity still triggers a full rebuild.
+ * @param max_refits The number of consecutive refits allowed before a full rebuild is forced, 
+ * since traversal performance degrades as instances move away from where they were built.
+ */
+void enableInstanceRefit(uint32_t max_refits = 256);
+
+/** Disables refitting the top level acceleration structure. Every scene edit will rebuild it. */
+void disableInstanceRefit();
+
 // This is for internal purposes. Forces the scene bounds to update.
 void updateSceneAabb(Entity* entity);
 
@@ -8,6 +8,38 @@
 
 namespace nvisii {
 
+class Texture;
+struct DecodedImage;
+struct TextureSampler;
+
+/**
+ * A single step of a texture composite. Composites apply a chain of these operations 
+ * to a base texture in one pass, without allocating intermediate textures.
+ * See Texture::createComposite.
+*/
+struct TextureOperation {
+	enum Type { MIX, ADD, MULTIPLY, HSV };
+
+	Type type = MIX;
+	Texture* texture = nullptr;
+	float mix = 1.f;
+	float hue = .5f;
+	float saturation = 1.f;
+	float value = 1.f;
+
+	/** Mixes the composite towards the given texture by a factor between 0 and 1. */
+	static TextureOperation mixWith(Texture* texture, float mix = 1.f);
+
+	/** Adds the given texture to the composite. */
+	static TextureOperation addWith(Texture* texture);
+
+	/** Multiplies the composite by the given texture. */
+	static TextureOperation multiplyWith(Texture* texture);
+
+	/** Applies an HSV color transformation to the composite. See Texture::createHSV for parameter details. */
+	static TextureOperation hsv(float hue, float saturation, float value, float mix = 1.f);
+};
+
 /**
  * The "Texture" component describes a 2D pattern used to drive the "Material" component's parameters.
 */
@@ -16,6 +48,7 @@ class Texture : public StaticFactory
 	friend class StaticFactory;
 	friend class Material;
 	friend class Light;
+	friend class SceneSnapshot;
   public:
 	/**
       * Instantiates a null Texture. Used to mark a row in the table as null. 
@@ -62,6 +95,53 @@ class Texture : public StaticFactory
 	*/
 	static Texture *createFromData(std::string name, uint32_t width, uint32_t height, const float* data, uint32_t length, bool linear = true, bool hdr = false);
 	
+	/**
+	 * Enables a persistent, on disk cache of decoded images for createFromFile. 
+	 * Decoded texels are written to the given directory the first time an image is loaded, 
+	 * and subsequent loads of the same file (including from other processes) read the texels 
+	 * back directly, skipping decompression. Entries are validated against the path, size, and 
+	 * modification time of the source image, so edited images are decoded again. 
+	 * The directory must already exist, and is never cleaned up automatically.
+	 * @param directory The directory to store cache files in.
+	*/
+	static void enableFileCache(std::string directory);
+
+	/** Disables the on disk cache of decoded images. Existing cache files are left in place. */
+	static void disableFileCache();
+
+	/** 
+	 * @returns statistics for the on disk cache of decoded images, as a dictionary with 
+	 * "hits", "misses", and "writes" counts. 
+	*/
+	static std::map<std::string, uint32_t> getFileCacheStatistics();
+
+	/** Resets the on disk cache statistics to zero. */
+	static void resetFileCacheStatistics();
+
+	/**
+	 * Enables generating a full chain of mip levels for every texture loaded from a file. 
+	 * Images that already contain mip levels (eg DDS and KTX files) keep the levels stored in the file.
+	 * @param filter The downsampling filter, either "box" or "kaiser". See generateMipmaps.
+	*/
+	static void enableMipmapGeneration(std::string filter = "box");
+
+	/** Disables generating mip levels for textures loaded from files. */
+	static void disableMipmapGeneration();
+
+	/**
+	 * Constructs many textures from image files at once. Images are decoded concurrently on a pool 
+	 * of worker threads, and the decoded textures are then added to the texture table in one batch. 
+	 * Images that fail to load are skipped rather than aborting the batch.
+	 * @param names A list of unique names, one per texture to create.
+	 * @param paths A list of image paths, one per name. See createFromFile for supported formats.
+	 * @param linear If true, texels of 8-bit images are interpreted as linear. Applies to every image.
+	 * @param num_threads The number of worker threads to decode with. If 0, one thread per hardware thread is used.
+	 * @param verbose If true, prints how long each image took to decode, along with any load errors.
+	 * @returns a list of textures in the same order as names, with None for any image that failed to load.
+	*/
+	static std::vector<Texture*> createFromFiles(std::vector<std::string> names, std::vector<std::string> paths, 
+		bool linear = false, uint32_t num_threads = 0, bool verbose = false);
+
 	/** 
 	 * Constructs a Texture with the given name that mixes two different textures together.
 	 * @param name The name of the texture to create.
@@ -108,6 +188,19 @@ class Texture : public StaticFactory
 	*/
 	static Texture* createHSV(std::string name, Texture* tex, float hue, float saturation, float value, float mix = 1.0, bool hdr = false);
 
+	/** 
+	 * Constructs a Texture with the given name by applying a chain of operations to a base texture.
+	 * All operations are evaluated together in linear color space, so chaining operations this way 
+	 * avoids creating and quantizing intermediate textures. Inputs of differing resolutions are 
+	 * bilinearly resampled to the largest input resolution.
+	 * @param name The name of the texture to create.
+	 * @param base The texture to start from.
+	 * @param operations The operations to apply to the base texture, in order.
+	 * @param hdr If true, represents the channels of the texture using 32 bit floats. Otherwise, textures are stored natively using 8 bits per channel. 
+	 * @returns a Texture allocated by the renderer. 
+	*/
+	static Texture* createComposite(std::string name, Texture* base, std::vector<TextureOperation> operations, bool hdr = false);
+
     /**
      * @param name The name of the Texture to get
 	 * @returns a Texture who's name matches the given name 
@@ -174,15 +267,95 @@ class Texture : public StaticFactory
     /** @returns a flattened list of 8-bit texels */
 	std::vector<u8vec4> getByteTexels();
 
+	/** 
+	 * @returns the format the texels of the texture are stored in. One of "R8", "RG8", "RGBA8", "R16F", 
+	 * "RGBA16F", "R32F" or "RGBA32F", or for block compressed textures "BC1", "BC3", "BC4" or "BC5". 
+	 * Grayscale images are stored with one channel, and grayscale images with alpha with two, 
+	 * where the second channel holds alpha. HDR images are stored as half floats when all 
+	 * of their values fit. getFloatTexels and getByteTexels expand every format to RGBA.
+	*/
+	std::string getFormat();
+
+	/** @returns the number of channels stored per texel, between 1 and 4. */
+	uint32_t getChannelCount();
+
+	/** 
+	 * @returns a flattened list of texels as 32-bit floats, with getChannelCount() values per texel 
+	 * rather than four. 8-bit channels are normalized to the range [0,1].
+	*/
+	std::vector<float> getTexels();
+
+	/** 
+	 * @returns the texels of the first mip level exactly as stored, laid out as described by getFormat. 
+	 * For example, one byte per texel for "R8", or four 16-bit floats per texel for "RGBA16F". 
+	 * For block compressed textures, returns the blocks of the first mip level.
+	*/
+	std::vector<uint8_t> getTexelBytes();
+
+	/**
+	 * Generates a full chain of mip levels, down to 1x1, from the first level of the texture. 
+	 * Filtering is done in linear space, so sRGB textures are gamma correct. 
+	 * Any existing mip levels are replaced. 
+	 * @param filter Either "box", which averages each 2x2 footprint, or "kaiser", a wider Kaiser 
+	 * windowed sinc which keeps lower levels sharper at the cost of some ringing.
+	*/
+	void generateMipmaps(std::string filter = "box");
+
+	/** Removes every mip level except the first. */
+	void clearMipmaps();
+
+	/** @returns the number of mip levels in the texture, including the first. */
+	uint32_t getMipLevelCount();
+
+	/** @returns the width in texels of the given mip level */
+	uint32_t getMipLevelWidth(uint32_t level);
+
+	/** @returns the height in texels of the given mip level */
+	uint32_t getMipLevelHeight(uint32_t level);
+
+	/** @returns a flattened list of 32-bit float texels for the given mip level */
+	std::vector<vec4> getMipLevelFloatTexels(uint32_t level);
+
+	/** @returns a flattened list of 8-bit texels for the given mip level */
+	std::vector<u8vec4> getMipLevelByteTexels(uint32_t level);
+
+	/**
+	 * Samples the texture on the CPU. Texel centers and orientation match the renderer, so 
+	 * [0,0] is the bottom left corner of the first row of texels and [1,1] the top right corner.
+	 * @param uv The texture coordinates to sample
+	 * @param filter "nearest", "linear" (bilinear), or "trilinear", which also blends between 
+	 * the two mip levels nearest to lod.
+	 * @param wrap How coordinates outside of [0,1] are handled, either "repeat", "clamp", or "mirror".
+	 * @param lod The mip level to sample. Nearest and linear filters use the closest level. 
+	 * Clamped to the available mip levels.
+	 * @param decode_srgb If True and the texture is sRGB, texels are converted to linear before filtering.
+	 * @returns the filtered RGBA texture value. 8-bit channels are normalized to the range [0,1].
+	*/
+	vec4 sample(vec2 uv, std::string filter = "linear", std::string wrap = "repeat", float lod = 0.f, bool decode_srgb = false);
+
+	/**
+	 * Samples the texture on the CPU at many texture coordinates at once, splitting the work across threads. 
+	 * Takes the same options as sample. In Python, uvs is an N by 2 numpy array, and the samples are 
+	 * returned as an N by 4 numpy array.
+	 * @param uvs Pairs of texture coordinates, uv_count by uv_components values. uv_components must be 2.
+	 * @param samples Set to uv_count RGBA samples, allocated with malloc. The caller takes ownership.
+	 * @param sample_count Set to uv_count
+	 * @param sample_components Set to 4
+	*/
+	void sampleBatch(const float* uvs, int uv_count, int uv_components, float** samples, int* sample_count, int* sample_components, 
+		std::string filter = "linear", std::string wrap = "repeat", float lod = 0.f, bool decode_srgb = false);
+
 	/**
-	 * Sample the texture at the given texture coordinates
+	 * Sample the texture at the given texture coordinates, bilinearly filtering the first mip level 
+	 * and clamping to the edges of the texture. See sample for other filter and wrap modes.
 	 * @param uv A pair of values between [0,0] and [1,1]
 	 * @returns a sampled texture value
 	*/
 	vec4 sampleFloatTexels(vec2 uv);
 	
 	/**
-	 * Sample the texture at the given texture coordinates
+	 * Sample the texture at the given texture coordinates, bilinearly filtering the first mip level 
+	 * and clamping to the edges of the texture. See sample for other filter and wrap modes.
 	 * @param uv A pair of values between [0,0] and [1,1]
 	 * @returns a sampled texture value
 	*/
@@ -206,6 +379,12 @@ class Texture : public StaticFactory
 	/** @returns True if the texture contains any values above 1 */
     bool isHDR();
 
+	/** 
+	 * @returns True if the texture is stored block compressed. BC1, BC3, BC4, and BC5 images loaded from 
+	 * DDS or KTX files keep their original blocks and mip levels, and are only decompressed on demand. 
+	*/
+	bool isCompressed();
+
 	/** @returns True if the texture is represented linearly. Otherwise, the texture is in sRGB space */
     bool isLinear();
 
@@ -213,6 +392,9 @@ class Texture : public StaticFactory
     void setLinear(bool is_linear);
 
   private:
+	/* Takes the texels and properties of a decoded image file, and marks the texture dirty. */
+	void setDecodedImage(DecodedImage &decoded);
+
   	/* TODO */
 	static std::shared_ptr<std::recursive_mutex> editMutex;
 
@@ -224,7 +406,7 @@ class Texture : public StaticFactory
 	static std::vector<TextureStruct> textureStructs;
 	
 	/** A lookup table of name to texture id */
-	static std::map<std::string, uint32_t> lookupTable;
+	static LookupTable lookupTable;
 
 	static std::set<Texture*> dirtyTextures;
 
@@ -232,6 +414,36 @@ class Texture : public StaticFactory
     std::vector<vec4> floatTexels;
     std::vector<u8vec4> byteTexels;
 	bool linear = false;
+
+	/** 
+	 * Mip levels after the first, stored back to back in the same format as the first level, 
+	 * or for packed textures, expanded to RGBA8 or RGBA32F 
+	*/
+	std::vector<vec4> floatMipTexels;
+	std::vector<u8vec4> byteMipTexels;
+	/** The texel offset of each mip level after the first within the mip texels */
+	std::vector<size_t> mipOffsets;
+
+	/** Block compressed texels for all mip levels, stored as loaded, top row of blocks first */
+	std::vector<uint8_t> compressedBlocks;
+	/** The byte offset of each mip level within compressedBlocks */
+	std::vector<size_t> compressedLevelOffsets;
+	/** A TextureCompression value describing compressedBlocks */
+	uint32_t compression = 0;
+
+	/** Texels of the first level with fewer than four channels or with half float channels, tightly packed */
+	std::vector<uint8_t> packedTexels;
+	/** A TexturePackedFormat value describing packedTexels */
+	uint32_t packedFormat = 0;
+
+	/* Decompresses the given mip level into 8-bit texels, bottom row first like the uncompressed texels. */
+	std::vector<u8vec4> decompressLevel(uint32_t level);
+
+	/* 
+	 * Parses sampling options and records where the texels of the mip levels used by lod live. 
+	 * If decompress is true, block compressed levels are decompressed up front into the sampler.
+	 */
+	void initializeSampler(TextureSampler &sampler, std::string filter, std::string wrap, float lod, bool decodeSRGB, bool decompress);
 };
 
 };
@@ -15,4 +15,5 @@ struct TextureStruct
     int32_t height = -1;
     vec2 scale = vec2(1.f, 1.f); 
     bool rightHanded = true;
+    int32_t channels = 4; // channels in the device texture. Single channel textures are read as grayscale.
 };
@@ -15,6 +15,7 @@
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/matrix_interpolation.hpp>
 // #include <glm/gtx/matrix_decompose.hpp>
+#include <atomic>
 #include <map>
 #include <mutex>
 
@@ -33,6 +34,7 @@ class Transform : public StaticFactory
 {
     friend class StaticFactory;
     friend class Entity;
+    friend class SceneSnapshot;
 
   private:
     bool useRelativeLinearMotionBlur = true;
@@ -43,15 +45,8 @@ class Transform : public StaticFactory
     int32_t parent = -1;
 	  std::set<int32_t> children;
 
-    /* Local <=> Parent */
-    glm::vec3 scale = glm::vec3(1.0);
-    glm::vec3 position = glm::vec3(0.0);
-    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
-
-    glm::vec3 prevScale = glm::vec3(1.0);
-    glm::vec3 prevPosition = glm::vec3(0.0);
-    glm::quat prevRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
-
+    /* Local <=> Parent. The current and previous frame scale, position and rotation are kept 
+       in the localScales, localPositions and localRotations tables and their prev counterparts, indexed by id. */
     glm::vec3 linearMotion = glm::vec3(0.0);
     glm::quat angularMotion = glm::quat(1.f,0.f,0.f,0.f);
     glm::vec3 scalarMotion = glm::vec3(0.0);
@@ -64,19 +59,30 @@ class Transform : public StaticFactory
     glm::mat4 prevLocalToParentMatrix = glm::mat4(1);
     glm::mat4 prevParentToLocalMatrix = glm::mat4(1);
 
-    /* Local <=> World */
-    glm::mat4 localToWorldMatrix = glm::mat4(1);
-    glm::mat4 worldToLocalMatrix = glm::mat4(1);
-
-    glm::mat4 prevLocalToWorldMatrix = glm::mat4(1);
-    glm::mat4 prevWorldToLocalMatrix = glm::mat4(1);
+    /* Local <=> World. Local to world matrices are kept directly in transformStructs, 
+       and world to local matrices in worldToLocalMatrices, indexed by id. */
 
   	static std::shared_ptr<std::recursive_mutex> editMutex;
     static bool factoryInitialized;
 
     static std::vector<Transform> transforms;
     static std::vector<TransformStruct> transformStructs;
-    static std::map<std::string, uint32_t> lookupTable;
+    static LookupTable lookupTable;
+
+    /* Structure of arrays storage for frequently accessed values, indexed by transform id. 
+       Keeping these in contiguous tables lets batch updates stream through memory, and lets
+       the transform struct table be uploaded to the GPU as is. */
+    static std::vector<glm::vec3> localScales;
+    static std::vector<glm::vec3> localPositions;
+    static std::vector<glm::quat> localRotations;
+    static std::vector<glm::vec3> prevLocalScales;
+    static std::vector<glm::vec3> prevLocalPositions;
+    static std::vector<glm::quat> prevLocalRotations;
+    static std::vector<glm::mat4> worldToLocalMatrices;
+    static std::vector<glm::mat4> prevWorldToLocalMatrices;
+
+    /* Resets the structure of arrays storage for the given id to an identity transform */
+    static void resetStorage(int32_t id);
     
     /* Updates cached rotation values */
     void updateRotation();
@@ -90,23 +96,29 @@ class Transform : public StaticFactory
     /* Updates cached final local to parent matrix values */
     void updateMatrix();
 
-    /* Updates cached final local to world matrix values */
-    void updateWorldMatrix();
+    /* Updates cached final local to parent matrix values without marking the transform dirty */
+    void updateLocalMatrices();
 
-    /* updates all childrens cached final local to world matrix values */
-    void updateChildren();
+    /* Updates cached final local to world matrix values from the parent's cached values */
+    void updateWorldMatrix();
 
     /* updates the struct for this transform which can be uploaded to the GPU. */
     void updateStruct();
     
-    /* traverses from the current transform up through its ancestors, 
-    computing a final world to local matrix */
-    glm::mat4 computeWorldToLocalMatrix(bool previous);
-    // glm::mat4 computePrevWorldToLocalMatrix(bool previous);
-
+    /* True if this transform was edited since world matrices were last resolved */
+    bool worldMatrixStale = false;
 
     static std::set<Transform*> dirtyTransforms;
 
+    /* Transforms edited since world matrices were last resolved. Their descendants are stale as well. */
+    static std::vector<Transform*> staleTransforms;
+
+    /* 
+     * True while staleTransforms is not empty. Only changed under the edit mutex, but read without it, 
+     * so that the lazy world matrix getters don't lock when nothing is stale. 
+     */
+    static std::atomic<bool> anyStale;
+
   public:
     /**
       * Instantiates a null Transform. Used to mark a row in the table as null. 
@@ -146,6 +158,38 @@ class Transform : public StaticFactory
       glm::mat4 transform = glm::mat4(1.0f)
     );
 
+    /**
+     * Constructs many transforms at once. This is much faster than calling "create" in a loop, 
+     * since the transform table is only locked once for the whole batch.
+     * 
+     * @param names A list of unique names, one per transform to create.
+     * @param scales (optional) A flattened list of (x, y, z) scales, either one per transform or a single scale shared by all.
+     * @param rotations (optional) A flattened list of (x, y, z, w) quaternions, either one per transform or a single rotation shared by all.
+     * @param positions (optional) A flattened list of (x, y, z) positions, either one per transform or a single position shared by all.
+     * @returns a list of references to the created transform components, in the same order as names
+    */
+    static std::vector<Transform*> createMany(std::vector<std::string> names,
+      std::vector<float> scales = std::vector<float>(),
+      std::vector<float> rotations = std::vector<float>(),
+      std::vector<float> positions = std::vector<float>()
+    );
+
+    /**
+     * Updates many transforms at once. This is much faster than calling the individual setters in a loop, 
+     * since the transform table is only locked once, and local matrices for the whole batch are recomputed 
+     * together in parallel.
+     * 
+     * @param transforms A list of transforms to update. Each transform may appear at most once.
+     * @param scales (optional) A flattened list of (x, y, z) scales, either one per transform or a single scale shared by all.
+     * @param rotations (optional) A flattened list of (x, y, z, w) quaternions, either one per transform or a single rotation shared by all.
+     * @param positions (optional) A flattened list of (x, y, z) positions, either one per transform or a single position shared by all.
+    */
+    static void setMany(std::vector<Transform*> transforms,
+      std::vector<float> scales = std::vector<float>(),
+      std::vector<float> rotations = std::vector<float>(),
+      std::vector<float> positions = std::vector<float>()
+    );
+
     /** 
      * @param name The name of the transform to get
      * @returns a transform who's name matches the given name 
@@ -197,9 +241,20 @@ class Transform : public StaticFactory
     /** @returns a list of transforms that have been modified since the previous frame */
     static std::set<Transform*> getDirtyTransforms();
 
-    /** Tags the current component as being modified since the previous frame. */
+    /** 
+     * Tags the current component as being modified since the previous frame. 
+     * World matrices of this transform and its descendants are recomputed lazily, 
+     * the next time any world space value is read or the renderer updates components.
+     */
 	  void markDirty();
 
+    /** 
+     * For internal use. Recomputes the cached world matrices of every transform modified since the 
+     * previous call, along with all of their descendants, in a single top down pass. Independent 
+     * subtrees are processed in parallel. Entities attached to updated transforms are then marked dirty.
+     */
+    static void updateWorldMatrices();
+
     /** For internal use. Returns the mutex used to lock transforms for processing by the renderer. */
     static std::shared_ptr<std::recursive_mutex> getEditMutex();
 
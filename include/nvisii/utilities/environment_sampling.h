@@ -0,0 +1,203 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <nvisii/environment_struct.h>
+#include <nvisii/utilities/parallel.h>
+
+/*
+ * Tables for importance sampling a latitude/longitude environment map by luminance. 
+ *
+ * The map is reduced to a grid of cells, optionally coarser than the map itself. Each cell 
+ * is weighted by its average luminance times the solid angle it covers, so that rows near 
+ * the poles, which are stretched over very little of the sphere, are sampled less often.
+ * Cells can then be sampled either through a marginal CDF over rows and a conditional CDF 
+ * per row (two binary searches), or through an alias table (constant time).
+ * 
+ * Directions are sampled uniformly in (u, v) within a cell, so the density with respect 
+ * to solid angle at a direction with polar angle theta = pi * v is
+ *     cellProbability * width * height / (2 * pi^2 * sin(theta))
+ */
+
+static const size_t ENVIRONMENT_SAMPLING_ROWS_PER_CHUNK = 8;
+static const double ENVIRONMENT_SAMPLING_PI = 3.14159265358979323846;
+
+struct EnvironmentSampling {
+    /* The resolution of the sampling grid. Zero if the map has no energy to sample. */
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    /* The marginal CDF over rows, one value per row. The last value is 1. */
+    std::vector<float> rows;
+
+    /* The conditional CDF over the columns of each row, width values per row. */
+    std::vector<float> cols;
+
+    /* An alias table over all cells in row major order. Empty unless requested. */
+    std::vector<EnvironmentAliasStruct> aliasTable;
+};
+
+/* Returns the probability of sampling the given cell, from the CDFs of the sampling tables */
+inline float getEnvironmentCellProbability(const EnvironmentSampling &sampling, uint32_t x, uint32_t y)
+{
+    size_t i = size_t(y) * sampling.width + x;
+    float rowProbability = sampling.rows[y] - ((y > 0) ? sampling.rows[y - 1] : 0.f);
+    float colProbability = sampling.cols[i] - ((x > 0) ? sampling.cols[i - 1] : 0.f);
+    return rowProbability * colProbability;
+}
+
+/* 
+ * Returns the density with respect to solid angle of sampling the direction at the given 
+ * texture coordinates, each between 0 and 1. 
+ */
+inline float getEnvironmentPdf(const EnvironmentSampling &sampling, float u, float v)
+{
+    if (sampling.width == 0 || sampling.height == 0) return 0.f;
+    uint32_t x = std::min(uint32_t(std::max(u, 0.f) * sampling.width), sampling.width - 1);
+    uint32_t y = std::min(uint32_t(std::max(v, 0.f) * sampling.height), sampling.height - 1);
+    float sinTheta = std::sin(float(ENVIRONMENT_SAMPLING_PI) * v);
+    if (sinTheta <= 0.f) return 0.f;
+    return getEnvironmentCellProbability(sampling, x, y) * sampling.width * sampling.height 
+        / (2.f * float(ENVIRONMENT_SAMPLING_PI) * float(ENVIRONMENT_SAMPLING_PI) * sinTheta);
+}
+
+/* 
+ * Builds an alias table from probabilities that sum to one, using Vose's method. 
+ * Each entry keeps its own probability so that sampled cells don't need a second lookup.
+ */
+inline std::vector<EnvironmentAliasStruct> buildAliasTable(const std::vector<float> &probabilities)
+{
+    size_t count = probabilities.size();
+    std::vector<EnvironmentAliasStruct> table(count);
+    std::vector<double> scaled(count);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < count; ++i) {
+        table[i].alias = uint32_t(i);
+        table[i].cellProbability = probabilities[i];
+        scaled[i] = double(probabilities[i]) * count;
+        if (scaled[i] < 1.0) small.push_back(uint32_t(i));
+        else large.push_back(uint32_t(i));
+    }
+
+    while (!small.empty() && !large.empty()) {
+        uint32_t s = small.back(); small.pop_back();
+        uint32_t l = large.back(); large.pop_back();
+        table[s].probability = float(scaled[s]);
+        table[s].alias = l;
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        if (scaled[l] < 1.0) small.push_back(l);
+        else large.push_back(l);
+    }
+
+    // whatever remains is within rounding error of one
+    for (auto i : small) table[i].probability = 1.f;
+    for (auto i : large) table[i].probability = 1.f;
+    return table;
+}
+
+/* 
+ * Builds sampling tables for a latitude/longitude environment map.
+ * @param texels width * height RGBA texels, four floats each, one row after another. 
+ * Rows map to polar angles between 0 and pi, and columns to azimuths.
+ * @param maxWidth The largest width of the sampling grid, or 0 to sample every texel. 
+ * Coarser grids average neighboring texels, keeping the aspect ratio of the map.
+ * @param aliasTable If true, also builds an alias table over the cells.
+ * @param cancelled If given and set while building, the build stops early and returns empty tables.
+ */
+inline EnvironmentSampling buildEnvironmentSampling(const float* texels, uint32_t width, uint32_t height, 
+    uint32_t maxWidth = 0, bool aliasTable = false, const std::atomic<bool>* cancelled = nullptr)
+{
+    auto isCancelled = [cancelled] () { return cancelled && cancelled->load(); };
+    EnvironmentSampling sampling;
+    if (!texels || width == 0 || height == 0) return sampling;
+
+    uint32_t gridWidth = ((maxWidth == 0) || (maxWidth >= width)) ? width : maxWidth;
+    uint32_t gridHeight = std::max(uint32_t((uint64_t(height) * gridWidth) / width), 1u);
+    sampling.width = gridWidth;
+    sampling.height = gridHeight;
+    sampling.rows.resize(gridHeight);
+    sampling.cols.resize(size_t(gridWidth) * gridHeight);
+
+    // Weigh each cell and take a prefix sum over every row, one chunk of rows per thread.
+    // Row totals are kept in double precision for the marginal CDF.
+    std::vector<double> rowTotals(gridHeight);
+    Parallel::forRange(0, gridHeight, ENVIRONMENT_SAMPLING_ROWS_PER_CHUNK, [&] (size_t rowBegin, size_t rowEnd) {
+        for (size_t gy = rowBegin; gy < rowEnd; ++gy) {
+            if (isCancelled()) return;
+            uint32_t y0 = uint32_t((uint64_t(gy) * height) / gridHeight);
+            uint32_t y1 = std::max(uint32_t((uint64_t(gy + 1) * height) / gridHeight), y0 + 1);
+            double theta0 = ENVIRONMENT_SAMPLING_PI * double(gy) / gridHeight;
+            double theta1 = ENVIRONMENT_SAMPLING_PI * double(gy + 1) / gridHeight;
+            double solidAngle = (2.0 * ENVIRONMENT_SAMPLING_PI / gridWidth) * (std::cos(theta0) - std::cos(theta1));
+
+            float* cdf = &sampling.cols[gy * gridWidth];
+            double total = 0.0;
+            for (uint32_t gx = 0; gx < gridWidth; ++gx) {
+                uint32_t x0 = uint32_t((uint64_t(gx) * width) / gridWidth);
+                uint32_t x1 = std::max(uint32_t((uint64_t(gx + 1) * width) / gridWidth), x0 + 1);
+                double luminance = 0.0;
+                for (uint32_t y = y0; y < y1; ++y) {
+                    const float* texel = &texels[(size_t(y) * width + x0) * 4];
+                    for (uint32_t x = x0; x < x1; ++x, texel += 4) {
+                        double l = 0.2126 * texel[0] + 0.7152 * texel[1] + 0.0722 * texel[2];
+                        if (l > 0.0) luminance += l; // also rejects NaNs
+                    }
+                }
+                total += solidAngle * luminance / (double(x1 - x0) * (y1 - y0));
+                cdf[gx] = float(total);
+            }
+
+            rowTotals[gy] = total;
+            for (uint32_t gx = 0; gx < gridWidth; ++gx) {
+                cdf[gx] = (total > 0.0) ? float(cdf[gx] / total) : float(gx + 1) / gridWidth;
+            }
+            cdf[gridWidth - 1] = 1.f;
+        }
+    });
+
+    if (isCancelled()) return EnvironmentSampling();
+
+    double total = 0.0;
+    for (uint32_t gy = 0; gy < gridHeight; ++gy) total += rowTotals[gy];
+    if (!(total > 0.0)) return EnvironmentSampling();
+
+    double sum = 0.0;
+    for (uint32_t gy = 0; gy < gridHeight; ++gy) {
+        sum += rowTotals[gy];
+        sampling.rows[gy] = float(sum / total);
+    }
+    sampling.rows[gridHeight - 1] = 1.f;
+
+    if (aliasTable) {
+        std::vector<float> probabilities(sampling.cols.size());
+        Parallel::forRange(0, gridHeight, ENVIRONMENT_SAMPLING_ROWS_PER_CHUNK, [&] (size_t rowBegin, size_t rowEnd) {
+            for (size_t gy = rowBegin; gy < rowEnd; ++gy) {
+                for (uint32_t gx = 0; gx < gridWidth; ++gx) {
+                    probabilities[gy * gridWidth + gx] = getEnvironmentCellProbability(sampling, gx, uint32_t(gy));
+                }
+            }
+        });
+        sampling.aliasTable = buildAliasTable(probabilities);
+    }
+    return sampling;
+}
@@ -0,0 +1,60 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/* A half open range of table indices, [begin, end) */
+struct IndexRange {
+    uint32_t begin;
+    uint32_t end;
+};
+
+/*
+ * Sorts the given indices and merges them into half open ranges. Ranges separated
+ * by maxGap or fewer unused indices are joined, trading a few redundant elements
+ * for fewer, larger copies.
+ */
+inline std::vector<IndexRange> coalesceIndices(std::vector<uint32_t> indices, uint32_t maxGap = 0)
+{
+    std::vector<IndexRange> ranges;
+    if (indices.size() == 0) return ranges;
+    std::sort(indices.begin(), indices.end());
+
+    IndexRange range = {indices[0], indices[0] + 1};
+    for (size_t i = 1; i < indices.size(); ++i) {
+        if (indices[i] < range.end) continue; // duplicate
+        if (indices[i] - range.end <= maxGap) {
+            range.end = indices[i] + 1;
+        } else {
+            ranges.push_back(range);
+            range = {indices[i], indices[i] + 1};
+        }
+    }
+    ranges.push_back(range);
+    return ranges;
+}
+
+/* Returns the total number of indices covered by the given ranges */
+inline size_t countIndices(const std::vector<IndexRange> &ranges)
+{
+    size_t count = 0;
+    for (auto &range : ranges) count += range.end - range.begin;
+    return count;
+}
@@ -0,0 +1,170 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/* How the instance acceleration structure should be brought up to date */
+enum class InstanceUpdate {
+    Rebuild, // create a new instance group, build it, and rebuild the SBT
+    Refit    // update transforms of the existing instance group and refit it in place
+};
+
+/*
+ * Everything about the top level instances other than their transforms. If two
+ * consecutive layouts match, the instance group and SBT from the previous frame
+ * remain valid and only the transforms need to be updated.
+ */
+template<typename Handle>
+struct InstanceLayout {
+    std::vector<Handle> children;
+    std::vector<uint8_t> masks;
+    std::vector<uint32_t> instanceToEntity;
+
+    void clear()
+    {
+        // clear keeps capacity, so layouts can be refilled every frame without reallocating
+        children.clear();
+        masks.clear();
+        instanceToEntity.clear();
+    }
+
+    size_t size() const { return children.size(); }
+
+    bool operator==(const InstanceLayout &other) const
+    {
+        return children == other.children && masks == other.masks 
+            && instanceToEntity == other.instanceToEntity;
+    }
+    bool operator!=(const InstanceLayout &other) const { return !(*this == other); }
+};
+
+/*
+ * Decides whether the instance acceleration structure can be refit, or must be rebuilt.
+ * A refit is only possible when refitting is enabled, an acceleration structure already 
+ * exists, no child acceleration structure was released or recreated since the last build, 
+ * the instance layout is unchanged, and fewer than maxRefits refits have been done since 
+ * the last build. Refits degrade traversal quality as instances move, so a periodic
+ * rebuild is forced. 
+ * Children are compared by handle, and a recreated child can be given the handle of the 
+ * one it replaced, so the layout alone can't tell that a child changed; childrenChanged must.
+ */
+template<typename Handle>
+InstanceUpdate chooseInstanceUpdate(
+    const InstanceLayout<Handle> &previous, const InstanceLayout<Handle> &current,
+    bool hasAccel, bool childrenChanged, bool refitEnabled, uint32_t refitCount, uint32_t maxRefits)
+{
+    if (!refitEnabled || !hasAccel) return InstanceUpdate::Rebuild;
+    if (childrenChanged) return InstanceUpdate::Rebuild;
+    if (current.size() == 0) return InstanceUpdate::Rebuild;
+    if (refitCount >= maxRefits) return InstanceUpdate::Rebuild;
+    if (previous != current) return InstanceUpdate::Rebuild;
+    return InstanceUpdate::Refit;
+}
+
+/*
+ * Tracks the instance layout used to build the current acceleration structure, and
+ * drives a backend to either rebuild or refit it. The backend abstracts the ray tracing 
+ * API so that this logic can run against a CPU mock. It must provide:
+ *   Group create(size_t count)
+ *   void setChild(Group group, size_t index, Handle child)
+ *   void setInstances(Group group, const std::vector<Transform> &t0, const std::vector<Transform> &t1, 
+ *                     const InstanceLayout<Handle> &layout)
+ *   void build(Group group)
+ *   void refit(Group group)
+ *   void release(Group group)
+ *   void commit(Group group) // called after a rebuild, eg to bind the group and rebuild the SBT
+ */
+template<typename Handle, typename Group>
+class InstanceAccelState {
+    public:
+
+    /* Enables or disables the refit path. When disabled, every update rebuilds. */
+    void setRefitEnabled(bool enabled) { refitEnabled = enabled; }
+    bool isRefitEnabled() const { return refitEnabled; }
+
+    /* Controls how many consecutive refits are allowed before a rebuild is forced. */
+    void setMaxRefits(uint32_t count) { maxRefits = count; }
+
+    /* 
+     * Forces the next update to rebuild. Call this whenever a child acceleration structure 
+     * is released or recreated, since its replacement may reuse the same handle. 
+     */
+    void invalidateChildren() { childrenChanged = true; }
+
+    /* The layout to fill for the next update. */
+    InstanceLayout<Handle> &getPendingLayout() { return pending; }
+
+    /* The layout of the current acceleration structure. */
+    const InstanceLayout<Handle> &getLayout() const { return current; }
+
+    Group getGroup() const { return group; }
+
+    /* 
+     * Brings the acceleration structure up to date with the pending layout and the given 
+     * transforms. If the pending layout is empty, placeholder is instanced instead. 
+     * Returns the kind of update that was done.
+     */
+    template<typename Backend, typename Transform>
+    InstanceUpdate update(Backend &backend, const std::vector<Transform> &t0, 
+        const std::vector<Transform> &t1, Handle placeholder)
+    {
+        InstanceUpdate kind = chooseInstanceUpdate(current, pending, 
+            group != Group(), childrenChanged, refitEnabled, refitCount, maxRefits);
+
+        if (kind == InstanceUpdate::Refit) {
+            backend.setInstances(group, t0, t1, pending);
+            backend.refit(group);
+            refitCount++;
+            return kind;
+        }
+
+        Group oldGroup = group;
+        if (pending.size() == 0) {
+            // If no objects are instanced, insert an unhittable placeholder.
+            // (required for certain older driver versions)
+            group = backend.create(1);
+            backend.setChild(group, 0, placeholder);
+        } else {
+            group = backend.create(pending.size());
+            for (size_t i = 0; i < pending.size(); ++i) {
+                backend.setChild(group, i, pending.children[i]);
+            }
+            backend.setInstances(group, t0, t1, pending);
+        }
+        backend.build(group);
+        backend.commit(group);
+        if (oldGroup != Group()) backend.release(oldGroup);
+
+        std::swap(current, pending);
+        refitCount = 0;
+        childrenChanged = false;
+        return kind;
+    }
+
+    private:
+    InstanceLayout<Handle> current;
+    InstanceLayout<Handle> pending;
+    Group group = Group();
+    bool refitEnabled = false;
+    bool childrenChanged = false;
+    uint32_t refitCount = 0;
+    uint32_t maxRefits = 256;
+};
@@ -0,0 +1,155 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+ * Maps component names to component ids, and tracks which ids in a component
+ * table are available. Free ids are kept in a two level bitmap, so that finding
+ * the lowest available id, reserving it, and releasing it are all constant time
+ * operations for any realistic table size.
+ */
+class LookupTable {
+    public:
+
+    /* Returns the number of ids currently tracked by the free slot bitmap. */
+    size_t capacity() const { return numSlots; }
+
+    /* Returns the number of names in the table. */
+    size_t size() const { return ids.size(); }
+
+    /* Reserves space for the given number of names, avoiding rehashes during bulk creation. */
+    void reserve(size_t count) { ids.reserve(count); }
+
+    /* Resets the free slot bitmap so that all ids in [0, count) are available. */
+    void resize(size_t count)
+    {
+        numSlots = count;
+        size_t numWords = (count + 63) / 64;
+        size_t numSummaryWords = (numWords + 63) / 64;
+        slotBits = std::vector<uint64_t>(numWords, ~uint64_t(0));
+        wordBits = std::vector<uint64_t>(numSummaryWords, ~uint64_t(0));
+
+        // clear bits past the end of the table
+        if (count % 64) slotBits[numWords - 1] = (uint64_t(1) << (count % 64)) - 1;
+        if (numWords % 64) wordBits[numSummaryWords - 1] = (uint64_t(1) << (numWords % 64)) - 1;
+        if (numWords > 0 && slotBits[numWords - 1] == 0) clearWordBit(numWords - 1);
+    }
+
+    /* Returns true if a name exists in the table. */
+    bool contains(const std::string &name) const
+    {
+        return ids.find(name) != ids.end();
+    }
+
+    /* Returns the id for the given name, or -1 if the name does not exist. */
+    int32_t find(const std::string &name) const
+    {
+        auto it = ids.find(name);
+        if (it == ids.end()) return -1;
+        return (int32_t) it->second;
+    }
+
+    /* Returns the lowest available id, or -1 if every id is in use. */
+    int32_t findAvailable() const
+    {
+        for (size_t w = 0; w < wordBits.size(); ++w) {
+            if (wordBits[w] == 0) continue;
+            size_t word = w * 64 + countTrailingZeros(wordBits[w]);
+            return (int32_t) (word * 64 + countTrailingZeros(slotBits[word]));
+        }
+        return -1;
+    }
+
+    /* Associates a name with an id, marking that id as unavailable. */
+    void insert(const std::string &name, uint32_t id)
+    {
+        ids[name] = id;
+        markUsed(id);
+    }
+
+    /* Removes a name from the table, marking its id as available again. */
+    void erase(const std::string &name)
+    {
+        auto it = ids.find(name);
+        if (it == ids.end()) return;
+        markFree(it->second);
+        ids.erase(it);
+    }
+
+    /* Marks an id as unavailable without associating a name with it. */
+    void markUsed(uint32_t id)
+    {
+        if (id >= numSlots) return;
+        size_t word = id / 64;
+        slotBits[word] &= ~(uint64_t(1) << (id % 64));
+        if (slotBits[word] == 0) clearWordBit(word);
+    }
+
+    /* Marks an id as available. */
+    void markFree(uint32_t id)
+    {
+        if (id >= numSlots) return;
+        size_t word = id / 64;
+        slotBits[word] |= (uint64_t(1) << (id % 64));
+        wordBits[word / 64] |= (uint64_t(1) << (word % 64));
+    }
+
+    /* Returns an ordered copy of the name to id table. */
+    std::map<std::string, uint32_t> toMap() const
+    {
+        return std::map<std::string, uint32_t>(ids.begin(), ids.end());
+    }
+
+    private:
+
+    static uint32_t countTrailingZeros(uint64_t bits)
+    {
+        #ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return (uint32_t) index;
+        #else
+        return (uint32_t) __builtin_ctzll(bits);
+        #endif
+    }
+
+    void clearWordBit(size_t word)
+    {
+        wordBits[word / 64] &= ~(uint64_t(1) << (word % 64));
+    }
+
+    /* The name to id index */
+    std::unordered_map<std::string, uint32_t> ids;
+
+    /* One bit per id, set if that id is available */
+    std::vector<uint64_t> slotBits;
+
+    /* One bit per word of slotBits, set if that word has any available ids */
+    std::vector<uint64_t> wordBits;
+
+    size_t numSlots = 0;
+};
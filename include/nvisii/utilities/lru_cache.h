@@ -0,0 +1,82 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <utility>
+
+/*
+ * A small least recently used cache. Keys only need operator==, and lookups are a linear
+ * scan, so this is intended for caches of at most a few dozen entries whose values are 
+ * expensive to produce. A capacity of 0 disables caching.
+ */
+template<typename Key, typename Value>
+class LRUCache {
+    public:
+
+    LRUCache(size_t capacity = 0) : maxSize(capacity) {}
+
+    /* Returns the value for the given key and marks it most recently used, or nullptr if missing. */
+    const Value* find(const Key &key)
+    {
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (!(it->first == key)) continue;
+            entries.splice(entries.begin(), entries, it);
+            return &entries.front().second;
+        }
+        return nullptr;
+    }
+
+    /* Adds or replaces the value for the given key, evicting the least recently used entries if full. */
+    void insert(const Key &key, Value value)
+    {
+        if (maxSize == 0) return;
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (!(it->first == key)) continue;
+            entries.erase(it);
+            break;
+        }
+        entries.emplace_front(key, std::move(value));
+        trim();
+    }
+
+    /* Changes the maximum number of entries, evicting the least recently used entries if needed. */
+    void setCapacity(size_t capacity)
+    {
+        maxSize = capacity;
+        trim();
+    }
+
+    size_t capacity() const { return maxSize; }
+
+    size_t size() const { return entries.size(); }
+
+    void clear() { entries.clear(); }
+
+    private:
+
+    void trim()
+    {
+        while (entries.size() > maxSize) entries.pop_back();
+    }
+
+    /* Entries ordered from most to least recently used */
+    std::list<std::pair<Key, Value>> entries;
+
+    size_t maxSize;
+};
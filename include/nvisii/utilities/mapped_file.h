@@ -0,0 +1,115 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * A read only memory mapping of an entire file. Pages are loaded on demand by the OS, so
+ * large files can be read from many threads without first copying them into memory.
+ * The description is used in error messages, eg "scene snapshot". Empty files can't be 
+ * mapped, so they give an empty mapping instead, whose data() is nullptr.
+ */
+class MappedFile {
+    public:
+
+    MappedFile(const std::string &path, const std::string &description)
+    {
+        #ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Error: unable to open " + description + " \"" + path + "\"");
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            close();
+            throw std::runtime_error("Error: unable to open " + description + " \"" + path + "\"");
+        }
+        bytesSize = uint64_t(fileSize.QuadPart);
+        if (bytesSize > 0) mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) bytes = (const uint8_t*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        #else
+        descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) throw std::runtime_error("Error: unable to open " + description + " \"" + path + "\"");
+        struct stat info;
+        if (fstat(descriptor, &info) != 0) {
+            close();
+            throw std::runtime_error("Error: unable to open " + description + " \"" + path + "\"");
+        }
+        bytesSize = uint64_t(info.st_size);
+        if (bytesSize > 0) {
+            void* mapped = mmap(nullptr, size_t(bytesSize), PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapped != MAP_FAILED) bytes = (const uint8_t*) mapped;
+        }
+        #endif
+        if ((bytesSize > 0) && !bytes) {
+            close();
+            throw std::runtime_error("Error: unable to map " + description + " \"" + path + "\"");
+        }
+    }
+
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return bytes; }
+    uint64_t size() const { return bytesSize; }
+
+    private:
+
+    void close()
+    {
+        #ifdef _WIN32
+        if (bytes) UnmapViewOfFile(bytes);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+        #else
+        if (bytes) munmap((void*) bytes, size_t(bytesSize));
+        if (descriptor >= 0) ::close(descriptor);
+        descriptor = -1;
+        #endif
+        bytes = nullptr;
+    }
+
+    const uint8_t* bytes = nullptr;
+    uint64_t bytesSize = 0;
+    #ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+    #else
+    int descriptor = -1;
+    #endif
+};
@@ -0,0 +1,881 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <nvisii/utilities/mapped_file.h>
+#include <nvisii/utilities/parallel.h>
+
+/*
+ * Native readers for OBJ and PLY meshes.
+ *
+ * Assimp parses on a single thread and builds its own copy of every mesh before we convert it, 
+ * which dominates load times for large scans. These readers memory map the file and write 
+ * straight into the per vertex buffers of a mesh component, parsing OBJ files in parallel 
+ * chunks and reading binary PLY vertices directly by type. Only geometry is read, so they are 
+ * used for Mesh::createFromFile, while importScene still goes through assimp for materials.
+ */
+namespace MeshReaders {
+
+    /* Geometry in the layout of the mesh component. Normals are left empty if the file has none. */
+    struct MeshData {
+        std::vector<std::array<float, 3>> positions;
+        std::vector<glm::vec4> normals;
+        std::vector<glm::vec4> colors;
+        std::vector<glm::vec2> texCoords;
+        std::vector<uint32_t> triangleIndices;
+    };
+
+    static const uint32_t MISSING_INDEX = 0xFFFFFFFF;
+
+    /* Rows of an ASCII PLY element are parsed in blocks of this many rows, one block per task */
+    static const size_t TEXT_BLOCK_ROWS = 4096;
+
+    inline const char* skipSpaces(const char* p, const char* end)
+    {
+        while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r'))) ++p;
+        return p;
+    }
+
+    /* Like skipSpaces, but also skips line breaks */
+    inline const char* skipWhitespace(const char* p, const char* end)
+    {
+        while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n'))) ++p;
+        return p;
+    }
+
+    inline const char* skipLine(const char* p, const char* end)
+    {
+        const void* newline = memchr(p, '\n', size_t(end - p));
+        return (newline) ? (const char*) newline + 1 : end;
+    }
+
+    inline bool isDigit(char c) { return unsigned(c - '0') < 10u; }
+
+    /* 
+     * Parses a decimal floating point number and advances p past it. Accumulates up to 18 
+     * significant digits in an integer and scales once by a power of ten, which is several 
+     * times faster than strtod and exact to within float precision. Anything unusual 
+     * (eg nan or inf) falls back to strtod. Returns false if there was no number.
+     */
+    inline bool parseFloat(const char* &p, const char* end, float &out)
+    {
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        const char* s = p;
+        bool negative = false;
+        if ((s < end) && ((*s == '-') || (*s == '+'))) negative = (*s++ == '-');
+
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        bool any = false;
+        for (; (s < end) && isDigit(*s); ++s, any = true) {
+            if (mantissa < 100000000000000000ull) mantissa = mantissa * 10 + uint64_t(*s - '0');
+            else exponent++;
+        }
+        if ((s < end) && (*s == '.')) {
+            for (++s; (s < end) && isDigit(*s); ++s, any = true) {
+                if (mantissa < 100000000000000000ull) { mantissa = mantissa * 10 + uint64_t(*s - '0'); exponent--; }
+            }
+        }
+        if (!any) {
+            if ((p >= end) || isspace((unsigned char) *p)) return false;
+            char buffer[64];
+            size_t length = std::min(size_t(end - p), sizeof(buffer) - 1);
+            memcpy(buffer, p, length);
+            buffer[length] = '\0';
+            char* parsed = nullptr;
+            double value = strtod(buffer, &parsed);
+            if (parsed == buffer) return false;
+            p += (parsed - buffer);
+            out = float(value);
+            return true;
+        }
+        if ((s + 1 < end) && ((*s == 'e') || (*s == 'E'))) {
+            const char* e = s + 1;
+            bool negativeExponent = false;
+            if ((*e == '-') || (*e == '+')) negativeExponent = (*e++ == '-');
+            if ((e < end) && isDigit(*e)) {
+                int value = 0;
+                for (; (e < end) && isDigit(*e); ++e) if (value < 10000) value = value * 10 + (*e - '0');
+                exponent += (negativeExponent) ? -value : value;
+                s = e;
+            }
+        }
+
+        double value = double(mantissa);
+        if (mantissa != 0) {
+            if ((exponent >= 0) && (exponent <= 22)) value *= powers[exponent];
+            else if ((exponent < 0) && (exponent >= -22)) value /= powers[-exponent];
+            else value *= std::pow(10.0, double(exponent));
+        }
+        out = float((negative) ? -value : value);
+        p = s;
+        return true;
+    }
+
+    /* Parses a decimal integer and advances p past it. Returns false if there was no number. */
+    inline bool parseInt(const char* &p, const char* end, int64_t &out)
+    {
+        const char* s = p;
+        bool negative = false;
+        if ((s < end) && ((*s == '-') || (*s == '+'))) negative = (*s++ == '-');
+        if ((s >= end) || !isDigit(*s)) return false;
+        int64_t value = 0;
+        for (; (s < end) && isDigit(*s); ++s) value = value * 10 + (*s - '0');
+        out = (negative) ? -value : value;
+        p = s;
+        return true;
+    }
+
+    /* Returns true if the path has the given extension, ignoring case. Extension includes the dot. */
+    inline bool hasExtension(const std::string &path, const char* extension)
+    {
+        size_t length = strlen(extension);
+        if (path.size() < length) return false;
+        for (size_t i = 0; i < length; ++i) {
+            if (tolower((unsigned char) path[path.size() - length + i]) != extension[i]) return false;
+        }
+        return true;
+    }
+
+    /* Reads an OBJ file. v, vt, vn and f statements are used, everything else is skipped. */
+    class ObjReader {
+        public:
+
+        static void read(const std::string &path, MeshData &mesh)
+        {
+            MappedFile file(path, "OBJ file");
+            if (file.size() == 0) throw std::runtime_error("Error: \"" + path + "\" is empty");
+            const char* begin = (const char*) file.data();
+            const char* end = begin + file.size();
+
+            // Split the file into chunks of whole lines, a few per thread so that the work balances
+            size_t numChunks = std::max(size_t(1), std::min(Parallel::getNumThreads() * 4, size_t(file.size() >> 16)));
+            std::vector<Chunk> chunks(numChunks);
+            const char* chunkBegin = begin;
+            for (size_t c = 0; c < numChunks; ++c) {
+                const char* chunkEnd = (c + 1 == numChunks) ? end : 
+                    skipLine(std::max(chunkBegin, begin + file.size() * (c + 1) / numChunks), end);
+                chunks[c].begin = chunkBegin;
+                chunks[c].end = chunkEnd;
+                chunkBegin = chunkEnd;
+            }
+
+            // Count statements first, so that every chunk knows where its data goes, 
+            // and can resolve relative indices while parsing.
+            Parallel::forEachDynamic(numChunks, 0, [&] (size_t c) { count(chunks[c]); });
+            Chunk total;
+            for (auto &chunk : chunks) {
+                chunk.positionOffset = total.positions; total.positions += chunk.positions;
+                chunk.texCoordOffset = total.texCoords; total.texCoords += chunk.texCoords;
+                chunk.normalOffset = total.normals; total.normals += chunk.normals;
+                chunk.triangleOffset = total.triangles; total.triangles += chunk.triangles;
+            }
+            if (total.positions >= MISSING_INDEX) throw std::runtime_error("Error: \"" + path + "\" has too many vertices");
+
+            Buffers buffers;
+            buffers.positions = &mesh.positions;
+            buffers.totals = total;
+            mesh.positions.resize(total.positions);
+            buffers.texCoords.resize(total.texCoords);
+            buffers.normals.resize(total.normals);
+            buffers.corners.resize(total.triangles * 3);
+            Parallel::forEachDynamic(numChunks, 0, [&] (size_t c) { parse(chunks[c], buffers, path); });
+
+            buildVertices(buffers, mesh);
+        }
+
+        private:
+
+        struct Chunk {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            size_t positions = 0, texCoords = 0, normals = 0, triangles = 0;
+            size_t positionOffset = 0, texCoordOffset = 0, normalOffset = 0, triangleOffset = 0;
+        };
+
+        /* The position, texcoord and normal index of one face corner */
+        struct Corner {
+            uint32_t position, texCoord, normal;
+        };
+
+        struct Buffers {
+            Chunk totals;
+            std::vector<std::array<float, 3>>* positions;
+            std::vector<glm::vec2> texCoords;
+            std::vector<glm::vec4> normals;
+            std::vector<Corner> corners;
+        };
+
+        enum Statement { OTHER, POSITION, TEXCOORD, NORMAL, FACE };
+
+        /* Reads the keyword at the start of a line, and advances p past it */
+        static Statement readStatement(const char* &p, const char* end)
+        {
+            p = skipSpaces(p, end);
+            if ((p >= end) || (*p == '#')) return OTHER;
+            if ((p[0] == 'v') && (p + 1 < end)) {
+                if ((p[1] == ' ') || (p[1] == '\t')) { p += 1; return POSITION; }
+                if ((p + 2 < end) && ((p[2] == ' ') || (p[2] == '\t'))) {
+                    if (p[1] == 't') { p += 2; return TEXCOORD; }
+                    if (p[1] == 'n') { p += 2; return NORMAL; }
+                }
+                return OTHER;
+            }
+            if ((p[0] == 'f') && (p + 1 < end) && ((p[1] == ' ') || (p[1] == '\t'))) { p += 1; return FACE; }
+            return OTHER;
+        }
+
+        static void count(Chunk &chunk)
+        {
+            for (const char* p = chunk.begin; p < chunk.end; ) {
+                Statement statement = readStatement(p, chunk.end);
+                if (statement == POSITION) chunk.positions++;
+                else if (statement == TEXCOORD) chunk.texCoords++;
+                else if (statement == NORMAL) chunk.normals++;
+                else if (statement == FACE) {
+                    // a polygon with n corners is split into n - 2 triangles
+                    size_t corners = 0;
+                    for (p = skipSpaces(p, chunk.end); (p < chunk.end) && (*p != '\n') && (*p != '#'); p = skipSpaces(p, chunk.end)) {
+                        corners++;
+                        while ((p < chunk.end) && (*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != '\n')) ++p;
+                    }
+                    if (corners >= 3) chunk.triangles += corners - 2;
+                }
+                p = skipLine(p, chunk.end);
+            }
+        }
+
+        /* Converts a one based, or negative relative, OBJ index into a zero based index */
+        static uint32_t resolveIndex(int64_t index, size_t countSoFar, size_t total, const std::string &path)
+        {
+            int64_t resolved = (index > 0) ? index - 1 : int64_t(countSoFar) + index;
+            if ((index == 0) || (resolved < 0) || (resolved >= int64_t(total)))
+                throw std::runtime_error("Error: \"" + path + "\" invalid mesh index detected!");
+            return uint32_t(resolved);
+        }
+
+        static void parse(const Chunk &chunk, Buffers &buffers, const std::string &path)
+        {
+            size_t positions = chunk.positionOffset;
+            size_t texCoords = chunk.texCoordOffset;
+            size_t normals = chunk.normalOffset;
+            Corner* corners = buffers.corners.data() + chunk.triangleOffset * 3;
+            auto error = [&path] () { return std::runtime_error("Error: \"" + path + "\" could not be parsed"); };
+
+            for (const char* p = chunk.begin; p < chunk.end; p = skipLine(p, chunk.end)) {
+                Statement statement = readStatement(p, chunk.end);
+                if (statement == POSITION) {
+                    auto &position = (*buffers.positions)[positions++];
+                    for (int i = 0; i < 3; ++i) {
+                        p = skipSpaces(p, chunk.end);
+                        if (!parseFloat(p, chunk.end, position[i])) throw error();
+                    }
+                }
+                else if (statement == TEXCOORD) {
+                    glm::vec2 &texCoord = buffers.texCoords[texCoords++];
+                    p = skipSpaces(p, chunk.end);
+                    if (!parseFloat(p, chunk.end, texCoord.x)) throw error();
+                    p = skipSpaces(p, chunk.end);
+                    if (!parseFloat(p, chunk.end, texCoord.y)) texCoord.y = 0.f;
+                }
+                else if (statement == NORMAL) {
+                    glm::vec4 &normal = buffers.normals[normals++];
+                    normal.w = 0.f;
+                    for (int i = 0; i < 3; ++i) {
+                        p = skipSpaces(p, chunk.end);
+                        if (!parseFloat(p, chunk.end, normal[i])) throw error();
+                    }
+                }
+                else if (statement == FACE) {
+                    // triangulate polygons as a fan around their first corner
+                    Corner first = {MISSING_INDEX, MISSING_INDEX, MISSING_INDEX}, previous = first;
+                    size_t numCorners = 0;
+                    for (p = skipSpaces(p, chunk.end); (p < chunk.end) && (*p != '\n') && (*p != '#'); p = skipSpaces(p, chunk.end)) {
+                        int64_t index;
+                        Corner corner = {MISSING_INDEX, MISSING_INDEX, MISSING_INDEX};
+                        if (!parseInt(p, chunk.end, index)) throw error();
+                        corner.position = resolveIndex(index, positions, buffers.totals.positions, path);
+                        if ((p < chunk.end) && (*p == '/')) {
+                            ++p;
+                            if (parseInt(p, chunk.end, index)) corner.texCoord = resolveIndex(index, texCoords, buffers.totals.texCoords, path);
+                            if ((p < chunk.end) && (*p == '/')) {
+                                ++p;
+                                if (parseInt(p, chunk.end, index)) corner.normal = resolveIndex(index, normals, buffers.totals.normals, path);
+                            }
+                        }
+                        if (numCorners == 0) first = corner;
+                        else if (numCorners >= 2) {
+                            corners[0] = first;
+                            corners[1] = previous;
+                            corners[2] = corner;
+                            corners += 3;
+                        }
+                        previous = corner;
+                        numCorners++;
+                        while ((p < chunk.end) && (*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != '\n')) ++p;
+                    }
+                }
+            }
+        }
+
+        /* 
+         * OBJ indexes positions, texcoords and normals separately, while meshes need a single 
+         * index per vertex. Each position becomes a vertex using the texcoord and normal of its 
+         * first corner, and only corners which combine it with a different texcoord or normal 
+         * add new vertices. For most files, that means no vertices are added at all.
+         */
+        static void buildVertices(Buffers &buffers, MeshData &mesh)
+        {
+            struct CornerHash {
+                size_t operator()(const Corner &c) const {
+                    return size_t(c.position) * 73856093u ^ size_t(c.texCoord) * 19349663u ^ size_t(c.normal) * 83492791u;
+                }
+            };
+            struct CornerEqual {
+                bool operator()(const Corner &a, const Corner &b) const {
+                    return (a.position == b.position) && (a.texCoord == b.texCoord) && (a.normal == b.normal);
+                }
+            };
+
+            size_t numPositions = mesh.positions.size();
+            std::vector<Corner> vertices(numPositions, Corner{MISSING_INDEX, MISSING_INDEX, MISSING_INDEX});
+            std::vector<bool> claimed(numPositions, false);
+            std::unordered_map<Corner, uint32_t, CornerHash, CornerEqual> added;
+            mesh.triangleIndices.resize(buffers.corners.size());
+            for (size_t i = 0; i < buffers.corners.size(); ++i) {
+                const Corner &corner = buffers.corners[i];
+                uint32_t p = corner.position;
+                if (!claimed[p]) {
+                    claimed[p] = true;
+                    vertices[p] = corner;
+                    mesh.triangleIndices[i] = p;
+                }
+                else if (CornerEqual()(vertices[p], corner)) {
+                    mesh.triangleIndices[i] = p;
+                }
+                else {
+                    auto it = added.insert({corner, uint32_t(vertices.size())});
+                    if (it.second) vertices.push_back(corner);
+                    mesh.triangleIndices[i] = it.first->second;
+                }
+            }
+            std::vector<Corner>().swap(buffers.corners);
+
+            size_t numVertices = vertices.size();
+            if (numVertices >= MISSING_INDEX) throw std::runtime_error("Error: OBJ file has too many vertices");
+            mesh.positions.resize(numVertices);
+            mesh.texCoords.resize(numVertices);
+            if (!buffers.normals.empty()) mesh.normals.resize(numVertices);
+            Parallel::forEach(0, numVertices, 1 << 14, [&] (size_t v) {
+                const Corner &corner = vertices[v];
+                if (v >= numPositions) mesh.positions[v] = mesh.positions[corner.position];
+                mesh.texCoords[v] = (corner.texCoord != MISSING_INDEX) ? buffers.texCoords[corner.texCoord] : glm::vec2(0.f);
+                if (!buffers.normals.empty())
+                    mesh.normals[v] = (corner.normal != MISSING_INDEX) ? buffers.normals[corner.normal] : glm::vec4(0.f);
+            });
+        }
+    };
+
+    /* Reads ASCII, binary little endian and binary big endian PLY files. */
+    class PlyReader {
+        public:
+
+        static void read(const std::string &path, MeshData &mesh)
+        {
+            MappedFile file(path, "PLY file");
+            if (file.size() == 0) throw std::runtime_error("Error: \"" + path + "\" is empty");
+            const char* p = (const char*) file.data();
+            const char* end = p + file.size();
+            Format format;
+            std::vector<Element> elements = readHeader(p, end, format, path);
+
+            for (auto &element : elements) {
+                if (element.name == "vertex") {
+                    p = readVertices(element, p, end, format, mesh, path);
+                }
+                else if (element.name == "face") {
+                    p = readFaces(element, p, end, format, mesh, path);
+                }
+                else {
+                    p = skipElement(element, p, end, format, path);
+                }
+            }
+
+            for (auto &index : mesh.triangleIndices) {
+                if (index >= mesh.positions.size())
+                    throw std::runtime_error("Error: \"" + path + "\" invalid mesh index detected!");
+            }
+        }
+
+        private:
+
+        enum Format { ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN };
+        enum Type { INVALID, INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+
+        /* Where a vertex property is written to in the mesh. Colors are scaled to [0, 1] if stored as integers. */
+        enum Target { NONE, POSITION_X, POSITION_Y, POSITION_Z, NORMAL_X, NORMAL_Y, NORMAL_Z, 
+            TEXCOORD_U, TEXCOORD_V, COLOR_R, COLOR_G, COLOR_B, COLOR_A };
+
+        struct Property {
+            std::string name;
+            Type type = INVALID;
+            Type countType = INVALID;  // only set for lists
+            Target target = NONE;
+            size_t offset = 0;         // offset into a fixed size binary row
+        };
+
+        struct Element {
+            std::string name;
+            size_t count = 0;
+            std::vector<Property> properties;
+            bool hasLists = false;
+            size_t stride = 0;         // size of a binary row, if the element has no lists
+        };
+
+        static Type parseType(const std::string &name)
+        {
+            if ((name == "char") || (name == "int8")) return INT8;
+            if ((name == "uchar") || (name == "uint8")) return UINT8;
+            if ((name == "short") || (name == "int16")) return INT16;
+            if ((name == "ushort") || (name == "uint16")) return UINT16;
+            if ((name == "int") || (name == "int32")) return INT32;
+            if ((name == "uint") || (name == "uint32")) return UINT32;
+            if ((name == "float") || (name == "float32")) return FLOAT32;
+            if ((name == "double") || (name == "float64")) return FLOAT64;
+            return INVALID;
+        }
+
+        static size_t typeSize(Type type)
+        {
+            switch (type) {
+                case INT8: case UINT8: return 1;
+                case INT16: case UINT16: return 2;
+                case INT32: case UINT32: case FLOAT32: return 4;
+                case FLOAT64: return 8;
+                default: return 0;
+            }
+        }
+
+        static Target parseTarget(const std::string &name)
+        {
+            if (name == "x") return POSITION_X;
+            if (name == "y") return POSITION_Y;
+            if (name == "z") return POSITION_Z;
+            if (name == "nx") return NORMAL_X;
+            if (name == "ny") return NORMAL_Y;
+            if (name == "nz") return NORMAL_Z;
+            if ((name == "u") || (name == "s") || (name == "texture_u") || (name == "texture_s")) return TEXCOORD_U;
+            if ((name == "v") || (name == "t") || (name == "texture_v") || (name == "texture_t")) return TEXCOORD_V;
+            if ((name == "red") || (name == "r") || (name == "diffuse_red")) return COLOR_R;
+            if ((name == "green") || (name == "g") || (name == "diffuse_green")) return COLOR_G;
+            if ((name == "blue") || (name == "b") || (name == "diffuse_blue")) return COLOR_B;
+            if ((name == "alpha") || (name == "a")) return COLOR_A;
+            return NONE;
+        }
+
+        /* Splits one header line into whitespace separated words and advances p to the next line */
+        static std::vector<std::string> readHeaderLine(const char* &p, const char* end)
+        {
+            std::vector<std::string> words;
+            const char* lineEnd = (const char*) memchr(p, '\n', size_t(end - p));
+            if (!lineEnd) lineEnd = end;
+            while (p < lineEnd) {
+                p = skipSpaces(p, lineEnd);
+                const char* word = p;
+                while ((p < lineEnd) && (*p != ' ') && (*p != '\t') && (*p != '\r')) ++p;
+                if (p > word) words.push_back(std::string(word, p));
+            }
+            p = (lineEnd < end) ? lineEnd + 1 : end;
+            return words;
+        }
+
+        static std::vector<Element> readHeader(const char* &p, const char* end, Format &format, const std::string &path)
+        {
+            auto error = [&path] (const std::string &reason) { 
+                return std::runtime_error("Error: \"" + path + "\" has an invalid PLY header, " + reason); 
+            };
+            std::vector<std::string> words = readHeaderLine(p, end);
+            if ((words.size() != 1) || (words[0] != "ply")) throw error("missing \"ply\"");
+
+            std::vector<Element> elements;
+            bool hasFormat = false;
+            while (true) {
+                if (p >= end) throw error("missing \"end_header\"");
+                words = readHeaderLine(p, end);
+                if (words.empty() || (words[0] == "comment") || (words[0] == "obj_info")) continue;
+                if (words[0] == "end_header") break;
+                if (words[0] == "format") {
+                    if (words.size() < 2) throw error("bad format");
+                    if (words[1] == "ascii") format = ASCII;
+                    else if (words[1] == "binary_little_endian") format = BINARY_LITTLE_ENDIAN;
+                    else if (words[1] == "binary_big_endian") format = BINARY_BIG_ENDIAN;
+                    else throw error("unknown format \"" + words[1] + "\"");
+                    hasFormat = true;
+                }
+                else if (words[0] == "element") {
+                    if (words.size() < 3) throw error("bad element");
+                    Element element;
+                    element.name = words[1];
+                    element.count = size_t(std::stoull(words[2]));
+                    elements.push_back(element);
+                }
+                else if (words[0] == "property") {
+                    if (elements.empty()) throw error("property before element");
+                    Element &element = elements.back();
+                    Property property;
+                    if ((words.size() == 5) && (words[1] == "list")) {
+                        property.countType = parseType(words[2]);
+                        property.type = parseType(words[3]);
+                        property.name = words[4];
+                        if (property.countType == INVALID) throw error("unknown type \"" + words[2] + "\"");
+                        element.hasLists = true;
+                    }
+                    else if (words.size() == 3) {
+                        property.type = parseType(words[1]);
+                        property.name = words[2];
+                        property.offset = element.stride;
+                        element.stride += typeSize(property.type);
+                    }
+                    else throw error("bad property");
+                    if (property.type == INVALID) throw error("unknown type for property \"" + property.name + "\"");
+                    property.target = parseTarget(property.name);
+                    element.properties.push_back(property);
+                }
+                else throw error("unknown keyword \"" + words[0] + "\"");
+            }
+            if (!hasFormat) throw error("missing format");
+            return elements;
+        }
+
+        static bool hostIsLittleEndian()
+        {
+            uint16_t value = 1;
+            uint8_t firstByte;
+            memcpy(&firstByte, &value, 1);
+            return firstByte == 1;
+        }
+
+        /* Reads one binary value of the given type, swapping bytes if the file's byte order differs from ours */
+        static double readBinary(const uint8_t* data, Type type, bool swap)
+        {
+            uint8_t bytes[8];
+            size_t size = typeSize(type);
+            if (swap) for (size_t i = 0; i < size; ++i) bytes[i] = data[size - 1 - i];
+            else memcpy(bytes, data, size);
+            switch (type) {
+                case INT8: { int8_t v; memcpy(&v, bytes, 1); return double(v); }
+                case UINT8: { uint8_t v; memcpy(&v, bytes, 1); return double(v); }
+                case INT16: { int16_t v; memcpy(&v, bytes, 2); return double(v); }
+                case UINT16: { uint16_t v; memcpy(&v, bytes, 2); return double(v); }
+                case INT32: { int32_t v; memcpy(&v, bytes, 4); return double(v); }
+                case UINT32: { uint32_t v; memcpy(&v, bytes, 4); return double(v); }
+                case FLOAT32: { float v; memcpy(&v, bytes, 4); return double(v); }
+                case FLOAT64: { double v; memcpy(&v, bytes, 8); return v; }
+                default: return 0.0;
+            }
+        }
+
+        /* 
+         * The body of an ASCII PLY file is a stream of whitespace separated values. Rows usually 
+         * end with a line break, but they may also wrap over several lines or share one, so values 
+         * are read without regard to lines.
+         */
+
+        /* Skips whitespace and returns the start of the next value, throwing if the file ends first */
+        static const char* nextAsciiValue(const char* p, const char* end, const std::string &path)
+        {
+            p = skipWhitespace(p, end);
+            if (p >= end) throw std::runtime_error("Error: \"" + path + "\" is truncated");
+            return p;
+        }
+
+        /* Reads one ASCII value and advances p past it */
+        static double readAscii(const char* &p, const char* end, const std::string &path)
+        {
+            float value;
+            p = nextAsciiValue(p, end, path);
+            if (!parseFloat(p, end, value)) throw std::runtime_error("Error: \"" + path + "\" could not be parsed");
+            return double(value);
+        }
+
+        /* Reads one ASCII list count or index, which may not fit in a float, and advances p past it */
+        static int64_t readAsciiInt(const char* &p, const char* end, const std::string &path)
+        {
+            int64_t value;
+            p = nextAsciiValue(p, end, path);
+            if (!parseInt(p, end, value)) throw std::runtime_error("Error: \"" + path + "\" could not be parsed");
+            return value;
+        }
+
+        /* 
+         * Finds the start of every TEXT_BLOCK_ROWS'th row of an ASCII element, so that blocks of rows 
+         * can be parsed in parallel, and returns the end of the element. Since rows aren't tied to lines, 
+         * this walks every value, but only list counts are parsed.
+         */
+        static const char* findAsciiRowBlocks(const Element &element, const char* p, const char* end, 
+            std::vector<const char*> &blocks, const std::string &path)
+        {
+            blocks.clear();
+            blocks.reserve(element.count / TEXT_BLOCK_ROWS + 1);
+            for (size_t row = 0; row < element.count; ++row) {
+                if ((row % TEXT_BLOCK_ROWS) == 0) blocks.push_back(p);
+                for (auto &property : element.properties) {
+                    int64_t items = 1;
+                    if (property.countType != INVALID) {
+                        items = readAsciiInt(p, end, path);
+                        if (items < 0) throw std::runtime_error("Error: \"" + path + "\" could not be parsed");
+                    }
+                    for (int64_t i = 0; i < items; ++i) {
+                        p = nextAsciiValue(p, end, path);
+                        while ((p < end) && (*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != '\n')) ++p;
+                    }
+                }
+            }
+            return p;
+        }
+
+        static void writeTarget(MeshData &mesh, size_t v, Target target, Type type, double value)
+        {
+            float scale = ((type == UINT8) && (target >= COLOR_R)) ? (1.f / 255.f) : 
+                          ((type == UINT16) && (target >= COLOR_R)) ? (1.f / 65535.f) : 1.f;
+            float f = float(value) * scale;
+            switch (target) {
+                case POSITION_X: mesh.positions[v][0] = f; break;
+                case POSITION_Y: mesh.positions[v][1] = f; break;
+                case POSITION_Z: mesh.positions[v][2] = f; break;
+                case NORMAL_X: mesh.normals[v].x = f; break;
+                case NORMAL_Y: mesh.normals[v].y = f; break;
+                case NORMAL_Z: mesh.normals[v].z = f; break;
+                case TEXCOORD_U: mesh.texCoords[v].x = f; break;
+                case TEXCOORD_V: mesh.texCoords[v].y = f; break;
+                case COLOR_R: mesh.colors[v].r = f; break;
+                case COLOR_G: mesh.colors[v].g = f; break;
+                case COLOR_B: mesh.colors[v].b = f; break;
+                case COLOR_A: mesh.colors[v].a = f; break;
+                default: break;
+            }
+        }
+
+        static const char* readVertices(const Element &element, const char* p, const char* end, Format format, MeshData &mesh, const std::string &path)
+        {
+            bool hasNormals = false, hasColors = false;
+            for (auto &property : element.properties) {
+                if ((property.target >= NORMAL_X) && (property.target <= NORMAL_Z)) hasNormals = true;
+                if (property.target >= COLOR_R) hasColors = true;
+            }
+            size_t count = element.count;
+            mesh.positions.assign(count, {0.f, 0.f, 0.f});
+            mesh.texCoords.assign(count, glm::vec2(0.f));
+            if (hasNormals) mesh.normals.assign(count, glm::vec4(0.f));
+            if (hasColors) mesh.colors.assign(count, glm::vec4(0.f, 0.f, 0.f, 1.f));
+
+            if (format == ASCII) {
+                std::vector<const char*> blocks;
+                const char* next = findAsciiRowBlocks(element, p, end, blocks, path);
+                Parallel::forEachDynamic(blocks.size(), 0, [&] (size_t b) {
+                    const char* row = blocks[b];
+                    size_t last = std::min(count, (b + 1) * TEXT_BLOCK_ROWS);
+                    for (size_t v = b * TEXT_BLOCK_ROWS; v < last; ++v) {
+                        for (auto &property : element.properties) {
+                            if (property.countType != INVALID) {
+                                size_t items = size_t(readAsciiInt(row, end, path));
+                                for (size_t i = 0; i < items; ++i) readAscii(row, end, path);
+                                continue;
+                            }
+                            double value = readAscii(row, end, path);
+                            if (property.target != NONE) writeTarget(mesh, v, property.target, property.type, value);
+                        }
+                    }
+                });
+                return next;
+            }
+
+            bool swap = (format == BINARY_LITTLE_ENDIAN) != hostIsLittleEndian();
+            if (element.hasLists) {
+                // rows have different sizes, so they can't be split between threads without a scan
+                const uint8_t* row = (const uint8_t*) p;
+                for (size_t v = 0; v < count; ++v) {
+                    for (auto &property : element.properties) {
+                        row = readBinaryProperty(row, (const uint8_t*) end, property, swap, path, [&] (double value) {
+                            writeTarget(mesh, v, property.target, property.type, value);
+                        });
+                    }
+                }
+                return (const char*) row;
+            }
+
+            // Every row has the same size, so each property can be read in parallel directly by offset
+            const uint8_t* rows = (const uint8_t*) p;
+            if (uint64_t(end - p) / std::max(element.stride, size_t(1)) < count) 
+                throw std::runtime_error("Error: \"" + path + "\" is truncated");
+            Parallel::forEach(0, count, 1 << 14, [&] (size_t v) {
+                const uint8_t* row = rows + v * element.stride;
+                for (auto &property : element.properties) {
+                    if (property.target == NONE) continue;
+                    writeTarget(mesh, v, property.target, property.type, readBinary(row + property.offset, property.type, swap));
+                }
+            });
+            return (const char*) (rows + count * element.stride);
+        }
+
+        /* Reads a binary scalar or list property, calling function(value) for each value that has a target */
+        template<typename Function>
+        static const uint8_t* readBinaryProperty(const uint8_t* row, const uint8_t* end, const Property &property, 
+            bool swap, const std::string &path, Function &&function)
+        {
+            auto truncated = [&path] () { return std::runtime_error("Error: \"" + path + "\" is truncated"); };
+            if (property.countType != INVALID) {
+                if (row + typeSize(property.countType) > end) throw truncated();
+                size_t items = size_t(readBinary(row, property.countType, swap));
+                row += typeSize(property.countType);
+                if (uint64_t(end - row) / typeSize(property.type) < items) throw truncated();
+                return row + items * typeSize(property.type);
+            }
+            if (row + typeSize(property.type) > end) throw truncated();
+            if (property.target != NONE) function(readBinary(row, property.type, swap));
+            return row + typeSize(property.type);
+        }
+
+        static bool isIndexList(const Property &property)
+        {
+            return (property.countType != INVALID) && ((property.name == "vertex_indices") || (property.name == "vertex_index"));
+        }
+
+        static const char* readFaces(const Element &element, const char* p, const char* end, Format format, MeshData &mesh, const std::string &path)
+        {
+            size_t count = element.count;
+            if (format == ASCII) {
+                // count the triangles of every face first, so that faces can be written in parallel
+                std::vector<const char*> blocks;
+                const char* next = findAsciiRowBlocks(element, p, end, blocks, path);
+                std::vector<size_t> blockTriangles(blocks.size() + 1, 0);
+                auto forEachFace = [&] (size_t b, bool write) {
+                    const char* row = blocks[b];
+                    size_t last = std::min(count, (b + 1) * TEXT_BLOCK_ROWS);
+                    uint32_t* out = (write) ? mesh.triangleIndices.data() + blockTriangles[b] * 3 : nullptr;
+                    size_t triangles = 0;
+                    for (size_t f = b * TEXT_BLOCK_ROWS; f < last; ++f) {
+                        for (auto &property : element.properties) {
+                            if (property.countType == INVALID) { readAscii(row, end, path); continue; }
+                            size_t items = size_t(readAsciiInt(row, end, path));
+                            bool indices = isIndexList(property);
+                            if (indices && (items >= 3)) triangles += items - 2;
+                            if (!indices || !write) {
+                                for (size_t i = 0; i < items; ++i) readAscii(row, end, path);
+                                continue;
+                            }
+                            uint32_t first = 0, previous = 0;
+                            for (size_t i = 0; i < items; ++i) {
+                                uint32_t index = uint32_t(readAsciiInt(row, end, path));
+                                if (i == 0) first = index;
+                                else if (i >= 2) { out[0] = first; out[1] = previous; out[2] = index; out += 3; }
+                                previous = index;
+                            }
+                        }
+                    }
+                    return triangles;
+                };
+                Parallel::forEachDynamic(blocks.size(), 0, [&] (size_t b) { blockTriangles[b + 1] = forEachFace(b, false); });
+                for (size_t b = 0; b < blocks.size(); ++b) blockTriangles[b + 1] += blockTriangles[b];
+                mesh.triangleIndices.resize(blockTriangles.back() * 3);
+                Parallel::forEachDynamic(blocks.size(), 0, [&] (size_t b) { forEachFace(b, true); });
+                return next;
+            }
+
+            // Binary rows have different sizes, so faces are read in one pass, assuming mostly triangles
+            bool swap = (format == BINARY_LITTLE_ENDIAN) != hostIsLittleEndian();
+            const uint8_t* row = (const uint8_t*) p;
+            const uint8_t* rowsEnd = (const uint8_t*) end;
+            auto truncated = [&path] () { return std::runtime_error("Error: \"" + path + "\" is truncated"); };
+            mesh.triangleIndices.reserve(count * 3);
+            for (size_t f = 0; f < count; ++f) {
+                for (auto &property : element.properties) {
+                    if (!isIndexList(property)) {
+                        row = readBinaryProperty(row, rowsEnd, property, swap, path, [] (double) {});
+                        continue;
+                    }
+                    size_t countSize = typeSize(property.countType), indexSize = typeSize(property.type);
+                    if (row + countSize > rowsEnd) throw truncated();
+                    size_t items = size_t(readBinary(row, property.countType, swap));
+                    row += countSize;
+                    if (uint64_t(rowsEnd - row) / indexSize < items) throw truncated();
+                    uint32_t first = 0, previous = 0;
+                    for (size_t i = 0; i < items; ++i, row += indexSize) {
+                        uint32_t index = uint32_t(int64_t(readBinary(row, property.type, swap)));
+                        if (i == 0) first = index;
+                        else if (i >= 2) {
+                            mesh.triangleIndices.push_back(first);
+                            mesh.triangleIndices.push_back(previous);
+                            mesh.triangleIndices.push_back(index);
+                        }
+                        previous = index;
+                    }
+                }
+            }
+            return (const char*) row;
+        }
+
+        static const char* skipElement(const Element &element, const char* p, const char* end, Format format, const std::string &path)
+        {
+            if (format == ASCII) {
+                std::vector<const char*> blocks;
+                return findAsciiRowBlocks(element, p, end, blocks, path);
+            }
+            if (!element.hasLists) {
+                if (uint64_t(end - p) / std::max(element.stride, size_t(1)) < element.count) 
+                    throw std::runtime_error("Error: \"" + path + "\" is truncated");
+                return p + element.count * element.stride;
+            }
+            bool swap = (format == BINARY_LITTLE_ENDIAN) != hostIsLittleEndian();
+            const uint8_t* row = (const uint8_t*) p;
+            for (size_t i = 0; i < element.count; ++i) {
+                for (auto &property : element.properties) {
+                    row = readBinaryProperty(row, (const uint8_t*) end, property, swap, path, [] (double) {});
+                }
+            }
+            return (const char*) row;
+        }
+    };
+
+    /* 
+     * Reads the mesh at path if it has a format with a native reader (OBJ or PLY), and returns 
+     * true. Returns false for every other format, which should be read with assimp instead.
+     */
+    inline bool read(const std::string &path, MeshData &mesh)
+    {
+        if (hasExtension(path, ".obj")) ObjReader::read(path, mesh);
+        else if (hasExtension(path, ".ply")) PlyReader::read(path, mesh);
+        else return false;
+        return true;
+    }
+};
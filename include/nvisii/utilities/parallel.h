@@ -0,0 +1,106 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace Parallel {
+
+    /* Returns the number of worker threads to use for CPU side loops. */
+    inline size_t getNumThreads()
+    {
+        size_t count = std::thread::hardware_concurrency();
+        return (count == 0) ? 1 : count;
+    }
+
+    /*
+     * Splits [begin, end) into contiguous chunks and calls function(chunkBegin, chunkEnd)
+     * for each chunk, one chunk per thread. Ranges smaller than minChunkSize are run on
+     * the calling thread, so that small inputs don't pay for thread creation.
+     * Exceptions thrown by function are rethrown on the calling thread.
+     */
+    template<typename Function>
+    void forRange(size_t begin, size_t end, size_t minChunkSize, Function &&function)
+    {
+        if (end <= begin) return;
+        size_t count = end - begin;
+        size_t numChunks = std::min(getNumThreads(), count / std::max(minChunkSize, size_t(1)));
+        if (numChunks <= 1) {
+            function(begin, end);
+            return;
+        }
+
+        size_t chunkSize = (count + numChunks - 1) / numChunks;
+        std::vector<std::future<void>> futures;
+        futures.reserve(numChunks - 1);
+        for (size_t c = 1; c < numChunks; ++c) {
+            size_t chunkBegin = begin + c * chunkSize;
+            size_t chunkEnd = std::min(chunkBegin + chunkSize, end);
+            if (chunkBegin >= chunkEnd) break;
+            futures.push_back(std::async(std::launch::async, [&function, chunkBegin, chunkEnd] () {
+                function(chunkBegin, chunkEnd);
+            }));
+        }
+
+        // the calling thread takes the first chunk
+        function(begin, std::min(begin + chunkSize, end));
+        for (auto &f : futures) f.get();
+    }
+
+    /*
+     * Calls function(i) for every i in [0, count) on numThreads threads, handing out one index 
+     * at a time. Unlike forEach, this balances work whose cost varies a lot between items, 
+     * eg decoding files of different sizes. A numThreads of 0 uses getNumThreads().
+     * Exceptions thrown by function are rethrown on the calling thread.
+     */
+    template<typename Function>
+    void forEachDynamic(size_t count, size_t numThreads, Function &&function)
+    {
+        if (numThreads == 0) numThreads = getNumThreads();
+        numThreads = std::min(numThreads, count);
+        std::atomic<size_t> next(0);
+        auto worker = [&function, &next, count] () {
+            for (size_t i = next++; i < count; i = next++) function(i);
+        };
+        if (numThreads <= 1) {
+            worker();
+            return;
+        }
+
+        std::vector<std::future<void>> futures;
+        futures.reserve(numThreads - 1);
+        for (size_t t = 1; t < numThreads; ++t) {
+            futures.push_back(std::async(std::launch::async, worker));
+        }
+        worker();
+        for (auto &f : futures) f.get();
+    }
+
+    /* Calls function(i) for every i in [begin, end), in parallel when the range is large enough. */
+    template<typename Function>
+    void forEach(size_t begin, size_t end, size_t minChunkSize, Function &&function)
+    {
+        forRange(begin, end, minChunkSize, [&function] (size_t chunkBegin, size_t chunkEnd) {
+            for (size_t i = chunkBegin; i < chunkEnd; ++i) function(i);
+        });
+    }
+};
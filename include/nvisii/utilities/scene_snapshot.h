@@ -0,0 +1,264 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nvisii/utilities/mapped_file.h>
+
+/*
+ * File format and IO helpers for scene snapshots.
+ *
+ * A snapshot is a fixed size header, followed by 64 byte aligned chunks of raw data, followed 
+ * by a table of sections. Each section is an array of plain records (eg one record per mesh) or 
+ * the names of one component type. Variable length data, like vertex positions or texels, is 
+ * stored in its own chunk and referenced from records by file offset. Everything is stored 
+ * exactly as it is held in memory, so a snapshot can be memory mapped and copied straight 
+ * into component storage without any parsing or decoding. 
+ *
+ * Snapshots are not portable between builds whose component structs differ. Each section 
+ * records the size of its elements, and the loader rejects sections whose size has changed.
+ */
+
+static const uint32_t SCENE_SNAPSHOT_VERSION = 1;
+static const uint32_t SCENE_SNAPSHOT_ALIGNMENT = 64;
+
+struct SceneSnapshotHeader {
+    char magic[4] = {'N', 'V', 'S', 'S'};
+    uint32_t version = SCENE_SNAPSHOT_VERSION;
+    uint64_t fileSize = 0;
+    uint64_t sectionTableOffset = 0;
+    uint64_t sectionCount = 0;
+};
+
+struct SceneSnapshotSection {
+    uint32_t type = 0;          // a SceneSnapshotSectionType
+    uint32_t elementSize = 0;   // bytes per element
+    uint64_t count = 0;         // number of elements
+    uint64_t offset = 0;        // file offset of the first element
+};
+
+/* Each component type has a section of records, and a section holding its names separated by '\0' */
+enum SceneSnapshotSectionType : uint32_t {
+    SCENE_SNAPSHOT_ENTITIES = 1,
+    SCENE_SNAPSHOT_ENTITY_NAMES,
+    SCENE_SNAPSHOT_TRANSFORMS,
+    SCENE_SNAPSHOT_TRANSFORM_NAMES,
+    SCENE_SNAPSHOT_MESHES,
+    SCENE_SNAPSHOT_MESH_NAMES,
+    SCENE_SNAPSHOT_TEXTURES,
+    SCENE_SNAPSHOT_TEXTURE_NAMES,
+    SCENE_SNAPSHOT_MATERIALS,
+    SCENE_SNAPSHOT_MATERIAL_NAMES,
+    SCENE_SNAPSHOT_LIGHTS,
+    SCENE_SNAPSHOT_LIGHT_NAMES,
+    SCENE_SNAPSHOT_CAMERAS,
+    SCENE_SNAPSHOT_CAMERA_NAMES,
+    SCENE_SNAPSHOT_VOLUMES,
+    SCENE_SNAPSHOT_VOLUME_NAMES,
+};
+
+/* A reference from a record to an array of count elements stored at offset */
+struct SceneSnapshotRange {
+    uint64_t offset = 0;
+    uint64_t count = 0;
+};
+
+/* Writes a snapshot. Data passed to add and addSection must stay valid until write is called. */
+class SceneSnapshotWriter {
+    public:
+
+    /* Places size bytes of data in the file, returning the file offset it will be written at */
+    uint64_t add(const void* data, uint64_t size)
+    {
+        if (size == 0) return 0;
+        end = (end + SCENE_SNAPSHOT_ALIGNMENT - 1) / SCENE_SNAPSHOT_ALIGNMENT * SCENE_SNAPSHOT_ALIGNMENT;
+        chunks.push_back({data, end, size});
+        end += size;
+        return end - size;
+    }
+
+    /* Places an array of elements in the file, returning a range referencing it */
+    template<typename T>
+    SceneSnapshotRange addRange(const T* data, size_t count)
+    {
+        SceneSnapshotRange range;
+        range.offset = add(data, uint64_t(count) * sizeof(T));
+        range.count = count;
+        return range;
+    }
+
+    template<typename T>
+    SceneSnapshotRange addRange(const std::vector<T> &data)
+    {
+        return addRange(data.data(), data.size());
+    }
+
+    /* Places an array of elements in the file, listing it in the section table */
+    template<typename T>
+    void addSection(uint32_t type, const std::vector<T> &elements)
+    {
+        SceneSnapshotSection section;
+        section.type = type;
+        section.elementSize = sizeof(T);
+        section.count = elements.size();
+        section.offset = add(elements.data(), uint64_t(elements.size()) * sizeof(T));
+        sections.push_back(section);
+    }
+
+    /*
+     * Writes the file under a temporary name and then renames it, so that other processes never 
+     * observe a partially written snapshot. Throws on failure.
+     */
+    void write(const std::string &path)
+    {
+        SceneSnapshotHeader header;
+        header.sectionTableOffset = (end + SCENE_SNAPSHOT_ALIGNMENT - 1) / SCENE_SNAPSHOT_ALIGNMENT * SCENE_SNAPSHOT_ALIGNMENT;
+        header.sectionCount = sections.size();
+        header.fileSize = header.sectionTableOffset + sections.size() * sizeof(SceneSnapshotSection);
+
+        size_t unique = std::hash<std::thread::id>()(std::this_thread::get_id()) 
+            ^ size_t(std::chrono::steady_clock::now().time_since_epoch().count());
+        std::string tempPath = path + "." + std::to_string(unique) + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        if (!file) throw std::runtime_error("Error: unable to open \"" + tempPath + "\" for writing");
+
+        uint64_t position = 0;
+        std::vector<char> padding(SCENE_SNAPSHOT_ALIGNMENT, 0);
+        auto pad = [&] (uint64_t offset) {
+            bool ok = fwrite(padding.data(), 1, size_t(offset - position), file) == size_t(offset - position);
+            position = offset;
+            return ok;
+        };
+        bool written = (fwrite(&header, sizeof(header), 1, file) == 1);
+        position = sizeof(header);
+        for (auto &chunk : chunks) {
+            if (!written) break;
+            written = pad(chunk.offset) && (fwrite(chunk.data, 1, size_t(chunk.size), file) == size_t(chunk.size));
+            position += chunk.size;
+        }
+        written = written && pad(header.sectionTableOffset) 
+            && (sections.empty() || fwrite(sections.data(), sizeof(SceneSnapshotSection), sections.size(), file) == sections.size());
+        written = (fclose(file) == 0) && written;
+
+        if (written && std::rename(tempPath.c_str(), path.c_str()) != 0) {
+            // Windows won't rename over an existing file
+            std::remove(path.c_str());
+            written = (std::rename(tempPath.c_str(), path.c_str()) == 0);
+        }
+        if (!written) {
+            std::remove(tempPath.c_str());
+            throw std::runtime_error("Error: unable to write scene snapshot \"" + path + "\"");
+        }
+    }
+
+    private:
+
+    struct Chunk {
+        const void* data;
+        uint64_t offset;
+        uint64_t size;
+    };
+    std::vector<Chunk> chunks;
+    std::vector<SceneSnapshotSection> sections;
+    uint64_t end = sizeof(SceneSnapshotHeader);
+};
+
+/* Memory maps a snapshot read only, and validates the offsets and sizes of the data it references. */
+class SceneSnapshotReader {
+    public:
+
+    SceneSnapshotReader(const std::string &path) : path(path), file(path, "scene snapshot")
+    {
+        bytes = file.data();
+        size = file.size();
+
+        SceneSnapshotHeader expected;
+        if ((size < sizeof(SceneSnapshotHeader)) || (memcmp(bytes, expected.magic, sizeof(expected.magic)) != 0)) {
+            throw std::runtime_error("Error: \"" + path + "\" is not a scene snapshot");
+        }
+        memcpy(&header, bytes, sizeof(header));
+        if (header.version != SCENE_SNAPSHOT_VERSION) {
+            throw std::runtime_error("Error: scene snapshot \"" + path + "\" has version " + std::to_string(header.version) 
+                + ", expected version " + std::to_string(SCENE_SNAPSHOT_VERSION));
+        }
+        if ((header.fileSize != size) || !inBounds(header.sectionTableOffset, header.sectionCount, sizeof(SceneSnapshotSection))) {
+            throw std::runtime_error("Error: scene snapshot \"" + path + "\" is truncated or corrupt");
+        }
+    }
+
+    SceneSnapshotReader(const SceneSnapshotReader&) = delete;
+    SceneSnapshotReader &operator=(const SceneSnapshotReader&) = delete;
+
+    /* Returns the elements of the section with the given type, or an empty range if there is no such section */
+    template<typename T>
+    SceneSnapshotRange getSection(uint32_t type) const
+    {
+        for (uint64_t i = 0; i < header.sectionCount; ++i) {
+            SceneSnapshotSection section;
+            memcpy(&section, bytes + header.sectionTableOffset + i * sizeof(SceneSnapshotSection), sizeof(section));
+            if (section.type != type) continue;
+            if (section.elementSize != sizeof(T)) 
+                throw std::runtime_error("Error: scene snapshot \"" + path + "\" was written by an incompatible build");
+            SceneSnapshotRange range;
+            range.offset = section.offset;
+            range.count = section.count;
+            return range;
+        }
+        return SceneSnapshotRange();
+    }
+
+    /* Returns a pointer to the elements referenced by a range, throwing if the range is out of bounds or misaligned */
+    template<typename T>
+    const T* get(const SceneSnapshotRange &range) const
+    {
+        if (range.count == 0) return nullptr;
+        if (!inBounds(range.offset, range.count, sizeof(T)) || (range.offset % alignof(T)) != 0)
+            throw std::runtime_error("Error: scene snapshot \"" + path + "\" is truncated or corrupt");
+        return (const T*) (bytes + range.offset);
+    }
+
+    /* Copies the elements referenced by a range into a vector */
+    template<typename T>
+    void copy(const SceneSnapshotRange &range, std::vector<T> &out) const
+    {
+        const T* data = get<T>(range);
+        out.assign(data, data + range.count);
+    }
+
+    private:
+
+    bool inBounds(uint64_t offset, uint64_t count, uint64_t elementSize) const
+    {
+        if (offset > size) return false;
+        return (count <= (size - offset) / elementSize);
+    }
+
+    std::string path;
+    MappedFile file;
+    SceneSnapshotHeader header;
+    const uint8_t* bytes = nullptr;
+    uint64_t size = 0;
+};
@@ -33,15 +33,19 @@
 #include <string>
 #include <set>
 #include <map>
+#include <unordered_set>
 #include <vector>
 #include <memory>
 #include <typeindex>
+#include <functional>
 
 #include <exception>
 #include <mutex>
 #include <thread>
 #include <future>
 
+#include <nvisii/utilities/lookup_table.h>
+
 class StaticFactory {
     public:
 
@@ -55,32 +59,34 @@ class StaticFactory {
     virtual int32_t getId() { return id; };
     
     /* Returns whether or not a key exists in the lookup table. */
-    static bool doesItemExist(std::map<std::string, uint32_t> &lookupTable, std::string name)
+    static bool doesItemExist(LookupTable &lookupTable, std::string name)
     {
-        auto it = lookupTable.find(name);
-        return (it != lookupTable.end());
+        return lookupTable.contains(name);
     }
 
     /* Returns the first index where an item of type T is uninitialized. */
     template<class T>
-    static int32_t findAvailableID(T *items, size_t maxItems) 
+    static int32_t findAvailableID(LookupTable &lookupTable, T *items, size_t maxItems) 
     {
-        for (size_t i = 0; i < maxItems; ++i)
-            if (items[i].initialized == false)
-                return (int32_t)i;
-        return -1;
+        // The free slot bitmap is built lazily, the first time a table of a given size is used.
+        if (lookupTable.capacity() != maxItems) {
+            lookupTable.resize(maxItems);
+            for (size_t i = 0; i < maxItems; ++i)
+                if (items[i].initialized) lookupTable.markUsed((uint32_t)i);
+        }
+        return lookupTable.findAvailable();
     }
     
     /* Reserves a location in items and adds an entry in the lookup table */
     template<class T>
-    static T* create(std::shared_ptr<std::recursive_mutex> factory_mutex, std::string name, std::string type, std::map<std::string, uint32_t> &lookupTable, T* items, size_t maxItems, std::function<void(T*)> function = nullptr) 
+    static T* create(std::shared_ptr<std::recursive_mutex> factory_mutex, std::string name, std::string type, LookupTable &lookupTable, T* items, size_t maxItems, std::function<void(T*)> function = nullptr) 
     {
         auto mutex = factory_mutex.get();
         std::lock_guard<std::recursive_mutex> lock(*mutex);
         if (doesItemExist(lookupTable, name))
             throw std::runtime_error(std::string("Error: " + type + " \"" + name + "\" already exists."));
 
-        int32_t id = findAvailableID(items, maxItems);
+        int32_t id = findAvailableID(lookupTable, items, maxItems);
 
         if (id < 0) 
             throw std::runtime_error(std::string("Error: max " + type + " limit reached."));
@@ -90,7 +96,7 @@ class StaticFactory {
         std::cout << "Adding " << type << " \"" << name << "\"" << std::endl;
         #endif
         items[id] = T(name, id);
-        lookupTable[name] = id;
+        lookupTable.insert(name, id);
 
         // callback for creation before releasing mutex
         if (function != nullptr) function(&items[id]);
@@ -98,14 +104,79 @@ class StaticFactory {
         return &items[id];
     }
 
+    /* Reserves locations in items for a batch of names under a single lock, adding entries in the lookup table.
+       The callback receives each new item along with its index in names. Names and free space are validated 
+       before anything is created. If a callback throws, every item created by this call is removed through 
+       T::remove, which also undoes any links the callbacks made to other components, before the error is rethrown. */
+    template<class T>
+    static std::vector<T*> createMany(std::shared_ptr<std::recursive_mutex> factory_mutex, const std::vector<std::string> &names, std::string type, LookupTable &lookupTable, T* items, size_t maxItems, std::function<void(T*, size_t)> function = nullptr) 
+    {
+        auto mutex = factory_mutex.get();
+        std::lock_guard<std::recursive_mutex> lock(*mutex);
+
+        // Validate all names up front, so that a bad batch leaves the table untouched
+        std::unordered_set<std::string> batchNames(names.begin(), names.end());
+        if (batchNames.size() != names.size())
+            throw std::runtime_error(std::string("Error: duplicate " + type + " names given."));
+        for (auto &name : names) {
+            if (doesItemExist(lookupTable, name))
+                throw std::runtime_error(std::string("Error: " + type + " \"" + name + "\" already exists."));
+        }
+        if (names.size() > maxItems - lookupTable.size())
+            throw std::runtime_error(std::string("Error: max " + type + " limit reached."));
+        lookupTable.reserve(lookupTable.size() + names.size());
+
+        std::vector<T*> created;
+        created.reserve(names.size());
+        try {
+            for (size_t i = 0; i < names.size(); ++i) {
+                int32_t id = findAvailableID(lookupTable, items, maxItems);
+                if (id < 0) 
+                    throw std::runtime_error(std::string("Error: max " + type + " limit reached."));
+                items[id] = T(names[i], id);
+                lookupTable.insert(names[i], id);
+                created.push_back(&items[id]);
+
+                // callback for creation before releasing mutex
+                if (function != nullptr) function(&items[id], i);
+            }
+        } catch (...) {
+            for (auto &item : created) T::remove(item->name);
+            throw;
+        }
+        return created;
+    }
+
+    /* For batched creation, returns the offset of the i'th value in a flattened list holding either one value 
+       shared by all count items, or one value per item, each value having the given number of dimensions. */
+    static size_t getBatchOffset(const std::vector<float> &list, uint32_t dimensions, size_t count, size_t i, std::string listName)
+    {
+        if (list.size() == dimensions) return 0;
+        if (list.size() == dimensions * count) return i * dimensions;
+        throw std::runtime_error(std::string("Error: length of " + listName + " (" + std::to_string(list.size()) + 
+            ") must be either " + std::to_string(dimensions) + " or " + std::to_string(dimensions * count)));
+    }
+
+    /* For batched creation, returns the i'th component in a list holding either no components, one component 
+       shared by all count items, or one component per item. */
+    template<class T>
+    static T* getBatchComponent(const std::vector<T*> &list, size_t count, size_t i, std::string listName)
+    {
+        if (list.size() == 0) return nullptr;
+        if (list.size() == 1) return list[0];
+        if (list.size() == count) return list[i];
+        throw std::runtime_error(std::string("Error: length of " + listName + " (" + std::to_string(list.size()) + 
+            ") must be either 0, 1 or " + std::to_string(count)));
+    }
+
     /* Retrieves an element with a lookup table indirection */
     template<class T>
-    static T* get(std::shared_ptr<std::recursive_mutex> factory_mutex, std::string name, std::string type, std::map<std::string, uint32_t> &lookupTable, T* items, size_t maxItems) 
+    static T* get(std::shared_ptr<std::recursive_mutex> factory_mutex, std::string name, std::string type, LookupTable &lookupTable, T* items, size_t maxItems) 
     {
         auto mutex = factory_mutex.get();
         std::lock_guard<std::recursive_mutex> lock(*mutex);
-        if (doesItemExist(lookupTable, name)) {
-            uint32_t id = lookupTable[name];
+        int32_t id = lookupTable.find(name);
+        if (id >= 0) {
             if (!items[id].initialized) return nullptr;
             return &items[id];
         }
@@ -117,7 +188,7 @@ class StaticFactory {
 
     /* Retrieves an element by ID directly */
     template<class T>
-    static T* get(std::shared_ptr<std::recursive_mutex> factory_mutex, uint32_t id, std::string type, std::map<std::string, uint32_t> &lookupTable, T* items, size_t maxItems) 
+    static T* get(std::shared_ptr<std::recursive_mutex> factory_mutex, uint32_t id, std::string type, LookupTable &lookupTable, T* items, size_t maxItems) 
     {
         auto mutex = factory_mutex.get();
         std::lock_guard<std::recursive_mutex> lock(*mutex);
@@ -132,31 +203,33 @@ class StaticFactory {
 
     /* Removes an element with a lookup table indirection, removing from both items and the lookup table */
     template<class T>
-    static void remove(std::shared_ptr<std::recursive_mutex> factory_mutex, std::string name, std::string type, std::map<std::string, uint32_t> &lookupTable, T* items, size_t maxItems)
+    static void remove(std::shared_ptr<std::recursive_mutex> factory_mutex, std::string name, std::string type, LookupTable &lookupTable, T* items, size_t maxItems)
     {
         auto mutex = factory_mutex.get();
         std::lock_guard<std::recursive_mutex> lock(*mutex);
-        if (!doesItemExist(lookupTable, name))
+        int32_t id = lookupTable.find(name);
+        if (id < 0)
             throw std::runtime_error(std::string("Error: " + type + " \"" + name + "\" does not exist."));
 
-        items[lookupTable[name]] = T();
+        items[id] = T();
         lookupTable.erase(name);
     }
 
     /* If it exists, removes an element with a lookup table indirection, removing from both items and the lookup table */
     template<class T>
-    static void removeIfExists(std::shared_ptr<std::recursive_mutex> factory_mutex, std::string name, std::string type, std::map<std::string, uint32_t> &lookupTable, T* items, size_t maxItems)
+    static void removeIfExists(std::shared_ptr<std::recursive_mutex> factory_mutex, std::string name, std::string type, LookupTable &lookupTable, T* items, size_t maxItems)
     {
         auto mutex = factory_mutex.get();
         std::lock_guard<std::recursive_mutex> lock(*mutex);
-        if (!doesItemExist(lookupTable, name)) return;
-        items[lookupTable[name]] = T();
+        int32_t id = lookupTable.find(name);
+        if (id < 0) return;
+        items[id] = T();
         lookupTable.erase(name);
     }
 
     /* Removes an element by ID directly, removing from both items and the lookup table */
     template<class T>
-    static void remove(std::shared_ptr<std::recursive_mutex> factory_mutex, uint32_t id, std::string type, std::map<std::string, uint32_t> &lookupTable, T* items, size_t maxItems)
+    static void remove(std::shared_ptr<std::recursive_mutex> factory_mutex, uint32_t id, std::string type, LookupTable &lookupTable, T* items, size_t maxItems)
     {
         auto mutex = factory_mutex.get();
         std::lock_guard<std::recursive_mutex> lock(*mutex);
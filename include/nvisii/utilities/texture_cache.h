@@ -0,0 +1,179 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+/*
+ * File format and IO helpers for the on disk cache of decoded textures.
+ *
+ * A cache file is a fixed size header, followed by the path of the source image, 
+ * followed by raw texels starting at a 64 byte aligned offset. The texels are stored
+ * exactly as they are held in memory, so a cache file can be read straight into a 
+ * texel buffer, or memory mapped, without any decoding.
+ *
+ * Cache files are named by a hash of the source path, the source size and modification
+ * time, and the load options. The header repeats these so that hash collisions and
+ * stale files are detected. Stale files are never read, but are also not deleted.
+ */
+
+static const uint32_t TEXTURE_CACHE_VERSION = 2;
+static const uint32_t TEXTURE_CACHE_ALIGNMENT = 64;
+
+struct TextureCacheHeader {
+    char magic[4] = {'N', 'V', 'T', 'C'};
+    uint32_t version = TEXTURE_CACHE_VERSION;
+    uint64_t sourceSize = 0;
+    int64_t sourceModifiedTime = 0;
+    uint32_t options = 0;       // load options that change the decoded result, eg "linear"
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t texelSize = 0;     // bytes per texel
+    uint32_t flags = 0;         // TEXTURE_CACHE_FLAG_* bits describing the decoded texture
+    uint32_t pathLength = 0;
+    uint64_t dataOffset = 0;
+    uint64_t dataSize = 0;
+};
+
+enum TextureCacheFlags : uint32_t {
+    TEXTURE_CACHE_FLAG_FLOAT = 1u << 0,
+    TEXTURE_CACHE_FLAG_LINEAR = 1u << 1,
+    TEXTURE_CACHE_FLAG_RIGHT_HANDED = 1u << 2,
+};
+
+/* Flags bits from this shift up hold the packed texel format of the texture, 0 for RGBA texels */
+static const uint32_t TEXTURE_CACHE_PACKED_FORMAT_SHIFT = 8;
+
+/* Returns the size and modification time of a file, or false if the file can't be found. */
+inline bool getTextureCacheFileStamp(const std::string &path, uint64_t &size, int64_t &modifiedTime)
+{
+    #ifdef _MSC_VER
+    struct _stat64 info;
+    if (_stat64(path.c_str(), &info) != 0) return false;
+    #else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return false;
+    #endif
+    size = uint64_t(info.st_size);
+    modifiedTime = int64_t(info.st_mtime);
+    return true;
+}
+
+/* 64 bit FNV-1a. Unlike std::hash, this is stable across runs, compilers and platforms. */
+inline uint64_t textureCacheHash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull)
+{
+    const uint8_t* bytes = (const uint8_t*) data;
+    for (size_t i = 0; i < size; ++i) {
+        seed ^= bytes[i];
+        seed *= 1099511628211ull;
+    }
+    return seed;
+}
+
+/* Returns the path of the cache file for the given source image and options. */
+inline std::string getTextureCachePath(const std::string &directory, const std::string &sourcePath,
+    uint64_t sourceSize, int64_t sourceModifiedTime, uint32_t options)
+{
+    uint64_t hash = textureCacheHash(sourcePath.data(), sourcePath.size());
+    hash = textureCacheHash(&sourceSize, sizeof(sourceSize), hash);
+    hash = textureCacheHash(&sourceModifiedTime, sizeof(sourceModifiedTime), hash);
+    hash = textureCacheHash(&options, sizeof(options), hash);
+    hash = textureCacheHash(&TEXTURE_CACHE_VERSION, sizeof(TEXTURE_CACHE_VERSION), hash);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.nvtc", (unsigned long long) hash);
+    if (directory.empty()) return std::string(name);
+    char last = directory.back();
+    return directory + ((last == '/' || last == '\\') ? "" : "/") + name;
+}
+
+/*
+ * Reads a cache file. If the file exists and its header matches the given source stamp and 
+ * options, allocate(header) is called to get a destination of header.dataSize bytes, which 
+ * the texels are read into directly. Returns false on any mismatch or read error.
+ */
+inline bool readTextureCache(const std::string &cachePath, const std::string &sourcePath,
+    uint64_t sourceSize, int64_t sourceModifiedTime, uint32_t options, 
+    const std::function<void*(const TextureCacheHeader&)> &allocate)
+{
+    FILE* file = fopen(cachePath.c_str(), "rb");
+    if (!file) return false;
+
+    TextureCacheHeader header;
+    TextureCacheHeader expected;
+    std::string storedPath(sourcePath.size(), '\0');
+    bool valid = (fread(&header, sizeof(header), 1, file) == 1)
+        && (memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0)
+        && (header.version == TEXTURE_CACHE_VERSION)
+        && (header.sourceSize == sourceSize)
+        && (header.sourceModifiedTime == sourceModifiedTime)
+        && (header.options == options)
+        && (header.pathLength == sourcePath.size())
+        && (header.dataSize == uint64_t(header.width) * header.height * header.texelSize)
+        && (fread(&storedPath[0], 1, storedPath.size(), file) == storedPath.size())
+        && (storedPath == sourcePath)
+        && (fseek(file, long(header.dataOffset), SEEK_SET) == 0);
+
+    if (valid) {
+        void* destination = allocate(header);
+        valid = destination && (fread(destination, 1, size_t(header.dataSize), file) == size_t(header.dataSize));
+    }
+    fclose(file);
+    return valid;
+}
+
+/*
+ * Writes a cache file. The file is written under a temporary name and then renamed, so that 
+ * concurrent processes never observe a partially written cache file. Returns false on failure.
+ */
+inline bool writeTextureCache(const std::string &cachePath, const std::string &sourcePath,
+    TextureCacheHeader header, const void* data)
+{
+    header.pathLength = uint32_t(sourcePath.size());
+    uint64_t pathEnd = sizeof(TextureCacheHeader) + header.pathLength;
+    header.dataOffset = (pathEnd + TEXTURE_CACHE_ALIGNMENT - 1) / TEXTURE_CACHE_ALIGNMENT * TEXTURE_CACHE_ALIGNMENT;
+    header.dataSize = uint64_t(header.width) * header.height * header.texelSize;
+
+    size_t unique = std::hash<std::thread::id>()(std::this_thread::get_id()) 
+        ^ size_t(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::string tempPath = cachePath + "." + std::to_string(unique) + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+
+    std::vector<char> padding(size_t(header.dataOffset - pathEnd), 0);
+    bool written = (fwrite(&header, sizeof(header), 1, file) == 1)
+        && (fwrite(sourcePath.data(), 1, sourcePath.size(), file) == sourcePath.size())
+        && (fwrite(padding.data(), 1, padding.size(), file) == padding.size())
+        && (fwrite(data, 1, size_t(header.dataSize), file) == size_t(header.dataSize));
+    written = (fclose(file) == 0) && written;
+
+    if (written && std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        // Windows won't rename over an existing file, eg if another process wrote the same entry first
+        std::remove(cachePath.c_str());
+        written = (std::rename(tempPath.c_str(), cachePath.c_str()) == 0);
+    }
+    if (!written) std::remove(tempPath.c_str());
+    return written;
+}
@@ -0,0 +1,167 @@
+// ┌──────────────────────────────────────────────────────────────────────────┐
+// | Copyright 2018-2020 Nathan Morrical                                      |
+// |                                                                          |
+// | Licensed under the Apache License, Version 2.0 (the "License");          |
+// | you may not use this file except in compliance with the License.         |
+// | You may obtain a copy of the License at                                  |
+// |                                                                          |
+// |     http://www.apache.org/licenses/LICENSE-2.0                           |
+// |                                                                          |
+// | Unless required by applicable law or agreed to in writing, software      |
+// | distributed under the License is distributed on an "AS IS" BASIS,        |
+// | WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. |
+// | See the License for the specific language governing permissions and      |
+// | limitations under the License.                                           |
+// └──────────────────────────────────────────────────────────────────────────┘
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+/*
+ * Encoders and decoders for the compact per vertex layout used by Mesh::compress.
+ *
+ * Unit vectors are octahedral encoded into two 16 bit signed normalized values (at most about 
+ * 0.05 degrees of error), texture coordinates are stored as IEEE half floats, colors as 8 bit 
+ * unsigned normalized values, and positions optionally as 16 bit offsets into a per mesh grid.
+ */
+
+/* Encodes a unit vector as two 16 bit snorm values packed into 32 bits. Zero vectors are kept as zero. */
+inline uint32_t encodeOctahedral(glm::vec3 v)
+{
+    float sum = std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z);
+    if (!(sum > 0.f)) return 0x80008000u;
+    float x = v.x / sum;
+    float y = v.y / sum;
+    if (v.z < 0.f) {
+        float fx = (1.f - std::fabs(y)) * ((x >= 0.f) ? 1.f : -1.f);
+        float fy = (1.f - std::fabs(x)) * ((y >= 0.f) ? 1.f : -1.f);
+        x = fx;
+        y = fy;
+    }
+    auto snorm = [] (float f) {
+        return uint32_t(uint16_t(int16_t(std::lround(std::min(std::max(f, -1.f), 1.f) * 32767.f))));
+    };
+    return snorm(x) | (snorm(y) << 16);
+}
+
+/* Decodes a vector encoded with encodeOctahedral into a normalized vector */
+inline glm::vec3 decodeOctahedral(uint32_t encoded)
+{
+    if (encoded == 0x80008000u) return glm::vec3(0.f);
+    float x = float(int16_t(uint16_t(encoded & 0xFFFF))) / 32767.f;
+    float y = float(int16_t(uint16_t(encoded >> 16))) / 32767.f;
+    glm::vec3 v = glm::vec3(x, y, 1.f - std::fabs(x) - std::fabs(y));
+    if (v.z < 0.f) {
+        float fx = (1.f - std::fabs(y)) * ((x >= 0.f) ? 1.f : -1.f);
+        float fy = (1.f - std::fabs(x)) * ((y >= 0.f) ? 1.f : -1.f);
+        v.x = fx;
+        v.y = fy;
+    }
+    return glm::normalize(v);
+}
+
+/* 
+ * Converts a float to an IEEE 754 half float, rounding to nearest even. Finite values beyond the 
+ * half range saturate to +-65504 rather than becoming infinite, since they are used for texture coordinates.
+ */
+inline uint16_t floatToHalf(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t exponent = (bits >> 23) & 0xFFu;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    // infinity and nan
+    if (exponent == 0xFFu) return uint16_t(sign | 0x7C00u | ((mantissa) ? 0x200u : 0u));
+
+    int32_t halfExponent = int32_t(exponent) - 127 + 15;
+    if (halfExponent >= 31) return uint16_t(sign | 0x7BFFu);
+
+    // subnormal halves, including values which round to zero
+    if (halfExponent <= 0) {
+        if (halfExponent < -10) return uint16_t(sign);
+        mantissa |= 0x800000u;
+        uint32_t shift = uint32_t(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1u);
+        if ((remainder > halfway) || ((remainder == halfway) && (half & 1u))) half++;
+        return uint16_t(sign | half);
+    }
+
+    uint32_t half = (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFFu;
+    // a carry out of the mantissa correctly bumps the exponent
+    if ((remainder > 0x1000u) || ((remainder == 0x1000u) && (half & 1u))) half++;
+    if (half >= 0x7C00u) half = 0x7BFFu;
+    return uint16_t(sign | half);
+}
+
+/* Converts an IEEE 754 half float to a float. This is exact. */
+inline float halfToFloat(uint16_t h)
+{
+    uint32_t sign = uint32_t(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1Fu;
+    uint32_t mantissa = h & 0x3FFu;
+    uint32_t bits;
+    if (exponent == 0x1Fu) bits = sign | 0x7F800000u | (mantissa << 13);
+    else if (exponent != 0) bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    else if (mantissa == 0) bits = sign;
+    else {
+        // renormalize subnormal halves
+        exponent = 127 - 15 + 1;
+        while ((mantissa & 0x400u) == 0) { mantissa <<= 1; exponent--; }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+    }
+    float f;
+    memcpy(&f, &bits, 4);
+    return f;
+}
+
+/* Encodes a color as four 8 bit unorm values, clamping each channel to [0, 1] */
+inline uint32_t encodeColor(glm::vec4 c)
+{
+    auto unorm = [] (float f) { return uint32_t(std::lround(std::min(std::max(f, 0.f), 1.f) * 255.f)); };
+    return unorm(c.r) | (unorm(c.g) << 8) | (unorm(c.b) << 16) | (unorm(c.a) << 24);
+}
+
+inline glm::vec4 decodeColor(uint32_t c)
+{
+    return glm::vec4(float(c & 0xFF), float((c >> 8) & 0xFF), float((c >> 16) & 0xFF), float(c >> 24)) / 255.f;
+}
+
+/* 
+ * A grid of 2^16 steps per axis spanning a bounding box. Positions are snapped to the nearest 
+ * grid point, so the error along each axis is at most half a step, ie extent / 131070.
+ */
+struct PositionGrid {
+    glm::vec3 origin = glm::vec3(0.f);
+    glm::vec3 step = glm::vec3(0.f);
+
+    PositionGrid() {}
+    PositionGrid(glm::vec3 bbmin, glm::vec3 bbmax) : origin(bbmin), step((bbmax - bbmin) / 65535.f) {}
+
+    std::array<uint16_t, 3> encode(const std::array<float, 3> &p) const
+    {
+        std::array<uint16_t, 3> q;
+        for (int c = 0; c < 3; ++c) {
+            float t = (step[c] > 0.f) ? (p[c] - origin[c]) / step[c] : 0.f;
+            q[c] = uint16_t(std::lround(std::min(std::max(t, 0.f), 65535.f)));
+        }
+        return q;
+    }
+
+    std::array<float, 3> decode(const std::array<uint16_t, 3> &q) const
+    {
+        return {origin.x + float(q[0]) * step.x, origin.y + float(q[1]) * step.y, origin.z + float(q[2]) * step.z};
+    }
+};
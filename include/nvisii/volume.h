@@ -28,6 +28,7 @@ class Volume : public StaticFactory
 {
 	friend class StaticFactory;
 	friend class Entity;
+	friend class SceneSnapshot;
   public:
 	/**
       * Instantiates a null Volume. Used to mark a row in the table as null. 
@@ -262,7 +263,7 @@ class Volume : public StaticFactory
 	static std::vector<VolumeStruct> volumeStructs;
 	
 	/** A lookup table of name to volume id */
-	static std::map<std::string, uint32_t> lookupTable;
+	static LookupTable lookupTable;
 
 	static std::set<Volume*> dirtyVolumes;
 
@@ -5,7 +5,7 @@ namespace nvisii {
 
 std::vector<Camera> Camera::cameras;
 std::vector<CameraStruct> Camera::cameraStructs;
-std::map<std::string, uint32_t> Camera::lookupTable;
+LookupTable Camera::lookupTable;
 std::shared_ptr<std::recursive_mutex> Camera::editMutex;
 bool Camera::factoryInitialized = false;
 bool Camera::anyDirty = true;
@@ -279,7 +279,7 @@ std::string Camera::getName()
 
 std::map<std::string, uint32_t> Camera::getNameToIdMap()
 {
-	return lookupTable;
+	return lookupTable.toMap();
 }
 
 
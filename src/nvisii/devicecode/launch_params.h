@@ -15,6 +15,7 @@
 #include <nvisii/light_struct.h>
 #include <nvisii/texture_struct.h>
 #include <nvisii/volume_struct.h>
+#include <nvisii/environment_struct.h>
 
 #include "./buffer.h"
 
@@ -72,6 +73,7 @@ struct LaunchParams {
     glm::quat environmentMapRotation = glm::quat(1,0,0,0);
     float* environmentMapRows = nullptr;
     float* environmentMapCols = nullptr;
+    EnvironmentAliasStruct* environmentMapAlias = nullptr;
     int environmentMapWidth = 0;
     int environmentMapHeight = 0;
     cudaTextureObject_t proceduralSkyTexture = 0;
@@ -99,6 +99,10 @@ float3 missColor(const float3 n_dir, cudaTextureObject_t &tex)
     {
         vec2 tc = toUV(vec3(rayDir.x, rayDir.y, rayDir.z));
         float4 texColor = tex2D<float4>(tex, tc.x,tc.y);
+        if (LP.environmentMapID >= 0) {
+            GET(TextureStruct texInfo, TextureStruct, LP.textures, LP.environmentMapID);
+            if (texInfo.channels == 1) return make_float3(texColor.x, texColor.x, texColor.x);
+        }
         return make_float3(texColor);
     }
     
@@ -425,24 +429,32 @@ bool loadCamera(EntityStruct &cameraEntity, CameraStruct &camera, TransformStruc
 inline __device__ 
 float3 sampleTexture(int32_t textureId, float2 texCoord, float3 defaultVal) {
     auto &LP = optixLaunchParams;
-    if (textureId < 0 || textureId >= (LP.textures.count + LP.materials.count * NUM_MAT_PARAMS)) return defaultVal;
+    if (textureId < 0 || textureId >= LP.textures.count) return defaultVal;
     GET(cudaTextureObject_t tex, cudaTextureObject_t, LP.textureObjects, textureId);
     if (!tex) return defaultVal;
     GET(TextureStruct texInfo, TextureStruct, LP.textures, textureId);
     texCoord.x = texCoord.x / texInfo.scale.x;
     texCoord.y = texCoord.y / texInfo.scale.y;
+    if (texInfo.channels == 1) {
+        float gray = tex2D<float>(tex, texCoord.x, texCoord.y);
+        return make_float3(gray, gray, gray);
+    }
     return make_float3(tex2D<float4>(tex, texCoord.x, texCoord.y));
 }
 
 inline __device__ 
 float sampleTexture(int32_t textureId, float2 texCoord, int8_t channel, float defaultVal) {
     auto &LP = optixLaunchParams;
-    if (textureId < 0 || textureId >= (LP.textures.count + LP.materials.count * NUM_MAT_PARAMS)) return defaultVal;
+    if (textureId < 0 || textureId >= LP.textures.count) return defaultVal;
     GET(cudaTextureObject_t tex, cudaTextureObject_t, LP.textureObjects, textureId);
     if (!tex) return defaultVal;
     GET(TextureStruct texInfo, TextureStruct, LP.textures, textureId);
     texCoord.x = texCoord.x / texInfo.scale.x;
     texCoord.y = texCoord.y / texInfo.scale.y;
+    if (texInfo.channels == 1) {
+        if (channel >= 0 && channel < 3) return tex2D<float>(tex, texCoord.x, texCoord.y);
+        return (channel == 3) ? 1.f : defaultVal;
+    }
     if (channel == 0) return tex2D<float4>(tex, texCoord.x, texCoord.y).x;
     if (channel == 1) return tex2D<float4>(tex, texCoord.x, texCoord.y).y;
     if (channel == 2) return tex2D<float4>(tex, texCoord.x, texCoord.y).z;
@@ -505,22 +517,23 @@ void loadMeshTangentData(int meshID, int numTangents, int3 indices, float2 baryc
 
 __device__ 
 void loadDisneyMaterial(const MaterialStruct &p, float2 uv, DisneyMaterial &mat, float roughnessMinimum) {
-    mat.base_color = sampleTexture(p.base_color_texture_id, uv, make_float3(.8f, .8f, .8f));
-    mat.metallic = sampleTexture(p.metallic_texture_id, uv, p.metallic_texture_channel, .0f);
-    mat.specular = sampleTexture(p.specular_texture_id, uv, p.specular_texture_channel, .5f);
-    mat.roughness = sampleTexture(p.roughness_texture_id, uv, p.roughness_texture_channel, .5f);
-    mat.specular_tint = sampleTexture(p.specular_tint_texture_id, uv, p.specular_tint_texture_channel, 0.f);
-    mat.anisotropy = sampleTexture(p.anisotropic_texture_id, uv, p.anisotropic_texture_channel, 0.f);
-    mat.sheen = sampleTexture(p.sheen_texture_id, uv, p.sheen_texture_channel, 0.f);
-    mat.sheen_tint = sampleTexture(p.sheen_tint_texture_id, uv, p.sheen_tint_texture_channel, 0.5f);
-    mat.clearcoat = sampleTexture(p.clearcoat_texture_id, uv, p.clearcoat_texture_channel, 0.f);
-    float clearcoat_roughness = sampleTexture(p.clearcoat_roughness_texture_id, uv, p.clearcoat_roughness_texture_channel, 0.3f);
-    mat.ior = sampleTexture(p.ior_texture_id, uv, p.ior_texture_channel, 1.45f);
-    mat.specular_transmission = sampleTexture(p.transmission_texture_id, uv, p.transmission_texture_channel, 0.f);
-    mat.flatness = sampleTexture(p.subsurface_texture_id, uv, p.subsurface_texture_channel, 0.f);
-    mat.subsurface_color = sampleTexture(p.subsurface_color_texture_id, uv, make_float3(0.8f, 0.8f, 0.8f));
-    mat.transmission_roughness = sampleTexture(p.transmission_roughness_texture_id, uv, p.transmission_roughness_texture_channel, 0.f);
-    mat.alpha = sampleTexture(p.alpha_texture_id, uv, p.alpha_texture_channel, 1.f);
+    // Parameters without a texture fall back to the material's constant values
+    mat.base_color = sampleTexture(p.base_color_texture_id, uv, make_float3(p.base_color.x, p.base_color.y, p.base_color.z));
+    mat.metallic = sampleTexture(p.metallic_texture_id, uv, p.metallic_texture_channel, p.metallic);
+    mat.specular = sampleTexture(p.specular_texture_id, uv, p.specular_texture_channel, p.specular);
+    mat.roughness = sampleTexture(p.roughness_texture_id, uv, p.roughness_texture_channel, p.roughness);
+    mat.specular_tint = sampleTexture(p.specular_tint_texture_id, uv, p.specular_tint_texture_channel, p.specular_tint);
+    mat.anisotropy = sampleTexture(p.anisotropic_texture_id, uv, p.anisotropic_texture_channel, p.anisotropic);
+    mat.sheen = sampleTexture(p.sheen_texture_id, uv, p.sheen_texture_channel, p.sheen);
+    mat.sheen_tint = sampleTexture(p.sheen_tint_texture_id, uv, p.sheen_tint_texture_channel, p.sheen_tint);
+    mat.clearcoat = sampleTexture(p.clearcoat_texture_id, uv, p.clearcoat_texture_channel, p.clearcoat);
+    float clearcoat_roughness = sampleTexture(p.clearcoat_roughness_texture_id, uv, p.clearcoat_roughness_texture_channel, p.clearcoat_roughness);
+    mat.ior = sampleTexture(p.ior_texture_id, uv, p.ior_texture_channel, p.ior);
+    mat.specular_transmission = sampleTexture(p.transmission_texture_id, uv, p.transmission_texture_channel, p.transmission);
+    mat.flatness = sampleTexture(p.subsurface_texture_id, uv, p.subsurface_texture_channel, p.subsurface);
+    mat.subsurface_color = sampleTexture(p.subsurface_color_texture_id, uv, make_float3(p.subsurface_color.x, p.subsurface_color.y, p.subsurface_color.z));
+    mat.transmission_roughness = sampleTexture(p.transmission_roughness_texture_id, uv, p.transmission_roughness_texture_channel, p.transmission_roughness);
+    mat.alpha = sampleTexture(p.alpha_texture_id, uv, p.alpha_texture_channel, p.base_color.w);
     
     mat.transmission_roughness = max(max(mat.transmission_roughness, MIN_ROUGHNESS), roughnessMinimum);
     mat.roughness = max(max(mat.roughness, MIN_ROUGHNESS), roughnessMinimum);
@@ -992,8 +1005,8 @@ OPTIX_RAYGEN_PROGRAM(rayGen)()
                 dN = make_float3(0.5f, .5f, 1.f);
             } else {
                 dN = sampleTexture(entityMaterial.normal_map_texture_id, uv, make_float3(0.5f, .5f, 0.f));
-                GET(TextureStruct tex, TextureStruct, LP.textures, entityMaterial.normal_map_texture_id);
                 // For DirectX normal maps. 
+                // GET(TextureStruct tex, TextureStruct, LP.textures, entityMaterial.normal_map_texture_id);
                 // if (!tex.rightHanded) {
                 //     dN.y = 1.f - dN.y;
                 // }
@@ -1197,24 +1210,45 @@ OPTIX_RAYGEN_PROGRAM(rayGen)()
                 (LP.environmentMapRows != nullptr) && (LP.environmentMapCols != nullptr) 
             ) 
             {
-                // Reduces noise for strangely noisy dome light textures, but at the expense 
-                // of a highly uncoalesced binary search through a 2D CDF.
+                // Reduces noise for strangely noisy dome light textures, at the expense of 
+                // either a highly uncoalesced binary search through a 2D CDF, or an alias table lookup.
                 // disabled by default to avoid the hit to performance
                 float rx = lcg_randomf(rng);
                 float ry = lcg_randomf(rng);
-                float* rows = LP.environmentMapRows;
-                float* cols = LP.environmentMapCols;
                 int width = LP.environmentMapWidth;
                 int height = LP.environmentMapHeight;
-                float invjacobian = width * height / float(4 * M_PI);
-                float row_pdf, col_pdf;
+                float cellProbability;
                 unsigned x, y;
-                ry = sample_cdf(rows, height, ry, &y, &row_pdf);
-                y = max(min(y, height - 1), 0);
-                rx = sample_cdf(cols + y * width, width, rx, &x, &col_pdf);
-                lightDir = make_float3(toPolar(vec2((x /*+ rx*/) / float(width), (y/* + ry*/)/float(height))));
+                if (LP.environmentMapAlias != nullptr) {
+                    unsigned count = width * height;
+                    float u = lcg_randomf(rng) * count;
+                    unsigned i = min(unsigned(u), count - 1);
+                    EnvironmentAliasStruct entry = LP.environmentMapAlias[i];
+                    if ((u - i) >= entry.probability) {
+                        i = entry.alias;
+                        entry = LP.environmentMapAlias[i];
+                    }
+                    cellProbability = entry.cellProbability;
+                    x = i % width;
+                    y = i / width;
+                } else {
+                    float* rows = LP.environmentMapRows;
+                    float* cols = LP.environmentMapCols;
+                    float row_pdf, col_pdf;
+                    sample_cdf(rows, height, ry, &y, &row_pdf);
+                    y = max(min(y, height - 1), 0);
+                    sample_cdf(cols + y * width, width, rx, &x, &col_pdf);
+                    x = max(min(x, width - 1), 0);
+                    cellProbability = row_pdf * col_pdf;
+                }
+                // Directions are uniform in uv within the sampled cell, so convert from 
+                // area in uv to solid angle, which is stretched by sin(theta)
+                float v = (y + lcg_randomf(rng)) / float(height);
+                float u = (x + lcg_randomf(rng)) / float(width);
+                float sinTheta = sinf(M_PI * v);
+                lightDir = make_float3(toPolar(vec2(u, v)));
                 lightDir = glm::inverse(LP.environmentMapRotation) * lightDir;
-                lightPDF = row_pdf * col_pdf * invjacobian;
+                lightPDF = (sinTheta > 0.f) ? cellProbability * width * height / (2.f * M_PI * M_PI * sinTheta) : 0.f;
             } 
             else 
             {            
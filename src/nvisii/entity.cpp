@@ -11,7 +11,7 @@ namespace nvisii {
 
 std::vector<Entity> Entity::entities;
 std::vector<EntityStruct> Entity::entityStructs;
-std::map<std::string, uint32_t> Entity::lookupTable;
+LookupTable Entity::lookupTable;
 std::shared_ptr<std::recursive_mutex> Entity::editMutex;
 bool Entity::factoryInitialized = false;
 std::set<Entity*> Entity::dirtyEntities;
@@ -306,16 +306,20 @@ void Entity::setVisibility(
 
 glm::vec3 Entity::getMinAabbCorner()
 {
+	// the transform hierarchy might have been edited since this AABB was computed
+	Transform::updateWorldMatrices();
 	return entityStructs[id].bbmin;
 }
 
 glm::vec3 Entity::getMaxAabbCorner()
 {
+	Transform::updateWorldMatrices();
 	return entityStructs[id].bbmax;
 }
 
 glm::vec3 Entity::getAabbCenter()
 {
+	Transform::updateWorldMatrices();
 	return entityStructs[id].bbmin + (entityStructs[id].bbmax - entityStructs[id].bbmin) * .5f;
 }
 
@@ -460,6 +464,44 @@ Entity* Entity::create(
 	}
 }
 
+std::vector<Entity*> Entity::createMany(
+	std::vector<std::string> names, 
+	std::vector<Transform*> transforms, 
+	std::vector<Material*> materials, 
+	std::vector<Mesh*> meshes, 
+	std::vector<Light*> lights, 
+	std::vector<Camera*> cameras,
+	std::vector<Volume*> volumes
+) {
+	// Validate components before creating anything, so that a bad batch leaves the table untouched
+	size_t count = names.size();
+	for (size_t i = 0; i < count; ++i) {
+		getBatchComponent(transforms, count, i, "transforms");
+		getBatchComponent(materials, count, i, "materials");
+		getBatchComponent(lights, count, i, "lights");
+		getBatchComponent(cameras, count, i, "cameras");
+		auto mesh = getBatchComponent(meshes, count, i, "meshes");
+		auto volume = getBatchComponent(volumes, count, i, "volumes");
+		if ((volume != nullptr) && (mesh != nullptr)) throw std::runtime_error(
+			"Error, mesh and volume components cannot be simultaneously attached to an entity."
+		);
+		if (mesh && !mesh->isInitialized()) throw std::runtime_error("Error, mesh not initialized");
+		if (volume && !volume->isInitialized()) throw std::runtime_error("Error, volume not initialized");
+	}
+
+	auto createEntity = [&] (Entity* entity, size_t i) {
+		entity->setVisibility(true);
+		if (auto transform = getBatchComponent(transforms, count, i, "transforms")) entity->setTransform(transform);
+		if (auto material = getBatchComponent(materials, count, i, "materials")) entity->setMaterial(material);
+		if (auto camera = getBatchComponent(cameras, count, i, "cameras")) entity->setCamera(camera);
+		if (auto mesh = getBatchComponent(meshes, count, i, "meshes")) entity->setMesh(mesh);
+		if (auto light = getBatchComponent(lights, count, i, "lights")) entity->setLight(light);
+		if (auto volume = getBatchComponent(volumes, count, i, "volumes")) entity->setVolume(volume);
+		dirtyEntities.insert(entity);
+	};
+	return StaticFactory::createMany<Entity>(editMutex, names, "Entity", lookupTable, entities.data(), entities.size(), createEntity);
+}
+
 std::shared_ptr<std::recursive_mutex> Entity::getEditMutex()
 {
 	return editMutex;
@@ -506,7 +548,7 @@ int32_t Entity::getId()
 
 std::map<std::string, uint32_t> Entity::getNameToIdMap()
 {
-	return lookupTable;
+	return lookupTable.toMap();
 }
 
 };
@@ -5,7 +5,7 @@ namespace nvisii {
 
 std::vector<Light> Light::lights;
 std::vector<LightStruct> Light::lightStructs;
-std::map<std::string, uint32_t> Light::lookupTable;
+LookupTable Light::lookupTable;
 std::shared_ptr<std::recursive_mutex> Light::editMutex;
 bool Light::factoryInitialized = false;
 bool Light::anyDirty = true;
@@ -263,7 +263,7 @@ std::string Light::getName()
 
 std::map<std::string, uint32_t> Light::getNameToIdMap()
 {
-	return lookupTable;
+	return lookupTable.toMap();
 }
 
 };
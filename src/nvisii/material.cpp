@@ -5,7 +5,7 @@ namespace nvisii {
 
 std::vector<Material> Material::materials;
 std::vector<MaterialStruct> Material::materialStructs;
-std::map<std::string, uint32_t> Material::lookupTable;
+LookupTable Material::lookupTable;
 std::shared_ptr<std::recursive_mutex> Material::editMutex;
 bool Material::factoryInitialized = false;
 bool Material::anyDirty = true;
@@ -20,42 +20,8 @@ Material::Material(std::string name, uint32_t id)
 	this->name = name;
 	this->id = id;
 
-	/* Working off blender's principled BSDF */
-	this->base_color = vec4(.8, .8, .8, 1.0);
-	this->subsurface_radius = vec4(1.0, .2, .1, 1.0);
-	this->subsurface_color = vec4(.8, .8, .8, 1.0);
-	this->subsurface = 0.0;
-	this->metallic = 0.0;
-	this->specular = .5;
-	this->specular_tint = 0.0;
-	this->roughness = .5;
-	this->anisotropic = 0.0;
-	this->anisotropic_rotation = 0.0;
-	this->sheen = 0.0;
-	this->sheen_tint = 0.5;
-	this->clearcoat = 0.0;
-	this->clearcoat_roughness = .03f;
-	this->ior = 1.45f;
-	this->transmission = 0.0;
-	this->transmission_roughness = 0.0;
-	materialStructs[id].transmission_roughness_texture_id = -1;
-	materialStructs[id].base_color_texture_id = -1;
-	materialStructs[id].roughness_texture_id = -1;
-	materialStructs[id].alpha_texture_id = -1;
-	materialStructs[id].normal_map_texture_id = -1;
-	materialStructs[id].subsurface_color_texture_id = -1;
-	materialStructs[id].subsurface_radius_texture_id = -1;
-	materialStructs[id].subsurface_texture_id = -1;
-	materialStructs[id].metallic_texture_id = -1;
-	materialStructs[id].specular_texture_id = -1;
-	materialStructs[id].specular_tint_texture_id = -1;
-	materialStructs[id].anisotropic_texture_id = -1;
-	materialStructs[id].anisotropic_rotation_texture_id = -1;
-	materialStructs[id].sheen_texture_id = -1;
-	materialStructs[id].clearcoat_texture_id = -1;
-	materialStructs[id].clearcoat_roughness_texture_id = -1;
-	materialStructs[id].ior_texture_id = -1;
-	materialStructs[id].transmission_texture_id = -1;
+	/* Constants default to blender's principled BSDF, with no textures bound */
+	materialStructs[id] = MaterialStruct();
 }
 
 std::string Material::toString() {
@@ -178,6 +144,30 @@ Material* Material::create(std::string name,
 	}
 }
 
+std::vector<Material*> Material::createMany(std::vector<std::string> names,
+	std::vector<float> base_colors,
+	std::vector<float> roughness,
+	std::vector<float> metallic)
+{
+	// Validate list lengths before creating anything
+	size_t count = names.size();
+	if (base_colors.size() > 0) getBatchOffset(base_colors, 3, count, 0, "base_colors");
+	if (roughness.size() > 0) getBatchOffset(roughness, 1, count, 0, "roughness");
+	if (metallic.size() > 0) getBatchOffset(metallic, 1, count, 0, "metallic");
+
+	auto createMaterial = [&] (Material* mat, size_t i) {
+		if (base_colors.size() > 0) {
+			const float* c = &base_colors[getBatchOffset(base_colors, 3, count, i, "base_colors")];
+			mat->setBaseColor(vec3(c[0], c[1], c[2]));
+		}
+		if (roughness.size() > 0) mat->setRoughness(roughness[getBatchOffset(roughness, 1, count, i, "roughness")]);
+		if (metallic.size() > 0) mat->setMetallic(metallic[getBatchOffset(metallic, 1, count, i, "metallic")]);
+		anyDirty = true;
+	};
+
+	return StaticFactory::createMany<Material>(editMutex, names, "Material", lookupTable, materials.data(), materials.size(), createMaterial);
+}
+
 std::shared_ptr<std::recursive_mutex> Material::getEditMutex()
 {
 	return editMutex;
@@ -212,19 +202,21 @@ std::string Material::getName()
 
 std::map<std::string, uint32_t> Material::getNameToIdMap()
 {
-	return lookupTable;
+	return lookupTable.toMap();
 }
 
 void Material::setBaseColor(glm::vec3 color) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	base_color.r = color.r;
-	base_color.g = color.g;
-	base_color.b = color.b;
+	auto &material = getStruct();
+	material.base_color.r = color.r;
+	material.base_color.g = color.g;
+	material.base_color.b = color.b;
 	markDirty();
 }
 
 glm::vec3 Material::getBaseColor() {
-	return vec3(base_color.r, base_color.g, base_color.b);
+	auto &material = getStruct();
+	return vec3(material.base_color.r, material.base_color.g, material.base_color.b);
 }
 
 void Material::setBaseColorTexture(Texture *texture) 
@@ -249,14 +241,16 @@ void Material::clearBaseColorTexture() {
 
 void Material::setSubsurfaceColor(glm::vec3 color) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	subsurface_color.r = color.r;
-	subsurface_color.g = color.g;
-	subsurface_color.b = color.b;
+	auto &material = getStruct();
+	material.subsurface_color.r = color.r;
+	material.subsurface_color.g = color.g;
+	material.subsurface_color.b = color.b;
 	markDirty();
 }
 
 glm::vec3 Material::getSubsurfaceColor() {
-	return glm::vec3(subsurface_color.r, subsurface_color.g, subsurface_color.b);
+	auto &material = getStruct();
+	return glm::vec3(material.subsurface_color.r, material.subsurface_color.g, material.subsurface_color.b);
 }
 
 void Material::setSubsurfaceColorTexture(Texture *texture) 
@@ -281,12 +275,13 @@ void Material::clearSubsurfaceColorTexture() {
 
 void Material::setSubsurfaceRadius(glm::vec3 radius) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	subsurface_radius = glm::vec4(radius.x, radius.y, radius.z, 0.0);
+	getStruct().subsurface_radius = glm::vec4(radius.x, radius.y, radius.z, 0.0);
 	markDirty();
 }
 
 glm::vec3 Material::getSubsurfaceRadius() {
-	return glm::vec3(subsurface_radius.x, subsurface_radius.y, subsurface_radius.z);
+	auto &material = getStruct();
+	return glm::vec3(material.subsurface_radius.x, material.subsurface_radius.y, material.subsurface_radius.z);
 }
 
 void Material::setSubsurfaceRadiusTexture(Texture *texture) 
@@ -312,13 +307,13 @@ void Material::clearSubsurfaceRadiusTexture() {
 void Material::setAlpha(float a) 
 {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	base_color.a = a;
+	getStruct().base_color.a = a;
 	markDirty();
 }
 
 float Material::getAlpha()
 {
-	return base_color.a;
+	return getStruct().base_color.a;
 }
 
 void Material::setAlphaTexture(Texture *texture, int channel) 
@@ -344,12 +339,12 @@ void Material::clearAlphaTexture() {
 
 void Material::setSubsurface(float subsurface) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->subsurface = subsurface;
+	getStruct().subsurface = subsurface;
 	markDirty();
 }
 
 float Material::getSubsurface() {
-	return this->subsurface;
+	return getStruct().subsurface;
 }
 
 void Material::setSubsurfaceTexture(Texture *texture, int channel) 
@@ -375,12 +370,12 @@ void Material::clearSubsurfaceTexture() {
 
 void Material::setMetallic(float metallic) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->metallic = metallic;
+	getStruct().metallic = metallic;
 	markDirty();
 }
 
 float Material::getMetallic() {
-	return metallic;
+	return getStruct().metallic;
 }
 
 void Material::setMetallicTexture(Texture *texture, int channel) 
@@ -406,12 +401,12 @@ void Material::clearMetallicTexture() {
 
 void Material::setSpecular(float specular) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->specular = specular;
+	getStruct().specular = specular;
 	markDirty();
 }
 
 float Material::getSpecular() {
-	return specular;
+	return getStruct().specular;
 }
 
 void Material::setSpecularTexture(Texture *texture, int channel) 
@@ -437,13 +432,13 @@ void Material::clearSpecularTexture() {
 
 void Material::setSpecularTint(float specular_tint) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->specular_tint = specular_tint;
+	getStruct().specular_tint = specular_tint;
 	markDirty();
 }
 
 float Material::getSpecularTint() {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	return specular_tint;
+	return getStruct().specular_tint;
 }
 
 void Material::setSpecularTintTexture(Texture *texture, int channel) 
@@ -469,12 +464,12 @@ void Material::clearSpecularTintTexture() {
 
 void Material::setRoughness(float roughness) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->roughness = roughness;
+	getStruct().roughness = roughness;
 	markDirty();
 }
 
 float Material::getRoughness() {
-	return roughness;
+	return getStruct().roughness;
 }
 
 void Material::setRoughnessTexture(Texture *texture, int channel) 
@@ -500,12 +495,12 @@ void Material::clearRoughnessTexture() {
 
 void Material::setAnisotropic(float anisotropic) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->anisotropic = anisotropic;
+	getStruct().anisotropic = anisotropic;
 	markDirty();
 }
 
 float Material::getAnisotropic() {
-	return anisotropic;
+	return getStruct().anisotropic;
 }
 
 void Material::setAnisotropicTexture(Texture *texture, int channel) 
@@ -531,12 +526,12 @@ void Material::clearAnisotropicTexture() {
 
 void Material::setAnisotropicRotation(float anisotropic_rotation) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->anisotropic_rotation = anisotropic_rotation;
+	getStruct().anisotropic_rotation = anisotropic_rotation;
 	markDirty();
 }
 
 float Material::getAnisotropicRotation() {
-	return anisotropic_rotation;
+	return getStruct().anisotropic_rotation;
 }
 
 void Material::setAnisotropicRotationTexture(Texture *texture, int channel) 
@@ -562,12 +557,12 @@ void Material::clearAnisotropicRotationTexture() {
 
 void Material::setSheen(float sheen) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->sheen = sheen;
+	getStruct().sheen = sheen;
 	markDirty();
 }
 
 float Material::getSheen() {
-	return sheen;
+	return getStruct().sheen;
 }
 
 void Material::setSheenTexture(Texture *texture, int channel) 
@@ -593,12 +588,12 @@ void Material::clearSheenTexture() {
 
 void Material::setSheenTint(float sheen_tint) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->sheen_tint = sheen_tint;
+	getStruct().sheen_tint = sheen_tint;
 	markDirty();
 }
 
 float Material::getSheenTint() {
-	return sheen_tint;
+	return getStruct().sheen_tint;
 }
 
 void Material::setSheenTintTexture(Texture *texture, int channel) 
@@ -624,12 +619,12 @@ void Material::clearSheenTintTexture() {
 
 void Material::setClearcoat(float clearcoat) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->clearcoat = clearcoat;
+	getStruct().clearcoat = clearcoat;
 	markDirty();
 }
 
 float Material::getClearcoat() {
-	return clearcoat;
+	return getStruct().clearcoat;
 }
 
 void Material::setClearcoatTexture(Texture *texture, int channel) 
@@ -655,12 +650,12 @@ void Material::clearClearcoatTexture() {
 
 void Material::setClearcoatRoughness(float clearcoat_roughness) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->clearcoat_roughness = clearcoat_roughness;
+	getStruct().clearcoat_roughness = clearcoat_roughness;
 	markDirty();
 }
 
 float Material::getClearcoatRoughness() {
-	return clearcoat_roughness;
+	return getStruct().clearcoat_roughness;
 }
 
 void Material::setClearcoatRoughnessTexture(Texture *texture, int channel) 
@@ -686,12 +681,12 @@ void Material::clearClearcoatRoughnessTexture() {
 
 void Material::setIor(float ior) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->ior = ior;
+	getStruct().ior = ior;
 	markDirty();
 }
 
 float Material::getIor() {
-	return ior;
+	return getStruct().ior;
 }
 
 void Material::setIorTexture(Texture *texture, int channel) 
@@ -717,12 +712,12 @@ void Material::clearIorTexture() {
 
 void Material::setTransmission(float transmission) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->transmission = transmission;
+	getStruct().transmission = transmission;
 	markDirty();
 }
 
 float Material::getTransmission() {
-	return transmission;
+	return getStruct().transmission;
 }
 
 void Material::setTransmissionTexture(Texture *texture, int channel) 
@@ -748,12 +743,12 @@ void Material::clearTransmissionTexture() {
 
 void Material::setTransmissionRoughness(float transmission_roughness) {
 	std::lock_guard<std::recursive_mutex> lock(*Material::getEditMutex().get());
-	this->transmission_roughness = transmission_roughness;
+	getStruct().transmission_roughness = transmission_roughness;
 	markDirty();
 }
 
 float Material::getTransmissionRoughness() {
-	return transmission_roughness;
+	return getStruct().transmission_roughness;
 }
 
 void Material::setTransmissionRoughnessTexture(Texture *texture, int channel) 
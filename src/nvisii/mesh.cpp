@@ -1,5 +1,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <functional>
 #include <limits>
 #include <fcntl.h>
@@ -14,9 +17,13 @@
 #define GLM_FORCE_RIGHT_HANDED
 
 #include <glm/gtx/vector_angle.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/constants.hpp>
 
 #include <nvisii/mesh.h>
 #include <nvisii/entity.h>
+#include <nvisii/utilities/parallel.h>
+#include <nvisii/utilities/mesh_readers.h>
 
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
@@ -28,7 +35,7 @@ namespace nvisii {
 
 std::vector<Mesh> Mesh::meshes;
 std::vector<MeshStruct> Mesh::meshStructs;
-std::map<std::string, uint32_t> Mesh::lookupTable;
+LookupTable Mesh::lookupTable;
 std::shared_ptr<std::recursive_mutex> Mesh::editMutex;
 bool Mesh::factoryInitialized = false;
 std::set<Mesh*> Mesh::dirtyMeshes;
@@ -87,58 +94,215 @@ void Mesh::markDirty() {
 	}
 };
 
-std::vector<std::array<float, 3>> Mesh::getVertices() {
+const std::vector<std::array<float, 3>> &Mesh::getVertices() {
+	if (compressed) decompress();
 	return positions;
 }
 
-std::vector<glm::vec4> Mesh::getColors() {
+const std::vector<glm::vec4> &Mesh::getColors() {
+	if (compressed) decompress();
 	return colors;
 }
 
-std::vector<glm::vec4> Mesh::getNormals() {
+const std::vector<glm::vec4> &Mesh::getNormals() {
+	if (compressed) decompress();
 	return normals;
 }
 
-std::vector<glm::vec4> Mesh::getTangents() {
+const std::vector<glm::vec4> &Mesh::getTangents() {
+	if (compressed) decompress();
 	return tangents;
 }
 
-std::vector<glm::vec2> Mesh::getTexCoords() {
+const std::vector<glm::vec2> &Mesh::getTexCoords() {
+	if (compressed) decompress();
 	return texCoords;
 }
 
-std::vector<uint32_t> Mesh::getTriangleIndices() {
+const std::vector<uint32_t> &Mesh::getTriangleIndices() {
 	return triangleIndices;
 }
 
+void Mesh::getVerticesView(float** data, int* rows, int* cols) {
+	if (compressed) decompress();
+	*data = (positions.size() > 0) ? positions[0].data() : nullptr;
+	*rows = int(positions.size());
+	*cols = 3;
+}
+
+void Mesh::getColorsView(float** data, int* rows, int* cols) {
+	if (compressed) decompress();
+	*data = (colors.size() > 0) ? glm::value_ptr(colors[0]) : nullptr;
+	*rows = int(colors.size());
+	*cols = 4;
+}
+
+void Mesh::getNormalsView(float** data, int* rows, int* cols) {
+	if (compressed) decompress();
+	*data = (normals.size() > 0) ? glm::value_ptr(normals[0]) : nullptr;
+	*rows = int(normals.size());
+	*cols = 4;
+}
+
+void Mesh::getTangentsView(float** data, int* rows, int* cols) {
+	if (compressed) decompress();
+	*data = (tangents.size() > 0) ? glm::value_ptr(tangents[0]) : nullptr;
+	*rows = int(tangents.size());
+	*cols = 4;
+}
+
+void Mesh::getTexCoordsView(float** data, int* rows, int* cols) {
+	if (compressed) decompress();
+	*data = (texCoords.size() > 0) ? glm::value_ptr(texCoords[0]) : nullptr;
+	*rows = int(texCoords.size());
+	*cols = 2;
+}
+
+void Mesh::getTriangleIndicesView(uint32_t** data, int* length) {
+	*data = triangleIndices.data();
+	*length = int(triangleIndices.size());
+}
+
+/* Positions are reduced in chunks of this many vertices. Meshes smaller than this are reduced on the calling thread */
+static const size_t METADATA_CHUNK_SIZE = 1 << 16;
+
+/* 
+ * Returns the index of the position farthest from "from", reducing over chunks of 
+ * positions in parallel.
+ */
+static size_t findFarthestPosition(const std::vector<std::array<float, 3>> &positions, glm::vec3 from)
+{
+	std::mutex mutex;
+	size_t farthest = 0;
+	float farthestDist2 = -1.f;
+	Parallel::forRange(0, positions.size(), METADATA_CHUNK_SIZE, [&] (size_t begin, size_t end) {
+		size_t localIdx = begin;
+		float localDist2 = -1.f;
+		for (size_t i = begin; i < end; ++i) {
+			float dx = positions[i][0] - from.x;
+			float dy = positions[i][1] - from.y;
+			float dz = positions[i][2] - from.z;
+			float d2 = dx * dx + dy * dy + dz * dz;
+			if (d2 > localDist2) { localDist2 = d2; localIdx = i; }
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		if (localDist2 > farthestDist2 || (localDist2 == farthestDist2 && localIdx < farthest)) {
+			farthestDist2 = localDist2; 
+			farthest = localIdx;
+		}
+	});
+	return farthest;
+}
+
+/* Returns the smallest sphere (center xyz, radius w) containing both spheres a and b */
+static glm::vec4 mergeSpheres(glm::vec4 a, glm::vec4 b)
+{
+	glm::vec3 ab = glm::vec3(b) - glm::vec3(a);
+	float d = glm::length(ab);
+	if (d + b.w <= a.w) return a;
+	if (d + a.w <= b.w) return b;
+	float r = (d + a.w + b.w) * .5f;
+	glm::vec3 c = glm::vec3(a) + ab * ((r - a.w) / d);
+	return glm::vec4(c, r);
+}
+
 void Mesh::computeMetadata()
 {
-	// Compute AABB and center
-	glm::vec4 s(0.0);
-	meshStructs[id].bbmin = glm::vec4(std::numeric_limits<float>::max());
-	meshStructs[id].bbmax = glm::vec4( std::numeric_limits<float>::lowest());
-	meshStructs[id].bbmax.w = 0.f;
-	meshStructs[id].bbmin.w = 0.f;
-	for (int i = 0; i < positions.size(); i += 1)
-	{	
-		auto p = glm::vec3(positions[i][0], positions[i][1], positions[i][2]);
-		s += glm::vec4(p[0], p[1], p[2], 0.0f);
-		meshStructs[id].bbmin = glm::vec4(glm::min(p, glm::vec3(meshStructs[id].bbmin)), 0.0);
-		meshStructs[id].bbmax = glm::vec4(glm::max(p, glm::vec3(meshStructs[id].bbmax)), 0.0);
+	auto &meshStruct = meshStructs[id];
+	meshStruct.numTris = uint32_t(triangleIndices.size()) / 3;
+	meshStruct.numVerts = uint32_t(positions.size());
+	if (positions.size() == 0) {
+		meshStruct.center = meshStruct.bbmin = meshStruct.bbmax = glm::vec4(0.f);
+		meshStruct.bounding_sphere_radius = 0.f;
+		return;
 	}
-	s /= (float)positions.size();
-	meshStructs[id].center = s;
-
-	// Bounding Sphere
-	meshStructs[id].bounding_sphere_radius = 0.0;
-	for (int i = 0; i < positions.size(); i += 1) {
-		glm::vec3 p = glm::vec3(positions[i][0], positions[i][1], positions[i][2]);
-		meshStructs[id].bounding_sphere_radius = std::max(meshStructs[id].bounding_sphere_radius, 
-			glm::distance(glm::vec4(p.x, p.y, p.z, 0.0f), meshStructs[id].center));
+
+	// Compute AABB and center in one pass. Each fixed size chunk reduces into its own 
+	// slot over the raw position floats so that the min/max/sum loop can be vectorized, 
+	// and the slots are then merged in chunk order, so the result does not depend on 
+	// the number of threads or the order in which chunks finish.
+	struct ChunkBounds { double sum[3]; float lo[3]; float hi[3]; };
+	size_t numChunks = (positions.size() + METADATA_CHUNK_SIZE - 1) / METADATA_CHUNK_SIZE;
+	std::vector<ChunkBounds> chunks(numChunks);
+	const float *data = positions[0].data();
+	Parallel::forEach(0, numChunks, 1, [&] (size_t chunk) {
+		size_t begin = chunk * METADATA_CHUNK_SIZE;
+		size_t end = std::min(begin + METADATA_CHUNK_SIZE, positions.size());
+		double s[3] = {0.0, 0.0, 0.0};
+		float l[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+		float h[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+		for (size_t i = begin; i < end; ++i) {
+			for (int c = 0; c < 3; ++c) {
+				float v = data[i * 3 + c];
+				s[c] += v;
+				l[c] = (v < l[c]) ? v : l[c];
+				h[c] = (v > h[c]) ? v : h[c];
+			}
+		}
+		for (int c = 0; c < 3; ++c) {
+			chunks[chunk].sum[c] = s[c];
+			chunks[chunk].lo[c] = l[c];
+			chunks[chunk].hi[c] = h[c];
+		}
+	});
+	double sum[3] = {0.0, 0.0, 0.0};
+	float lo[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+	float hi[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+	for (auto &chunk : chunks) {
+		for (int c = 0; c < 3; ++c) {
+			sum[c] += chunk.sum[c];
+			lo[c] = std::min(lo[c], chunk.lo[c]);
+			hi[c] = std::max(hi[c], chunk.hi[c]);
+		}
 	}
+	double count = double(positions.size());
+	meshStruct.center = glm::vec4(float(sum[0] / count), float(sum[1] / count), float(sum[2] / count), 0.f);
+	meshStruct.bbmin = glm::vec4(lo[0], lo[1], lo[2], 0.f);
+	meshStruct.bbmax = glm::vec4(hi[0], hi[1], hi[2], 0.f);
+
+	// Bounding Sphere, which depends on the center and so needs its own pass
+	size_t farthest = findFarthestPosition(positions, glm::vec3(meshStruct.center));
+	meshStruct.bounding_sphere_radius = glm::distance(
+		glm::vec3(positions[farthest][0], positions[farthest][1], positions[farthest][2]),
+		glm::vec3(meshStruct.center));
+}
 
-	this->meshStructs[id].numTris = uint32_t(triangleIndices.size()) / 3;
-	this->meshStructs[id].numVerts = uint32_t(positions.size());
+glm::vec4 Mesh::computeTightBoundingSphere()
+{
+	if (compressed) decompress();
+	if (positions.size() == 0) return glm::vec4(0.f);
+	auto position = [this] (size_t i) {
+		return glm::vec3(positions[i][0], positions[i][1], positions[i][2]);
+	};
+
+	// Ritter's algorithm. Start from the two mutually distant positions y and z...
+	glm::vec3 y = position(findFarthestPosition(positions, position(0)));
+	glm::vec3 z = position(findFarthestPosition(positions, y));
+	glm::vec4 initial = glm::vec4((y + z) * .5f, glm::distance(y, z) * .5f);
+
+	// ...then grow the sphere to include any positions outside of it. Each fixed size 
+	// chunk grows its own copy of the initial sphere into its own slot, and the slots 
+	// are merged in chunk order, so that the result is the same from run to run.
+	size_t numChunks = (positions.size() + METADATA_CHUNK_SIZE - 1) / METADATA_CHUNK_SIZE;
+	std::vector<glm::vec4> chunkSpheres(numChunks);
+	Parallel::forEach(0, numChunks, 1, [&] (size_t chunk) {
+		size_t begin = chunk * METADATA_CHUNK_SIZE;
+		size_t end = std::min(begin + METADATA_CHUNK_SIZE, positions.size());
+		glm::vec3 c = glm::vec3(initial);
+		float r = initial.w;
+		for (size_t i = begin; i < end; ++i) {
+			glm::vec3 p = position(i);
+			float d = glm::distance(p, c);
+			if (d <= r) continue;
+			float newR = (r + d) * .5f;
+			c += (p - c) * ((newR - r) / d);
+			r = newR;
+		}
+		chunkSpheres[chunk] = glm::vec4(c, r);
+	});
+	glm::vec4 sphere = initial;
+	for (auto &chunkSphere : chunkSpheres) sphere = mergeSpheres(sphere, chunkSphere);
+	return sphere;
 }
 
 glm::vec3 Mesh::getCenter()
@@ -206,6 +370,189 @@ void Mesh::updateComponents()
 	dirtyMeshes.clear();
 } 
 
+/*
+ * Finds identical vertices in a triangle soup using an open addressing hash table with 
+ * linear probing. The table is sized for every vertex up front, and each vertex is either 
+ * found or inserted with a single probe sequence. 
+ * 
+ * Without an epsilon, vertices are compared by the exact bits of each attribute (with -0 and 0 
+ * considered equal). With an epsilon, vertices are hashed by the cell of a grid with spacing 
+ * 2 * epsilon that holds their position. A vertex within epsilon of another then lies either in 
+ * the same cell or, along each axis, in the neighboring cell on the side nearest to it, so at most 
+ * 2^3 cells are probed. Candidates found there are welded only if each of their attributes is 
+ * within epsilon (Euclidean distance) of the vertex's.
+ */
+class VertexWelder {
+	public:
+	VertexWelder(size_t numVertices, float epsilon) 
+		: epsilon(epsilon), invCellSize((epsilon > 0.f) ? 0.5 / double(epsilon) : 0.0)
+	{
+		if (std::isnan(epsilon) || std::isinf(epsilon)) 
+			throw std::runtime_error("Error: weld_epsilon must be a finite number.");
+		size_t capacity = 16;
+		while (capacity < numVertices + numVertices / 2) capacity *= 2;
+		slots.resize(capacity, 0);
+		mask = capacity - 1;
+	}
+
+	/* 
+	 * Adds a per vertex attribute, using the first "count" of every "dimensions" floats. 
+	 * The first attribute added must be the positions, which are used to hash vertices with an epsilon. 
+	 */
+	void addAttribute(const float *data, uint32_t dimensions, uint32_t count, size_t numVertices)
+	{
+		if (attributes.empty() && (invCellSize > 0.0)) {
+			// grid cells are integers, so the scaled positions must stay well within range
+			float largest = 0.f;
+			for (size_t i = 0; i < numVertices; ++i) {
+				for (uint32_t c = 0; c < count; ++c) {
+					float v = std::fabs(data[i * dimensions + c]);
+					if (v > largest && !std::isinf(v)) largest = v;
+				}
+			}
+			if (double(largest) * invCellSize >= MAX_CELL)
+				throw std::runtime_error("Error: weld_epsilon is too small for the range of the positions.");
+		}
+		attributes.push_back({data, dimensions, count});
+		keyLength += count;
+	}
+
+	/* 
+	 * Returns the index of the earliest inserted vertex that the given vertex welds to. 
+	 * If there is none, the given vertex is inserted and its own index returned. 
+	 */
+	uint32_t findOrInsert(uint32_t vertex)
+	{
+		return (invCellSize > 0.0) ? findOrInsertNear(vertex) : findOrInsertExact(vertex);
+	}
+
+	private:
+	static const uint32_t MAX_KEY_LENGTH = 18;
+	static constexpr double MAX_CELL = 4503599627370496.0; // 2^52
+
+	struct Attribute {
+		const float *data;
+		uint32_t dimensions;
+		uint32_t count;
+	};
+
+	static inline void mixHash(uint64_t &hash, uint64_t value)
+	{
+		hash = (hash ^ value) * 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 32;
+	}
+
+	/* Adds the vertex at the first free slot of the probe sequence for the given hash, and returns it */
+	uint32_t insert(uint64_t hash, uint32_t vertex)
+	{
+		size_t slot = size_t(hash) & mask;
+		while (slots[slot] != 0) slot = (slot + 1) & mask;
+		slots[slot] = (uint64_t(uint32_t(hash >> 32)) << 32) | (uint64_t(vertex) + 1);
+		return vertex;
+	}
+
+	/* Writes the exact key of the given vertex, and returns its hash */
+	uint64_t computeExactKey(uint32_t vertex, uint32_t *key) const
+	{
+		uint64_t hash = 0x9E3779B97F4A7C15ull;
+		uint32_t k = 0;
+		for (auto &attribute : attributes) {
+			const float *d = &attribute.data[size_t(vertex) * attribute.dimensions];
+			for (uint32_t c = 0; c < attribute.count; ++c, ++k) {
+				float v = (d[c] == 0.f) ? 0.f : d[c];
+				std::memcpy(&key[k], &v, sizeof(uint32_t));
+				mixHash(hash, key[k]);
+			}
+		}
+		return hash;
+	}
+
+	uint32_t findOrInsertExact(uint32_t vertex)
+	{
+		uint32_t key[MAX_KEY_LENGTH];
+		uint64_t hash = computeExactKey(vertex, key);
+		uint32_t tag = uint32_t(hash >> 32);
+		for (size_t slot = size_t(hash) & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+			uint64_t entry = slots[slot];
+			if (uint32_t(entry >> 32) != tag) continue;
+			uint32_t other = uint32_t(entry & 0xFFFFFFFF) - 1;
+			uint32_t otherKey[MAX_KEY_LENGTH];
+			computeExactKey(other, otherKey);
+			if (std::equal(key, key + keyLength, otherKey)) return other;
+		}
+		return insert(hash, vertex);
+	}
+
+	static uint64_t hashCell(const int64_t cell[3])
+	{
+		uint64_t hash = 0x9E3779B97F4A7C15ull;
+		for (uint32_t c = 0; c < 3; ++c) mixHash(hash, uint64_t(cell[c]));
+		return hash;
+	}
+
+	/* True if every attribute of a is within epsilon of the same attribute of b */
+	bool isNear(uint32_t a, uint32_t b) const
+	{
+		double limit = double(epsilon) * double(epsilon);
+		for (auto &attribute : attributes) {
+			const float *da = &attribute.data[size_t(a) * attribute.dimensions];
+			const float *db = &attribute.data[size_t(b) * attribute.dimensions];
+			double distance = 0.0;
+			for (uint32_t c = 0; c < attribute.count; ++c) {
+				double d = double(da[c]) - double(db[c]);
+				distance += d * d;
+			}
+			if (!(distance <= limit)) return false; // also rejects NaNs
+		}
+		return true;
+	}
+
+	uint32_t findOrInsertNear(uint32_t vertex)
+	{
+		const float *p = &attributes[0].data[size_t(vertex) * attributes[0].dimensions];
+		int64_t cell[3], side[3];
+		for (uint32_t c = 0; c < 3; ++c) {
+			double scaled = double(p[c]) * invCellSize;
+			// infinite and NaN positions never weld, so any cell will do
+			if (!(std::fabs(scaled) < MAX_CELL)) { cell[c] = 0; side[c] = 0; continue; }
+			double f = std::floor(scaled);
+			cell[c] = int64_t(f);
+			side[c] = (scaled - f < .5) ? -1 : 1;
+		}
+
+		uint32_t best = vertex;
+		for (uint32_t corner = 0; corner < 8; ++corner) {
+			int64_t probe[3];
+			bool skip = false;
+			for (uint32_t c = 0; c < 3; ++c) {
+				bool neighbor = ((corner >> c) & 1) != 0;
+				if (neighbor && side[c] == 0) skip = true;
+				probe[c] = cell[c] + (neighbor ? side[c] : 0);
+			}
+			if (skip) continue;
+			uint64_t hash = hashCell(probe);
+			uint32_t tag = uint32_t(hash >> 32);
+			for (size_t slot = size_t(hash) & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+				uint64_t entry = slots[slot];
+				if (uint32_t(entry >> 32) != tag) continue;
+				uint32_t other = uint32_t(entry & 0xFFFFFFFF) - 1;
+				if (other < best && isNear(vertex, other)) best = other;
+			}
+		}
+		if (best != vertex) return best;
+		return insert(hashCell(cell), vertex);
+	}
+
+	std::vector<Attribute> attributes;
+	uint32_t keyLength = 0;
+	float epsilon;
+	double invCellSize;
+
+	/* Each slot holds the upper 32 bits of a hash, and one plus a vertex index. Zero is empty. */
+	std::vector<uint64_t> slots;
+	size_t mask;
+};
+
 void Mesh::loadData(
 	std::vector<float> &positions_, 
 	uint32_t position_dimensions,
@@ -217,7 +564,8 @@ void Mesh::loadData(
 	uint32_t color_dimensions,
 	std::vector<float> &texcoords_, 
 	uint32_t texcoord_dimensions,
-	std::vector<uint32_t> indices_
+	std::vector<uint32_t> indices_,
+	float weld_epsilon
 )
 {
 	bool readingNormals = normals_.size() > 0;
@@ -262,85 +610,73 @@ void Mesh::loadData(
 	if (readingTexCoords && ((texcoords_.size() / texcoord_dimensions) != (positions_.size() / position_dimensions)))
 		throw std::runtime_error( std::string("Error, length mismatch. Total texcoords: " + std::to_string(texcoords_.size() / texcoord_dimensions) + " does not equal total positions: " + std::to_string(positions_.size() / position_dimensions)));
 	
+	size_t numVertices = positions_.size() / position_dimensions;
 	if (readingIndices) {
 		for (uint32_t i = 0; i < indices_.size(); ++i) {
-			if (indices_[i] >= positions_.size())
-				throw std::runtime_error( std::string("Error, index out of bounds. Index " + std::to_string(i) + " is greater than total positions: " + std::to_string(positions_.size() / position_dimensions)));
+			if (indices_[i] >= numVertices)
+				throw std::runtime_error( std::string("Error, index out of bounds. Index " + std::to_string(i) + " is greater than total positions: " + std::to_string(numVertices)));
 		}
 	}
-		
-	std::vector<Vertex> vertices;
-
-	/* For each vertex */
-	for (int i = 0; i < positions_.size() / position_dimensions; ++ i) {
-		Vertex vertex = Vertex();
-		vertex.point.x = positions_[i * position_dimensions + 0];
-		vertex.point.y = positions_[i * position_dimensions + 1];
-		vertex.point.z = positions_[i * position_dimensions + 2];
-		vertex.point.w = (position_dimensions == 4) ? positions_[i * position_dimensions + 3] : 1.f;
-		if (readingNormals) {
-			vertex.normal.x = normals_[i * normal_dimensions + 0];
-			vertex.normal.y = normals_[i * normal_dimensions + 1];
-			vertex.normal.z = normals_[i * normal_dimensions + 2];
-			vertex.normal.w = (normal_dimensions == 4) ? normals_[i * normal_dimensions + 3] : 0.f;
-		}
-		if (readingTangents) {
-			vertex.tangent.x = tangents_[i * tangent_dimensions + 0];
-			vertex.tangent.y = tangents_[i * tangent_dimensions + 1];
-			vertex.tangent.z = tangents_[i * tangent_dimensions + 2];
-			vertex.tangent.w = (tangent_dimensions == 4) ? tangents_[i * tangent_dimensions + 3] : 0.f;
-		}
-		if (readingColors) {
-			vertex.color.x = colors_[i * color_dimensions + 0];
-			vertex.color.y = colors_[i * color_dimensions + 1];
-			vertex.color.z = colors_[i * color_dimensions + 2];
-			vertex.color.w = (color_dimensions == 4) ? colors_[i * color_dimensions + 3] : 1.f;
-		}
-		if (readingTexCoords) {
-			vertex.texcoord.x = texcoords_[i * texcoord_dimensions + 0];      
-			vertex.texcoord.y = texcoords_[i * texcoord_dimensions + 1];      
-		}  
-		vertices.push_back(vertex);
-	}
 
-	/* Eliminate duplicate positions */
-	std::unordered_map<Vertex, uint32_t> uniqueVertexMap = {};
-	std::vector<Vertex> uniqueVertices;
+	if (weld_epsilon < 0.f)
+		throw std::runtime_error( std::string("Error, weld epsilon must be zero or positive."));
+
+	auto readVec4 = [] (const std::vector<float> &data, uint32_t dimensions, size_t i, float w) {
+		const float *d = &data[i * dimensions];
+		return glm::vec4(d[0], d[1], d[2], (dimensions == 4) ? d[3] : w);
+	};
+
+	/* Copies the attributes of the given input vertex to the end of the per vertex buffers */
+	auto appendVertex = [&] (size_t i) {
+		const float *p = &positions_[i * position_dimensions];
+		this->positions.push_back({p[0], p[1], p[2]});
+		this->colors.push_back(readingColors ? readVec4(colors_, color_dimensions, i, 1.f) : glm::vec4(1, 0, 1, 1));
+		this->normals.push_back(readingNormals ? readVec4(normals_, normal_dimensions, i, 0.f) : glm::vec4(0.f));
+		this->tangents.push_back(readingTangents ? readVec4(tangents_, tangent_dimensions, i, 0.f) : glm::vec4(0.f));
+		this->texCoords.push_back(readingTexCoords ? glm::vec2(texcoords_[i * 2 + 0], texcoords_[i * 2 + 1]) : glm::vec2(0.f));
+	};
+
+	this->positions.clear();
+	this->colors.clear();
+	this->normals.clear();
+	this->tangents.clear();
+	this->texCoords.clear();
+	this->triangleIndices.clear();
 
-	/* Don't bin positions as unique when editing, since it's unexpected for a user to lose positions */
-	bool allow_edits = false; // temporary...
+	/* Don't bin positions as unique when indices are given, since it's unexpected for a user to lose positions */
 	if (readingIndices) {
-		this->triangleIndices = indices_;
-		uniqueVertices = vertices;
+		this->positions.reserve(numVertices);
+		this->colors.reserve(numVertices);
+		this->normals.reserve(numVertices);
+		this->tangents.reserve(numVertices);
+		this->texCoords.reserve(numVertices);
+		for (size_t i = 0; i < numVertices; ++i) appendVertex(i);
+		this->triangleIndices = std::move(indices_);
 	}
-	/* If indices werent supplied and editing isn't allowed, optimize by binning unique verts */
-	else {    
-		for (int i = 0; i < vertices.size(); ++i)
-		{
-			Vertex vertex = vertices[i];
-			if (uniqueVertexMap.count(vertex) == 0)
-			{
-				uniqueVertexMap[vertex] = static_cast<uint32_t>(uniqueVertices.size());
-				uniqueVertices.push_back(vertex);
+	/* If indices werent supplied, optimize by welding together identical vertices */
+	else {
+		VertexWelder welder(numVertices, weld_epsilon);
+		welder.addAttribute(positions_.data(), position_dimensions, 3, numVertices);
+		if (readingNormals) welder.addAttribute(normals_.data(), normal_dimensions, normal_dimensions, numVertices);
+		if (readingTangents) welder.addAttribute(tangents_.data(), tangent_dimensions, tangent_dimensions, numVertices);
+		if (readingColors) welder.addAttribute(colors_.data(), color_dimensions, color_dimensions, numVertices);
+		if (readingTexCoords) welder.addAttribute(texcoords_.data(), texcoord_dimensions, texcoord_dimensions, numVertices);
+
+		this->triangleIndices.resize(numVertices);
+		for (size_t i = 0; i < numVertices; ++i) {
+			uint32_t representative = welder.findOrInsert(uint32_t(i));
+			if (representative == i) {
+				this->triangleIndices[i] = uint32_t(this->positions.size());
+				appendVertex(i);
+			} else {
+				this->triangleIndices[i] = this->triangleIndices[representative];
 			}
-			this->triangleIndices.push_back(uniqueVertexMap[vertex]);
 		}
-	}
-
-	/* Map vertices to buffers */
-	this->positions.resize(uniqueVertices.size());
-	this->colors.resize(uniqueVertices.size());
-	this->normals.resize(uniqueVertices.size());
-	this->tangents.resize(uniqueVertices.size());
-	this->texCoords.resize(uniqueVertices.size());
-	for (int i = 0; i < uniqueVertices.size(); ++i)
-	{
-		Vertex v = uniqueVertices[i];
-		this->positions[i] = {v.point.x, v.point.y, v.point.z};
-		this->colors[i] = v.color;
-		this->normals[i] = v.normal;
-		this->tangents[i] = v.tangent;
-		this->texCoords[i] = v.texcoord;
+		this->positions.shrink_to_fit();
+		this->colors.shrink_to_fit();
+		this->normals.shrink_to_fit();
+		this->tangents.shrink_to_fit();
+		this->texCoords.shrink_to_fit();
 	}
 
 	if (!readingNormals) {
@@ -354,165 +690,236 @@ void Mesh::loadData(
 	computeMetadata();
 }
 
-void Mesh::generateSmoothNormals()
+/* 
+ * Polynomial approximation of acos (Abramowitz and Stegun 4.4.45), accurate to 
+ * about 7e-5 radians. This is plenty for angle weighting, and unlike std::acos 
+ * it is branch free, so loops using it can be vectorized by the compiler.
+ */
+static inline float fastAcos(float x)
 {
-	std::vector<std::vector<glm::vec4>> w_normals(positions.size());
+	float ax = std::min(std::fabs(x), 1.0f);
+	float r = std::sqrt(1.0f - ax) * (1.5707288f + ax * (-0.2121144f + ax * (0.0742610f + ax * -0.0187293f)));
+	return (x < 0.0f) ? glm::pi<float>() - r : r;
+}
 
-	for (uint32_t f = 0; f < triangleIndices.size(); f += 3)
-	{
-		uint32_t i1 = triangleIndices[f + 0];
-		uint32_t i2 = triangleIndices[f + 1];
-		uint32_t i3 = triangleIndices[f + 2];
-
-		// p1, p2 and p3 are the positions in the face (f)
-		auto p1 = glm::vec3(positions[i1][0], positions[i1][1], positions[i1][2]);
-		auto p2 = glm::vec3(positions[i2][0], positions[i2][1], positions[i2][2]);
-		auto p3 = glm::vec3(positions[i3][0], positions[i3][1], positions[i3][2]);
-
-		// calculate facet normal of the triangle  using cross product;
-		// both components are "normalized" against a common point chosen as the base
-		auto n = glm::cross((p2 - p1), (p3 - p1));    // p1 is the 'base' here
-
-		// get the angle between the two other positions for each point;
-		// the starting point will be the 'base' and the two adjacent positions will be normalized against it
-		auto a1 = glm::angle(glm::normalize(p2 - p1), glm::normalize(p3 - p1));    // p1 is the 'base' here
-		auto a2 = glm::angle(glm::normalize(p3 - p2), glm::normalize(p1 - p2));    // p2 is the 'base' here
-		auto a3 = glm::angle(glm::normalize(p1 - p3), glm::normalize(p2 - p3));    // p3 is the 'base' here
-
-		// normalize the initial facet normals if you want to ignore surface area
-		// if (!area_weighting)
-		// {
-		//    n = glm::normalize(n);
-		// }
-
-		// store the weighted normal in an structured array
-		auto wn1 = n * a1;
-		auto wn2 = n * a2;
-		auto wn3 = n * a3;
-		w_normals[i1].push_back(glm::vec4(wn1.x, wn1.y, wn1.z, 0.f));
-		w_normals[i2].push_back(glm::vec4(wn2.x, wn2.y, wn2.z, 0.f));
-		w_normals[i3].push_back(glm::vec4(wn3.x, wn3.y, wn3.z, 0.f));
-	}
-	for (uint32_t v = 0; v < w_normals.size(); v++)
-	{
-		glm::vec4 N = glm::vec4(0.0);
+/* 
+ * Returns the interior angle of a triangle at the corner "base". Degenerate 
+ * (zero length) edges result in a weight of zero rather than NaN.
+ */
+static inline float cornerAngle(const glm::vec3 &base, const glm::vec3 &next, const glm::vec3 &prev)
+{
+	glm::vec3 e1 = next - base;
+	glm::vec3 e2 = prev - base;
+	float len = glm::length(e1) * glm::length(e2);
+	if (len <= 0.0f) return 0.0f;
+	return fastAcos(glm::dot(e1, e2) / len);
+}
+
+/* 
+ * Builds a compressed adjacency list from vertices to the triangle corners (indices into 
+ * "indices") which reference them. Corners of vertex v are corners[offsets[v]] through 
+ * corners[offsets[v+1] - 1], in increasing order. Runs in O(V + F).
+ */
+static void buildVertexCorners(
+	const std::vector<uint32_t> &indices, size_t numVertices,
+	std::vector<uint32_t> &offsets, std::vector<uint32_t> &corners)
+{
+	offsets.assign(numVertices + 1, 0);
+	for (size_t c = 0; c < indices.size(); ++c) offsets[indices[c] + 1]++;
+	for (size_t v = 0; v < numVertices; ++v) offsets[v + 1] += offsets[v];
+	std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+	corners.resize(indices.size());
+	for (size_t c = 0; c < indices.size(); ++c) corners[cursor[indices[c]]++] = (uint32_t) c;
+}
+
+/* 
+ * For every vertex, sums faceVector(face, p1, p2, p3) weighted by the interior angle of 
+ * each adjacent face at that vertex, then normalizes the result into output. The face 
+ * vector and the three corner angles of each triangle are computed once, in parallel over 
+ * faces, into one weighted vector per corner. Vertices then gather their own corners in 
+ * parallel, so no locking or per thread accumulation buffers are needed and the result 
+ * is deterministic.
+ */
+template<typename FaceVector>
+static void accumulateAngleWeighted(
+	const std::vector<std::array<float, 3>> &positions,
+	const std::vector<uint32_t> &indices,
+	std::vector<glm::vec4> &output,
+	FaceVector faceVector)
+{
+	std::vector<uint32_t> offsets, corners;
+	buildVertexCorners(indices, positions.size(), offsets, corners);
+	output.resize(positions.size());
+
+	auto position = [&positions] (uint32_t i) {
+		return glm::vec3(positions[i][0], positions[i][1], positions[i][2]);
+	};
 
-		// run through the normals in each vertex's array and interpolate them
-		// vertex(v) here fetches the data of the vertex at index 'v'
-		for (uint32_t n = 0; n < w_normals[v].size(); n++)
-		{
-			N += w_normals[v][n];
+	std::vector<glm::vec3> cornerVectors(indices.size());
+	Parallel::forEach(0, indices.size() / 3, 1 << 14, [&] (size_t face) {
+		uint32_t i[3] = {indices[face * 3 + 0], indices[face * 3 + 1], indices[face * 3 + 2]};
+		glm::vec3 p[3] = {position(i[0]), position(i[1]), position(i[2])};
+		glm::vec3 n = faceVector(i, p);
+		for (uint32_t k = 0; k < 3; ++k) {
+			// the angle at this corner, between the two adjacent positions
+			cornerVectors[face * 3 + k] = n * cornerAngle(p[k], p[(k + 1) % 3], p[(k + 2) % 3]);
 		}
+	});
 
-		// normalize the final normal
-		normals[v] = glm::normalize(glm::vec4(N.x, N.y, N.z, 0.0f));
-	}
+	Parallel::forEach(0, positions.size(), 1 << 14, [&] (size_t v) {
+		glm::vec3 N = glm::vec3(0.f);
+		for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) N += cornerVectors[corners[c]];
+		// vertices with no usable faces are left zero rather than NaN
+		float length = glm::length(N);
+		output[v] = (length > 0.f) ? glm::vec4(N / length, 0.0f) : glm::vec4(0.f);
+	});
+}
+
+void Mesh::generateSmoothNormals()
+{
+	if (compressed) decompress();
+	// the facet normal of the triangle, unnormalized so that it is also weighted by surface area
+	accumulateAngleWeighted(positions, triangleIndices, normals,
+		[] (const uint32_t[3], const glm::vec3 p[3]) {
+			return glm::cross((p[1] - p[0]), (p[2] - p[0]));
+		});
 
 	markDirty();
 }
 
 void Mesh::generateSmoothTangents()
 {
-	tangents.resize(positions.size());
-	std::vector<std::vector<glm::vec4>> w_tangents(positions.size());
-
-	for (uint32_t f = 0; f < triangleIndices.size(); f += 3)
+	if (compressed) decompress();
+	// Compute tangents for normal mapping and anisotropy
+	auto compute_tangent = [] (
+	    glm::vec3 A, glm::vec3 B, glm::vec3 C, 
+	    glm::vec2 H, glm::vec2 K, glm::vec2 L) -> glm::vec3
 	{
-		uint32_t i1 = triangleIndices[f + 0];
-		uint32_t i2 = triangleIndices[f + 1];
-		uint32_t i3 = triangleIndices[f + 2];
+	    glm::vec3 D = B-A;
+	    glm::vec3 E = C-A;
+	    glm::vec2 F = K-H;
+	    glm::vec2 G = L-H;
+	    // texture coordinates that don't span an area give no tangent, rather than a NaN one
+	    float determinant = F.s * G.t - G.s * F.t;
+	    if (determinant == 0.f) return glm::vec3(0.f);
+	    float f = 1.0f / determinant;
+	    glm::vec3 T;
+	    T.x = f * (D.x * G.t - F.t * E.x);
+	    T.y = f * (D.y * G.t - F.t * E.y);
+	    T.z = f * (D.z * G.t - F.t * E.z);
+	    float length = glm::length(T);
+	    if (!(length > 0.f) || std::isinf(length)) return glm::vec3(0.f);
+	    return T / length;
+	};
 
-		// p1, p2 and p3 are the positions in the face (f)
-		auto p1 = glm::vec3(positions[i1][0], positions[i1][1], positions[i1][2]);
-		auto p2 = glm::vec3(positions[i2][0], positions[i2][1], positions[i2][2]);
-		auto p3 = glm::vec3(positions[i3][0], positions[i3][1], positions[i3][2]);
+	accumulateAngleWeighted(positions, triangleIndices, tangents,
+		[this, &compute_tangent] (const uint32_t i[3], const glm::vec3 p[3]) {
+			return compute_tangent(p[0], p[1], p[2], texCoords[i[0]], texCoords[i[1]], texCoords[i[2]]);
+		});
 
-		auto uv1 = texCoords[i1];
-		auto uv2 = texCoords[i2];
-		auto uv3 = texCoords[i3];
+	markDirty();
+}
 
-		// calculate facet normal of the triangle  using cross product;
-		// both components are "normalized" against a common point chosen as the base
-		// auto n = glm::cross((p2 - p1), (p3 - p1));    // p1 is the 'base' here
+/* Encodes every element of input into output in parallel */
+template<typename In, typename Out, typename Encode>
+static void encodeVertexList(std::vector<In> &input, std::vector<Out> &output, Encode encode)
+{
+	output.resize(input.size());
+	Parallel::forEach(0, input.size(), 1 << 14, [&] (size_t i) { output[i] = encode(input[i]); });
+	std::vector<In>().swap(input);
+}
 
+/* Decodes every element of input into output in parallel */
+template<typename In, typename Out, typename Decode>
+static void decodeVertexList(const std::vector<In> &input, std::vector<Out> &output, Decode decode)
+{
+	output.resize(input.size());
+	Parallel::forEach(0, input.size(), 1 << 14, [&] (size_t i) { output[i] = decode(input[i]); });
+}
 
-		// std::vector<Vertex> tangentVertices;
-		// Vertex v1 = vertices[triangle.vertices[0]];
-		// Vertex v2 = vertices[triangle.vertices[1]];
-		// Vertex v3 = vertices[triangle.vertices[2]];
-		
-		// Compute tangents for normal mapping and anisotropy
-		auto compute_tangent = [] (
-		    glm::vec3 A, glm::vec3 B, glm::vec3 C, 
-		    glm::vec2 H, glm::vec2 K, glm::vec2 L) -> glm::vec3
-		{
-		    glm::vec3 D = B-A;
-		    glm::vec3 E = C-A;
-		    glm::vec2 F = K-H;
-		    glm::vec2 G = L-H;
-		    float f = 1.0f / (F.s * G.t - G.s * F.t);
-		    glm::vec3 T;
-		    T.x = f * (D.x * G.t - F.t * E.x);
-		    T.y = f * (D.y * G.t - F.t * E.y);
-		    T.z = f * (D.z * G.t - F.t * E.z);
-		    return glm::normalize(T);
-		};
-		
-		auto n = compute_tangent(p1, p2, p3, uv1, uv2, uv3);
-		// std::cout<<n.x << " " << n.y << " " << n.z << " " << std::endl;
-
-		// glm::vec3 A = glm::vec3(v1.point);            
-		// glm::vec3 B = glm::vec3(v2.point);
-		// glm::vec3 C = glm::vec3(v3.point);
-		// glm::vec2 H = v1.texcoord;
-		// glm::vec2 K = v2.texcoord;
-		// glm::vec2 L = v3.texcoord;
-
-		// v1.tangent = glm::vec4(compute_tangent(A, B, C, H, K, L), 0.f);
-		// v2.tangent = glm::vec4(compute_tangent(C, A, B, L, H, K), 0.f);
-		// v3.tangent = glm::vec4(compute_tangent(B, C, A, K, L, H), 0.f);
-		// tangentVertices.push_back(v1);
-		// tangentVertices.push_back(v2);
-		// tangentVertices.push_back(v3);
-
-
-
-		// get the angle between the two other positions for each point;
-		// the starting point will be the 'base' and the two adjacent positions will be normalized against it
-		auto a1 = glm::angle(glm::normalize(p2 - p1), glm::normalize(p3 - p1));    // p1 is the 'base' here
-		auto a2 = glm::angle(glm::normalize(p3 - p2), glm::normalize(p1 - p2));    // p2 is the 'base' here
-		auto a3 = glm::angle(glm::normalize(p1 - p3), glm::normalize(p2 - p3));    // p3 is the 'base' here
-
-		// normalize the initial facet tangents if you want to ignore surface area
-		// if (!area_weighting)
-		// {
-		//    n = glm::normalize(n);
-		// }
-
-		// store the weighted normal in an structured array
-		auto wn1 = n * a1;
-		auto wn2 = n * a2;
-		auto wn3 = n * a3;
-		w_tangents[i1].push_back(glm::vec4(wn1.x, wn1.y, wn1.z, 0.f));
-		w_tangents[i2].push_back(glm::vec4(wn2.x, wn2.y, wn2.z, 0.f));
-		w_tangents[i3].push_back(glm::vec4(wn3.x, wn3.y, wn3.z, 0.f));
-	}
-	for (uint32_t v = 0; v < w_tangents.size(); v++)
-	{
-		glm::vec4 N = glm::vec4(0.0);
+static glm::vec4 decodeDirection(uint32_t packed)
+{
+	return glm::vec4(decodeOctahedral(packed), 0.f);
+}
 
-		// run through the tangents in each vertex's array and interpolate them
-		// vertex(v) here fetches the data of the vertex at index 'v'
-		for (uint32_t n = 0; n < w_tangents[v].size(); n++)
-		{
-			N += w_tangents[v][n];
-		}
+void Mesh::compress(bool quantizePositions, bool keepColors)
+{
+	// the renderer decodes the packed lists while holding this lock
+	std::lock_guard<std::recursive_mutex> lock(*editMutex);
+	if (compressed) decompress();
+
+	if (quantizePositions) {
+		auto &meshStruct = meshStructs[id];
+		positionGrid = PositionGrid(glm::vec3(meshStruct.bbmin), glm::vec3(meshStruct.bbmax));
+		const PositionGrid &grid = positionGrid;
+		encodeVertexList(positions, quantizedPositions, [&grid] (const std::array<float, 3> &p) { return grid.encode(p); });
+	}
+	encodeVertexList(normals, packedNormals, [] (const glm::vec4 &n) { return encodeOctahedral(glm::vec3(n)); });
+	encodeVertexList(tangents, packedTangents, [] (const glm::vec4 &t) { return encodeOctahedral(glm::vec3(t)); });
+	encodeVertexList(texCoords, packedTexCoords, [] (const glm::vec2 &uv) { 
+		return std::array<uint16_t, 2>{floatToHalf(uv.x), floatToHalf(uv.y)}; 
+	});
+	if (keepColors) encodeVertexList(colors, packedColors, encodeColor);
+	else std::vector<glm::vec4>().swap(colors);
+	compressed = true;
+
+	// the renderer uploads the decoded data, which now differs slightly from the original
+	markDirty();
+}
 
-		// normalize the final normal
-		tangents[v] = glm::normalize(glm::vec4(N.x, N.y, N.z, 0.0f));
+void Mesh::decompress()
+{
+	// getters decompress on demand, so this can race with the renderer decoding the packed lists
+	std::lock_guard<std::recursive_mutex> lock(*editMutex);
+	if (!compressed) return;
+	decodeVertexData(positions, normals, tangents, colors, texCoords);
+	compressed = false;
+	std::vector<std::array<uint16_t, 3>>().swap(quantizedPositions);
+	std::vector<uint32_t>().swap(packedNormals);
+	std::vector<uint32_t>().swap(packedTangents);
+	std::vector<uint32_t>().swap(packedColors);
+	std::vector<std::array<uint16_t, 2>>().swap(packedTexCoords);
+}
+
+const std::vector<std::array<float, 3>>* Mesh::decodeVertexData(
+	std::vector<std::array<float, 3>> &positions_,
+	std::vector<glm::vec4> &normals_,
+	std::vector<glm::vec4> &tangents_,
+	std::vector<glm::vec4> &colors_,
+	std::vector<glm::vec2> &texCoords_)
+{
+	if (!compressed) return nullptr;
+	const PositionGrid &grid = positionGrid;
+	// positions that weren't quantized are still stored as floats, and are used as is
+	const std::vector<std::array<float, 3>>* decodedPositions = &positions;
+	if (!quantizedPositions.empty()) {
+		decodeVertexList(quantizedPositions, positions_, [&grid] (const std::array<uint16_t, 3> &q) { return grid.decode(q); });
+		decodedPositions = &positions_;
 	}
+	decodeVertexList(packedNormals, normals_, decodeDirection);
+	decodeVertexList(packedTangents, tangents_, decodeDirection);
+	decodeVertexList(packedColors, colors_, decodeColor);
+	decodeVertexList(packedTexCoords, texCoords_, [] (const std::array<uint16_t, 2> &uv) { 
+		return glm::vec2(halfToFloat(uv[0]), halfToFloat(uv[1])); 
+	});
+	return decodedPositions;
+}
 
-	markDirty();
+bool Mesh::isCompressed()
+{
+	return compressed;
+}
+
+float Mesh::getBytesPerVertex()
+{
+	size_t bytes = 
+		positions.size() * sizeof(std::array<float, 3>) + normals.size() * sizeof(glm::vec4) + 
+		tangents.size() * sizeof(glm::vec4) + colors.size() * sizeof(glm::vec4) + texCoords.size() * sizeof(glm::vec2) + 
+		quantizedPositions.size() * sizeof(std::array<uint16_t, 3>) + packedNormals.size() * sizeof(uint32_t) + 
+		packedTangents.size() * sizeof(uint32_t) + packedColors.size() * sizeof(uint32_t) + 
+		packedTexCoords.size() * sizeof(std::array<uint16_t, 2>);
+	uint32_t numVertices = meshStructs[id].numVerts;
+	return (numVertices > 0) ? float(bytes) / float(numVertices) : 0.f;
 }
 
 std::shared_ptr<std::recursive_mutex> Mesh::getEditMutex()
@@ -1245,6 +1652,39 @@ Mesh* Mesh::createFromObj(std::string name, std::string path)
 	return createFromFile(name, path);
 }
 
+/* 
+ * Gives every triangle its own three vertices, with the facet normal of the triangle, matching 
+ * the flat normals assimp's aiProcess_GenNormals generates for meshes that have none.
+ */
+static void splitFlatFaces(MeshReaders::MeshData &data)
+{
+	size_t numCorners = data.triangleIndices.size();
+	std::vector<std::array<float, 3>> positions(numCorners);
+	std::vector<glm::vec4> normals(numCorners);
+	std::vector<glm::vec4> colors(data.colors.empty() ? 0 : numCorners);
+	std::vector<glm::vec2> texCoords(data.texCoords.empty() ? 0 : numCorners);
+	Parallel::forEach(0, numCorners / 3, 1 << 14, [&] (size_t f) {
+		const uint32_t* i = &data.triangleIndices[f * 3];
+		glm::vec3 p[3];
+		for (uint32_t k = 0; k < 3; ++k) p[k] = glm::vec3(data.positions[i[k]][0], data.positions[i[k]][1], data.positions[i[k]][2]);
+		glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+		float length = glm::length(n);
+		n = (length > 0.f) ? n / length : glm::vec3(0.f);
+		for (uint32_t k = 0; k < 3; ++k) {
+			size_t c = f * 3 + k;
+			positions[c] = data.positions[i[k]];
+			normals[c] = glm::vec4(n, 0.f);
+			if (!colors.empty()) colors[c] = data.colors[i[k]];
+			if (!texCoords.empty()) texCoords[c] = data.texCoords[i[k]];
+		}
+	});
+	for (size_t c = 0; c < numCorners; ++c) data.triangleIndices[c] = uint32_t(c);
+	data.positions = std::move(positions);
+	data.normals = std::move(normals);
+	data.colors = std::move(colors);
+	data.texCoords = std::move(texCoords);
+}
+
 Mesh* Mesh::createFromFile(std::string name, std::string path)
 {
 	auto create = [path, name] (Mesh* mesh) {
@@ -1255,6 +1695,25 @@ Mesh* Mesh::createFromFile(std::string name, std::string path)
 				std::string("Error: \"") + name + 
 				std::string(" \" provide a file with a valid extension."));
 
+		// OBJ and PLY files are read natively, which is much faster than assimp for large files
+		MeshReaders::MeshData data;
+		if (MeshReaders::read(path, data)) {
+			if (data.positions.size() == 0) 
+				throw std::runtime_error(
+					std::string("Error: \"") + name + 
+					std::string("\" positions must be greater than 1!"));
+			if (data.normals.empty()) splitFlatFaces(data);
+			mesh->positions = std::move(data.positions);
+			mesh->normals = std::move(data.normals);
+			mesh->colors = std::move(data.colors);
+			mesh->texCoords = std::move(data.texCoords);
+			mesh->triangleIndices = std::move(data.triangleIndices);
+			mesh->generateSmoothTangents();
+			mesh->computeMetadata();
+			dirtyMeshes.insert(mesh);
+			return;
+		}
+
 		if (AI_FALSE == aiIsExtensionSupported(extension))
 			throw std::runtime_error(
 				std::string("Error: \"") + name + 
@@ -1366,14 +1825,15 @@ Mesh* Mesh::createFromData(
 	uint32_t color_dimensions, 
 	std::vector<float> texcoords_, 
 	uint32_t texcoord_dimensions, 
-	std::vector<uint32_t> indices_
+	std::vector<uint32_t> indices_,
+	float weld_epsilon
 ) {
 	auto create = [&positions_, position_dimensions, &normals_, normal_dimensions, &tangents_, tangent_dimensions, 
-				   &colors_, color_dimensions, &texcoords_, texcoord_dimensions, &indices_] 
+				   &colors_, color_dimensions, &texcoords_, texcoord_dimensions, &indices_, weld_epsilon] 
 				   (Mesh* mesh) 
 	{
 		mesh->loadData(positions_, position_dimensions, normals_, normal_dimensions, tangents_, tangent_dimensions, 
-			colors_, color_dimensions, texcoords_, texcoord_dimensions, indices_);
+			colors_, color_dimensions, texcoords_, texcoord_dimensions, std::move(indices_), weld_epsilon);
 		dirtyMeshes.insert(mesh);
 	};
 	
@@ -1393,6 +1853,11 @@ void Mesh::remove(std::string name) {
 	std::vector<glm::vec4>().swap(m->colors);
 	std::vector<glm::vec2>().swap(m->texCoords);
 	std::vector<uint32_t>().swap(m->triangleIndices);
+	std::vector<std::array<uint16_t, 3>>().swap(m->quantizedPositions);
+	std::vector<uint32_t>().swap(m->packedNormals);
+	std::vector<uint32_t>().swap(m->packedTangents);
+	std::vector<uint32_t>().swap(m->packedColors);
+	std::vector<std::array<uint16_t, 2>>().swap(m->packedTexCoords);
 	int32_t oldID = m->getId();
 	StaticFactory::remove(editMutex, name, "Mesh", lookupTable, meshes.data(), meshes.size());
 	dirtyMeshes.insert(&meshes[oldID]);
@@ -1428,7 +1893,7 @@ int32_t Mesh::getAddress()
 
 std::map<std::string, uint32_t> Mesh::getNameToIdMap()
 {
-	return lookupTable;
+	return lookupTable.toMap();
 }
 
 };
@@ -23,9 +23,15 @@
 #define PBRLUT_IMPLEMENTATION
 #include <nvisii/utilities/ggx_lookup_tables.h>
 #include <nvisii/utilities/procedural_sky.h>
+#include <nvisii/utilities/index_ranges.h>
+#include <nvisii/utilities/instance_update.h>
+#include <nvisii/utilities/environment_sampling.h>
+#include <nvisii/utilities/lru_cache.h>
+#include <nvisii/utilities/parallel.h>
 
 #include <thread>
 #include <future>
+#include <atomic>
 #include <queue>
 #include <algorithm>
 #include <cctype>
@@ -82,6 +88,22 @@ extern "C" char ptxCode[];
 //     OWLGroup blas;
 // };
 
+/* Everything that determines the texels of a baked procedural sky */
+struct ProceduralSkyKey {
+    vec3 sunPosition;
+    vec3 skyTint;
+    float atmosphereThickness;
+    float saturation;
+    uint32_t width;
+    uint32_t height;
+
+    bool operator==(const ProceduralSkyKey &other) const {
+        return sunPosition == other.sunPosition && skyTint == other.skyTint 
+            && atmosphereThickness == other.atmosphereThickness && saturation == other.saturation 
+            && width == other.width && height == other.height;
+    }
+};
+
 static struct OptixData {
     OWLContext context;
     OWLModule module;
@@ -121,8 +143,14 @@ static struct OptixData {
     OWLBuffer textureObjectsBuffer;
     OWLBuffer volumeHandlesBuffer;
 
+    /* Bytes uploaded to the GPU by the most recent call to updateComponents, summed over all GPUs */
+    size_t uploadedBytes = 0;
+
+    /* Texture objects created and destroyed by the most recent call to updateComponents */
+    uint32_t createdTextureObjects = 0;
+    uint32_t destroyedTextureObjects = 0;
+
     std::vector<OWLTexture> textureObjects;
-    std::vector<TextureStruct> textureStructs;
 
     std::vector<OWLBuffer> volumeHandles;
 
@@ -143,7 +171,9 @@ static struct OptixData {
     std::vector<OWLGeom> volumeGeomList;
     std::vector<OWLGroup> volumeBlasList;
 
-    OWLGroup IAS = nullptr;
+    InstanceAccelState<OWLGroup, OWLGroup> instanceAccel;
+    std::vector<owl4x3f> t0InstanceTransforms;
+    std::vector<owl4x3f> t1InstanceTransforms;
 
     std::vector<uint32_t> lightEntities;
 
@@ -166,9 +196,17 @@ static struct OptixData {
 
     OWLBuffer environmentMapRowsBuffer;
     OWLBuffer environmentMapColsBuffer;
+    OWLBuffer environmentMapAliasBuffer;
     OWLTexture proceduralSkyTexture;
 
-    std::vector<MaterialStruct> materialStructs;
+    /* Recently baked procedural skies, so that returning to earlier sky parameters skips the bake */
+    LRUCache<ProceduralSkyKey, std::vector<glm::vec4>> proceduralSkyCache = LRUCache<ProceduralSkyKey, std::vector<glm::vec4>>(8);
+
+    /* Dome light sampling tables being built off the render thread, the flag that cancels that build, 
+       and superseded builds still winding down */
+    std::future<EnvironmentSampling> environmentSampling;
+    std::shared_ptr<std::atomic<bool>> environmentSamplingCancelled;
+    std::vector<std::future<EnvironmentSampling>> discardedEnvironmentSampling;
 
     OWLBuffer placeholder;
     OWLGroup placeholderGroup;
@@ -313,6 +351,11 @@ void instanceGroupSetChild(OWLGroup group, int whichChild, OWLGroup child)
     owlInstanceGroupSetChild(group, whichChild, child); 
 }
 
+void groupRefitAccel(OWLGroup group)
+{
+    owlGroupRefitAccel(group);
+}
+
 void instanceGroupSetTransform(OWLGroup group, size_t childID, glm::mat4 m44xfm)
 {
     owl4x3f xfm = {
@@ -332,6 +375,28 @@ owl4x3f glmToOWL(glm::mat4 &xfm){
     return oxfm;
 }
 
+/* Drives InstanceAccelState with owl instance groups */
+struct OwlInstanceBackend {
+    OWLGroup create(size_t count) { return instanceGroupCreate(OptixData.context, count); }
+    void setChild(OWLGroup group, size_t index, OWLGroup child) { instanceGroupSetChild(group, (int)index, child); }
+    void setInstances(OWLGroup group, const std::vector<owl4x3f> &t0, const std::vector<owl4x3f> &t1,
+        const InstanceLayout<OWLGroup> &layout)
+    {
+        owlInstanceGroupSetTransforms(group, 0, (const float*)t0.data());
+        owlInstanceGroupSetTransforms(group, 1, (const float*)t1.data());
+        owlInstanceGroupSetVisibilityMasks(group, layout.masks.data());
+    }
+    void build(OWLGroup group) { groupBuildAccel(group); }
+    void refit(OWLGroup group) { groupRefitAccel(group); }
+    void release(OWLGroup group) { owlGroupRelease(group); }
+    void commit(OWLGroup group)
+    {
+        owlParamsSetGroup(OptixData.launchParams, "IAS", group);
+        // Now that IAS have changed, we need to rebuild SBT
+        owlBuildSBT(OptixData.context);
+    }
+};
+
 void synchronizeDevices(std::string error_string = "")
 {
     for (int i = 0; i < getDeviceCount(); i++) {
@@ -539,6 +604,7 @@ void initializeOptix(bool headless)
         { "environmentMapRotation",  OWL_USER_TYPE(glm::quat),          OWL_OFFSETOF(LaunchParams, environmentMapRotation)},
         { "environmentMapRows",      OWL_BUFPTR,                        OWL_OFFSETOF(LaunchParams, environmentMapRows)},
         { "environmentMapCols",      OWL_BUFPTR,                        OWL_OFFSETOF(LaunchParams, environmentMapCols)},
+        { "environmentMapAlias",     OWL_BUFPTR,                        OWL_OFFSETOF(LaunchParams, environmentMapAlias)},
         { "environmentMapWidth",     OWL_USER_TYPE(uint32_t),           OWL_OFFSETOF(LaunchParams, environmentMapWidth)},
         { "environmentMapHeight",    OWL_USER_TYPE(uint32_t),           OWL_OFFSETOF(LaunchParams, environmentMapHeight)},
         { "textureObjects",          OWL_BUFFER,                        OWL_OFFSETOF(LaunchParams, textureObjects)},
@@ -604,7 +670,7 @@ void initializeOptix(bool headless)
     OD.materialBuffer            = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(MaterialStruct),      Material::getCount(),  nullptr);
     OD.meshBuffer                = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(MeshStruct),          Mesh::getCount(),     nullptr);
     OD.lightBuffer               = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(LightStruct),         Light::getCount(),     nullptr);
-    OD.textureBuffer             = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(TextureStruct),       Texture::getCount() + NUM_MAT_PARAMS * Material::getCount(),   nullptr);
+    OD.textureBuffer             = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(TextureStruct),       Texture::getCount(),   nullptr);
     OD.volumeBuffer              = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(VolumeStruct),        Volume::getCount(),   nullptr);
     OD.volumeHandlesBuffer       = owlDeviceBufferCreate(OD.context, OWL_BUFFER,                         Volume::getCount(),   nullptr);
     OD.lightEntitiesBuffer       = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(uint32_t),            1,              nullptr);
@@ -614,7 +680,7 @@ void initializeOptix(bool headless)
     OD.tangentListsBuffer        = owlDeviceBufferCreate(OD.context, OWL_BUFFER,                         Mesh::getCount(),     nullptr);
     OD.texCoordListsBuffer       = owlDeviceBufferCreate(OD.context, OWL_BUFFER,                         Mesh::getCount(),     nullptr);
     OD.indexListsBuffer          = owlDeviceBufferCreate(OD.context, OWL_BUFFER,                         Mesh::getCount(),     nullptr);
-    OD.textureObjectsBuffer      = owlDeviceBufferCreate(OD.context, OWL_TEXTURE,                        Texture::getCount() + NUM_MAT_PARAMS * Material::getCount(),   nullptr);
+    OD.textureObjectsBuffer      = owlDeviceBufferCreate(OD.context, OWL_TEXTURE,                        Texture::getCount(),   nullptr);
 
     owlParamsSetBuffer(OD.launchParams, "entities",             OD.entityBuffer);
     owlParamsSetBuffer(OD.launchParams, "transforms",           OD.transformBuffer);
@@ -647,10 +713,7 @@ void initializeOptix(bool headless)
     OD.volumeGeomList.resize(volumeCount);
     OD.volumeBlasList.resize(volumeCount);
 
-    uint32_t materialCount = Material::getCount();
-    OD.textureObjects.resize(Texture::getCount() + NUM_MAT_PARAMS * materialCount, nullptr);        
-    OD.textureStructs.resize(Texture::getCount() + NUM_MAT_PARAMS * materialCount);
-    OD.materialStructs.resize(materialCount);
+    OD.textureObjects.resize(Texture::getCount(), nullptr);        
 
     OD.volumeHandles.resize(Volume::getCount());
 
@@ -661,6 +724,7 @@ void initializeOptix(bool headless)
 
     owlParamsSetBuffer(OD.launchParams, "environmentMapRows", OD.environmentMapRowsBuffer);
     owlParamsSetBuffer(OD.launchParams, "environmentMapCols", OD.environmentMapColsBuffer);
+    owlParamsSetBuffer(OD.launchParams, "environmentMapAlias", OD.environmentMapAliasBuffer);
     owlParamsSetRaw(OD.launchParams, "environmentMapWidth", &OD.LP.environmentMapWidth);
     owlParamsSetRaw(OD.launchParams, "environmentMapHeight", &OD.LP.environmentMapHeight);
    
@@ -902,15 +966,73 @@ void setDomeLightColor(vec3 color)
     resetAccumulation();
 }
 
+/* 
+ * Replaces the dome light sampling tables on the GPU. Empty tables turn off importance sampling 
+ * of the dome light texture.
+ */
+void uploadEnvironmentSampling(const EnvironmentSampling &sampling)
+{
+    auto &OD = OptixData;
+    if (OD.environmentMapRowsBuffer) owlBufferRelease(OD.environmentMapRowsBuffer);
+    if (OD.environmentMapColsBuffer) owlBufferRelease(OD.environmentMapColsBuffer);
+    if (OD.environmentMapAliasBuffer) owlBufferRelease(OD.environmentMapAliasBuffer);
+    OD.environmentMapRowsBuffer = nullptr;
+    OD.environmentMapColsBuffer = nullptr;
+    OD.environmentMapAliasBuffer = nullptr;
+    OD.LP.environmentMapWidth = 0;
+    OD.LP.environmentMapHeight = 0;
+    if (sampling.width == 0 || sampling.height == 0) return;
+
+    OD.environmentMapRowsBuffer = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(float), sampling.rows.size(), sampling.rows.data());
+    OD.environmentMapColsBuffer = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(float), sampling.cols.size(), sampling.cols.data());
+    if (sampling.aliasTable.size() > 0) {
+        OD.environmentMapAliasBuffer = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(EnvironmentAliasStruct), 
+            sampling.aliasTable.size(), sampling.aliasTable.data());
+    }
+    OD.LP.environmentMapWidth = sampling.width;
+    OD.LP.environmentMapHeight = sampling.height;
+}
+
+/* 
+ * Stops waiting on any dome light sampling tables still being built, and cancels that build so that 
+ * it doesn't hold up later builds or shutdown.
+ */
+void discardEnvironmentSampling()
+{
+    auto &OD = OptixData;
+    if (OD.environmentSamplingCancelled) *OD.environmentSamplingCancelled = true;
+    OD.environmentSamplingCancelled = nullptr;
+    if (OD.environmentSampling.valid()) OD.discardedEnvironmentSampling.push_back(std::move(OD.environmentSampling));
+}
+
+/* 
+ * Uploads dome light sampling tables once they finish building. Called from the render thread, 
+ * which never waits on a build.
+ */
+void updateEnvironmentSampling()
+{
+    auto &OD = OptixData;
+    auto isReady = [] (std::future<EnvironmentSampling> &future) {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+    OD.discardedEnvironmentSampling.erase(std::remove_if(OD.discardedEnvironmentSampling.begin(), 
+        OD.discardedEnvironmentSampling.end(), isReady), OD.discardedEnvironmentSampling.end());
+    if (!OD.environmentSampling.valid() || !isReady(OD.environmentSampling)) return;
+    try {
+        uploadEnvironmentSampling(OD.environmentSampling.get());
+    } catch (std::exception &e) {
+        std::cout << "Error: failed to build dome light sampling tables. Reason: " << e.what() << std::endl;
+    }
+    resetAccumulation();
+}
+
 void clearDomeLightTexture()
 {
     resetAccumulation();
     enqueueCommand([] () {
         OptixData.LP.environmentMapID = -1;
-        if (OptixData.environmentMapRowsBuffer) owlBufferRelease(OptixData.environmentMapRowsBuffer);
-        if (OptixData.environmentMapColsBuffer) owlBufferRelease(OptixData.environmentMapColsBuffer);
-        OptixData.environmentMapRowsBuffer = nullptr;
-        OptixData.environmentMapColsBuffer = nullptr;
+        discardEnvironmentSampling();
+        uploadEnvironmentSampling(EnvironmentSampling());
         OptixData.LP.environmentMapWidth = -1;
         OptixData.LP.environmentMapHeight = -1;  
     });
@@ -938,31 +1060,66 @@ vec3 toPolar(vec2 uv)
     return n;
 }
 
-void setDomeLightSky(vec3 sunPos, vec3 skyTint, float atmosphereThickness, float saturation)
+/* 
+ * Evaluates the procedural sky for every texel of a latitude/longitude map. Rows are split across 
+ * threads, and the per-parameter and per-column terms are computed once up front.
+ */
+std::vector<glm::vec4> bakeProceduralSky(const ProceduralSkyKey &key)
 {
-    enqueueCommand([sunPos, skyTint, atmosphereThickness, saturation] () {
-        /* Generate procedural sky */
-        uint32_t width = 1024/2;
-        uint32_t height = 512/2;
-        std::vector<glm::vec4> texels(width * height);
-        for (uint32_t y = 0; y < height; ++y) {
+    uint32_t width = key.width;
+    uint32_t height = key.height;
+    ProceduralSkyParameters params = makeProceduralSkyParameters(
+        vec3(key.sunPosition.x, key.sunPosition.z, key.sunPosition.y), 
+        key.skyTint, key.atmosphereThickness, key.saturation);
+
+    // matches toPolar, with theta varying along x and phi along y
+    std::vector<glm::vec2> columns(width);
+    for (uint32_t x = 0; x < width; ++x) {
+        float theta = 2.0 * M_PI * (x / float(width)) + - M_PI / 2.0;
+        columns[x] = glm::vec2(cos(theta), sin(theta));
+    }
+
+    std::vector<glm::vec4> texels(size_t(width) * height);
+    Parallel::forRange(0, height, 8, [&] (size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y) {
+            float phi = M_PI * (y / float(height));
+            float sinPhi = sin(phi), cosPhi = cos(phi);
+            glm::vec4 *row = &texels[y * width];
             for (uint32_t x = 0; x < width; ++x) {
-                glm::vec2 uv = glm::vec2(x / float(width), y / float(height));
-                glm::vec3 dir = toPolar(uv);
-                glm::vec3 c = ProceduralSkybox(glm::vec3(dir.x, -dir.z, dir.y), glm::vec3(sunPos.x, sunPos.z, sunPos.y), skyTint, atmosphereThickness, saturation);
-                texels[x + y * width] = glm::vec4(c.r, c.g, c.b, 1.0f);
+                glm::vec3 dir = glm::vec3(columns[x].x * sinPhi, columns[x].y * sinPhi, cosPhi);
+                glm::vec3 c = ProceduralSkybox(glm::vec3(dir.x, -dir.z, dir.y), params);
+                row[x] = glm::vec4(c.r, c.g, c.b, 1.0f);
             }
         }
+    });
+    return texels;
+}
+
+void setDomeLightSky(vec3 sunPos, vec3 skyTint, float atmosphereThickness, float saturation, uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0) 
+        throw std::runtime_error("Error: procedural sky width and height must be greater than zero");
+    ProceduralSkyKey key = {sunPos, skyTint, atmosphereThickness, saturation, width, height};
+    enqueueCommand([key] () {
+        discardEnvironmentSampling();
+        /* Generate procedural sky, reusing an earlier bake of the same parameters if we have one */
+        const std::vector<glm::vec4> *texels = OptixData.proceduralSkyCache.find(key);
+        std::vector<glm::vec4> baked;
+        if (!texels) {
+            baked = bakeProceduralSky(key);
+            texels = &baked;
+        }
 
         //debug
-        // stbi_write_hdr("./proceduralSky.hdr", width, height, 4, (float*)texels.data());
+        // stbi_write_hdr("./proceduralSky.hdr", key.width, key.height, 4, (float*)texels->data());
 
         OptixData.LP.environmentMapID = -2;
         if (OptixData.proceduralSkyTexture) {
             owlTexture2DDestroy(OptixData.proceduralSkyTexture);
         }
-        OptixData.proceduralSkyTexture = owlTexture2DCreate(OptixData.context, OWL_TEXEL_FORMAT_RGBA32F, width, height, texels.data());
+        OptixData.proceduralSkyTexture = owlTexture2DCreate(OptixData.context, OWL_TEXEL_FORMAT_RGBA32F, key.width, key.height, texels->data());
         owlParamsSetTexture(OptixData.launchParams, "proceduralSkyTexture", OptixData.proceduralSkyTexture);
+        if (texels == &baked) OptixData.proceduralSkyCache.insert(key, std::move(baked));
 
         OptixData.LP.environmentMapWidth = 0;
         OptixData.LP.environmentMapHeight = 0;  
@@ -970,51 +1127,41 @@ void setDomeLightSky(vec3 sunPos, vec3 skyTint, float atmosphereThickness, float
     });
 }
 
-void setDomeLightTexture(Texture* texture, bool enableCDF)
+void setDomeLightSkyCacheSize(uint32_t size)
 {
-    enqueueCommand([texture, enableCDF] () {
-        OptixData.LP.environmentMapID = texture->getId();
-        if (enableCDF) {
-            std::vector<glm::vec4> texels = texture->getFloatTexels();
-
-            int width = texture->getWidth();
-            int height = texture->getHeight();
-            int cdfWidth = width;
-            int cdfHeight = height;
-
-            float invWidth = 1.f / float(cdfWidth);
-            float invHeight = 1.f / float(cdfHeight);
-            float invjacobian = cdfWidth * cdfHeight / float(4 * M_PI);
-
-            auto rows = std::vector<float>(cdfHeight);
-            auto cols = std::vector<float>(cdfWidth * cdfHeight);
-            for (int y = 0, i = 0; y < cdfHeight; y++) {
-                for (int x = 0; x < cdfWidth; x++, i++) {
-                    glm::vec4 texel = texels[i];
-                    cols[i] = std::max(texel.r, std::max(texel.g, texel.b)) + ((x > 0) ? cols[i - 1] : 0.f);
-                }
-                rows[y] = cols[i - 1] + ((y > 0) ? rows[y - 1] : 0.0f);
-                // normalize the pdf for this scanline (if it was non-zero)
-                if (cols[i - 1] > 0) {
-                    for (int x = 0; x < cdfWidth; x++) {
-                        cols[i - cdfWidth + x] /= cols[i - 1];
-                    }
-                }
-            }
+    enqueueCommand([size] () {
+        OptixData.proceduralSkyCache.setCapacity(size);
+    });
+}
 
-            // normalize the pdf across all scanlines
-            for (int y = 0; y < cdfHeight; y++) rows[y] /= rows[cdfHeight - 1];
+void setDomeLightTexture(Texture* texture, bool enableCDF, uint32_t cdfMaxWidth, bool aliasTable)
+{
+    // The texture may be removed before the commands below run, so it is looked up again by name
+    std::string textureName = texture->getName();
+    int32_t textureId = texture->getId();
+    enqueueCommand([textureName, textureId, enableCDF, cdfMaxWidth, aliasTable] () {
+        OptixData.LP.environmentMapID = textureId;
 
-            if (OptixData.environmentMapRowsBuffer) owlBufferRelease(OptixData.environmentMapRowsBuffer);
-            if (OptixData.environmentMapColsBuffer) owlBufferRelease(OptixData.environmentMapColsBuffer);
-            OptixData.environmentMapRowsBuffer = owlDeviceBufferCreate(OptixData.context, OWL_USER_TYPE(float), cdfHeight, rows.data());
-            OptixData.environmentMapColsBuffer = owlDeviceBufferCreate(OptixData.context, OWL_USER_TYPE(float), cdfWidth * cdfHeight, cols.data());
-            OptixData.LP.environmentMapWidth = cdfWidth;
-            OptixData.LP.environmentMapHeight = cdfHeight;  
-        }
-        else {
-            OptixData.LP.environmentMapWidth = 0;
-            OptixData.LP.environmentMapHeight = 0;  
+        // Until the sampling tables are ready, the dome light is sampled uniformly
+        discardEnvironmentSampling();
+        uploadEnvironmentSampling(EnvironmentSampling());
+        if (enableCDF) {
+            auto cancelled = std::make_shared<std::atomic<bool>>(false);
+            OptixData.environmentSamplingCancelled = cancelled;
+            OptixData.environmentSampling = std::async(std::launch::async, [textureName, textureId, cdfMaxWidth, aliasTable, cancelled] () {
+                std::vector<glm::vec4> texels;
+                uint32_t width, height;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(*Texture::getEditMutex().get());
+                    Texture* texture = Texture::get(textureName);
+                    if (*cancelled || !texture || texture->getId() != textureId) return EnvironmentSampling();
+                    texels = texture->getFloatTexels();
+                    width = texture->getWidth();
+                    height = texture->getHeight();
+                }
+                if (texels.size() != size_t(width) * height) return EnvironmentSampling();
+                return buildEnvironmentSampling((const float*) texels.data(), width, height, cdfMaxWidth, aliasTable, cancelled.get());
+            });
         }
         resetAccumulation();        
     });
@@ -1106,9 +1253,87 @@ void sampleTimeInterval(vec2 sampleTimeInterval)
     resetAccumulation();
 }
 
+/* Uploads an entire buffer to every GPU, counting the bytes uploaded */
+void uploadBuffer(OWLBuffer buffer, const void* data, size_t numBytes)
+{
+    owlBufferUpload(buffer, data);
+    OptixData.uploadedBytes += numBytes * owlGetDeviceCount(OptixData.context);
+}
+
+/* 
+ * Uploads only the given element ranges of a device buffer to every GPU, counting the bytes 
+ * uploaded. If most of the buffer changed, the whole buffer is uploaded in one copy instead.
+ */
+void uploadBufferRanges(OWLBuffer buffer, const void* data, size_t elementSize, size_t numElements, const std::vector<IndexRange> &ranges)
+{
+    if (ranges.size() == 0) return;
+    if (countIndices(ranges) * 2 > numElements) {
+        uploadBuffer(buffer, data, elementSize * numElements);
+        return;
+    }
+
+    int numGPUs = owlGetDeviceCount(OptixData.context);
+    for (int deviceID = 0; deviceID < numGPUs; ++deviceID) {
+        cudaSetDevice(deviceID);
+        uint8_t* devicePtr = (uint8_t*) owlBufferGetPointer(buffer, deviceID);
+        for (auto &range : ranges) {
+            size_t offset = size_t(range.begin) * elementSize;
+            size_t numBytes = size_t(range.end - range.begin) * elementSize;
+            cudaMemcpy(devicePtr + offset, (const uint8_t*) data + offset, numBytes, cudaMemcpyHostToDevice);
+            OptixData.uploadedBytes += numBytes;
+        }
+    }
+    cudaSetDevice(0);
+}
+
+/* Returns the table indices of the given components, merged into ranges for uploading */
+template<class T>
+std::vector<IndexRange> getDirtyRanges(const std::set<T*> &components)
+{
+    std::vector<uint32_t> indices;
+    indices.reserve(components.size());
+    for (auto &c : components) indices.push_back(uint32_t(c - T::getFront()));
+    return coalesceIndices(indices, /*maxGap=*/ 8);
+}
+
+/* Returns the table indices of components flagged as dirty, merged into ranges for uploading */
+template<class T>
+std::vector<IndexRange> getDirtyRanges(T* components, uint32_t count)
+{
+    std::vector<uint32_t> indices;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (components[i].isDirty()) indices.push_back(i);
+    }
+    return coalesceIndices(indices, /*maxGap=*/ 8);
+}
+
+size_t getUploadedByteCount()
+{
+    return OptixData.uploadedBytes;
+}
+
+std::map<std::string, uint32_t> getTextureObjectStatistics()
+{
+    uint32_t allocated = 0;
+    for (auto &textureObject : OptixData.textureObjects) if (textureObject) allocated++;
+    std::map<std::string, uint32_t> statistics;
+    statistics["created"] = OptixData.createdTextureObjects;
+    statistics["destroyed"] = OptixData.destroyedTextureObjects;
+    statistics["allocated"] = allocated;
+    return statistics;
+}
+
 void updateComponents()
 {
     auto &OD = OptixData;
+    OD.uploadedBytes = 0;
+    OD.createdTextureObjects = 0;
+    OD.destroyedTextureObjects = 0;
+
+    updateEnvironmentSampling();
+
+    // Resolve any edits to the transform hierarchy, marking affected transforms and entities dirty
+    Transform::updateWorldMatrices();
     
     if (OptixData.LP.cameraEntity.initialized) {
         auto transform = Transform::getFront()[OptixData.LP.cameraEntity.transform_id];
@@ -1144,6 +1369,8 @@ void updateComponents()
     // Manage Meshes: Build / Rebuild BLAS
     auto dirtyMeshes = Mesh::getDirtyMeshes();
     if (dirtyMeshes.size() > 0) {
+        // Released BLAS handles can be reused by the BLAS created below, so the IAS can't be refit
+        OD.instanceAccel.invalidateChildren();
         for (auto &m : dirtyMeshes) {
             // First, release any resources from a previous, stale mesh.
             if (OD.vertexLists[m->getAddress()]) { 
@@ -1161,33 +1388,49 @@ void updateComponents()
             if (!m->isInitialized()) continue;
             if (m->getTriangleIndices().size() == 0) throw std::runtime_error("ERROR: indices is 0");
 
+            // Reference the mesh data directly, rather than copying it for every upload. 
+            // Compressed meshes are decoded into temporary lists, so that they stay compressed, 
+            // except for positions that weren't quantized, which are referenced directly too.
+            std::vector<std::array<float, 3>> decodedVertices;
+            std::vector<glm::vec4> decodedNormals, decodedTangents, decodedColors;
+            std::vector<glm::vec2> decodedTexCoords;
+            auto decodedPositions = m->decodeVertexData(decodedVertices, decodedNormals, decodedTangents, decodedColors, decodedTexCoords);
+            bool decoded = (decodedPositions != nullptr);
+            auto &vertices = (decoded) ? *decodedPositions : m->getVertices();
+            auto &normals = (decoded) ? decodedNormals : m->getNormals();
+            auto &tangents = (decoded) ? decodedTangents : m->getTangents();
+            auto &texCoords = (decoded) ? decodedTexCoords : m->getTexCoords();
+            auto &indices = m->getTriangleIndices();
+
             // Next, allocate resources for the new mesh.
-            OD.vertexLists[m->getAddress()]  = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(vec3), m->getVertices().size(), m->getVertices().data());
-            OD.normalLists[m->getAddress()]   = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(vec4), m->getNormals().size(), m->getNormals().data());
-            OD.tangentLists[m->getAddress()]   = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(vec4), m->getTangents().size(), m->getTangents().data());
-            OD.texCoordLists[m->getAddress()] = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(vec2), m->getTexCoords().size(), m->getTexCoords().data());
-            OD.indexLists[m->getAddress()]   = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(uint32_t), m->getTriangleIndices().size(), m->getTriangleIndices().data());
+            OD.vertexLists[m->getAddress()]  = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(vec3), vertices.size(), vertices.data());
+            OD.normalLists[m->getAddress()]   = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(vec4), normals.size(), normals.data());
+            OD.tangentLists[m->getAddress()]   = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(vec4), tangents.size(), tangents.data());
+            OD.texCoordLists[m->getAddress()] = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(vec2), texCoords.size(), texCoords.data());
+            OD.indexLists[m->getAddress()]   = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(uint32_t), indices.size(), indices.data());
             
             // Create geometry and build BLAS
             OD.surfaceGeomList[m->getAddress()] = geomCreate(OD.context, OD.trianglesGeomType);
-            trianglesSetVertices(OD.surfaceGeomList[m->getAddress()], OD.vertexLists[m->getAddress()], m->getVertices().size(), sizeof(std::array<float, 3>), 0);
-            trianglesSetIndices(OD.surfaceGeomList[m->getAddress()], OD.indexLists[m->getAddress()], m->getTriangleIndices().size() / 3, sizeof(ivec3), 0);
+            trianglesSetVertices(OD.surfaceGeomList[m->getAddress()], OD.vertexLists[m->getAddress()], vertices.size(), sizeof(std::array<float, 3>), 0);
+            trianglesSetIndices(OD.surfaceGeomList[m->getAddress()], OD.indexLists[m->getAddress()], indices.size() / 3, sizeof(ivec3), 0);
             OD.surfaceBlasList[m->getAddress()] = trianglesGeomGroupCreate(OD.context, 1, &OD.surfaceGeomList[m->getAddress()]);
             groupBuildAccel(OD.surfaceBlasList[m->getAddress()]);          
         }
 
-        owlBufferUpload(OD.vertexListsBuffer, OD.vertexLists.data());
-        owlBufferUpload(OD.texCoordListsBuffer, OD.texCoordLists.data());
-        owlBufferUpload(OD.indexListsBuffer, OD.indexLists.data());
-        owlBufferUpload(OD.normalListsBuffer, OD.normalLists.data());
-        owlBufferUpload(OD.tangentListsBuffer, OD.tangentLists.data());
+        // Buffers of buffers hold one device pointer per mesh
+        uploadBuffer(OD.vertexListsBuffer, OD.vertexLists.data(), OD.vertexLists.size() * sizeof(CUdeviceptr));
+        uploadBuffer(OD.texCoordListsBuffer, OD.texCoordLists.data(), OD.texCoordLists.size() * sizeof(CUdeviceptr));
+        uploadBuffer(OD.indexListsBuffer, OD.indexLists.data(), OD.indexLists.size() * sizeof(CUdeviceptr));
+        uploadBuffer(OD.normalListsBuffer, OD.normalLists.data(), OD.normalLists.size() * sizeof(CUdeviceptr));
+        uploadBuffer(OD.tangentListsBuffer, OD.tangentLists.data(), OD.tangentLists.size() * sizeof(CUdeviceptr));
         Mesh::updateComponents();
-        owlBufferUpload(OptixData.meshBuffer, Mesh::getFrontStruct());
+        uploadBufferRanges(OD.meshBuffer, Mesh::getFrontStruct(), sizeof(MeshStruct), Mesh::getCount(), getDirtyRanges(dirtyMeshes));
     }    
 
     // Manage Volumes: Build / Rebuild BLAS
     auto dirtyVolumes = Volume::getDirtyVolumes();
     if (dirtyVolumes.size() > 0) {
+        OD.instanceAccel.invalidateChildren();
         for (auto &v : dirtyVolumes) {
             // First, release any resources from a previous, stale volume
             if (OD.volumeHandles[v->getAddress()]) owlBufferDestroy(OD.volumeHandles[v->getAddress()]);
@@ -1208,7 +1451,7 @@ void updateComponents()
             // int nodecount = grid->tree().nodeCount(3);
 
             OD.volumeHandles[v->getAddress()] = owlDeviceBufferCreate(OD.context, OWL_USER_TYPE(uint8_t), gridHdlPtr.get()->size(), nullptr);
-            owlBufferUpload(OD.volumeHandles[v->getAddress()], gridHdlPtr.get()->data());
+            uploadBuffer(OD.volumeHandles[v->getAddress()], gridHdlPtr.get()->data(), gridHdlPtr.get()->size());
             // printf("%hhx\n",gridHdlPtr.get()->data()[0]);
             const void* d_gridData = owlBufferGetPointer(OD.volumeHandles[v->getAddress()], 0);
             uint8_t first_byte;
@@ -1228,18 +1471,20 @@ void updateComponents()
             groupBuildAccel(OD.volumeBlasList[v->getAddress()]);    
         }
         Volume::updateComponents();
-        owlBufferUpload(OptixData.volumeBuffer, Volume::getFrontStruct());
-        owlBufferUpload(OD.volumeHandlesBuffer, OD.volumeHandles.data());
+        uploadBufferRanges(OD.volumeBuffer, Volume::getFrontStruct(), sizeof(VolumeStruct), Volume::getCount(), getDirtyRanges(dirtyVolumes));
+        uploadBuffer(OD.volumeHandlesBuffer, OD.volumeHandles.data(), OD.volumeHandles.size() * sizeof(CUdeviceptr));
     }
 
-    // Manage Entities: Build / Rebuild TLAS
+    // Manage Entities: Build / Rebuild / Refit TLAS
     auto dirtyEntities = Entity::getDirtyEntities();
     if (dirtyEntities.size() > 0) {
-        std::vector<OWLGroup> instances;
-        std::vector<glm::mat4> t0Transforms;
-        std::vector<glm::mat4> t1Transforms;
-        std::vector<uint8_t> masks;
-        std::vector<uint32_t> instanceToEntity;
+        // Instance storage is reused across frames, so transform only edits don't reallocate
+        InstanceLayout<OWLGroup> &layout = OD.instanceAccel.getPendingLayout();
+        std::vector<owl4x3f> &t0Transforms = OD.t0InstanceTransforms;
+        std::vector<owl4x3f> &t1Transforms = OD.t1InstanceTransforms;
+        layout.clear();
+        t0Transforms.clear();
+        t1Transforms.clear();
 
         // Aggregate instanced geometry and transformations 
         Entity* entities = Entity::getFront();
@@ -1258,14 +1503,14 @@ void updateComponents()
             // Get instance transformation
             glm::mat4 prevLocalToWorld = entities[eid].getTransform()->getLocalToWorldMatrix(/*previous = */true);
             glm::mat4 localToWorld = entities[eid].getTransform()->getLocalToWorldMatrix(/*previous = */false);
-            t0Transforms.push_back(prevLocalToWorld);
-            t1Transforms.push_back(localToWorld);
+            t0Transforms.push_back(glmToOWL(prevLocalToWorld));
+            t1Transforms.push_back(glmToOWL(localToWorld));
 
             // Get instance mask
-            masks.push_back(entities[eid].getStruct().flags);
+            layout.masks.push_back(entities[eid].getStruct().flags);
 
             // Indirection from instance back to entity ID
-            instanceToEntity.push_back(eid);
+            layout.instanceToEntity.push_back(eid);
 
             // Add any instanced mesh geometry to the list
             if (entities[eid].getMesh()) {
@@ -1276,7 +1521,7 @@ void updateComponents()
                     // Mark it as dirty. It should be available in a subsequent frame
                     entities[eid].getMesh()->markDirty(); return; 
                 }
-                instances.push_back(blas);
+                layout.children.push_back(blas);
             }
             
             // Add any instanced volume geometry to the list
@@ -1287,7 +1532,7 @@ void updateComponents()
                     // Same as meshes, if BLAS doesn't exist, force BLAS build and try again.
                     entities[eid].getMesh()->markDirty(); return; 
                 }
-                instances.push_back(blas);
+                layout.children.push_back(blas);
             } 
             
             else {
@@ -1295,44 +1540,15 @@ void updateComponents()
             }   
         }
 
-        std::vector<uint8_t>     owlVisibilityMasks;
-        std::vector<owl4x3f>     t0OwlTransforms;
-        std::vector<owl4x3f>     t1OwlTransforms;
-        auto oldIAS = OD.IAS;
-        
-        // If no objects are instanced, insert an unhittable placeholder.
-        // (required for certain older driver versions)
-        if (instances.size() == 0) {
-            OD.IAS = instanceGroupCreate(OD.context, 1);
-            instanceGroupSetChild(OD.IAS, 0, OD.placeholderGroup); 
-            groupBuildAccel(OD.IAS);
+        // If only transforms changed since the last build, the existing IAS is refit in place 
+        // and the SBT is kept. Otherwise, a new IAS is built and the SBT is rebuilt.
+        OwlInstanceBackend backend;
+        InstanceUpdate update = OD.instanceAccel.update(backend, t0Transforms, t1Transforms, OD.placeholderGroup);
+        const InstanceLayout<OWLGroup> &builtLayout = OD.instanceAccel.getLayout();
+        if (update == InstanceUpdate::Rebuild && builtLayout.size() > 0) {
+            owlBufferResize(OD.instanceToEntityBuffer, builtLayout.instanceToEntity.size());
+            uploadBuffer(OD.instanceToEntityBuffer, builtLayout.instanceToEntity.data(), builtLayout.instanceToEntity.size() * sizeof(uint32_t));
         }
-
-        // Set instance transforms and masks, upload instance to entity map
-        if (instances.size() > 0) {
-            OD.IAS = instanceGroupCreate(OD.context, instances.size());
-            for (uint32_t iid = 0; iid < instances.size(); ++iid) {
-                instanceGroupSetChild(OD.IAS, iid, instances[iid]);                 
-                t0OwlTransforms.push_back(glmToOWL(t0Transforms[iid]));
-                t1OwlTransforms.push_back(glmToOWL(t1Transforms[iid]));
-                owlVisibilityMasks.push_back(masks[iid]);
-            }            
-            owlInstanceGroupSetTransforms(OD.IAS,0,(const float*)t0OwlTransforms.data());
-            owlInstanceGroupSetTransforms(OD.IAS,1,(const float*)t1OwlTransforms.data());
-            owlInstanceGroupSetVisibilityMasks(OD.IAS, owlVisibilityMasks.data());
-            owlBufferResize(OD.instanceToEntityBuffer, instanceToEntity.size());
-            owlBufferUpload(OD.instanceToEntityBuffer, instanceToEntity.data());
-        }       
-
-        // Build IAS
-        groupBuildAccel(OD.IAS);
-        owlParamsSetGroup(OD.launchParams, "IAS", OD.IAS);
-        
-        // Now that IAS have changed, we need to rebuild SBT
-        owlBuildSBT(OD.context);
-
-        // Release any old IAS (TODO, don't rebuild if entity edit doesn't effect IAS...)
-        if (oldIAS) {owlGroupRelease(oldIAS);}
     
         // Aggregate entities that are light sources (todo: consider emissive volumes...)
         OD.lightEntities.resize(0);
@@ -1345,13 +1561,14 @@ void updateComponents()
             OD.lightEntities.push_back(eid);
         }
         owlBufferResize(OptixData.lightEntitiesBuffer, OD.lightEntities.size());
-        owlBufferUpload(OptixData.lightEntitiesBuffer, OD.lightEntities.data());
+        uploadBuffer(OptixData.lightEntitiesBuffer, OD.lightEntities.data(), OD.lightEntities.size() * sizeof(uint32_t));
         OD.LP.numLightEntities = uint32_t(OD.lightEntities.size());
         owlParamsSetRaw(OD.launchParams, "numLightEntities", &OD.LP.numLightEntities);
 
         // Finally, upload entity structs to the GPU.
+        // Only the entities which changed need to be uploaded
         Entity::updateComponents();
-        owlBufferUpload(OptixData.entityBuffer,    Entity::getFrontStruct());
+        uploadBufferRanges(OD.entityBuffer, Entity::getFrontStruct(), sizeof(EntityStruct), Entity::getCount(), getDirtyRanges(dirtyEntities));
     }
 
     // Manage textures and materials
@@ -1366,125 +1583,78 @@ void updateComponents()
             if (OD.textureObjects[tid]) { 
                 owlTexture2DDestroy(OD.textureObjects[tid]); 
                 OD.textureObjects[tid] = 0; 
+                OD.destroyedTextureObjects++;
             }
             if (!texture->isInitialized()) continue;
             bool isHDR = texture->isHDR();
             bool isLinear = texture->isLinear();
             uint32_t width = texture->getWidth();
             uint32_t height = texture->getHeight();
-            OWLTexelFormat format = ((isHDR) ? OWL_TEXEL_FORMAT_RGBA32F : OWL_TEXEL_FORMAT_RGBA8);
+            std::string texelFormat = texture->getFormat();
             OWLTextureColorSpace colorSpace = ((isLinear) ? OWL_COLOR_SPACE_LINEAR: OWL_COLOR_SPACE_SRGB);
-            if (width < 1 || height < 1 || 
-                (isHDR && texture->getFloatTexels().size() != width * height) || 
-                (!isHDR && texture->getByteTexels().size() != width * height)) 
-            {
-                std::cout<<"Internal error: corrupt texture. Attempting to recover..." <<std::endl;
-                return; 
+
+            // Single channel textures stay single channel on the device. Other formats 
+            // are expanded to RGBA, since those are the remaining formats OWL supports.
+            // Texels are fetched once, since compressed textures are decompressed by these calls
+            OWLTexelFormat format;
+            std::vector<uint8_t> texelBytes;
+            std::vector<float> singleChannelTexels;
+            std::vector<glm::vec4> floatTexels;
+            std::vector<glm::u8vec4> byteTexels;
+            const void* texels;
+            size_t texelCount;
+            if (texelFormat == "R8") {
+                format = OWL_TEXEL_FORMAT_R8;
+                texelBytes = texture->getTexelBytes();
+                texels = texelBytes.data();
+                texelCount = texelBytes.size();
+            }
+            else if ((texelFormat == "R16F") || (texelFormat == "R32F")) {
+                format = OWL_TEXEL_FORMAT_R32F;
+                singleChannelTexels = texture->getTexels();
+                texels = singleChannelTexels.data();
+                texelCount = singleChannelTexels.size();
             }
-            if (isHDR) {
-                auto texels = texture->getFloatTexels();
-                OD.textureObjects[tid] = owlTexture2DCreate(
-                    OD.context, 
-                    format,
-                    width, height, texels.data(),
-                    OWL_TEXTURE_LINEAR, 
-                    OWL_TEXTURE_WRAP,
-                    colorSpace
-                );
+            else if (isHDR) {
+                format = OWL_TEXEL_FORMAT_RGBA32F;
+                floatTexels = texture->getFloatTexels();
+                texels = floatTexels.data();
+                texelCount = floatTexels.size();
             }
             else {
-                auto texels = texture->getByteTexels();
-                OD.textureObjects[tid] = owlTexture2DCreate(
-                    OD.context, 
-                    format,
-                    width, height, texels.data(),
-                    OWL_TEXTURE_LINEAR, 
-                    OWL_TEXTURE_WRAP,
-                    colorSpace
-                );
+                format = OWL_TEXEL_FORMAT_RGBA8;
+                byteTexels = texture->getByteTexels();
+                texels = byteTexels.data();
+                texelCount = byteTexels.size();
             }
-        }
-
-        // Create additional cuda textures for material constants
-
-        // Manage materials
-        {
-            Material* materials = Material::getFront();
-            MaterialStruct* matStructs = Material::getFrontStruct();
-            
-            for (uint32_t mid = 0; mid < Material::getCount(); ++mid) {
-                if (!materials[mid].isInitialized()) continue;
-                if (!materials[mid].isDirty()) continue;
-
-                OptixData.materialStructs[mid] = matStructs[mid];
-
-                auto genRGBATex = [&OD](int index, vec4 c, vec4 defaultVal) {
-                    if (OD.textureObjects[index]) { 
-                        owlTexture2DDestroy(OD.textureObjects[index]); 
-                        OD.textureObjects[index] = 0; 
-                    }
-                    if (glm::all(glm::equal(c, defaultVal))) return;
-                    OD.textureObjects[index] = owlTexture2DCreate(
-                        OD.context, OWL_TEXEL_FORMAT_RGBA32F,
-                        1,1, &c, OWL_TEXTURE_LINEAR, OWL_TEXTURE_WRAP, OWL_COLOR_SPACE_LINEAR);
-                    OptixData.textureStructs[index] = TextureStruct();
-                    OptixData.textureStructs[index].width = 1;
-                    OptixData.textureStructs[index].height = 1;
-                };
-
-                int off = Texture::getCount() + mid * NUM_MAT_PARAMS;
-                auto &m = materials[mid];
-                auto &ms = matStructs[mid];
-                auto &odms = OptixData.materialStructs[mid];
-                if (ms.transmission_roughness_texture_id == -1) { genRGBATex(off + 0, vec4(m.getTransmissionRoughness()), vec4(0.f)); }
-                if (ms.base_color_texture_id == -1)             { genRGBATex(off + 1, vec4(m.getBaseColor(), 1.f), vec4(.8f, .8f, .8f, 1.f)); }
-                if (ms.roughness_texture_id == -1)              { genRGBATex(off + 2, vec4(m.getRoughness()), vec4(.5f)); }
-                if (ms.alpha_texture_id == -1)                  { genRGBATex(off + 3, vec4(m.getAlpha()), vec4(1.f)); }
-                if (ms.normal_map_texture_id == -1)             { genRGBATex(off + 4, vec4(0.5f, .5f, 1.f, 0.f), vec4(0.5f, .5f, 1.f, 0.f)); }
-                if (ms.subsurface_color_texture_id == -1)       { genRGBATex(off + 5, vec4(m.getSubsurfaceColor(), 1.f), glm::vec4(0.8f, 0.8f, 0.8f, 1.f)); }
-                if (ms.subsurface_radius_texture_id == -1)      { genRGBATex(off + 6, vec4(m.getSubsurfaceRadius(), 1.f), glm::vec4(1.0f, .2f, .1f, 1.f)); }
-                if (ms.subsurface_texture_id == -1)             { genRGBATex(off + 7, vec4(m.getSubsurface()), glm::vec4(0.f)); }
-                if (ms.metallic_texture_id == -1)               { genRGBATex(off + 8, vec4(m.getMetallic()), glm::vec4(0.f)); }
-                if (ms.specular_texture_id == -1)               { genRGBATex(off + 9, vec4(m.getSpecular()), glm::vec4(.5f)); }
-                if (ms.specular_tint_texture_id == -1)          { genRGBATex(off + 10, vec4(m.getSpecularTint()), glm::vec4(0.f)); }
-                if (ms.anisotropic_texture_id == -1)            { genRGBATex(off + 11, vec4(m.getAnisotropic()), glm::vec4(0.f)); }
-                if (ms.anisotropic_rotation_texture_id == -1)   { genRGBATex(off + 12, vec4(m.getAnisotropicRotation()), glm::vec4(0.f)); }
-                if (ms.sheen_texture_id == -1)                  { genRGBATex(off + 13, vec4(m.getSheen()), glm::vec4(0.f)); }
-                if (ms.sheen_tint_texture_id == -1)             { genRGBATex(off + 14, vec4(m.getSheenTint()), glm::vec4(0.5f)); }
-                if (ms.clearcoat_texture_id == -1)              { genRGBATex(off + 15, vec4(m.getClearcoat()), glm::vec4(0.f)); }
-                if (ms.clearcoat_roughness_texture_id == -1)    { genRGBATex(off + 16, vec4(m.getClearcoatRoughness()), glm::vec4(0.3f)); }
-                if (ms.ior_texture_id == -1)                    { genRGBATex(off + 17, vec4(m.getIor()), glm::vec4(1.45f)); }
-                if (ms.transmission_texture_id == -1)           { genRGBATex(off + 18, vec4(m.getTransmission()), glm::vec4(0.f)); }
-                
-                if (ms.transmission_roughness_texture_id == -1) { odms.transmission_roughness_texture_id = off + 0; }
-                if (ms.base_color_texture_id == -1)             { odms.base_color_texture_id = off + 1; }
-                if (ms.roughness_texture_id == -1)              { odms.roughness_texture_id = off + 2; }
-                if (ms.alpha_texture_id == -1)                  { odms.alpha_texture_id = off + 3; }
-                if (ms.normal_map_texture_id == -1)             { odms.normal_map_texture_id = off + 4; }
-                if (ms.subsurface_color_texture_id == -1)       { odms.subsurface_color_texture_id = off + 5; }
-                if (ms.subsurface_radius_texture_id == -1)      { odms.subsurface_radius_texture_id = off + 6; }
-                if (ms.subsurface_texture_id == -1)             { odms.subsurface_texture_id = off + 7; }
-                if (ms.metallic_texture_id == -1)               { odms.metallic_texture_id = off + 8; }
-                if (ms.specular_texture_id == -1)               { odms.specular_texture_id = off + 9; }
-                if (ms.specular_tint_texture_id == -1)          { odms.specular_tint_texture_id = off + 10; }
-                if (ms.anisotropic_texture_id == -1)            { odms.anisotropic_texture_id = off + 11; }
-                if (ms.anisotropic_rotation_texture_id == -1)   { odms.anisotropic_rotation_texture_id = off + 12; }
-                if (ms.sheen_texture_id == -1)                  { odms.sheen_texture_id = off + 13; }
-                if (ms.sheen_tint_texture_id == -1)             { odms.sheen_tint_texture_id = off + 14; }
-                if (ms.clearcoat_texture_id == -1)              { odms.clearcoat_texture_id = off + 15; }
-                if (ms.clearcoat_roughness_texture_id == -1)    { odms.clearcoat_roughness_texture_id = off + 16; }
-                if (ms.ior_texture_id == -1)                    { odms.ior_texture_id = off + 17; }
-                if (ms.transmission_texture_id == -1)           { odms.transmission_texture_id = off + 18; }
+            if (width < 1 || height < 1 || texelCount != width * height) 
+            {
+                std::cout<<"Internal error: corrupt texture. Attempting to recover..." <<std::endl;
+                return; 
             }
-
-            Material::updateComponents();
-            owlBufferUpload(OptixData.materialBuffer, OptixData.materialStructs.data());
+            OD.textureObjects[tid] = owlTexture2DCreate(
+                OD.context, 
+                format,
+                width, height, 
+                texels,
+                OWL_TEXTURE_LINEAR, 
+                OWL_TEXTURE_WRAP,
+                colorSpace
+            );
+            OD.createdTextureObjects++;
         }
+
+        // Material constants are stored in the material structs, so only the materials 
+        // which changed need to be uploaded
+        auto dirtyMaterials = getDirtyRanges(Material::getFront(), Material::getCount());
+        Material::updateComponents();
+        uploadBufferRanges(OD.materialBuffer, Material::getFrontStruct(), sizeof(MaterialStruct), Material::getCount(), dirtyMaterials);
         
-        owlBufferUpload(OD.textureObjectsBuffer, OD.textureObjects.data());
+        if (dirtyTextures.size() > 0) {
+            uploadBuffer(OD.textureObjectsBuffer, OD.textureObjects.data(), OD.textureObjects.size() * sizeof(cudaTextureObject_t));
+        }
         Texture::updateComponents();
-        memcpy(OptixData.textureStructs.data(), Texture::getFrontStruct(), Texture::getCount() * sizeof(TextureStruct));
-        owlBufferUpload(OptixData.textureBuffer, OptixData.textureStructs.data());
+        uploadBufferRanges(OD.textureBuffer, Texture::getFrontStruct(), sizeof(TextureStruct), Texture::getCount(), getDirtyRanges(dirtyTextures));
     }
     
     // Manage transforms
@@ -1492,20 +1662,22 @@ void updateComponents()
     if (dirtyTransforms.size() > 0) {
         Transform::updateComponents();
 
-        // cudaSetDevice(0);
-        owlBufferUpload(OptixData.transformBuffer, Transform::getFrontStruct());
+        // Only the transforms which changed need to be uploaded
+        uploadBufferRanges(OD.transformBuffer, Transform::getFrontStruct(), sizeof(TransformStruct), Transform::getCount(), getDirtyRanges(dirtyTransforms));
     }   
 
     // Manage Cameras
     if (Camera::areAnyDirty()) {
+        auto dirtyRanges = getDirtyRanges(Camera::getFront(), Camera::getCount());
         Camera::updateComponents();
-        owlBufferUpload(OptixData.cameraBuffer,    Camera::getFrontStruct());
+        uploadBufferRanges(OD.cameraBuffer, Camera::getFrontStruct(), sizeof(CameraStruct), Camera::getCount(), dirtyRanges);
     }    
 
     // Manage lights
     if (Light::areAnyDirty()) {
+        auto dirtyRanges = getDirtyRanges(Light::getFront(), Light::getCount());
         Light::updateComponents();
-        owlBufferUpload(OptixData.lightBuffer,     Light::getFrontStruct());
+        uploadBufferRanges(OD.lightBuffer, Light::getFrontStruct(), sizeof(LightStruct), Light::getCount(), dirtyRanges);
     }
 }
 
@@ -1529,6 +1701,7 @@ void updateLaunchParams()
     owlParamsSetRaw(OptixData.launchParams, "environmentMapRotation", &OptixData.LP.environmentMapRotation);
     owlParamsSetBuffer(OptixData.launchParams, "environmentMapRows", OptixData.environmentMapRowsBuffer);
     owlParamsSetBuffer(OptixData.launchParams, "environmentMapCols", OptixData.environmentMapColsBuffer);
+    owlParamsSetBuffer(OptixData.launchParams, "environmentMapAlias", OptixData.environmentMapAliasBuffer);
     owlParamsSetRaw(OptixData.launchParams, "environmentMapWidth", &OptixData.LP.environmentMapWidth);
     owlParamsSetRaw(OptixData.launchParams, "environmentMapHeight", &OptixData.LP.environmentMapHeight);
     owlParamsSetRaw(OptixData.launchParams, "sceneBBMin", &OptixData.LP.sceneBBMin);
@@ -1809,6 +1982,19 @@ void disableDenoiser()
     enqueueCommand([] () { OptixData.enableDenoiser = false; });
 }
 
+void enableInstanceRefit(uint32_t maxRefits)
+{
+    enqueueCommand([maxRefits] () { 
+        OptixData.instanceAccel.setRefitEnabled(true); 
+        OptixData.instanceAccel.setMaxRefits(maxRefits);
+    });
+}
+
+void disableInstanceRefit()
+{
+    enqueueCommand([] () { OptixData.instanceAccel.setRefitEnabled(false); });
+}
+
 void configureDenoiser(bool useAlbedoGuide, bool useNormalGuide, bool useKernelPrediction)
 {
     if (useNormalGuide && (!useAlbedoGuide)) {
@@ -2588,14 +2774,17 @@ void clearAll()
 }
 
 glm::vec3 getSceneMinAabbCorner() {
+    Transform::updateWorldMatrices();
     return OptixData.LP.sceneBBMin;
 }
 
 glm::vec3 getSceneMaxAabbCorner() {
+    Transform::updateWorldMatrices();
     return OptixData.LP.sceneBBMax;
 }
 
 glm::vec3 getSceneAabbCenter() {
+    Transform::updateWorldMatrices();
     return OptixData.LP.sceneBBMin + (OptixData.LP.sceneBBMax - OptixData.LP.sceneBBMin) * .5f;
 }
 
@@ -2650,6 +2839,9 @@ void deinitialize()
             stopped = true;
             renderThread.join();
         }
+        // cancelled builds return promptly, so waiting on them here doesn't hold up shutdown
+        discardEnvironmentSampling();
+        OptixData.discardedEnvironmentSampling.clear();
         clearAll();
     }
     initialized = false;
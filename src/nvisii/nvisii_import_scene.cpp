@@ -2,8 +2,11 @@
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <nvisii/utilities/parallel.h>
 
+#include <cstring>
 #include <set>
+#include <unordered_map>
 
 namespace nvisii {
 
@@ -32,6 +35,282 @@ inline glm::mat4 aiMatrix4x4ToGlm(const aiMatrix4x4* from)
     return to;
 }
 
+/* Loads assimp data directly into components. This needs access to their private per vertex buffers. */
+class SceneImporter {
+public:
+    static void loadMeshes(const aiScene* scene, Scene &nvisiiScene, uint32_t numThreads, bool deduplicate, bool compress, bool verbose);
+
+private:
+    static void decodeMesh(const aiMesh* aiMesh, size_t numTriangles, Mesh* mesh);
+};
+
+/* 
+ * Hashes a buffer eight bytes at a time, so that hashing the streams of large meshes stays 
+ * cheap compared to decoding them. Only used to find candidate duplicates, which are then 
+ * compared byte for byte.
+ */
+static uint64_t hashMeshBytes(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* bytes = (const uint8_t*) data;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        seed = (seed ^ word) * 0x100000001b3ull;
+        seed ^= seed >> 29;
+    }
+    for (; i < size; ++i) seed = (seed ^ bytes[i]) * 0x100000001b3ull;
+    return seed;
+}
+
+/* Hashes every stream of an aiMesh that decodeMesh reads, along with which streams are present. */
+static uint64_t hashMeshStreams(const aiMesh* aiMesh)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    uint32_t streams[5] = {aiMesh->mNumVertices, aiMesh->mNumFaces, uint32_t(aiMesh->HasNormals()),
+        uint32_t(aiMesh->HasTangentsAndBitangents()), uint32_t(aiMesh->HasTextureCoords(0))};
+    hash = hashMeshBytes(streams, sizeof(streams), hash);
+    size_t streamSize = aiMesh->mNumVertices * sizeof(aiVector3D);
+    hash = hashMeshBytes(aiMesh->mVertices, streamSize, hash);
+    if (aiMesh->HasNormals()) hash = hashMeshBytes(aiMesh->mNormals, streamSize, hash);
+    if (aiMesh->HasTangentsAndBitangents()) hash = hashMeshBytes(aiMesh->mTangents, streamSize, hash);
+    if (aiMesh->HasTextureCoords(0)) hash = hashMeshBytes(aiMesh->mTextureCoords[0], streamSize, hash);
+    for (uint32_t faceIdx = 0; faceIdx < aiMesh->mNumFaces; ++faceIdx) {
+        const aiFace &aiFace = aiMesh->mFaces[faceIdx];
+        if (aiFace.mNumIndices != 3) continue;
+        hash = hashMeshBytes(aiFace.mIndices, 3 * sizeof(unsigned int), hash);
+    }
+    return hash;
+}
+
+/* Returns true if decodeMesh would produce identical buffers for both meshes. */
+static bool sameMeshStreams(const aiMesh* a, const aiMesh* b)
+{
+    if ((a->mNumVertices != b->mNumVertices) || (a->mNumFaces != b->mNumFaces)) return false;
+    if ((a->HasNormals() != b->HasNormals()) || 
+        (a->HasTangentsAndBitangents() != b->HasTangentsAndBitangents()) || 
+        (a->HasTextureCoords(0) != b->HasTextureCoords(0))) return false;
+    size_t streamSize = a->mNumVertices * sizeof(aiVector3D);
+    if (memcmp(a->mVertices, b->mVertices, streamSize) != 0) return false;
+    if (a->HasNormals() && (memcmp(a->mNormals, b->mNormals, streamSize) != 0)) return false;
+    if (a->HasTangentsAndBitangents() && (memcmp(a->mTangents, b->mTangents, streamSize) != 0)) return false;
+    if (a->HasTextureCoords(0) && (memcmp(a->mTextureCoords[0], b->mTextureCoords[0], streamSize) != 0)) return false;
+    for (uint32_t faceIdx = 0; faceIdx < a->mNumFaces; ++faceIdx) {
+        const aiFace &faceA = a->mFaces[faceIdx];
+        const aiFace &faceB = b->mFaces[faceIdx];
+        if (faceA.mNumIndices != faceB.mNumIndices) return false;
+        if (faceA.mNumIndices != 3) continue;
+        if (memcmp(faceA.mIndices, faceB.mIndices, 3 * sizeof(unsigned int)) != 0) return false;
+    }
+    return true;
+}
+
+/*
+ * Writes the attributes of an aiMesh straight into the structure of arrays buffers of a
+ * mesh component, without any intermediate copies. Faces which aren't triangles (eg points
+ * and lines) are skipped, so numTriangles must count only the triangle faces.
+ */
+void SceneImporter::decodeMesh(const aiMesh* aiMesh, size_t numTriangles, Mesh* mesh)
+{
+    size_t numVertices = aiMesh->mNumVertices;
+
+    mesh->positions.resize(numVertices);
+    for (size_t vid = 0; vid < numVertices; ++vid) {
+        const aiVector3D &p = aiMesh->mVertices[vid];
+        mesh->positions[vid] = {p.x, p.y, p.z};
+    }
+
+    mesh->normals.assign(numVertices, glm::vec4(0.f));
+    if (aiMesh->HasNormals()) {
+        for (size_t vid = 0; vid < numVertices; ++vid) {
+            const aiVector3D &n = aiMesh->mNormals[vid];
+            mesh->normals[vid] = glm::vec4(n.x, n.y, n.z, 0.f);
+        }
+    }
+
+    // left zero when missing, unless generated from texture coordinates once decoded
+    mesh->tangents.assign(numVertices, glm::vec4(0.f));
+    if (aiMesh->HasTangentsAndBitangents()) {
+        for (size_t vid = 0; vid < numVertices; ++vid) {
+            const aiVector3D &t = aiMesh->mTangents[vid];
+            mesh->tangents[vid] = glm::vec4(t.x, t.y, t.z, 0.f);
+        }
+    }
+
+    // just try to take the first texcoord
+    mesh->texCoords.assign(numVertices, glm::vec2(0.f));
+    if (aiMesh->HasTextureCoords(0)) {
+        for (size_t vid = 0; vid < numVertices; ++vid) {
+            const aiVector3D &uv = aiMesh->mTextureCoords[0][vid];
+            mesh->texCoords[vid] = glm::vec2(uv.x, uv.y);
+        }
+    }
+
+    // same default as Mesh::createFromData when no colors are given
+    mesh->colors.assign(numVertices, glm::vec4(1.f, 0.f, 1.f, 1.f));
+
+    mesh->triangleIndices.resize(numTriangles * 3);
+    uint32_t* indices = mesh->triangleIndices.data();
+    for (uint32_t faceIdx = 0; faceIdx < aiMesh->mNumFaces; ++faceIdx) {
+        const aiFace &aiFace = aiMesh->mFaces[faceIdx];
+        if (aiFace.mNumIndices != 3) continue;
+        indices[0] = aiFace.mIndices[0];
+        indices[1] = aiFace.mIndices[1];
+        indices[2] = aiFace.mIndices[2];
+        indices += 3;
+    }
+
+    mesh->computeMetadata();
+}
+
+/*
+ * Creates a mesh component for every loadable aiMesh. Meshes are validated and decoded on
+ * numThreads worker threads, and all components are registered with the factory in one batch.
+ * Meshes which fail to load are left as nullptr in nvisiiScene.meshes.
+ * If deduplicate is true, aiMeshes with identical streams share a single mesh component, so 
+ * that each unique mesh is only stored and uploaded once. If compress is true, every mesh is 
+ * stored in the compact per vertex layout (see Mesh::compress).
+ */
+void SceneImporter::loadMeshes(const aiScene* scene, Scene &nvisiiScene, uint32_t numThreads, bool deduplicate, bool compress, bool verbose)
+{
+    nvisiiScene.meshes.resize(scene->mNumMeshes, nullptr);
+
+    // Pick a unique name for each mesh
+    std::vector<uint32_t> meshIndices;
+    std::vector<std::string> meshNames;
+    std::set<std::string> batchNames;
+    for (uint32_t meshIdx = 0; meshIdx < scene->mNumMeshes; ++meshIdx) {
+        auto &aiMesh = scene->mMeshes[meshIdx];
+        std::string meshName = std::string(aiMesh->mName.C_Str());
+        int duplicateCount = 0;
+        while ((Mesh::get(meshName) != nullptr) || (batchNames.count(meshName) != 0)) {
+            duplicateCount += 1;
+            meshName += std::to_string(duplicateCount);
+        }
+        if (verbose) std::cout<<"Loading mesh " << meshName << std::endl;
+
+        // mesh at the very least needs positions...
+        if (!aiMesh->HasPositions()) {
+            if (verbose) std::cout<<"\tERROR: mesh " << meshName << " has no positions" << std::endl;
+            continue;
+        }
+        if (!aiMesh->HasNormals()) {
+            if (verbose) std::cout<<"\tWARNING: mesh " << meshName << " has no normals" << std::endl;
+        }
+        if (!aiMesh->HasTangentsAndBitangents()) {
+            if (verbose) std::cout<<"\tWARNING: mesh " << meshName << " has no tangents" << std::endl;
+        }
+        if (!aiMesh->HasTextureCoords(0)) {
+            if (verbose) std::cout<<"\tWARNING: mesh " << meshName << " has no texture coordinates" << std::endl;
+        }
+        meshIndices.push_back(meshIdx);
+        meshNames.push_back(meshName);
+        batchNames.insert(meshName);
+    }
+
+    // Count the triangles of each mesh, and find any face referencing a vertex that doesn't exist
+    std::vector<size_t> triangleCounts(meshIndices.size(), 0);
+    std::vector<int64_t> invalidFaces(meshIndices.size(), -1);
+    std::vector<uint64_t> hashes(meshIndices.size(), 0);
+    Parallel::forEachDynamic(meshIndices.size(), numThreads, [&] (size_t i) {
+        auto &aiMesh = scene->mMeshes[meshIndices[i]];
+        if (deduplicate) hashes[i] = hashMeshStreams(aiMesh);
+        for (uint32_t faceIdx = 0; faceIdx < aiMesh->mNumFaces; ++faceIdx) {
+            // faces must have only 3 indices
+            auto &aiFace = aiMesh->mFaces[faceIdx];
+            if (aiFace.mNumIndices != 3) continue;
+            if ((aiFace.mIndices[0] >= aiMesh->mNumVertices) || 
+                (aiFace.mIndices[1] >= aiMesh->mNumVertices) || 
+                (aiFace.mIndices[2] >= aiMesh->mNumVertices)) {
+                invalidFaces[i] = faceIdx;
+                return;
+            }
+            triangleCounts[i]++;
+        }
+    });
+
+    // Meshes with the same hash become instances of the first such mesh, if their streams really match
+    std::vector<size_t> instanceOf(meshIndices.size());
+    for (size_t i = 0; i < meshIndices.size(); ++i) instanceOf[i] = i;
+    if (deduplicate) {
+        std::unordered_map<uint64_t, size_t> firstWithHash;
+        for (size_t i = 0; i < meshIndices.size(); ++i) {
+            if (invalidFaces[i] >= 0) continue;
+            auto it = firstWithHash.insert({hashes[i], i});
+            if (!it.second) instanceOf[i] = it.first->second;
+        }
+        Parallel::forEachDynamic(meshIndices.size(), numThreads, [&] (size_t i) {
+            if (instanceOf[i] == i) return;
+            if (!sameMeshStreams(scene->mMeshes[meshIndices[i]], scene->mMeshes[meshIndices[instanceOf[i]]])) 
+                instanceOf[i] = i;
+        });
+    }
+
+    // if we found a face that would result in an access violation, don't make this mesh.
+    std::vector<size_t> valid;
+    std::vector<std::string> validNames;
+    for (size_t i = 0; i < meshIndices.size(); ++i) {
+        if (invalidFaces[i] >= 0) {
+            if (verbose) std::cout<<"\tERROR: mesh " << meshNames[i] << " has an invalid face index at face " << invalidFaces[i] << ". Skipping..." <<std::endl;
+            continue;
+        }
+        if (instanceOf[i] != i) continue;
+        valid.push_back(i);
+        validNames.push_back(meshNames[i]);
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(*Mesh::editMutex);
+    std::vector<Mesh*> meshes = StaticFactory::createMany<Mesh>(Mesh::editMutex, validNames, "Mesh",
+        Mesh::lookupTable, Mesh::meshes.data(), Mesh::meshes.size());
+
+    std::vector<std::string> errors(meshes.size());
+    Parallel::forEachDynamic(meshes.size(), numThreads, [&] (size_t i) {
+        try {
+            decodeMesh(scene->mMeshes[meshIndices[valid[i]]], triangleCounts[valid[i]], meshes[i]);
+        } catch (std::exception &e) {
+            errors[i] = std::string(e.what());
+        }
+    });
+
+    // Generating normals and tangents marks the mesh dirty, which isn't thread safe, so finish up here
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        auto mesh = meshes[i];
+        auto &aiMesh = scene->mMeshes[meshIndices[valid[i]]];
+        if (!errors[i].empty()) {
+            if (verbose) std::cout<<"Warning: unable to load mesh " << mesh->getName() <<  " : " << errors[i] <<std::endl;
+            Mesh::remove(mesh->getName());
+            continue;
+        }
+        if (!aiMesh->HasNormals()) mesh->generateSmoothNormals();
+        if (!aiMesh->HasTangentsAndBitangents() && aiMesh->HasTextureCoords(0)) mesh->generateSmoothTangents();
+        if (compress) {
+            float bytesBefore = mesh->getBytesPerVertex();
+            mesh->compress();
+            if (verbose) std::cout<<"\tCompressed mesh " << mesh->getName() << " from " << bytesBefore << " to " << mesh->getBytesPerVertex() << " bytes per vertex" << std::endl;
+        }
+        mesh->markDirty();
+        nvisiiScene.meshes[meshIndices[valid[i]]] = mesh;
+    }
+
+    if (!deduplicate) return;
+    size_t numInstanced = 0;
+    size_t bytesSaved = 0;
+    for (size_t i = 0; i < meshIndices.size(); ++i) {
+        if (instanceOf[i] == i) continue;
+        Mesh* mesh = nvisiiScene.meshes[meshIndices[instanceOf[i]]];
+        if (mesh == nullptr) continue;
+        nvisiiScene.meshes[meshIndices[i]] = mesh;
+        if (verbose) std::cout<<"\tMesh " << meshNames[i] << " is a duplicate of " << mesh->getName() << std::endl;
+        size_t numVertices = scene->mMeshes[meshIndices[i]]->mNumVertices;
+        numInstanced++;
+        // the shared mesh may have been compressed, so use its actual vertex layout
+        bytesSaved += size_t(numVertices * double(mesh->getBytesPerVertex())) 
+            + triangleCounts[i] * 3 * sizeof(uint32_t);
+    }
+    if (verbose) std::cout<<"Deduplicated " << numInstanced << " of " << meshIndices.size() << " meshes, saving " 
+        << (bytesSaved / (1024.0 * 1024.0)) << " MB" << std::endl;
+}
+
 std::string dirnameOf(const std::string& fname)
 {
      size_t pos = fname.find_last_of("\\/");
@@ -45,9 +324,17 @@ Scene importScene(std::string path, glm::vec3 position, glm::vec3 scale, glm::qu
     std::string directory = dirnameOf(path);
     bool verbose = false;
     bool max_quality = false;
+    uint32_t texture_threads = 0;
+    uint32_t mesh_threads = 0;
+    bool deduplicate_meshes = false;
+    bool compress_meshes = false;
     for (uint32_t i = 0; i < args.size(); ++i) {
         if (args[i].compare("verbose") == 0) verbose = true;
         if (args[i].compare("max_quality") == 0) max_quality = true;
+        if (args[i].compare("deduplicate_meshes") == 0) deduplicate_meshes = true;
+        if (args[i].compare("compress_meshes") == 0) compress_meshes = true;
+        if (args[i].compare(0, 16, "texture_threads=") == 0) texture_threads = (uint32_t) std::stoul(args[i].substr(16));
+        if (args[i].compare(0, 13, "mesh_threads=") == 0) mesh_threads = (uint32_t) std::stoul(args[i].substr(13));
     }
 
     Scene nvisiiScene;
@@ -175,24 +462,28 @@ Scene importScene(std::string path, glm::vec3 position, glm::vec3 scale, glm::qu
     }
 
     // load textures
+    // Images are decoded concurrently, then added to the texture table together
+    std::vector<std::string> texture_names;
+    std::vector<std::string> texture_files;
+    std::set<std::string> batch_names;
     for (auto &tex : texture_paths)
     {
         std::string textureName = tex.path;
         int duplicateCount = 0;
-        while (Texture::get(textureName) != nullptr) {
+        while (Texture::get(textureName) != nullptr || batch_names.count(textureName) > 0) {
             duplicateCount += 1;
             textureName += std::to_string(duplicateCount);
         }
         if (verbose) std::cout<<"Loading texture " << textureName << std::endl;
+        batch_names.insert(textureName);
+        texture_names.push_back(textureName);
+        texture_files.push_back(tex.path);
+    }
 
-        Texture* texture = nullptr;
-        try {
-            texture = (Texture::get(textureName) != nullptr) ? Texture::get(textureName) : Texture::createFromFile(textureName, tex.path);
-        } catch (std::exception& e) {
-            if (verbose) std::cout<<"Warning: unable to load texture " << textureName <<  " : " << std::string(e.what()) <<std::endl;
-        }
-        nvisiiScene.textures.push_back(texture);
-        texture_map[tex.path] = texture;
+    auto textures = Texture::createFromFiles(texture_names, texture_files, /* linear */ false, texture_threads, verbose);
+    for (size_t i = 0; i < textures.size(); ++i) {
+        nvisiiScene.textures.push_back(textures[i]);
+        texture_map[texture_files[i]] = textures[i];
     }
 
     // assign textures to materials
@@ -320,121 +611,7 @@ Scene importScene(std::string path, glm::vec3 position, glm::vec3 scale, glm::qu
     }
 
     // load objects
-    nvisiiScene.meshes.resize(scene->mNumMeshes, nullptr);
-    for (uint32_t meshIdx = 0; meshIdx < scene->mNumMeshes; ++meshIdx) {
-        auto &aiMesh = scene->mMeshes[meshIdx];
-        auto &aiVertices = aiMesh->mVertices;
-        auto &aiNormals = aiMesh->mNormals;
-        auto &aiTangents = aiMesh->mTangents;
-        auto &aiFaces = aiMesh->mFaces;
-        auto &aiTextureCoords = aiMesh->mTextureCoords;
-
-        std::vector<float> positions;
-        std::vector<float> normals;
-        std::vector<float> tangents;
-        std::vector<float> texCoords;
-        std::vector<uint32_t> indices;
-
-        std::string meshName = std::string(aiMesh->mName.C_Str());
-        int duplicateCount = 0;
-        while (Mesh::get(meshName) != nullptr) {
-            duplicateCount += 1;
-            meshName += std::to_string(duplicateCount);
-        }
-        if (verbose) std::cout<<"Loading mesh " << meshName << std::endl;
-
-        // mesh at the very least needs positions...
-        if (!aiMesh->HasPositions()) {
-            if (verbose) std::cout<<"\tERROR: mesh " << meshName << " has no positions" << std::endl;
-            continue;
-        }
-        if (!aiMesh->HasNormals()) {
-            if (verbose) std::cout<<"\tWARNING: mesh " << meshName << " has no normals" << std::endl;
-        }
-        if (!aiMesh->HasTangentsAndBitangents()) {
-            if (verbose) std::cout<<"\tWARNING: mesh " << meshName << " has no tangents" << std::endl;
-        }
-        if (!aiMesh->HasTextureCoords(0)) {
-            if (verbose) std::cout<<"\tWARNING: mesh " << meshName << " has no texture coordinates" << std::endl;
-        }
-
-        // note that we triangulated the meshes above
-        for (uint32_t vid = 0; vid < aiMesh->mNumVertices; ++vid) {
-            Vertex v;
-            if (aiMesh->HasPositions()) {
-                auto vert = aiVertices[vid];
-                v.point.x = vert.x;
-                v.point.y = vert.y;
-                v.point.z = vert.z;
-            }
-            if (aiMesh->HasNormals()) {
-                auto normal = aiNormals[vid];
-                v.normal.x = normal.x;
-                v.normal.y = normal.y;
-                v.normal.z = normal.z;
-            }
-            if (aiMesh->HasTangentsAndBitangents()) {
-                auto tangent = aiTangents[vid];
-                v.tangent.x = tangent.x;
-                v.tangent.y = tangent.y;
-                v.tangent.z = tangent.z;
-            }
-            if (aiMesh->HasTextureCoords(0)) {
-                // just try to take the first texcoord
-                auto texCoord = aiTextureCoords[0][vid];						
-                v.texcoord.x = texCoord.x;
-                v.texcoord.y = texCoord.y;
-            }
-            positions.push_back(v.point.x);
-            positions.push_back(v.point.y);
-            positions.push_back(v.point.z);
-            normals.push_back(v.normal.x);
-            normals.push_back(v.normal.y);
-            normals.push_back(v.normal.z);
-            tangents.push_back(v.tangent.x);
-            tangents.push_back(v.tangent.y);
-            tangents.push_back(v.tangent.z);
-            texCoords.push_back(v.texcoord.x);
-            texCoords.push_back(v.texcoord.y);
-        }
-
-        bool validFaces = true;
-        for (uint32_t faceIdx = 0; faceIdx < aiMesh->mNumFaces; ++faceIdx) {
-            // faces must have only 3 indices
-            auto &aiFace = aiFaces[faceIdx];			
-            if (aiFace.mNumIndices != 3) continue;
-            indices.push_back(aiFace.mIndices[0]);
-            indices.push_back(aiFace.mIndices[1]);
-            indices.push_back(aiFace.mIndices[2]);
-            if (((aiFace.mIndices[0]) >= positions.size()) || 
-                ((aiFace.mIndices[1]) >= positions.size()) || 
-                ((aiFace.mIndices[2]) >= positions.size())) {
-
-                if (verbose) std::cout<<"\tERROR: mesh " << meshName << " has an invalid face index at face " << faceIdx << ". Skipping..." <<std::endl;
-                validFaces = false;
-                break;
-            }                
-        }
-
-        // if we found a face that would result in an access violation, don't make this mesh.
-        if (!validFaces) continue; 
-
-        try {
-            nvisiiScene.meshes[meshIdx] = Mesh::createFromData(
-                meshName, 
-                positions, 3,
-                normals, 3,
-                tangents, 3,
-                /*colors*/{}, 3,
-                texCoords, 2,
-                indices
-            );
-        }
-        catch (std::exception& e) {
-            if (verbose) std::cout<<"Warning: unable to load mesh " << meshName <<  " : " << std::string(e.what()) <<std::endl;
-            continue;
-        }
-    }
+    SceneImporter::loadMeshes(scene, nvisiiScene, mesh_threads, deduplicate_meshes, compress_meshes, verbose);
 
     std::function<void(aiNode*, Transform*, int level)> addNode;
     addNode = [&scene, &nvisiiScene, &material_light_map, &addNode, position, rotation, scale, verbose]
@@ -482,7 +659,7 @@ Scene importScene(std::string path, glm::vec3 position, glm::vec3 scale, glm::qu
             
             duplicateCount = 0;
             std::string entityName = transformName + "_" + mesh->getName();
-            while (Entity::get(transformName) != nullptr) {
+            while (Entity::get(entityName) != nullptr) {
                 duplicateCount += 1;
                 entityName += std::to_string(duplicateCount);
             }    
@@ -0,0 +1,598 @@
+#include <nvisii/nvisii.h>
+
+#include <nvisii/utilities/parallel.h>
+#include <nvisii/utilities/scene_snapshot.h>
+
+#include <cstring>
+#include <list>
+#include <unordered_map>
+
+namespace nvisii {
+
+/*
+ * Records stored in a snapshot, one per component. Ids are the ids the components had when saved,
+ * and are remapped to the ids of the recreated components on load.
+ */
+struct SnapshotEntity {
+    int32_t id;
+    int32_t active;
+    EntityStruct entityStruct;
+};
+
+struct SnapshotTransform {
+    int32_t id;
+    int32_t parent;
+    int32_t useRelativeLinearMotionBlur;
+    int32_t useRelativeAngularMotionBlur;
+    int32_t useRelativeScalarMotionBlur;
+    glm::vec3 scale;
+    glm::vec3 position;
+    glm::quat rotation;
+    glm::vec3 prevScale;
+    glm::vec3 prevPosition;
+    glm::quat prevRotation;
+    glm::vec3 linearMotion;
+    glm::quat angularMotion;
+    glm::vec3 scalarMotion;
+    glm::mat4 localToParentTransform;
+    glm::mat4 prevLocalToParentTransform;
+};
+
+struct SnapshotMesh {
+    int32_t id;
+    MeshStruct meshStruct;
+    SceneSnapshotRange positions;
+    SceneSnapshotRange normals;
+    SceneSnapshotRange tangents;
+    SceneSnapshotRange colors;
+    SceneSnapshotRange texCoords;
+    SceneSnapshotRange triangleIndices;
+};
+
+struct SnapshotTexture {
+    int32_t id;
+    int32_t linear;
+    uint32_t compression;
+    uint32_t packedFormat;
+    TextureStruct textureStruct;
+    SceneSnapshotRange floatTexels;
+    SceneSnapshotRange byteTexels;
+    SceneSnapshotRange floatMipTexels;
+    SceneSnapshotRange byteMipTexels;
+    SceneSnapshotRange mipOffsets;
+    SceneSnapshotRange compressedBlocks;
+    SceneSnapshotRange compressedLevelOffsets;
+    SceneSnapshotRange packedTexels;
+};
+
+struct SnapshotMaterial {
+    int32_t id;
+    MaterialStruct materialStruct;
+};
+
+struct SnapshotLight {
+    int32_t id;
+    LightStruct lightStruct;
+};
+
+struct SnapshotCamera {
+    int32_t id;
+    CameraStruct cameraStruct;
+};
+
+struct SnapshotVolume {
+    int32_t id;
+    VolumeStruct volumeStruct;
+    SceneSnapshotRange grid;
+};
+
+/* Maps the ids components were saved with to the components recreated from them */
+template<class T>
+using SnapshotIdMap = std::unordered_map<int32_t, T*>;
+
+template<class T>
+static T* findSnapshotComponent(const SnapshotIdMap<T> &components, int32_t id)
+{
+    if (id < 0) return nullptr;
+    auto it = components.find(id);
+    return (it == components.end()) ? nullptr : it->second;
+}
+
+/* Every texture id in a MaterialStruct, remapped to the recreated textures on load */
+static int32_t MaterialStruct::* const materialTextureIds[] = {
+    &MaterialStruct::transmission_roughness_texture_id,
+    &MaterialStruct::base_color_texture_id,
+    &MaterialStruct::roughness_texture_id,
+    &MaterialStruct::alpha_texture_id,
+    &MaterialStruct::normal_map_texture_id,
+    &MaterialStruct::subsurface_color_texture_id,
+    &MaterialStruct::subsurface_radius_texture_id,
+    &MaterialStruct::subsurface_texture_id,
+    &MaterialStruct::metallic_texture_id,
+    &MaterialStruct::specular_texture_id,
+    &MaterialStruct::specular_tint_texture_id,
+    &MaterialStruct::anisotropic_texture_id,
+    &MaterialStruct::anisotropic_rotation_texture_id,
+    &MaterialStruct::sheen_texture_id,
+    &MaterialStruct::sheen_tint_texture_id,
+    &MaterialStruct::clearcoat_texture_id,
+    &MaterialStruct::clearcoat_roughness_texture_id,
+    &MaterialStruct::ior_texture_id,
+    &MaterialStruct::transmission_texture_id
+};
+
+/* Appends a name to a names section, terminated by '\0' */
+static void addSnapshotName(std::vector<char> &names, const std::string &name)
+{
+    names.insert(names.end(), name.begin(), name.end());
+    names.push_back('\0');
+}
+
+/*
+ * Saving and loading are implemented here rather than in each component, since loading
+ * has to recreate the components in dependency order and fix up the references between them.
+ */
+class SceneSnapshot {
+    public:
+
+    static void save(const std::string &path);
+    static Scene load(const std::string &path);
+
+    private:
+
+    /* The records and names of one component type, read from a snapshot */
+    template<class Record>
+    struct Section {
+        const Record* records = nullptr;
+        std::vector<std::string> names;
+        size_t size() const { return names.size(); }
+    };
+
+    template<class Record>
+    static Section<Record> readSection(const SceneSnapshotReader &reader, uint32_t recordType, uint32_t namesType,
+        const std::string &type, LookupTable &lookupTable, size_t maxItems);
+
+    /* Removes the components a failed load already created, entities first since they link to the rest */
+    static void removeScene(const Scene &scene);
+};
+
+template<class Record>
+SceneSnapshot::Section<Record> SceneSnapshot::readSection(const SceneSnapshotReader &reader, uint32_t recordType,
+    uint32_t namesType, const std::string &type, LookupTable &lookupTable, size_t maxItems)
+{
+    Section<Record> section;
+    SceneSnapshotRange records = reader.getSection<Record>(recordType);
+    SceneSnapshotRange names = reader.getSection<char>(namesType);
+    section.records = reader.get<Record>(records);
+
+    const char* chars = reader.get<char>(names);
+    section.names.reserve(size_t(records.count));
+    for (uint64_t begin = 0, end = 0; end < names.count; ++end) {
+        if (chars[end] != '\0') continue;
+        section.names.push_back(std::string(chars + begin, size_t(end - begin)));
+        begin = end + 1;
+    }
+    if (section.names.size() != records.count)
+        throw std::runtime_error("Error: scene snapshot has " + std::to_string(records.count) + " " + type
+            + " records but " + std::to_string(section.names.size()) + " " + type + " names");
+
+    // Check for existing components and free space up front, so that most failed loads are caught before 
+    // anything is created. Anything else that fails later is undone by removeScene.
+    for (auto &name : section.names) {
+        if (lookupTable.contains(name))
+            throw std::runtime_error("Error: " + type + " \"" + name + "\" already exists.");
+    }
+    if (section.size() > maxItems - lookupTable.size())
+        throw std::runtime_error("Error: max " + type + " limit reached.");
+    return section;
+}
+
+void SceneSnapshot::removeScene(const Scene &scene)
+{
+    for (auto entity : scene.entities) Entity::remove(entity->getName());
+    for (auto transform : scene.transforms) Transform::remove(transform->getName());
+    for (auto volume : scene.volumes) Volume::remove(volume->getName());
+    for (auto camera : scene.cameras) Camera::remove(camera->getName());
+    for (auto light : scene.lights) Light::remove(light->getName());
+    for (auto material : scene.materials) Material::remove(material->getName());
+    for (auto mesh : scene.meshes) Mesh::remove(mesh->getName());
+    for (auto texture : scene.textures) Texture::remove(texture->getName());
+}
+
+void SceneSnapshot::save(const std::string &path)
+{
+    // Lock every component table, so the snapshot is consistent and the data referenced by the writer stays valid
+    std::lock(*Entity::editMutex, *Transform::editMutex, *Mesh::editMutex, *Texture::editMutex,
+        *Material::editMutex, *Light::editMutex, *Camera::editMutex, *Volume::editMutex);
+    std::lock_guard<std::recursive_mutex> entityLock(*Entity::editMutex, std::adopt_lock);
+    std::lock_guard<std::recursive_mutex> transformLock(*Transform::editMutex, std::adopt_lock);
+    std::lock_guard<std::recursive_mutex> meshLock(*Mesh::editMutex, std::adopt_lock);
+    std::lock_guard<std::recursive_mutex> textureLock(*Texture::editMutex, std::adopt_lock);
+    std::lock_guard<std::recursive_mutex> materialLock(*Material::editMutex, std::adopt_lock);
+    std::lock_guard<std::recursive_mutex> lightLock(*Light::editMutex, std::adopt_lock);
+    std::lock_guard<std::recursive_mutex> cameraLock(*Camera::editMutex, std::adopt_lock);
+    std::lock_guard<std::recursive_mutex> volumeLock(*Volume::editMutex, std::adopt_lock);
+
+    // Records are zero filled before being written, so that their padding doesn't make snapshots of the 
+    // same scene differ
+    SceneSnapshotWriter writer;
+
+    std::vector<SnapshotEntity> entities;
+    std::vector<char> entityNames;
+    for (auto &entity : Entity::entities) {
+        if (!entity.initialized) continue;
+        SnapshotEntity record;
+        memset((void*) &record, 0, sizeof(record));
+        record.id = entity.id;
+        record.active = entity.active;
+        record.entityStruct = Entity::entityStructs[entity.id];
+        entities.push_back(record);
+        addSnapshotName(entityNames, entity.name);
+    }
+    writer.addSection(SCENE_SNAPSHOT_ENTITIES, entities);
+    writer.addSection(SCENE_SNAPSHOT_ENTITY_NAMES, entityNames);
+
+    std::vector<SnapshotTransform> transforms;
+    std::vector<char> transformNames;
+    for (auto &transform : Transform::transforms) {
+        if (!transform.initialized) continue;
+        int32_t id = transform.id;
+        SnapshotTransform record;
+        memset((void*) &record, 0, sizeof(record));
+        record.id = id;
+        record.parent = transform.parent;
+        record.useRelativeLinearMotionBlur = transform.useRelativeLinearMotionBlur;
+        record.useRelativeAngularMotionBlur = transform.useRelativeAngularMotionBlur;
+        record.useRelativeScalarMotionBlur = transform.useRelativeScalarMotionBlur;
+        record.scale = Transform::localScales[id];
+        record.position = Transform::localPositions[id];
+        record.rotation = Transform::localRotations[id];
+        record.prevScale = Transform::prevLocalScales[id];
+        record.prevPosition = Transform::prevLocalPositions[id];
+        record.prevRotation = Transform::prevLocalRotations[id];
+        record.linearMotion = transform.linearMotion;
+        record.angularMotion = transform.angularMotion;
+        record.scalarMotion = transform.scalarMotion;
+        record.localToParentTransform = transform.localToParentTransform;
+        record.prevLocalToParentTransform = transform.prevLocalToParentTransform;
+        transforms.push_back(record);
+        addSnapshotName(transformNames, transform.name);
+    }
+    writer.addSection(SCENE_SNAPSHOT_TRANSFORMS, transforms);
+    writer.addSection(SCENE_SNAPSHOT_TRANSFORM_NAMES, transformNames);
+
+    // compressed meshes are stored decoded, and must outlive the writer
+    struct DecodedMesh {
+        std::vector<std::array<float, 3>> positions;
+        std::vector<glm::vec4> normals, tangents, colors;
+        std::vector<glm::vec2> texCoords;
+    };
+    std::list<DecodedMesh> decodedMeshes;
+
+    std::vector<SnapshotMesh> meshes;
+    std::vector<char> meshNames;
+    for (auto &mesh : Mesh::meshes) {
+        if (!mesh.initialized) continue;
+        SnapshotMesh record;
+        memset((void*) &record, 0, sizeof(record));
+        record.id = mesh.id;
+        record.meshStruct = Mesh::meshStructs[mesh.id];
+        DecodedMesh decoded;
+        auto decodedPositions = mesh.decodeVertexData(decoded.positions, decoded.normals, decoded.tangents, decoded.colors, decoded.texCoords);
+        bool isDecoded = (decodedPositions != nullptr);
+        bool hasDecodedPositions = (decodedPositions == &decoded.positions);
+        if (isDecoded) decodedMeshes.push_back(std::move(decoded));
+        record.positions = writer.addRange((hasDecodedPositions) ? decodedMeshes.back().positions : mesh.positions);
+        record.normals = writer.addRange((isDecoded) ? decodedMeshes.back().normals : mesh.normals);
+        record.tangents = writer.addRange((isDecoded) ? decodedMeshes.back().tangents : mesh.tangents);
+        record.colors = writer.addRange((isDecoded) ? decodedMeshes.back().colors : mesh.colors);
+        record.texCoords = writer.addRange((isDecoded) ? decodedMeshes.back().texCoords : mesh.texCoords);
+        record.triangleIndices = writer.addRange(mesh.triangleIndices);
+        meshes.push_back(record);
+        addSnapshotName(meshNames, mesh.name);
+    }
+    writer.addSection(SCENE_SNAPSHOT_MESHES, meshes);
+    writer.addSection(SCENE_SNAPSHOT_MESH_NAMES, meshNames);
+
+    // mip offsets are stored as 64 bit values regardless of the size of size_t
+    std::list<std::vector<uint64_t>> offsets;
+    auto addOffsets = [&writer, &offsets] (const std::vector<size_t> &values) {
+        offsets.push_back(std::vector<uint64_t>(values.begin(), values.end()));
+        return writer.addRange(offsets.back());
+    };
+    std::vector<SnapshotTexture> textures;
+    std::vector<char> textureNames;
+    for (auto &texture : Texture::textures) {
+        if (!texture.initialized) continue;
+        SnapshotTexture record;
+        memset((void*) &record, 0, sizeof(record));
+        record.id = texture.id;
+        record.linear = texture.linear;
+        record.compression = texture.compression;
+        record.packedFormat = texture.packedFormat;
+        record.textureStruct = Texture::textureStructs[texture.id];
+        record.floatTexels = writer.addRange(texture.floatTexels);
+        record.byteTexels = writer.addRange(texture.byteTexels);
+        record.floatMipTexels = writer.addRange(texture.floatMipTexels);
+        record.byteMipTexels = writer.addRange(texture.byteMipTexels);
+        record.mipOffsets = addOffsets(texture.mipOffsets);
+        record.compressedBlocks = writer.addRange(texture.compressedBlocks);
+        record.compressedLevelOffsets = addOffsets(texture.compressedLevelOffsets);
+        record.packedTexels = writer.addRange(texture.packedTexels);
+        textures.push_back(record);
+        addSnapshotName(textureNames, texture.name);
+    }
+    writer.addSection(SCENE_SNAPSHOT_TEXTURES, textures);
+    writer.addSection(SCENE_SNAPSHOT_TEXTURE_NAMES, textureNames);
+
+    std::vector<SnapshotMaterial> materials;
+    std::vector<char> materialNames;
+    for (auto &material : Material::materials) {
+        if (!material.initialized) continue;
+        SnapshotMaterial record;
+        memset((void*) &record, 0, sizeof(record));
+        record.id = material.id;
+        record.materialStruct = Material::materialStructs[material.id];
+        materials.push_back(record);
+        addSnapshotName(materialNames, material.name);
+    }
+    writer.addSection(SCENE_SNAPSHOT_MATERIALS, materials);
+    writer.addSection(SCENE_SNAPSHOT_MATERIAL_NAMES, materialNames);
+
+    std::vector<SnapshotLight> lights;
+    std::vector<char> lightNames;
+    for (auto &light : Light::lights) {
+        if (!light.initialized) continue;
+        SnapshotLight record;
+        memset((void*) &record, 0, sizeof(record));
+        record.id = light.id;
+        record.lightStruct = Light::lightStructs[light.id];
+        lights.push_back(record);
+        addSnapshotName(lightNames, light.name);
+    }
+    writer.addSection(SCENE_SNAPSHOT_LIGHTS, lights);
+    writer.addSection(SCENE_SNAPSHOT_LIGHT_NAMES, lightNames);
+
+    std::vector<SnapshotCamera> cameras;
+    std::vector<char> cameraNames;
+    for (auto &camera : Camera::cameras) {
+        if (!camera.initialized) continue;
+        SnapshotCamera record;
+        memset((void*) &record, 0, sizeof(record));
+        record.id = camera.id;
+        record.cameraStruct = Camera::cameraStructs[camera.id];
+        cameras.push_back(record);
+        addSnapshotName(cameraNames, camera.name);
+    }
+    writer.addSection(SCENE_SNAPSHOT_CAMERAS, cameras);
+    writer.addSection(SCENE_SNAPSHOT_CAMERA_NAMES, cameraNames);
+
+    std::vector<SnapshotVolume> volumes;
+    std::vector<char> volumeNames;
+    for (auto &volume : Volume::volumes) {
+        if (!volume.initialized) continue;
+        SnapshotVolume record;
+        memset((void*) &record, 0, sizeof(record));
+        record.id = volume.id;
+        record.volumeStruct = Volume::volumeStructs[volume.id];
+        if (volume.gridHdlPtr) record.grid = writer.addRange(volume.gridHdlPtr->data(), size_t(volume.gridHdlPtr->size()));
+        volumes.push_back(record);
+        addSnapshotName(volumeNames, volume.name);
+    }
+    writer.addSection(SCENE_SNAPSHOT_VOLUMES, volumes);
+    writer.addSection(SCENE_SNAPSHOT_VOLUME_NAMES, volumeNames);
+
+    writer.write(path);
+}
+
+Scene SceneSnapshot::load(const std::string &path)
+{
+    SceneSnapshotReader reader(path);
+
+    // Read and validate everything before creating any components
+    auto entityRecords = readSection<SnapshotEntity>(reader, SCENE_SNAPSHOT_ENTITIES, SCENE_SNAPSHOT_ENTITY_NAMES, "Entity", Entity::lookupTable, Entity::entities.size());
+    auto transformRecords = readSection<SnapshotTransform>(reader, SCENE_SNAPSHOT_TRANSFORMS, SCENE_SNAPSHOT_TRANSFORM_NAMES, "Transform", Transform::lookupTable, Transform::transforms.size());
+    auto meshRecords = readSection<SnapshotMesh>(reader, SCENE_SNAPSHOT_MESHES, SCENE_SNAPSHOT_MESH_NAMES, "Mesh", Mesh::lookupTable, Mesh::meshes.size());
+    auto textureRecords = readSection<SnapshotTexture>(reader, SCENE_SNAPSHOT_TEXTURES, SCENE_SNAPSHOT_TEXTURE_NAMES, "Texture", Texture::lookupTable, Texture::textures.size());
+    auto materialRecords = readSection<SnapshotMaterial>(reader, SCENE_SNAPSHOT_MATERIALS, SCENE_SNAPSHOT_MATERIAL_NAMES, "Material", Material::lookupTable, Material::materials.size());
+    auto lightRecords = readSection<SnapshotLight>(reader, SCENE_SNAPSHOT_LIGHTS, SCENE_SNAPSHOT_LIGHT_NAMES, "Light", Light::lookupTable, Light::lights.size());
+    auto cameraRecords = readSection<SnapshotCamera>(reader, SCENE_SNAPSHOT_CAMERAS, SCENE_SNAPSHOT_CAMERA_NAMES, "Camera", Camera::lookupTable, Camera::cameras.size());
+    auto volumeRecords = readSection<SnapshotVolume>(reader, SCENE_SNAPSHOT_VOLUMES, SCENE_SNAPSHOT_VOLUME_NAMES, "Volume", Volume::lookupTable, Volume::volumes.size());
+    for (size_t i = 0; i < meshRecords.size(); ++i) {
+        auto &r = meshRecords.records[i];
+        reader.get<std::array<float, 3>>(r.positions);
+        reader.get<glm::vec4>(r.normals);
+        reader.get<glm::vec4>(r.tangents);
+        reader.get<glm::vec4>(r.colors);
+        reader.get<glm::vec2>(r.texCoords);
+        reader.get<uint32_t>(r.triangleIndices);
+    }
+    for (size_t i = 0; i < textureRecords.size(); ++i) {
+        auto &r = textureRecords.records[i];
+        reader.get<glm::vec4>(r.floatTexels);
+        reader.get<glm::u8vec4>(r.byteTexels);
+        reader.get<glm::vec4>(r.floatMipTexels);
+        reader.get<glm::u8vec4>(r.byteMipTexels);
+        reader.get<uint64_t>(r.mipOffsets);
+        reader.get<uint8_t>(r.compressedBlocks);
+        reader.get<uint64_t>(r.compressedLevelOffsets);
+        reader.get<uint8_t>(r.packedTexels);
+    }
+    for (size_t i = 0; i < volumeRecords.size(); ++i) reader.get<uint8_t>(volumeRecords.records[i].grid);
+
+    Scene scene;
+    SnapshotIdMap<Texture> textureIds;
+    SnapshotIdMap<Material> materialIds;
+    SnapshotIdMap<Light> lightIds;
+    SnapshotIdMap<Camera> cameraIds;
+    SnapshotIdMap<Mesh> meshIds;
+    SnapshotIdMap<Volume> volumeIds;
+    SnapshotIdMap<Transform> transformIds;
+
+    // If anything below fails, the components created so far are removed, so that a failed load
+    // doesn't leave a partial scene behind
+    try {
+        // Textures and meshes hold most of the data. Their components are created under a single lock,
+        // then their arrays are copied out of the mapped file in parallel.
+        {
+            std::lock_guard<std::recursive_mutex> lock(*Texture::editMutex);
+            auto &records = textureRecords.records;
+            scene.textures = StaticFactory::createMany<Texture>(Texture::editMutex, textureRecords.names, "Texture",
+                Texture::lookupTable, Texture::textures.data(), Texture::textures.size(),
+                [&] (Texture* texture, size_t i) {
+                    Texture::textureStructs[texture->getId()] = records[i].textureStruct;
+                    texture->linear = records[i].linear != 0;
+                    texture->compression = records[i].compression;
+                    texture->packedFormat = records[i].packedFormat;
+                    textureIds[records[i].id] = texture;
+                });
+            Parallel::forEachDynamic(scene.textures.size(), 0, [&] (size_t i) {
+                auto texture = scene.textures[i];
+                std::vector<uint64_t> mipOffsets, compressedLevelOffsets;
+                reader.copy(records[i].floatTexels, texture->floatTexels);
+                reader.copy(records[i].byteTexels, texture->byteTexels);
+                reader.copy(records[i].floatMipTexels, texture->floatMipTexels);
+                reader.copy(records[i].byteMipTexels, texture->byteMipTexels);
+                reader.copy(records[i].compressedBlocks, texture->compressedBlocks);
+                reader.copy(records[i].packedTexels, texture->packedTexels);
+                reader.copy(records[i].mipOffsets, mipOffsets);
+                reader.copy(records[i].compressedLevelOffsets, compressedLevelOffsets);
+                texture->mipOffsets.assign(mipOffsets.begin(), mipOffsets.end());
+                texture->compressedLevelOffsets.assign(compressedLevelOffsets.begin(), compressedLevelOffsets.end());
+            });
+            for (auto texture : scene.textures) texture->markDirty();
+        }
+
+        {
+            std::lock_guard<std::recursive_mutex> lock(*Mesh::editMutex);
+            auto &records = meshRecords.records;
+            scene.meshes = StaticFactory::createMany<Mesh>(Mesh::editMutex, meshRecords.names, "Mesh",
+                Mesh::lookupTable, Mesh::meshes.data(), Mesh::meshes.size(),
+                [&] (Mesh* mesh, size_t i) {
+                    Mesh::meshStructs[mesh->getId()] = records[i].meshStruct;
+                    meshIds[records[i].id] = mesh;
+                });
+            Parallel::forEachDynamic(scene.meshes.size(), 0, [&] (size_t i) {
+                auto mesh = scene.meshes[i];
+                reader.copy(records[i].positions, mesh->positions);
+                reader.copy(records[i].normals, mesh->normals);
+                reader.copy(records[i].tangents, mesh->tangents);
+                reader.copy(records[i].colors, mesh->colors);
+                reader.copy(records[i].texCoords, mesh->texCoords);
+                reader.copy(records[i].triangleIndices, mesh->triangleIndices);
+            });
+            for (auto mesh : scene.meshes) mesh->markDirty();
+        }
+
+        // Materials and lights reference textures
+        scene.materials = StaticFactory::createMany<Material>(Material::editMutex, materialRecords.names, "Material",
+            Material::lookupTable, Material::materials.data(), Material::materials.size(),
+            [&] (Material* material, size_t i) {
+                auto &materialStruct = Material::materialStructs[material->getId()];
+                materialStruct = materialRecords.records[i].materialStruct;
+                for (auto textureIdMember : materialTextureIds) {
+                    int32_t &textureId = materialStruct.*textureIdMember;
+                    Texture* texture = findSnapshotComponent(textureIds, textureId);
+                    textureId = (texture) ? texture->getId() : -1;
+                    if (texture) texture->materials.insert(material->getId());
+                }
+                material->markDirty();
+                materialIds[materialRecords.records[i].id] = material;
+            });
+
+        scene.lights = StaticFactory::createMany<Light>(Light::editMutex, lightRecords.names, "Light",
+            Light::lookupTable, Light::lights.data(), Light::lights.size(),
+            [&] (Light* light, size_t i) {
+                auto &lightStruct = Light::lightStructs[light->getId()];
+                lightStruct = lightRecords.records[i].lightStruct;
+                Texture* texture = findSnapshotComponent(textureIds, lightStruct.color_texture_id);
+                lightStruct.color_texture_id = (texture) ? texture->getId() : -1;
+                if (texture) texture->lights.insert(light->getId());
+                light->markDirty();
+                lightIds[lightRecords.records[i].id] = light;
+            });
+
+        scene.cameras = StaticFactory::createMany<Camera>(Camera::editMutex, cameraRecords.names, "Camera",
+            Camera::lookupTable, Camera::cameras.data(), Camera::cameras.size(),
+            [&] (Camera* camera, size_t i) {
+                Camera::cameraStructs[camera->getId()] = cameraRecords.records[i].cameraStruct;
+                camera->markDirty();
+                cameraIds[cameraRecords.records[i].id] = camera;
+            });
+
+        scene.volumes = StaticFactory::createMany<Volume>(Volume::editMutex, volumeRecords.names, "Volume",
+            Volume::lookupTable, Volume::volumes.data(), Volume::volumes.size(),
+            [&] (Volume* volume, size_t i) {
+                auto &record = volumeRecords.records[i];
+                Volume::volumeStructs[volume->getId()] = record.volumeStruct;
+                if (record.grid.count > 0) {
+                    nanovdb::HostBuffer buffer = nanovdb::HostBuffer::create(record.grid.count);
+                    memcpy(buffer.data(), reader.get<uint8_t>(record.grid), size_t(record.grid.count));
+                    volume->gridHdlPtr = std::make_shared<nanovdb::GridHandle<>>(std::move(buffer));
+                }
+                volume->markDirty();
+                volumeIds[record.id] = volume;
+            });
+
+        // Transforms are created first, then linked to their parents once every transform exists
+        scene.transforms = StaticFactory::createMany<Transform>(Transform::editMutex, transformRecords.names, "Transform",
+            Transform::lookupTable, Transform::transforms.data(), Transform::transforms.size(),
+            [&] (Transform* transform, size_t i) {
+                auto &record = transformRecords.records[i];
+                int32_t id = transform->getId();
+                Transform::localScales[id] = record.scale;
+                Transform::localPositions[id] = record.position;
+                Transform::localRotations[id] = record.rotation;
+                transform->useRelativeLinearMotionBlur = record.useRelativeLinearMotionBlur != 0;
+                transform->useRelativeAngularMotionBlur = record.useRelativeAngularMotionBlur != 0;
+                transform->useRelativeScalarMotionBlur = record.useRelativeScalarMotionBlur != 0;
+                Transform::prevLocalScales[id] = record.prevScale;
+                Transform::prevLocalPositions[id] = record.prevPosition;
+                Transform::prevLocalRotations[id] = record.prevRotation;
+                transform->linearMotion = record.linearMotion;
+                transform->angularMotion = record.angularMotion;
+                transform->scalarMotion = record.scalarMotion;
+                transform->localToParentTransform = record.localToParentTransform;
+                transform->prevLocalToParentTransform = record.prevLocalToParentTransform;
+                transform->updateMatrix();
+                transformIds[record.id] = transform;
+            });
+        for (size_t i = 0; i < scene.transforms.size(); ++i) {
+            Transform* parent = findSnapshotComponent(transformIds, transformRecords.records[i].parent);
+            if (parent) scene.transforms[i]->setParent(parent);
+        }
+
+        scene.entities = StaticFactory::createMany<Entity>(Entity::editMutex, entityRecords.names, "Entity",
+            Entity::lookupTable, Entity::entities.data(), Entity::entities.size(),
+            [&] (Entity* entity, size_t i) {
+                auto &record = entityRecords.records[i];
+                auto &links = record.entityStruct;
+                if (auto transform = findSnapshotComponent(transformIds, links.transform_id)) entity->setTransform(transform);
+                if (auto material = findSnapshotComponent(materialIds, links.material_id)) entity->setMaterial(material);
+                if (auto camera = findSnapshotComponent(cameraIds, links.camera_id)) entity->setCamera(camera);
+                if (auto mesh = findSnapshotComponent(meshIds, links.mesh_id)) entity->setMesh(mesh);
+                if (auto light = findSnapshotComponent(lightIds, links.light_id)) entity->setLight(light);
+                if (auto volume = findSnapshotComponent(volumeIds, links.volume_id)) entity->setVolume(volume);
+                Entity::entityStructs[entity->getId()].flags = links.flags;
+                entity->active = record.active != 0;
+                entity->markDirty();
+            });
+    } catch (...) {
+        removeScene(scene);
+        throw;
+    }
+
+    return scene;
+}
+
+void saveSceneSnapshot(std::string path)
+{
+    SceneSnapshot::save(path);
+}
+
+Scene loadSceneSnapshot(std::string path)
+{
+    return SceneSnapshot::load(path);
+}
+
+};
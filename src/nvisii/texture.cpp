@@ -4,25 +4,262 @@
 
 #include <stb_image.h>
 #include <stb_image_write.h>
+#include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
+#include <cmath>
 
 #include <gli/gli.hpp>
 #include <gli/convert.hpp>
 #include <gli/core/s3tc.hpp>
 
 #include <glm/gtc/color_space.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <nvisii/utilities/parallel.h>
+#include <nvisii/utilities/texture_cache.h>
+
+#include <atomic>
+#include <chrono>
 
 namespace nvisii {
 
 std::vector<Texture> Texture::textures;
 std::vector<TextureStruct> Texture::textureStructs;
-std::map<std::string, uint32_t> Texture::lookupTable;
+LookupTable Texture::lookupTable;
 std::shared_ptr<std::recursive_mutex> Texture::editMutex;
 bool Texture::factoryInitialized = false;
 std::set<Texture*> Texture::dirtyTextures;
 
+static struct TextureFileCache {
+    std::mutex mutex;
+    std::string directory;
+    bool enabled = false;
+    std::atomic<uint32_t> hits{0};
+    std::atomic<uint32_t> misses{0};
+    std::atomic<uint32_t> writes{0};
+} TextureFileCache;
+
+/* Texels and properties decoded from an image file, before being assigned to a texture */
+struct DecodedImage {
+    std::vector<vec4> floatTexels;
+    std::vector<u8vec4> byteTexels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool linear = false;
+    bool rightHanded = true;
+    std::vector<vec4> floatMipTexels;
+    std::vector<u8vec4> byteMipTexels;
+    std::vector<size_t> mipOffsets;
+    std::vector<uint8_t> compressedBlocks;
+    std::vector<size_t> compressedLevelOffsets;
+    uint32_t compression = 0;
+    std::vector<uint8_t> packedTexels;
+    uint32_t packedFormat = 0;
+};
+
+static struct TextureMipmapGeneration {
+    std::mutex mutex;
+    bool enabled = false;
+    std::string filter = "box";
+} TextureMipmapGeneration;
+
+static void buildMipChain(const vec4* floatTexels, const u8vec4* byteTexels, uint32_t width, uint32_t height, bool srgb, 
+    const std::string &filter, std::vector<vec4> &floatMipTexels, std::vector<u8vec4> &byteMipTexels, std::vector<size_t> &mipOffsets);
+
+/* How the texels of a texture are block compressed */
+enum TextureCompression : uint32_t {
+    TEXTURE_COMPRESSION_NONE = 0,
+    TEXTURE_COMPRESSION_BC1,
+    TEXTURE_COMPRESSION_BC3,
+    TEXTURE_COMPRESSION_BC4,
+    TEXTURE_COMPRESSION_BC5,
+};
+
+static const size_t DECOMPRESS_BLOCK_ROWS_PER_CHUNK = 16;
+
+/* Returns the number of bytes in one 4x4 block of the given compression format */
+static size_t getCompressedBlockSize(uint32_t compression)
+{
+    return ((compression == TEXTURE_COMPRESSION_BC1) || (compression == TEXTURE_COMPRESSION_BC4)) ? 8 : 16;
+}
+
+/* Decompresses one 4x4 block into normalized texels, top row first */
+static gli::detail::texel_block4x4 decompressBlock(uint32_t compression, const uint8_t* block)
+{
+    switch (compression) {
+        case TEXTURE_COMPRESSION_BC1: return gli::detail::decompress_dxt1_block(*(const gli::detail::dxt1_block*) block);
+        case TEXTURE_COMPRESSION_BC3: return gli::detail::decompress_dxt5_block(*(const gli::detail::dxt5_block*) block);
+        case TEXTURE_COMPRESSION_BC4: return gli::detail::decompress_bc4unorm_block(*(const gli::detail::bc4_block*) block);
+        case TEXTURE_COMPRESSION_BC5: return gli::detail::decompress_bc5unorm_block(*(const gli::detail::bc5_block*) block);
+        default: throw std::runtime_error("Internal Error, unknown texture compression format");
+    }
+}
+
+/* Decompresses a single texel of the first mip level. y counts from the bottom row, like uncompressed texels. */
+static u8vec4 fetchCompressedTexel(const uint8_t* blocks, uint32_t compression, uint32_t width, uint32_t height, uint32_t x, uint32_t y)
+{
+    uint32_t blocksX = (width + 3) / 4;
+    uint32_t row = height - 1 - y;
+    auto block = decompressBlock(compression, blocks + (size_t(row / 4) * blocksX + x / 4) * getCompressedBlockSize(compression));
+    return u8vec4(block.Texel[row % 4][x % 4] * 255.f);
+}
+
+/* 
+ * Formats for textures that keep fewer than four channels, or half floats, instead of 
+ * being expanded to RGBA8 or RGBA32F. One and two channel formats hold grayscale and 
+ * grayscale plus alpha, so they expand to (r, r, r, 1) and (r, r, r, g).
+ */
+enum TexturePackedFormat : uint32_t {
+    TEXTURE_PACKED_NONE = 0,
+    TEXTURE_PACKED_R8,
+    TEXTURE_PACKED_RG8,
+    TEXTURE_PACKED_R16F,
+    TEXTURE_PACKED_RGBA16F,
+    TEXTURE_PACKED_R32F,
+};
+
+static const size_t UNPACK_TEXELS_PER_CHUNK = 1 << 14;
+
+/* The largest finite value a half float can hold */
+static const float HALF_MAX = 65504.f;
+
+/* Returns the number of bytes in one texel of the given packed format */
+static size_t getPackedTexelSize(uint32_t format)
+{
+    switch (format) {
+        case TEXTURE_PACKED_R8: return 1;
+        case TEXTURE_PACKED_RG8: return 2;
+        case TEXTURE_PACKED_R16F: return 2;
+        case TEXTURE_PACKED_RGBA16F: return 8;
+        case TEXTURE_PACKED_R32F: return 4;
+        default: throw std::runtime_error("Internal Error, unknown packed texture format");
+    }
+}
+
+/* Returns the number of channels stored per texel of the given packed format */
+static uint32_t getPackedChannelCount(uint32_t format)
+{
+    if (format == TEXTURE_PACKED_RG8) return 2;
+    if (format == TEXTURE_PACKED_RGBA16F) return 4;
+    return 1;
+}
+
+static bool isPackedFloat(uint32_t format)
+{
+    return (format == TEXTURE_PACKED_R16F) || (format == TEXTURE_PACKED_RGBA16F) || (format == TEXTURE_PACKED_R32F);
+}
+
+/* Reads channel c of the given packed texel. 8-bit channels are normalized to [0, 1]. */
+static float unpackChannel(uint32_t format, const uint8_t* texel, uint32_t c)
+{
+    switch (format) {
+        case TEXTURE_PACKED_R8: 
+        case TEXTURE_PACKED_RG8: return texel[c] / 255.f;
+        case TEXTURE_PACKED_R16F: 
+        case TEXTURE_PACKED_RGBA16F: {
+            uint16_t half;
+            memcpy(&half, texel + c * sizeof(uint16_t), sizeof(uint16_t));
+            return glm::unpackHalf1x16(half);
+        }
+        case TEXTURE_PACKED_R32F: {
+            float value;
+            memcpy(&value, texel, sizeof(float));
+            return value;
+        }
+        default: throw std::runtime_error("Internal Error, unknown packed texture format");
+    }
+}
+
+/* Expands a single packed texel to RGBA */
+static vec4 unpackTexel(uint32_t format, const uint8_t* texel)
+{
+    if (format == TEXTURE_PACKED_RGBA16F) {
+        return vec4(unpackChannel(format, texel, 0), unpackChannel(format, texel, 1), 
+            unpackChannel(format, texel, 2), unpackChannel(format, texel, 3));
+    }
+    float gray = unpackChannel(format, texel, 0);
+    float alpha = (format == TEXTURE_PACKED_RG8) ? unpackChannel(format, texel, 1) : 1.f;
+    return vec4(gray, gray, gray, alpha);
+}
+
+/* Expands a single packed texel to 8-bit RGBA. 8-bit formats are copied without rounding. */
+static u8vec4 unpackByteTexel(uint32_t format, const uint8_t* texel)
+{
+    if (format == TEXTURE_PACKED_R8) return u8vec4(texel[0], texel[0], texel[0], 255);
+    if (format == TEXTURE_PACKED_RG8) return u8vec4(texel[0], texel[0], texel[0], texel[1]);
+    return u8vec4(glm::clamp(unpackTexel(format, texel), vec4(0.f), vec4(1.f)) * 255.f);
+}
+
+/* 
+ * Expands packed texels to RGBA, into floatTexels for float formats and byteTexels otherwise, 
+ * matching how unpacked textures are stored.
+ */
+static void unpackTexels(uint32_t format, const std::vector<uint8_t> &packed, 
+    std::vector<vec4> &floatTexels, std::vector<u8vec4> &byteTexels)
+{
+    size_t texelSize = getPackedTexelSize(format);
+    size_t count = packed.size() / texelSize;
+    bool isFloat = isPackedFloat(format);
+    if (isFloat) floatTexels.resize(count);
+    else byteTexels.resize(count);
+    Parallel::forRange(0, count, UNPACK_TEXELS_PER_CHUNK, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (isFloat) floatTexels[i] = unpackTexel(format, &packed[i * texelSize]);
+            else byteTexels[i] = unpackByteTexel(format, &packed[i * texelSize]);
+        }
+    });
+}
+
+/* 
+ * Points floats or bytes at RGBA texels for the first level of a texture, unpacking packed 
+ * texels into the given temporaries. Exactly one of floats and bytes is set.
+ */
+static void getRGBATexels(uint32_t packedFormat, const std::vector<uint8_t> &packedTexels, 
+    const std::vector<vec4> &floatTexels, const std::vector<u8vec4> &byteTexels, 
+    std::vector<vec4> &unpackedFloats, std::vector<u8vec4> &unpackedBytes, 
+    const vec4* &floats, const u8vec4* &bytes)
+{
+    if (packedFormat != TEXTURE_PACKED_NONE) {
+        unpackTexels(packedFormat, packedTexels, unpackedFloats, unpackedBytes);
+        floats = isPackedFloat(packedFormat) ? unpackedFloats.data() : nullptr;
+        bytes = isPackedFloat(packedFormat) ? nullptr : unpackedBytes.data();
+        return;
+    }
+    floats = (floatTexels.size() > 0) ? floatTexels.data() : nullptr;
+    bytes = (floatTexels.size() > 0) ? nullptr : byteTexels.data();
+}
+
+/* 
+ * Packs float texels with the given number of channels (1 to 4) into half floats, or 
+ * returns false if any value is out of half float range, in which case nothing is written.
+ * Texels with more than one channel are packed as RGBA16F, expanding like stb_image does.
+ */
+static bool packHalfTexels(const float* texels, size_t count, int channels, std::vector<uint8_t> &packed, uint32_t &format)
+{
+    for (size_t i = 0; i < count * channels; ++i) {
+        if (!(std::fabs(texels[i]) <= HALF_MAX)) return false;
+    }
+    format = (channels == 1) ? TEXTURE_PACKED_R16F : TEXTURE_PACKED_RGBA16F;
+    size_t outChannels = getPackedChannelCount(format);
+    packed.resize(count * outChannels * sizeof(uint16_t));
+    uint16_t* out = (uint16_t*) packed.data();
+    Parallel::forRange(0, count, UNPACK_TEXELS_PER_CHUNK, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const float* in = &texels[i * channels];
+            vec4 rgba;
+            if (channels == 1) rgba = vec4(in[0]);
+            else if (channels == 2) rgba = vec4(in[0], in[0], in[0], in[1]);
+            else if (channels == 3) rgba = vec4(in[0], in[1], in[2], 1.f);
+            else rgba = vec4(in[0], in[1], in[2], in[3]);
+            for (size_t c = 0; c < outChannels; ++c) out[i * outChannels + c] = glm::packHalf1x16(rgba[int(c)]);
+        }
+    });
+    return true;
+}
+
 Texture::Texture()
 {
     this->initialized = false;
@@ -32,6 +269,10 @@ Texture::~Texture()
 {
     std::vector<glm::vec4>().swap(this->floatTexels);
     std::vector<glm::u8vec4>().swap(this->byteTexels);
+    std::vector<glm::vec4>().swap(this->floatMipTexels);
+    std::vector<glm::u8vec4>().swap(this->byteMipTexels);
+    std::vector<uint8_t>().swap(this->compressedBlocks);
+    std::vector<uint8_t>().swap(this->packedTexels);
 }
 
 Texture::Texture(std::string name, uint32_t id)
@@ -42,6 +283,7 @@ Texture::Texture(std::string name, uint32_t id)
 
     textureStructs[id].width = -1;
     textureStructs[id].height = -1;
+    textureStructs[id].channels = 4;
     this->floatTexels = std::vector<vec4>();
     this->byteTexels = std::vector<u8vec4>();
 }
@@ -55,10 +297,49 @@ std::string Texture::toString() {
     return output;
 }
 
+std::vector<u8vec4> Texture::decompressLevel(uint32_t level) {
+    if (compression == TEXTURE_COMPRESSION_NONE || level >= compressedLevelOffsets.size()) return std::vector<u8vec4>();
+    uint32_t width = std::max(uint32_t(textureStructs[id].width) >> level, 1u);
+    uint32_t height = std::max(uint32_t(textureStructs[id].height) >> level, 1u);
+    uint32_t blocksX = (width + 3) / 4;
+    uint32_t blocksY = (height + 3) / 4;
+    size_t blockSize = getCompressedBlockSize(compression);
+    const uint8_t* blocks = compressedBlocks.data() + compressedLevelOffsets[level];
+
+    // Blocks are stored top row first, while texels are stored bottom row first
+    std::vector<u8vec4> texels(size_t(width) * height);
+    Parallel::forRange(0, blocksY, DECOMPRESS_BLOCK_ROWS_PER_CHUNK, [&] (size_t rowBegin, size_t rowEnd) {
+        for (size_t by = rowBegin; by < rowEnd; ++by) {
+            for (uint32_t bx = 0; bx < blocksX; ++bx) {
+                auto block = decompressBlock(compression, blocks + (by * blocksX + bx) * blockSize);
+                for (uint32_t ty = 0; ty < 4; ++ty) {
+                    uint32_t y = uint32_t(by) * 4 + ty;
+                    if (y >= height) break;
+                    u8vec4* row = &texels[size_t(height - 1 - y) * width];
+                    for (uint32_t tx = 0; tx < 4; ++tx) {
+                        uint32_t x = bx * 4 + tx;
+                        if (x >= width) break;
+                        row[x] = u8vec4(block.Texel[ty][tx] * 255.f);
+                    }
+                }
+            }
+        }
+    });
+    return texels;
+}
+
 std::vector<vec4> Texture::getFloatTexels() {
     // If natively represented as 32f, return that. 
     // otherwise, cast 8uc to 32f.
     if (floatTexels.size() > 0) return floatTexels;
+    std::vector<vec4> unpackedFloats;
+    std::vector<u8vec4> decompressed;
+    if (packedFormat != TEXTURE_PACKED_NONE) {
+        unpackTexels(packedFormat, packedTexels, unpackedFloats, decompressed);
+        if (isPackedFloat(packedFormat)) return unpackedFloats;
+    }
+    if (compression != TEXTURE_COMPRESSION_NONE) decompressed = decompressLevel(0);
+    const std::vector<u8vec4> &byteTexels = (compression != TEXTURE_COMPRESSION_NONE || packedFormat != TEXTURE_PACKED_NONE) ? decompressed : this->byteTexels;
     std::vector<vec4> floatTexels(byteTexels.size());
     for (uint32_t i = 0; i < byteTexels.size(); ++i) {
         floatTexels[i] = vec4(byteTexels[i]) / 255.0f;
@@ -68,8 +349,19 @@ std::vector<vec4> Texture::getFloatTexels() {
 
 std::vector<u8vec4> Texture::getByteTexels() {
     // If natively represented as 8uc, return that. 
+    // If block compressed, decompress the first mip level.
+    // If packed, expand to four channels.
     // otherwise, cast 32f to 8uc.
+    if (compression != TEXTURE_COMPRESSION_NONE) return decompressLevel(0);
     if (byteTexels.size() > 0) return byteTexels;
+    if (packedFormat != TEXTURE_PACKED_NONE) {
+        size_t texelSize = getPackedTexelSize(packedFormat);
+        std::vector<u8vec4> texels8(packedTexels.size() / texelSize);
+        Parallel::forRange(0, texels8.size(), UNPACK_TEXELS_PER_CHUNK, [&] (size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) texels8[i] = unpackByteTexel(packedFormat, &packedTexels[i * texelSize]);
+        });
+        return texels8;
+    }
     std::vector<u8vec4> texels8(floatTexels.size());
     for (uint32_t i = 0; i < floatTexels.size(); ++i) {
         texels8[i] = u8vec4(floatTexels[i] * 255.0f);
@@ -93,8 +385,74 @@ void Texture::setScale(glm::vec2 scale)
 
 bool Texture::isHDR()
 {
-    // if the texture is natively represented as a 32 bit-per-channel texture, it's HDR.
-    return (floatTexels.size() > 0);
+    // if the texture is natively represented as a 32 or 16 bit-per-channel float texture, it's HDR.
+    return (floatTexels.size() > 0) || isPackedFloat(packedFormat);
+}
+
+bool Texture::isCompressed() {
+    return compression != TEXTURE_COMPRESSION_NONE;
+}
+
+std::string Texture::getFormat() {
+    switch (compression) {
+        case TEXTURE_COMPRESSION_BC1: return "BC1";
+        case TEXTURE_COMPRESSION_BC3: return "BC3";
+        case TEXTURE_COMPRESSION_BC4: return "BC4";
+        case TEXTURE_COMPRESSION_BC5: return "BC5";
+        default: break;
+    }
+    switch (packedFormat) {
+        case TEXTURE_PACKED_R8: return "R8";
+        case TEXTURE_PACKED_RG8: return "RG8";
+        case TEXTURE_PACKED_R16F: return "R16F";
+        case TEXTURE_PACKED_RGBA16F: return "RGBA16F";
+        case TEXTURE_PACKED_R32F: return "R32F";
+        default: break;
+    }
+    return (floatTexels.size() > 0) ? "RGBA32F" : "RGBA8";
+}
+
+uint32_t Texture::getChannelCount() {
+    if (packedFormat != TEXTURE_PACKED_NONE) return getPackedChannelCount(packedFormat);
+    return 4;
+}
+
+std::vector<float> Texture::getTexels() {
+    if (packedFormat == TEXTURE_PACKED_NONE) {
+        std::vector<vec4> texels = getFloatTexels();
+        const float* values = (const float*) texels.data();
+        return std::vector<float>(values, values + texels.size() * 4);
+    }
+    size_t texelSize = getPackedTexelSize(packedFormat);
+    uint32_t channels = getPackedChannelCount(packedFormat);
+    size_t count = packedTexels.size() / texelSize;
+    std::vector<float> texels(count * channels);
+    Parallel::forRange(0, count, UNPACK_TEXELS_PER_CHUNK, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            for (uint32_t c = 0; c < channels; ++c) {
+                texels[i * channels + c] = unpackChannel(packedFormat, &packedTexels[i * texelSize], c);
+            }
+        }
+    });
+    return texels;
+}
+
+std::vector<uint8_t> Texture::getTexelBytes() {
+    const uint8_t* begin = packedTexels.data();
+    const uint8_t* end = begin + packedTexels.size();
+    if (compression != TEXTURE_COMPRESSION_NONE) {
+        begin = compressedBlocks.data();
+        end = begin + ((compressedLevelOffsets.size() > 1) ? compressedLevelOffsets[1] : compressedBlocks.size());
+    }
+    else if (floatTexels.size() > 0) {
+        begin = (const uint8_t*) floatTexels.data();
+        end = begin + floatTexels.size() * sizeof(vec4);
+    }
+    else if (byteTexels.size() > 0) {
+        begin = (const uint8_t*) byteTexels.data();
+        end = begin + byteTexels.size() * sizeof(u8vec4);
+    }
+    return std::vector<uint8_t>(begin, end);
 }
 
 bool Texture::isLinear() {
@@ -178,214 +536,343 @@ Texture* Texture::createFromImage(std::string name, std::string path, bool linea
     return createFromFile(name, path, linear);
 }
 
-Texture* Texture::createFromFile(std::string name, std::string path, bool linear) {
-    auto create = [path, linear] (Texture* l) {
-        // first, check the extension
-        std::string extension = std::string(strrchr(path.c_str(), '.'));
-        std::transform(extension.data(), extension.data() + extension.size(), 
-            std::addressof(extension[0]), [](unsigned char c){ return std::tolower(c); });
-        
-        if ((extension.compare(".dds") == 0) || (extension.compare(".ktx") == 0)) {
-            auto texture = gli::load(path);
-            if (texture.target() != gli::target::TARGET_2D) {
-                std::string reason = "Currently only 2D textures supported!";
-                throw std::runtime_error(std::string("Error: failed to load texture image \"") + 
-                    path + std::string("\". Reason: ") + reason); 
-            }
+void Texture::enableFileCache(std::string directory)
+{
+    std::lock_guard<std::mutex> lock(TextureFileCache.mutex);
+    TextureFileCache.directory = directory;
+    TextureFileCache.enabled = true;
+}
+
+void Texture::disableFileCache()
+{
+    std::lock_guard<std::mutex> lock(TextureFileCache.mutex);
+    TextureFileCache.enabled = false;
+}
+
+std::map<std::string, uint32_t> Texture::getFileCacheStatistics()
+{
+    return {
+        {"hits", TextureFileCache.hits.load()}, 
+        {"misses", TextureFileCache.misses.load()}, 
+        {"writes", TextureFileCache.writes.load()}
+    };
+}
 
-            auto tex2D = gli::texture2d(texture);
-            auto format = tex2D.format();
-            if (tex2D.empty())
-                throw std::runtime_error( std::string("Error: image " + path + " is empty"));
-
-            // gli detects whether or not a texture is srgb. Ignore "linear" parameter above.
-            l->linear = (!gli::is_srgb(format));
-
-            if (gli::is_compressed(format)) {
-                if ((format != gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8) &&
-                    (format != gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16) &&
-                    (format != gli::FORMAT_R_ATI1N_UNORM_BLOCK8) &&
-                    (format != gli::FORMAT_RG_ATI2N_UNORM_BLOCK16)
-                )
-                throw std::runtime_error(std::string("Error: image " + path + " is compressed using an unsupported S3TC format. " + 
-                        "Supported formats are " + 
-                        "FORMAT_RGBA32_SFLOAT_PACK32, " +
-                        "FORMAT_RGBA8_SRGB_PACK8, " +
-                        "FORMAT_R32_SFLOAT_PACK32, " +
-                        "FORMAT_R8_SRGB_PACK8, " +
-                        "FORMAT_RG32_SFLOAT_PACK32, " +
-                        "FORMAT_RG8_SRGB_PACK8" + 
-                        "FORMAT_RGBA_DXT1_UNORM_BLOCK8, " +
-                        "FORMAT_RGBA_DXT5_UNORM_BLOCK16, " +
-                        "FORMAT_R_ATI1N_UNORM_BLOCK8, " +
-                        "FORMAT_RG_ATI2N_UNORM_BLOCK16")); 
-
-                // decompress RGBA DXT1
-                gli::texture2d &TextureCompressed = tex2D;
-                gli::texture2d TextureLocalDecompressed(
-                    gli::FORMAT_RGBA32_SFLOAT_PACK32, 
-                    TextureCompressed.extent(), 
-                    TextureCompressed.levels(), 
-                    TextureCompressed.swizzles());
-                gli::extent2d BlockExtent;
-                {
-                    gli::extent3d TempExtent = gli::block_extent(format);
-                    BlockExtent.x = TempExtent.x;
-                    BlockExtent.y = TempExtent.y;
+void Texture::resetFileCacheStatistics()
+{
+    TextureFileCache.hits = 0;
+    TextureFileCache.misses = 0;
+    TextureFileCache.writes = 0;
+}
+
+/* 
+ * Decodes an image file into texels, without touching the texture tables. Safe to call from multiple threads. 
+ * stb's flip flag is global in the version of stb in the tree, so callers must set it before decoding, and not 
+ * while other threads are decoding.
+ */
+static void decodeImageFile(const std::string &path, bool linear, DecodedImage &decoded)
+{
+    // If enabled, try the on disk cache before decoding. The only load option that 
+    // changes the decoded result is "linear".
+    std::string cachePath;
+    uint64_t sourceSize = 0;
+    int64_t sourceModifiedTime = 0;
+    uint32_t options = linear ? 1 : 0;
+    {
+        std::lock_guard<std::mutex> lock(TextureFileCache.mutex);
+        if (TextureFileCache.enabled && getTextureCacheFileStamp(path, sourceSize, sourceModifiedTime)) {
+            cachePath = getTextureCachePath(TextureFileCache.directory, path, sourceSize, sourceModifiedTime, options);
+        }
+    }
+    if (!cachePath.empty()) {
+        bool hit = readTextureCache(cachePath, path, sourceSize, sourceModifiedTime, options, 
+            [&decoded] (const TextureCacheHeader &header) -> void* {
+                bool isFloat = (header.flags & TEXTURE_CACHE_FLAG_FLOAT) != 0;
+                uint32_t packedFormat = header.flags >> TEXTURE_CACHE_PACKED_FORMAT_SHIFT;
+                if (packedFormat > TEXTURE_PACKED_R32F) return nullptr;
+                size_t texelSize = (packedFormat != TEXTURE_PACKED_NONE) ? getPackedTexelSize(packedFormat) : 
+                    (isFloat ? sizeof(vec4) : sizeof(u8vec4));
+                if (header.texelSize != texelSize) return nullptr;
+                decoded.linear = (header.flags & TEXTURE_CACHE_FLAG_LINEAR) != 0;
+                decoded.width = header.width;
+                decoded.height = header.height;
+                decoded.rightHanded = (header.flags & TEXTURE_CACHE_FLAG_RIGHT_HANDED) != 0;
+                if (packedFormat != TEXTURE_PACKED_NONE) {
+                    decoded.packedFormat = packedFormat;
+                    decoded.packedTexels.resize(size_t(header.width) * header.height * texelSize);
+                    return decoded.packedTexels.data();
                 }
+                if (isFloat) {
+                    decoded.floatTexels.resize(size_t(header.width) * header.height);
+                    return decoded.floatTexels.data();
+                }
+                decoded.byteTexels.resize(size_t(header.width) * header.height);
+                return decoded.byteTexels.data();
+            });
+        if (hit) {
+            TextureFileCache.hits++;
+            return;
+        }
+        // a partial read may have left texels behind
+        decoded = DecodedImage();
+        TextureFileCache.misses++;
+    }
+
+    // first, check the extension
+    std::string extension = std::string(strrchr(path.c_str(), '.'));
+    std::transform(extension.data(), extension.data() + extension.size(), 
+        std::addressof(extension[0]), [](unsigned char c){ return std::tolower(c); });
+    
+    if ((extension.compare(".dds") == 0) || (extension.compare(".ktx") == 0)) {
+        auto texture = gli::load(path);
+        if (texture.target() != gli::target::TARGET_2D) {
+            std::string reason = "Currently only 2D textures supported!";
+            throw std::runtime_error(std::string("Error: failed to load texture image \"") + 
+                path + std::string("\". Reason: ") + reason); 
+        }
+
+        auto tex2D = gli::texture2d(texture);
+        auto format = tex2D.format();
+        if (tex2D.empty())
+            throw std::runtime_error( std::string("Error: image " + path + " is empty"));
+
+        // gli detects whether or not a texture is srgb. Ignore "linear" parameter above.
+        decoded.linear = (!gli::is_srgb(format));
+
+        if (gli::is_compressed(format)) {
+            if ((format != gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8) &&
+                (format != gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16) &&
+                (format != gli::FORMAT_R_ATI1N_UNORM_BLOCK8) &&
+                (format != gli::FORMAT_RG_ATI2N_UNORM_BLOCK16)
+            )
+            throw std::runtime_error(std::string("Error: image " + path + " is compressed using an unsupported S3TC format. " + 
+                    "Supported formats are " + 
+                    "FORMAT_RGBA32_SFLOAT_PACK32, " +
+                    "FORMAT_RGBA8_SRGB_PACK8, " +
+                    "FORMAT_R32_SFLOAT_PACK32, " +
+                    "FORMAT_R8_SRGB_PACK8, " +
+                    "FORMAT_RG32_SFLOAT_PACK32, " +
+                    "FORMAT_RG8_SRGB_PACK8" + 
+                    "FORMAT_RGBA_DXT1_UNORM_BLOCK8, " +
+                    "FORMAT_RGBA_DXT5_UNORM_BLOCK16, " +
+                    "FORMAT_R_ATI1N_UNORM_BLOCK8, " +
+                    "FORMAT_RG_ATI2N_UNORM_BLOCK16")); 
+
+            // Keep the original blocks for all mip levels. Texels are only decompressed on demand.
+            if (format == gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8) decoded.compression = TEXTURE_COMPRESSION_BC1;
+            if (format == gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16) decoded.compression = TEXTURE_COMPRESSION_BC3;
+            if (format == gli::FORMAT_R_ATI1N_UNORM_BLOCK8) decoded.compression = TEXTURE_COMPRESSION_BC4;
+            if (format == gli::FORMAT_RG_ATI2N_UNORM_BLOCK16) decoded.compression = TEXTURE_COMPRESSION_BC5;
+            if ((decoded.compression == TEXTURE_COMPRESSION_BC1) || (decoded.compression == TEXTURE_COMPRESSION_BC3)) {
+                decoded.linear = false; // hack for buggy importer...
+            }
+
+            const uint8_t* base = (const uint8_t*) tex2D.data();
+            decoded.compressedBlocks.assign(base, base + tex2D.size());
+            for (size_t level = 0; level < tex2D.levels(); ++level) {
+                decoded.compressedLevelOffsets.push_back(size_t((const uint8_t*) tex2D.data(0, 0, level) - base));
+            }
+            decoded.width = (uint32_t)(tex2D.extent(0).x);
+            decoded.height = (uint32_t)(tex2D.extent(0).y);
+            
+            // for directX normal maps
+            if (extension.compare(".dds") == 0) decoded.rightHanded = false;
+        }
+        else {
+            tex2D = gli::flip(tex2D);
+            decoded.width = (uint32_t)(tex2D.extent().x);
+            decoded.height = (uint32_t)(tex2D.extent().y);
+
+            // Single channel images without mip levels keep one channel. 
+            // Other one and two channel formats are expanded to four channels.
+            if ((tex2D.levels() == 1) && (format == gli::FORMAT_R8_SRGB_PACK8)) {
+                decoded.packedFormat = TEXTURE_PACKED_R8;
+            }
+            else if ((tex2D.levels() == 1) && (format == gli::FORMAT_R32_SFLOAT_PACK32)) {
+                decoded.packedFormat = TEXTURE_PACKED_R32F;
+            }
+            else if ((format == gli::FORMAT_R32_SFLOAT_PACK32) || (format == gli::FORMAT_RG32_SFLOAT_PACK32)) {
+                tex2D = gli::convert(tex2D, gli::format::FORMAT_RGBA32_SFLOAT_PACK32);
+            }
+            else if ((format == gli::FORMAT_R8_SRGB_PACK8) || (format == gli::FORMAT_RG8_SRGB_PACK8)) {
+                tex2D = gli::convert(tex2D, gli::format::FORMAT_RGBA8_SRGB_PACK8);
+            }
+            else if ((format != gli::FORMAT_RGBA32_SFLOAT_PACK32) && (format != gli::FORMAT_RGBA8_SRGB_PACK8)) {
+                throw std::runtime_error(std::string("Error: image " + path + " uses an unsupported format. " + 
+                    "Supported formats are " + 
+                    "FORMAT_RGBA32_SFLOAT_PACK32, " +
+                    "FORMAT_RGBA8_SRGB_PACK8, " +
+                    "FORMAT_R32_SFLOAT_PACK32, " +
+                    "FORMAT_R8_SRGB_PACK8, " +
+                    "FORMAT_RG32_SFLOAT_PACK32, " +
+                    "FORMAT_RG8_SRGB_PACK8" + 
+                    "FORMAT_RGBA_DXT1_UNORM_BLOCK8, " +
+                    "FORMAT_RGBA_DXT5_UNORM_BLOCK16, " +
+                    "FORMAT_R_ATI1N_UNORM_BLOCK8, " +
+                    "FORMAT_RG_ATI2N_UNORM_BLOCK16"));
+            }
 
-                for(size_t Level = 0; Level < TextureCompressed.levels(); ++Level) {
-                    gli::extent2d TexelCoord, BlockCoord;
-                    gli::extent2d LevelExtent = TextureCompressed.extent(Level);
-                    gli::extent2d LevelExtentInBlocks = glm::max(gli::extent2d(1, 1), LevelExtent / BlockExtent);
-                    gli::extent2d DecompressedBlockCoord;
-                    for(BlockCoord.y = 0, TexelCoord.y = 0; BlockCoord.y < LevelExtentInBlocks.y; ++BlockCoord.y, TexelCoord.y += BlockExtent.y) {
-                        for(BlockCoord.x = 0, TexelCoord.x = 0; BlockCoord.x < LevelExtentInBlocks.x; ++BlockCoord.x, TexelCoord.x += BlockExtent.x) {
-                            if (format == gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8) {
-                                l->linear = false; // hack for buggy importer...
-                                const gli::detail::dxt1_block *DXT1Block = TextureCompressed.data<gli::detail::dxt1_block>(0, 0, Level) + (BlockCoord.y * LevelExtentInBlocks.x + BlockCoord.x);
-                                const gli::detail::texel_block4x4 DecompressedBlock = gli::detail::decompress_dxt1_block(*DXT1Block);
-                                for(DecompressedBlockCoord.y = 0; DecompressedBlockCoord.y < glm::min(4, LevelExtent.y); ++DecompressedBlockCoord.y) {
-                                    for(DecompressedBlockCoord.x = 0; DecompressedBlockCoord.x < glm::min(4, LevelExtent.x); ++DecompressedBlockCoord.x) {
-                                        TextureLocalDecompressed.store(TexelCoord + DecompressedBlockCoord, Level, DecompressedBlock.Texel[DecompressedBlockCoord.y][DecompressedBlockCoord.x]);
-                                    }
-                                }
-                            }
-                            else if (format == gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16) {
-                                l->linear = false; // hack for buggy importer...
-                                const gli::detail::dxt5_block *DXT5Block = TextureCompressed.data<gli::detail::dxt5_block>(0, 0, Level) + (BlockCoord.y * LevelExtentInBlocks.x + BlockCoord.x);
-                                const gli::detail::texel_block4x4 DecompressedBlock = gli::detail::decompress_dxt5_block(*DXT5Block);
-                                for(DecompressedBlockCoord.y = 0; DecompressedBlockCoord.y < glm::min(4, LevelExtent.y); ++DecompressedBlockCoord.y) {
-                                    for(DecompressedBlockCoord.x = 0; DecompressedBlockCoord.x < glm::min(4, LevelExtent.x); ++DecompressedBlockCoord.x) {
-                                        TextureLocalDecompressed.store(TexelCoord + DecompressedBlockCoord, Level, DecompressedBlock.Texel[DecompressedBlockCoord.y][DecompressedBlockCoord.x]);
-                                    }
-                                }
-                            }
-                            else if (format == gli::FORMAT_R_ATI1N_UNORM_BLOCK8) {
-                                const gli::detail::bc4_block *BC4Block = TextureCompressed.data<gli::detail::bc4_block>(0, 0, Level) + (BlockCoord.y * LevelExtentInBlocks.x + BlockCoord.x);
-						        const gli::detail::texel_block4x4 DecompressedBlock = gli::detail::decompress_bc4unorm_block(*BC4Block);
-                                for(DecompressedBlockCoord.y = 0; DecompressedBlockCoord.y < glm::min(4, LevelExtent.y); ++DecompressedBlockCoord.y) {
-                                    for(DecompressedBlockCoord.x = 0; DecompressedBlockCoord.x < glm::min(4, LevelExtent.x); ++DecompressedBlockCoord.x) {
-                                        TextureLocalDecompressed.store(TexelCoord + DecompressedBlockCoord, Level, DecompressedBlock.Texel[DecompressedBlockCoord.y][DecompressedBlockCoord.x]);
-                                    }
-                                }
-                            }
-                            else if (format == gli::FORMAT_RG_ATI2N_UNORM_BLOCK16) {
-                                const gli::detail::bc5_block *BC5Block = TextureCompressed.data<gli::detail::bc5_block>(0, 0, Level) + (BlockCoord.y * LevelExtentInBlocks.x + BlockCoord.x);
-                                const gli::detail::texel_block4x4 DecompressedBlock = gli::detail::decompress_bc5unorm_block(*BC5Block);
-                                for(DecompressedBlockCoord.y = 0; DecompressedBlockCoord.y < glm::min(4, LevelExtent.y); ++DecompressedBlockCoord.y) {
-                                    for(DecompressedBlockCoord.x = 0; DecompressedBlockCoord.x < glm::min(4, LevelExtent.x); ++DecompressedBlockCoord.x) {
-                                        TextureLocalDecompressed.store(TexelCoord + DecompressedBlockCoord, Level, DecompressedBlock.Texel[DecompressedBlockCoord.y][DecompressedBlockCoord.x]);
-                                    }
-                                }
-                            }
-                        }
+            // Keep every mip level stored in the file
+            bool isFloat = (tex2D.format() == gli::FORMAT_RGBA32_SFLOAT_PACK32);
+            if (decoded.packedFormat != TEXTURE_PACKED_NONE) {
+                const uint8_t* texels = (const uint8_t*) tex2D.data();
+                decoded.packedTexels.assign(texels, texels + tex2D.size());
+            }
+            else for (size_t level = 0; level < tex2D.levels(); ++level) {
+                auto image = tex2D[level];
+                if (isFloat) {
+                    const vec4* texels = (const vec4*) image.data();
+                    size_t count = image.size() / sizeof(vec4);
+                    if (level == 0) decoded.floatTexels.assign(texels, texels + count);
+                    else {
+                        decoded.mipOffsets.push_back(decoded.floatMipTexels.size());
+                        decoded.floatMipTexels.insert(decoded.floatMipTexels.end(), texels, texels + count);
                     }
-                }
-                
-                TextureLocalDecompressed = gli::flip(TextureLocalDecompressed);
-                
-                int lvl = 0;
-                textureStructs[l->getId()].width = (uint32_t)(TextureLocalDecompressed.extent(lvl).x);
-                textureStructs[l->getId()].height = (uint32_t)(TextureLocalDecompressed.extent(lvl).y);
-                
-                // for directX normal maps
-                if (extension.compare(".dds") == 0) textureStructs[l->getId()].rightHanded = false;
-
-                auto image = TextureLocalDecompressed[lvl]; // get mipmap 0
-                if (gli::is_float(format)) {
-                    l->floatTexels.resize(textureStructs[l->getId()].width * textureStructs[l->getId()].height);
-                    memcpy(l->floatTexels.data(), image.data(), (uint32_t)image.size());
                 } else {
-                    l->byteTexels.resize(textureStructs[l->getId()].width * textureStructs[l->getId()].height);
-                    std::vector<vec4> temp(textureStructs[l->getId()].width * textureStructs[l->getId()].height);
-                    memcpy(temp.data(), image.data(), (uint32_t)image.size());
-                    for (uint32_t i = 0; i < temp.size(); ++i) l->byteTexels[i] = u8vec4(temp[i] * 255.f);
-                }            
-            }
-            else {
-                tex2D = gli::flip(tex2D);
-                textureStructs[l->getId()].width = (uint32_t)(tex2D.extent().x);
-                textureStructs[l->getId()].height = (uint32_t)(tex2D.extent().y);
-                auto image = tex2D[0]; // get mipmap 0
-                if (format == gli::FORMAT_RGBA32_SFLOAT_PACK32) {
-                    l->floatTexels.resize(textureStructs[l->getId()].width * textureStructs[l->getId()].height);
-                    memcpy(l->floatTexels.data(), image.data(), (uint32_t)image.size());
-                }
-                else if (format == gli::FORMAT_RGBA8_SRGB_PACK8) {
-                    l->byteTexels.resize(textureStructs[l->getId()].width * textureStructs[l->getId()].height);
-                    memcpy(l->byteTexels.data(), image.data(), (uint32_t)image.size());
-                }
-                if (format == gli::FORMAT_R32_SFLOAT_PACK32) {
-                    tex2D = gli::convert(tex2D, gli::format::FORMAT_RGBA32_SFLOAT_PACK32);
-                    l->floatTexels.resize(textureStructs[l->getId()].width * textureStructs[l->getId()].height);
-                    memcpy(l->floatTexels.data(), image.data(), (uint32_t)image.size());
-                }
-                else if (format == gli::FORMAT_R8_SRGB_PACK8) {
-                    tex2D = gli::convert(tex2D, gli::format::FORMAT_RGBA8_SRGB_PACK8);
-                    l->byteTexels.resize(textureStructs[l->getId()].width * textureStructs[l->getId()].height);
-                    memcpy(l->byteTexels.data(), image.data(), (uint32_t)image.size());
-                }
-                if (format == gli::FORMAT_RG32_SFLOAT_PACK32) {
-                    tex2D = gli::convert(tex2D, gli::format::FORMAT_RGBA32_SFLOAT_PACK32);
-                    l->floatTexels.resize(textureStructs[l->getId()].width * textureStructs[l->getId()].height);
-                    memcpy(l->floatTexels.data(), image.data(), (uint32_t)image.size());
-                }
-                else if (format == gli::FORMAT_RG8_SRGB_PACK8) {
-                    tex2D = gli::convert(tex2D, gli::format::FORMAT_RGBA8_SRGB_PACK8);
-                    l->byteTexels.resize(textureStructs[l->getId()].width * textureStructs[l->getId()].height);
-                    memcpy(l->byteTexels.data(), image.data(), (uint32_t)image.size());
+                    const u8vec4* texels = (const u8vec4*) image.data();
+                    size_t count = image.size() / sizeof(u8vec4);
+                    if (level == 0) decoded.byteTexels.assign(texels, texels + count);
+                    else {
+                        decoded.mipOffsets.push_back(decoded.byteMipTexels.size());
+                        decoded.byteMipTexels.insert(decoded.byteMipTexels.end(), texels, texels + count);
+                    }
                 }
-                else {
-                    throw std::runtime_error(std::string("Error: image " + path + " uses an unsupported format. " + 
-                        "Supported formats are " + 
-                        "FORMAT_RGBA32_SFLOAT_PACK32, " +
-                        "FORMAT_RGBA8_SRGB_PACK8, " +
-                        "FORMAT_R32_SFLOAT_PACK32, " +
-                        "FORMAT_R8_SRGB_PACK8, " +
-                        "FORMAT_RG32_SFLOAT_PACK32, " +
-                        "FORMAT_RG8_SRGB_PACK8" + 
-                        "FORMAT_RGBA_DXT1_UNORM_BLOCK8, " +
-                        "FORMAT_RGBA_DXT5_UNORM_BLOCK16, " +
-                        "FORMAT_R_ATI1N_UNORM_BLOCK8, " +
-                        "FORMAT_RG_ATI2N_UNORM_BLOCK16"));
+            }
+        }
+    }
+    else {
+        if (extension.compare(".hdr") == 0) {
+            int x, y, num_channels;
+            decoded.linear = true; // Since we convert HDR images from srgb to linear, srgb is always false here.
+            float* pixels = stbi_loadf(path.c_str(), &x, &y, &num_channels, 0);
+            if (!pixels) { 
+                std::string reason (stbi_failure_reason());
+                throw std::runtime_error(std::string("Error: failed to load texture image \"") + path + std::string("\". Reason: ") + reason); 
+            }
+            // Store as half floats when every value fits, otherwise fall back to 32 bit floats
+            size_t count = size_t(x) * y;
+            if (!packHalfTexels(pixels, count, num_channels, decoded.packedTexels, decoded.packedFormat)) {
+                if (num_channels == 1) {
+                    decoded.packedFormat = TEXTURE_PACKED_R32F;
+                    decoded.packedTexels.resize(count * sizeof(float));
+                    memcpy(decoded.packedTexels.data(), pixels, count * sizeof(float));
+                } else {
+                    decoded.floatTexels.resize(count);
+                    for (size_t i = 0; i < count; ++i) {
+                        const float* in = &pixels[i * num_channels];
+                        if (num_channels == 2) decoded.floatTexels[i] = vec4(in[0], in[0], in[0], in[1]);
+                        else if (num_channels == 3) decoded.floatTexels[i] = vec4(in[0], in[1], in[2], 1.f);
+                        else decoded.floatTexels[i] = vec4(in[0], in[1], in[2], in[3]);
+                    }
                 }
             }
+            decoded.width = x;
+            decoded.height = y;
+            stbi_image_free(pixels);
         }
         else {
-            if (extension.compare(".hdr") == 0) {
-                int x, y, num_channels;
-                stbi_set_flip_vertically_on_load(true);
-                l->linear = true; // Since we convert HDR images from srgb to linear, srgb is always false here.
-                float* pixels = stbi_loadf(path.c_str(), &x, &y, &num_channels, STBI_rgb_alpha);
-                if (!pixels) { 
-                    std::string reason (stbi_failure_reason());
-                    throw std::runtime_error(std::string("Error: failed to load texture image \"") + path + std::string("\". Reason: ") + reason); 
+            decoded.linear = linear; // if linear is true, treat the texture contents as if it were not sRGB.
+            int x, y, num_channels;
+            stbi_uc* pixels = stbi_load(path.c_str(), &x, &y, &num_channels, 0);
+            if (!pixels) { 
+                std::string reason (stbi_failure_reason());
+                throw std::runtime_error(std::string("Error: failed to load texture image \"") + path + std::string("\". Reason: ") + reason); 
+            }
+            // Grayscale and grayscale plus alpha images keep their channel count, 
+            // RGB images gain an opaque alpha channel
+            size_t count = size_t(x) * y;
+            if (num_channels <= 2) {
+                decoded.packedFormat = (num_channels == 1) ? TEXTURE_PACKED_R8 : TEXTURE_PACKED_RG8;
+                decoded.packedTexels.assign(pixels, pixels + count * num_channels);
+            }
+            else if (num_channels == 3) {
+                decoded.byteTexels.resize(count);
+                for (size_t i = 0; i < count; ++i) {
+                    decoded.byteTexels[i] = u8vec4(pixels[i * 3 + 0], pixels[i * 3 + 1], pixels[i * 3 + 2], 255);
                 }
-                l->floatTexels.resize(x * y);
-                memcpy(l->floatTexels.data(), pixels, x * y * 4 * sizeof(float));
-                textureStructs[l->getId()].width = x;
-                textureStructs[l->getId()].height = y;
-                stbi_image_free(pixels);
             }
             else {
-                l->linear = linear; // if linear is true, treat the texture contents as if it were not sRGB.
-                int x, y, num_channels;
-                stbi_set_flip_vertically_on_load(true);
-                stbi_uc* pixels = stbi_load(path.c_str(), &x, &y, &num_channels, STBI_rgb_alpha);
-                if (!pixels) { 
-                    std::string reason (stbi_failure_reason());
-                    throw std::runtime_error(std::string("Error: failed to load texture image \"") + path + std::string("\". Reason: ") + reason); 
-                }
-                l->byteTexels.resize(x * y);
-                memcpy(l->byteTexels.data(), pixels, x * y * 4 * sizeof(stbi_uc));
-                textureStructs[l->getId()].width = x;
-                textureStructs[l->getId()].height = y;
-                stbi_image_free(pixels);
+                decoded.byteTexels.resize(count);
+                memcpy(decoded.byteTexels.data(), pixels, count * 4 * sizeof(stbi_uc));
             }
+            decoded.width = x;
+            decoded.height = y;
+            stbi_image_free(pixels);
         }
+    }
 
-        l->markDirty();
+    // Compressed images are stored as loaded, so there's no decoding work worth caching.
+    // The cache only holds the first level, so images with mip levels in the file aren't cached either.
+    if (!cachePath.empty() && decoded.compression == TEXTURE_COMPRESSION_NONE && decoded.mipOffsets.empty()) {
+        TextureCacheHeader header;
+        header.sourceSize = sourceSize;
+        header.sourceModifiedTime = sourceModifiedTime;
+        header.options = options;
+        header.width = decoded.width;
+        header.height = decoded.height;
+        bool isPacked = (decoded.packedFormat != TEXTURE_PACKED_NONE);
+        bool isFloat = isPacked ? isPackedFloat(decoded.packedFormat) : (decoded.floatTexels.size() > 0);
+        header.texelSize = isPacked ? uint32_t(getPackedTexelSize(decoded.packedFormat)) : (isFloat ? sizeof(vec4) : sizeof(u8vec4));
+        header.flags = (isFloat ? TEXTURE_CACHE_FLAG_FLOAT : 0) 
+            | (decoded.linear ? TEXTURE_CACHE_FLAG_LINEAR : 0) 
+            | (decoded.rightHanded ? TEXTURE_CACHE_FLAG_RIGHT_HANDED : 0)
+            | (decoded.packedFormat << TEXTURE_CACHE_PACKED_FORMAT_SHIFT);
+        const void* data = isPacked ? (const void*) decoded.packedTexels.data() : 
+            (isFloat ? (const void*) decoded.floatTexels.data() : (const void*) decoded.byteTexels.data());
+        if (writeTextureCache(cachePath, path, header, data)) TextureFileCache.writes++;
+    }
+
+}
+
+/* Decodes an image file, then generates mip levels if enabled and the file didn't provide any. */
+static void loadImageFile(const std::string &path, bool linear, DecodedImage &decoded)
+{
+    decodeImageFile(path, linear, decoded);
+
+    std::string filter;
+    {
+        std::lock_guard<std::mutex> lock(TextureMipmapGeneration.mutex);
+        if (!TextureMipmapGeneration.enabled) return;
+        filter = TextureMipmapGeneration.filter;
+    }
+    if (decoded.compression != TEXTURE_COMPRESSION_NONE || decoded.mipOffsets.size() > 0) return;
+    std::vector<vec4> unpackedFloats;
+    std::vector<u8vec4> unpackedBytes;
+    const vec4* floats;
+    const u8vec4* bytes;
+    getRGBATexels(decoded.packedFormat, decoded.packedTexels, decoded.floatTexels, decoded.byteTexels, 
+        unpackedFloats, unpackedBytes, floats, bytes);
+    buildMipChain(floats, bytes, decoded.width, decoded.height, !decoded.linear, filter, 
+        decoded.floatMipTexels, decoded.byteMipTexels, decoded.mipOffsets);
+}
+
+void Texture::setDecodedImage(DecodedImage &decoded)
+{
+    linear = decoded.linear;
+    floatTexels = std::move(decoded.floatTexels);
+    byteTexels = std::move(decoded.byteTexels);
+    floatMipTexels = std::move(decoded.floatMipTexels);
+    byteMipTexels = std::move(decoded.byteMipTexels);
+    mipOffsets = std::move(decoded.mipOffsets);
+    compressedBlocks = std::move(decoded.compressedBlocks);
+    compressedLevelOffsets = std::move(decoded.compressedLevelOffsets);
+    compression = decoded.compression;
+    packedTexels = std::move(decoded.packedTexels);
+    packedFormat = decoded.packedFormat;
+    // single channel textures are uploaded with one channel, other packed formats are expanded to RGBA
+    textureStructs[id].channels = (getChannelCount() == 1) ? 1 : 4;
+    textureStructs[id].width = decoded.width;
+    textureStructs[id].height = decoded.height;
+    textureStructs[id].rightHanded = decoded.rightHanded;
+    markDirty();
+}
+
+Texture* Texture::createFromFile(std::string name, std::string path, bool linear) {
+    auto create = [path, linear] (Texture* l) {
+        DecodedImage decoded;
+        stbi_set_flip_vertically_on_load(true);
+        loadImageFile(path, linear, decoded);
+        l->setDecodedImage(decoded);
     };
 
     try {
@@ -396,6 +883,51 @@ Texture* Texture::createFromFile(std::string name, std::string path, bool linear
 	}
 }
 
+std::vector<Texture*> Texture::createFromFiles(std::vector<std::string> names, std::vector<std::string> paths, 
+    bool linear, uint32_t numThreads, bool verbose)
+{
+    if (names.size() != paths.size()) throw std::runtime_error("Error: names and paths must be the same length!");
+
+    // Decode all images concurrently, without holding the texture table lock
+    std::vector<DecodedImage> decoded(paths.size());
+    std::vector<std::string> errors(paths.size());
+    std::vector<double> milliseconds(paths.size(), 0.0);
+    // set once here rather than by each worker, since the flag is shared by all threads
+    stbi_set_flip_vertically_on_load(true);
+    Parallel::forEachDynamic(paths.size(), numThreads, [&] (size_t i) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            loadImageFile(paths[i], linear, decoded[i]);
+        } catch (std::exception &e) {
+            errors[i] = e.what();
+            decoded[i] = DecodedImage();
+        }
+        milliseconds[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    });
+
+    std::vector<std::string> loadedNames;
+    std::vector<size_t> loadedIndices;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (verbose) {
+            if (errors[i].empty()) std::cout<<"Decoded texture " << names[i] << " in " << milliseconds[i] << " ms" << std::endl;
+            else std::cout<<"Warning: unable to load texture " << names[i] << " : " << errors[i] << std::endl;
+        }
+        if (!errors[i].empty()) continue;
+        loadedNames.push_back(names[i]);
+        loadedIndices.push_back(i);
+    }
+
+    // Only registration with the texture table is serialized
+    auto loaded = StaticFactory::createMany<Texture>(editMutex, loadedNames, "Texture", lookupTable, textures.data(), textures.size(), 
+        [&decoded, &loadedIndices] (Texture* l, size_t i) {
+            l->setDecodedImage(decoded[loadedIndices[i]]);
+        });
+
+    std::vector<Texture*> result(names.size(), nullptr);
+    for (size_t i = 0; i < loaded.size(); ++i) result[loadedIndices[i]] = loaded[i];
+    return result;
+}
+
 Texture* Texture::createFromData(std::string name, uint32_t width, uint32_t height, const float* data, uint32_t length, bool linear, bool hdr)
 {
     if (length != (width * height * 4)) { throw std::runtime_error("Error: width * height * 4 does not equal length of data!"); }
@@ -452,76 +984,283 @@ vec3 hsv2rgb(vec3 c)
     return c.z * mix(vec3(K.x), clamp(p - vec3(K.x), 0.0f, 1.0f), c.y);
 }
 
-Texture* Texture::createHSV(std::string name, Texture* tex, float hue, float sat, float val, float alpha, bool hdr)
+/* Texture compositing.
+ * Composites are evaluated one row at a time. Each input row is decoded to linear RGBA floats 
+ * (resampling if the input resolution differs from the output), the operation chain is applied
+ * to an accumulator row, and the result is encoded back into the output texels. Rows are 
+ * distributed across threads, and the inner loops run over flat float arrays so that the 
+ * compiler can vectorize them.
+ */
+
+static const uint32_t SRGB_ENCODE_TABLE_SIZE = 4096;
+static const size_t COMPOSITE_ROWS_PER_CHUNK = 8;
+
+struct SRGBTables {
+    float decode[256];                             // 8 bit sRGB to linear
+    float encode[SRGB_ENCODE_TABLE_SIZE + 1];      // linear [0,1] to sRGB [0,1], linearly interpolated
+};
+
+static const SRGBTables &getSRGBTables()
 {
-    auto create = [tex, hue, sat, val, alpha, hdr] (Texture* l) {
-        if (!tex || !tex->isInitialized()) throw std::runtime_error(std::string("Error: input texture is null/uninitialized!")); 
+    static const SRGBTables tables = [] () {
+        SRGBTables t;
+        for (uint32_t i = 0; i < 256; ++i) {
+            t.decode[i] = glm::convertSRGBToLinear(vec3(i / 255.f)).x;
+        }
+        for (uint32_t i = 0; i <= SRGB_ENCODE_TABLE_SIZE; ++i) {
+            t.encode[i] = glm::convertLinearToSRGB(vec3(i / float(SRGB_ENCODE_TABLE_SIZE))).x;
+        }
+        return t;
+    }();
+    return tables;
+}
 
-        uint32_t width = tex->getWidth();
-        uint32_t height = tex->getHeight();
-        if (hdr) l->floatTexels.resize(width * height);
-        else l->byteTexels.resize(width * height);
-        textureStructs[l->getId()].width = width;
-        textureStructs[l->getId()].height = height;
+static inline float encodeSRGB(const SRGBTables &tables, float linear)
+{
+    float x = clamp(linear, 0.f, 1.f) * SRGB_ENCODE_TABLE_SIZE;
+    uint32_t i = std::min(uint32_t(x), SRGB_ENCODE_TABLE_SIZE - 1);
+    float f = x - float(i);
+    return tables.encode[i] + (tables.encode[i + 1] - tables.encode[i]) * f;
+}
+
+/* A texture input to a composite, along with the tables used to resample it to the output resolution */
+struct CompositeSource {
+    const u8vec4* byteTexels = nullptr;
+    const vec4* floatTexels = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool srgb = false;
+
+    // for each output column, the two source columns to interpolate between and the weight of the second
+    std::vector<uint32_t> x0, x1;
+    std::vector<float> fx;
+};
+
+/* Maps an output texel center to the two nearest source texels and an interpolation weight, clamping to edge */
+static inline void resampleCoordinate(uint32_t i, uint32_t dstSize, uint32_t srcSize, uint32_t &i0, uint32_t &i1, float &f)
+{
+    float s = (i + .5f) * (float(srcSize) / float(dstSize)) - .5f;
+    s = clamp(s, 0.f, float(srcSize - 1));
+    i0 = uint32_t(s);
+    i1 = std::min(i0 + 1, srcSize - 1);
+    f = s - float(i0);
+}
 
-        float dh = (hue * 2.f) - 1.0f;
-        for (uint32_t y = 0; y < height; ++y) {
-            for (uint32_t x = 0; x < width; ++x) {
-                vec2 off = vec2(1 / float(width), 1 / float(height)); 
-                vec2 uv = vec2(x / float(width), y / float(height)) + .5f * off;
-                vec4 c = tex->sampleFloatTexels(uv);
-                if (!tex->isLinear()) c = glm::convertSRGBToLinear(c);
-                vec3 rgb = vec3(c);
-                vec3 hsv = rgb2hsv(rgb);
-                hsv.x = (hsv.x + dh) - (long)(hsv.x + dh);
-                hsv.y = clamp(sat * hsv.y, 0.f, 1.f); hsv.z = clamp(hsv.z * val, 0.f, 1.f);
-                rgb = mix(rgb, hsv2rgb(hsv), alpha);
-                vec4 result = vec4( rgb.r, rgb.g, rgb.b, c.a);
-                if (!tex->isLinear()) result = glm::convertLinearToSRGB(result);
-                if (hdr) l->floatTexels[y * width + x] = vec4( rgb.r, rgb.g, rgb.b, c.a);
-                else l->byteTexels[y * width + x] = u8vec4(vec4(rgb.r, rgb.g, rgb.b, c.a) * 255.f);
+static void initializeCompositeSource(CompositeSource &source, uint32_t width)
+{
+    source.x0.resize(width);
+    source.x1.resize(width);
+    source.fx.resize(width);
+    for (uint32_t x = 0; x < width; ++x) {
+        resampleCoordinate(x, width, source.width, source.x0[x], source.x1[x], source.fx[x]);
+    }
+}
+
+/* Decodes one source row into linear RGBA floats */
+static void decodeSourceRow(const CompositeSource &source, const SRGBTables &tables, uint32_t y, float* out)
+{
+    size_t count = size_t(source.width);
+    if (source.byteTexels) {
+        const uint8_t* in = &source.byteTexels[size_t(y) * source.width].x;
+        if (source.srgb) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i * 4 + 0] = tables.decode[in[i * 4 + 0]];
+                out[i * 4 + 1] = tables.decode[in[i * 4 + 1]];
+                out[i * 4 + 2] = tables.decode[in[i * 4 + 2]];
+                out[i * 4 + 3] = in[i * 4 + 3] * (1.f / 255.f);
             }
+        } else {
+            for (size_t i = 0; i < count * 4; ++i) out[i] = in[i] * (1.f / 255.f);
         }
-        
-        l->markDirty();
-    };
+    } else {
+        const float* in = &source.floatTexels[size_t(y) * source.width].x;
+        if (source.srgb) {
+            for (size_t i = 0; i < count; ++i) {
+                vec4 c = glm::convertSRGBToLinear(vec4(in[i * 4 + 0], in[i * 4 + 1], in[i * 4 + 2], in[i * 4 + 3]));
+                out[i * 4 + 0] = c.r; out[i * 4 + 1] = c.g; out[i * 4 + 2] = c.b; out[i * 4 + 3] = c.a;
+            }
+        } else {
+            memcpy(out, in, count * 4 * sizeof(float));
+        }
+    }
+}
 
-    try {
-        return StaticFactory::create<Texture>(editMutex, name, "Texture", lookupTable, textures.data(), textures.size(), create);
-    } catch (...) {
-		StaticFactory::removeIfExists(editMutex, name, "Texture", lookupTable, textures.data(), textures.size());
-		throw;
-	}
+/* Per thread scratch space used to decode and resample source rows */
+struct CompositeRowCache {
+    std::vector<float> row0, row1;
+    int64_t y0 = -1, y1 = -1;
+};
+
+/* Fetches one output row of a source in linear RGBA floats, bilinearly resampling if needed */
+static void fetchSourceRow(const CompositeSource &source, const SRGBTables &tables, 
+    uint32_t y, uint32_t width, uint32_t height, CompositeRowCache &cache, float* out)
+{
+    if (source.width == width && source.height == height) {
+        decodeSourceRow(source, tables, y, out);
+        return;
+    }
+
+    uint32_t sy0, sy1; float fy;
+    resampleCoordinate(y, height, source.height, sy0, sy1, fy);
+    cache.row0.resize(size_t(source.width) * 4);
+    cache.row1.resize(size_t(source.width) * 4);
+    if (cache.y0 != int64_t(sy0)) {
+        if (cache.y1 == int64_t(sy0)) { std::swap(cache.row0, cache.row1); std::swap(cache.y0, cache.y1); }
+        else { decodeSourceRow(source, tables, sy0, cache.row0.data()); cache.y0 = sy0; }
+    }
+    if (cache.y1 != int64_t(sy1)) {
+        decodeSourceRow(source, tables, sy1, cache.row1.data()); 
+        cache.y1 = sy1;
+    }
+
+    const float* r0 = cache.row0.data();
+    const float* r1 = cache.row1.data();
+    for (uint32_t x = 0; x < width; ++x) {
+        const float* a0 = r0 + source.x0[x] * 4; const float* b0 = r0 + source.x1[x] * 4;
+        const float* a1 = r1 + source.x0[x] * 4; const float* b1 = r1 + source.x1[x] * 4;
+        float fx = source.fx[x];
+        for (uint32_t c = 0; c < 4; ++c) {
+            float top = a0[c] + (b0[c] - a0[c]) * fx;
+            float bottom = a1[c] + (b1[c] - a1[c]) * fx;
+            out[x * 4 + c] = top + (bottom - top) * fy;
+        }
+    }
 }
 
-Texture* Texture::createMix(std::string name, Texture* a, Texture* b, float mix, bool hdr)
+static void applyHSV(float* acc, uint32_t width, const TextureOperation &op)
 {
-    auto create = [a, b, mix, hdr] (Texture* l) {
-        if (!a || !a->isInitialized()) throw std::runtime_error(std::string("Error: Texture A is null/uninitialized!")); 
-        if (!b || !b->isInitialized()) throw std::runtime_error(std::string("Error: Texture B is null/uninitialized!")); 
+    float dh = (op.hue * 2.f) - 1.0f;
+    for (uint32_t x = 0; x < width; ++x) {
+        vec3 rgb = vec3(acc[x * 4 + 0], acc[x * 4 + 1], acc[x * 4 + 2]);
+        vec3 hsv = rgb2hsv(rgb);
+        hsv.x = (hsv.x + dh) - (long)(hsv.x + dh);
+        hsv.y = clamp(op.saturation * hsv.y, 0.f, 1.f); hsv.z = clamp(hsv.z * op.value, 0.f, 1.f);
+        rgb = mix(rgb, hsv2rgb(hsv), op.mix);
+        acc[x * 4 + 0] = rgb.r; acc[x * 4 + 1] = rgb.g; acc[x * 4 + 2] = rgb.b;
+    }
+}
 
-        uint32_t width = ::max(a->getWidth(), b->getWidth());
-        uint32_t height = ::max(a->getHeight(), b->getHeight());
-        if (hdr) l->floatTexels.resize(width * height);
-        else l->byteTexels.resize(width * height);
-        textureStructs[l->getId()].width = width;
-        textureStructs[l->getId()].height = height;
+TextureOperation TextureOperation::mixWith(Texture* texture, float mix)
+{
+    TextureOperation op; op.type = MIX; op.texture = texture; op.mix = mix;
+    return op;
+}
+
+TextureOperation TextureOperation::addWith(Texture* texture)
+{
+    TextureOperation op; op.type = ADD; op.texture = texture;
+    return op;
+}
+
+TextureOperation TextureOperation::multiplyWith(Texture* texture)
+{
+    TextureOperation op; op.type = MULTIPLY; op.texture = texture;
+    return op;
+}
+
+TextureOperation TextureOperation::hsv(float hue, float saturation, float value, float mix)
+{
+    TextureOperation op; op.type = HSV; op.hue = hue; op.saturation = saturation; op.value = value; op.mix = mix;
+    return op;
+}
+
+Texture* Texture::createComposite(std::string name, Texture* base, std::vector<TextureOperation> operations, bool hdr)
+{
+    auto create = [base, operations, hdr] (Texture* l) {
+        if (!base || !base->isInitialized()) throw std::runtime_error(std::string("Error: base texture is null/uninitialized!")); 
+        for (auto &op : operations) {
+            if (op.type == TextureOperation::HSV) continue;
+            if (!op.texture || !op.texture->isInitialized()) throw std::runtime_error(std::string("Error: operation texture is null/uninitialized!")); 
+        }
+
+        // Gather inputs. The result is only sRGB encoded if every input is.
+        std::vector<Texture*> inputs = {base};
+        for (auto &op : operations) if (op.type != TextureOperation::HSV) inputs.push_back(op.texture);
+        uint32_t width = 0, height = 0;
+        bool srgb = true;
+        for (auto &input : inputs) {
+            width = ::max(width, input->getWidth());
+            height = ::max(height, input->getHeight());
+            srgb &= !input->isLinear();
+        }
 
-        for (uint32_t y = 0; y < height; ++y) {
-            for (uint32_t x = 0; x < width; ++x) {
-                vec2 off = vec2(1 / float(width), 1 / float(height)); 
-                vec2 uv = vec2(x / float(width), y / float(height)) + .5f * off;
-                vec4 ac = a->sampleFloatTexels(uv);
-                vec4 bc = b->sampleFloatTexels(uv);
-                if (!a->isLinear()) ac = glm::convertSRGBToLinear(ac);
-                if (!b->isLinear()) bc = glm::convertSRGBToLinear(bc);
-                vec4 result = glm::mix(ac, bc, mix);
-                if (!a->isLinear() && !b->isLinear()) result = glm::convertLinearToSRGB(result);
-                if (hdr) l->floatTexels[y * width + x] = result;
-                else l->byteTexels[y * width + x] = u8vec4(result * 255.f);
+        // Block compressed and packed inputs are expanded once for the duration of the composite
+        std::map<Texture*, std::vector<u8vec4>> decompressed;
+        std::map<Texture*, std::vector<vec4>> unpacked;
+        std::vector<CompositeSource> sources(inputs.size());
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            Texture* input = inputs[i];
+            if (input->isCompressed()) {
+                if (decompressed.count(input) == 0) decompressed[input] = input->decompressLevel(0);
+                sources[i].byteTexels = decompressed[input].data();
+                sources[i].floatTexels = nullptr;
+            } else {
+                getRGBATexels(input->packedFormat, input->packedTexels, input->floatTexels, input->byteTexels, 
+                    unpacked[input], decompressed[input], sources[i].floatTexels, sources[i].byteTexels);
             }
+            sources[i].width = inputs[i]->getWidth();
+            sources[i].height = inputs[i]->getHeight();
+            sources[i].srgb = !inputs[i]->isLinear();
+            initializeCompositeSource(sources[i], width);
         }
-        
+
+        std::vector<vec4> floatTexels;
+        std::vector<u8vec4> byteTexels;
+        if (hdr) floatTexels.resize(size_t(width) * height);
+        else byteTexels.resize(size_t(width) * height);
+
+        const SRGBTables &tables = getSRGBTables();
+        Parallel::forRange(0, height, COMPOSITE_ROWS_PER_CHUNK, [&] (size_t rowBegin, size_t rowEnd) {
+            std::vector<float> acc(size_t(width) * 4);
+            std::vector<float> src(size_t(width) * 4);
+            std::vector<CompositeRowCache> caches(sources.size());
+            for (size_t y = rowBegin; y < rowEnd; ++y) {
+                fetchSourceRow(sources[0], tables, uint32_t(y), width, height, caches[0], acc.data());
+
+                size_t sourceIndex = 1;
+                for (auto &op : operations) {
+                    if (op.type == TextureOperation::HSV) {
+                        applyHSV(acc.data(), width, op);
+                        continue;
+                    }
+                    fetchSourceRow(sources[sourceIndex], tables, uint32_t(y), width, height, caches[sourceIndex], src.data());
+                    sourceIndex++;
+                    float* a = acc.data(); const float* b = src.data();
+                    size_t count = acc.size();
+                    if (op.type == TextureOperation::MIX) {
+                        float f = op.mix;
+                        for (size_t i = 0; i < count; ++i) a[i] += (b[i] - a[i]) * f;
+                    } else if (op.type == TextureOperation::ADD) {
+                        for (size_t i = 0; i < count; ++i) a[i] += b[i];
+                    } else if (op.type == TextureOperation::MULTIPLY) {
+                        for (size_t i = 0; i < count; ++i) a[i] *= b[i];
+                    }
+                }
+
+                // Encode the accumulated row into the output texels
+                if (srgb) {
+                    for (uint32_t x = 0; x < width; ++x) {
+                        acc[x * 4 + 0] = encodeSRGB(tables, acc[x * 4 + 0]);
+                        acc[x * 4 + 1] = encodeSRGB(tables, acc[x * 4 + 1]);
+                        acc[x * 4 + 2] = encodeSRGB(tables, acc[x * 4 + 2]);
+                    }
+                }
+                if (hdr) {
+                    memcpy(&floatTexels[y * width], acc.data(), acc.size() * sizeof(float));
+                } else {
+                    uint8_t* out = &byteTexels[y * width].x;
+                    for (size_t i = 0; i < acc.size(); ++i) {
+                        out[i] = uint8_t(clamp(acc[i], 0.f, 1.f) * 255.f + .5f);
+                    }
+                }
+            }
+        });
+
+        l->linear = !srgb;
+        l->floatTexels = std::move(floatTexels);
+        l->byteTexels = std::move(byteTexels);
+        textureStructs[l->getId()].width = width;
+        textureStructs[l->getId()].height = height;
         l->markDirty();
     };
 
@@ -533,108 +1272,496 @@ Texture* Texture::createMix(std::string name, Texture* a, Texture* b, float mix,
 	}
 }
 
+Texture* Texture::createHSV(std::string name, Texture* tex, float hue, float sat, float val, float alpha, bool hdr)
+{
+    if (!tex || !tex->isInitialized()) throw std::runtime_error(std::string("Error: input texture is null/uninitialized!")); 
+    return createComposite(name, tex, {TextureOperation::hsv(hue, sat, val, alpha)}, hdr);
+}
+
+Texture* Texture::createMix(std::string name, Texture* a, Texture* b, float mix, bool hdr)
+{
+    if (!a || !a->isInitialized()) throw std::runtime_error(std::string("Error: Texture A is null/uninitialized!")); 
+    if (!b || !b->isInitialized()) throw std::runtime_error(std::string("Error: Texture B is null/uninitialized!")); 
+    return createComposite(name, a, {TextureOperation::mixWith(b, mix)}, hdr);
+}
+
 Texture* Texture::createAdd(std::string name, Texture* a, Texture* b, bool hdr)
 {
-    auto create = [a, b, hdr] (Texture* l) {
-        if (!a || !a->isInitialized()) throw std::runtime_error(std::string("Error: Texture A is null/uninitialized!")); 
-        if (!b || !b->isInitialized()) throw std::runtime_error(std::string("Error: Texture B is null/uninitialized!")); 
+    if (!a || !a->isInitialized()) throw std::runtime_error(std::string("Error: Texture A is null/uninitialized!")); 
+    if (!b || !b->isInitialized()) throw std::runtime_error(std::string("Error: Texture B is null/uninitialized!")); 
+    return createComposite(name, a, {TextureOperation::addWith(b)}, hdr);
+}
 
-        uint32_t width = ::max(a->getWidth(), b->getWidth());
-        uint32_t height = ::max(a->getHeight(), b->getHeight());
-        if (hdr) l->floatTexels.resize(width * height);
-        else l->byteTexels.resize(width * height);
-        textureStructs[l->getId()].width = width;
-        textureStructs[l->getId()].height = height;
+Texture* Texture::createMultiply(std::string name, Texture* a, Texture* b, bool hdr)
+{
+    if (!a || !a->isInitialized()) throw std::runtime_error(std::string("Error: Texture A is null/uninitialized!")); 
+    if (!b || !b->isInitialized()) throw std::runtime_error(std::string("Error: Texture B is null/uninitialized!")); 
+    return createComposite(name, a, {TextureOperation::multiplyWith(b)}, hdr);
+}
+
+/* Mipmap generation.
+ * Each level is filtered from a linear space float copy of the previous level, so that sRGB
+ * textures are filtered gamma correctly and quantization error doesn't accumulate down the
+ * chain. Filters are separable, and applied to rows then columns, each in parallel.
+ */
+
+static const size_t MIP_ROWS_PER_CHUNK = 16;
+
+/* 
+ * A separable 2:1 downsampling filter. Destination texel i reads source texels 2i + firstTap + k. 
+ * When the source size is odd, 2:1 leaves the last source texel over. Wide filters reach it anyway, 
+ * but the two tap box does not, so with foldOddEdge set the last destination texel instead averages 
+ * the last three source texels.
+ */
+struct MipFilter {
+    std::vector<float> weights;
+    int32_t firstTap = 0;
+    bool foldOddEdge = false;
+};
 
-        for (uint32_t y = 0; y < height; ++y) {
-            for (uint32_t x = 0; x < width; ++x) {
-                vec2 off = vec2(1 / float(width), 1 / float(height)); 
-                vec2 uv = vec2(x / float(width), y / float(height)) + .5f * off;
-                vec4 ac = a->sampleFloatTexels(uv);
-                vec4 bc = b->sampleFloatTexels(uv);
-                if (!a->isLinear()) ac = glm::convertSRGBToLinear(ac);
-                if (!b->isLinear()) bc = glm::convertSRGBToLinear(bc);
-                vec4 result = ac + bc;
-                if (!a->isLinear() && !b->isLinear()) result = glm::convertLinearToSRGB(result);
-                if (hdr) l->floatTexels[y * width + x] = result;
-                else l->byteTexels[y * width + x] = u8vec4(result * 255.f);
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x * x) / (4.0 * k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+static MipFilter getMipFilter(const std::string &filter)
+{
+    MipFilter f;
+    if (filter.compare("box") == 0) {
+        f.weights = {.5f, .5f};
+        f.firstTap = 0;
+        f.foldOddEdge = true;
+    }
+    else if (filter.compare("kaiser") == 0) {
+        // Kaiser windowed sinc with a radius of 3 source texels
+        const double alpha = 4.0, radius = 1.5;
+        f.firstTap = -2;
+        double total = 0.0;
+        for (int k = 0; k < 6; ++k) {
+            double x = (k - 2.5) * .5; // distance from the destination texel center, in destination texels
+            double sinc = (x == 0.0) ? 1.0 : sin(glm::pi<double>() * x) / (glm::pi<double>() * x);
+            double t = x / radius;
+            double window = besselI0(alpha * sqrt(std::max(0.0, 1.0 - t * t))) / besselI0(alpha);
+            f.weights.push_back(float(sinc * window));
+            total += sinc * window;
+        }
+        for (auto &w : f.weights) w = float(w / total);
+    }
+    else {
+        throw std::runtime_error(std::string("Error: unknown mipmap filter \"") + filter + "\". Supported filters are \"box\" and \"kaiser\".");
+    }
+    return f;
+}
+
+/* The filter used for the last destination texel of an odd sized source, if the filter folds the leftover texel in */
+static const MipFilter ODD_EDGE_BOX_FILTER = {{1.f / 3.f, 1.f / 3.f, 1.f / 3.f}, 0, false};
+
+static void downsampleRows(const float* src, uint32_t width, uint32_t height, float* dst, uint32_t dstWidth, const MipFilter &f)
+{
+    bool foldLast = f.foldOddEdge && (width > 2 * dstWidth);
+    Parallel::forRange(0, height, MIP_ROWS_PER_CHUNK, [&] (size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y) {
+            const float* in = src + y * width * 4;
+            float* out = dst + y * dstWidth * 4;
+            for (uint32_t x = 0; x < dstWidth; ++x) {
+                const MipFilter &xf = (foldLast && x == dstWidth - 1) ? ODD_EDGE_BOX_FILTER : f;
+                float acc[4] = {0.f, 0.f, 0.f, 0.f};
+                for (size_t k = 0; k < xf.weights.size(); ++k) {
+                    int32_t sx = clamp(int32_t(2 * x) + xf.firstTap + int32_t(k), 0, int32_t(width) - 1);
+                    for (uint32_t c = 0; c < 4; ++c) acc[c] += xf.weights[k] * in[sx * 4 + c];
+                }
+                for (uint32_t c = 0; c < 4; ++c) out[x * 4 + c] = acc[c];
             }
         }
-        
-        l->markDirty();
-    };
+    });
+}
 
-    try {
-        return StaticFactory::create<Texture>(editMutex, name, "Texture", lookupTable, textures.data(), textures.size(), create);
-    } catch (...) {
-		StaticFactory::removeIfExists(editMutex, name, "Texture", lookupTable, textures.data(), textures.size());
-		throw;
-	}
+static void downsampleColumns(const float* src, uint32_t width, uint32_t height, float* dst, uint32_t dstHeight, const MipFilter &f)
+{
+    size_t rowSize = size_t(width) * 4;
+    bool foldLast = f.foldOddEdge && (height > 2 * dstHeight);
+    Parallel::forRange(0, dstHeight, MIP_ROWS_PER_CHUNK, [&] (size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y) {
+            const MipFilter &yf = (foldLast && y == dstHeight - 1) ? ODD_EDGE_BOX_FILTER : f;
+            float* out = dst + y * rowSize;
+            std::fill(out, out + rowSize, 0.f);
+            for (size_t k = 0; k < yf.weights.size(); ++k) {
+                int32_t sy = clamp(int32_t(2 * y) + yf.firstTap + int32_t(k), 0, int32_t(height) - 1);
+                const float* in = src + sy * rowSize;
+                float w = yf.weights[k];
+                for (size_t i = 0; i < rowSize; ++i) out[i] += w * in[i];
+            }
+        }
+    });
 }
 
-Texture* Texture::createMultiply(std::string name, Texture* a, Texture* b, bool hdr)
+static void buildMipChain(const vec4* floatTexels, const u8vec4* byteTexels, uint32_t width, uint32_t height, bool srgb, 
+    const std::string &filter, std::vector<vec4> &floatMipTexels, std::vector<u8vec4> &byteMipTexels, std::vector<size_t> &mipOffsets)
+{
+    MipFilter f = getMipFilter(filter);
+    const SRGBTables &tables = getSRGBTables();
+    floatMipTexels.clear();
+    byteMipTexels.clear();
+    mipOffsets.clear();
+    if (width <= 1 && height <= 1) return;
+
+    // Convert the first level to linear floats
+    std::vector<float> level(size_t(width) * height * 4);
+    CompositeSource source;
+    source.byteTexels = byteTexels;
+    source.floatTexels = floatTexels;
+    source.width = width;
+    source.height = height;
+    source.srgb = srgb;
+    Parallel::forRange(0, height, MIP_ROWS_PER_CHUNK, [&] (size_t rowBegin, size_t rowEnd) {
+        for (size_t y = rowBegin; y < rowEnd; ++y) decodeSourceRow(source, tables, uint32_t(y), &level[y * width * 4]);
+    });
+
+    std::vector<float> rows, next;
+    while (width > 1 || height > 1) {
+        uint32_t dstWidth = std::max(width / 2, 1u);
+        uint32_t dstHeight = std::max(height / 2, 1u);
+        rows.resize(size_t(dstWidth) * height * 4);
+        next.resize(size_t(dstWidth) * dstHeight * 4);
+        downsampleRows(level.data(), width, height, rows.data(), dstWidth, f);
+        downsampleColumns(rows.data(), dstWidth, height, next.data(), dstHeight, f);
+        std::swap(level, next);
+        width = dstWidth;
+        height = dstHeight;
+
+        // Encode the new level back into the storage format of the first level
+        size_t count = size_t(width) * height;
+        if (floatTexels) {
+            mipOffsets.push_back(floatMipTexels.size());
+            floatMipTexels.resize(floatMipTexels.size() + count);
+            vec4* out = &floatMipTexels[mipOffsets.back()];
+            for (size_t i = 0; i < count; ++i) {
+                vec4 c = vec4(level[i * 4 + 0], level[i * 4 + 1], level[i * 4 + 2], level[i * 4 + 3]);
+                out[i] = (srgb) ? glm::convertLinearToSRGB(c) : c;
+            }
+        } else {
+            mipOffsets.push_back(byteMipTexels.size());
+            byteMipTexels.resize(byteMipTexels.size() + count);
+            uint8_t* out = &byteMipTexels[mipOffsets.back()].x;
+            for (size_t i = 0; i < count * 4; ++i) {
+                float v = ((srgb) && ((i & 3) != 3)) ? encodeSRGB(tables, level[i]) : level[i];
+                out[i] = uint8_t(clamp(v, 0.f, 1.f) * 255.f + .5f);
+            }
+        }
+    }
+}
+
+void Texture::enableMipmapGeneration(std::string filter)
 {
-    auto create = [a, b, hdr] (Texture* l) {
-        if (!a || !a->isInitialized()) throw std::runtime_error(std::string("Error: Texture A is null/uninitialized!")); 
-        if (!b || !b->isInitialized()) throw std::runtime_error(std::string("Error: Texture B is null/uninitialized!")); 
+    getMipFilter(filter); // validate
+    std::lock_guard<std::mutex> lock(TextureMipmapGeneration.mutex);
+    TextureMipmapGeneration.enabled = true;
+    TextureMipmapGeneration.filter = filter;
+}
 
-        uint32_t width = ::max(a->getWidth(), b->getWidth());
-        uint32_t height = ::max(a->getHeight(), b->getHeight());
-        if (hdr) l->floatTexels.resize(width * height);
-        else l->byteTexels.resize(width * height);
-        textureStructs[l->getId()].width = width;
-        textureStructs[l->getId()].height = height;
+void Texture::disableMipmapGeneration()
+{
+    std::lock_guard<std::mutex> lock(TextureMipmapGeneration.mutex);
+    TextureMipmapGeneration.enabled = false;
+}
+
+void Texture::generateMipmaps(std::string filter)
+{
+    if (compression != TEXTURE_COMPRESSION_NONE) {
+        throw std::runtime_error("Error: texture " + name + " is block compressed. Its mip levels are the ones stored in its file.");
+    }
+    std::vector<vec4> unpackedFloats;
+    std::vector<u8vec4> unpackedBytes;
+    const vec4* floats;
+    const u8vec4* bytes;
+    getRGBATexels(packedFormat, packedTexels, floatTexels, byteTexels, unpackedFloats, unpackedBytes, floats, bytes);
+    buildMipChain(floats, bytes, textureStructs[id].width, textureStructs[id].height, !linear, filter, 
+        floatMipTexels, byteMipTexels, mipOffsets);
+    // the renderer only uses the first level, so the texture is not marked dirty
+}
+
+void Texture::clearMipmaps()
+{
+    if (compression != TEXTURE_COMPRESSION_NONE && compressedLevelOffsets.size() > 1) {
+        compressedBlocks.resize(compressedLevelOffsets[1]);
+        compressedBlocks.shrink_to_fit();
+        compressedLevelOffsets.resize(1);
+    }
+    std::vector<vec4>().swap(floatMipTexels);
+    std::vector<u8vec4>().swap(byteMipTexels);
+    mipOffsets.clear();
+}
+
+uint32_t Texture::getMipLevelCount()
+{
+    if (compression != TEXTURE_COMPRESSION_NONE) return uint32_t(compressedLevelOffsets.size());
+    return uint32_t(mipOffsets.size() + 1);
+}
+
+uint32_t Texture::getMipLevelWidth(uint32_t level)
+{
+    if (level >= getMipLevelCount()) throw std::runtime_error("Error: mip level out of range");
+    return std::max(uint32_t(textureStructs[id].width) >> level, 1u);
+}
+
+uint32_t Texture::getMipLevelHeight(uint32_t level)
+{
+    if (level >= getMipLevelCount()) throw std::runtime_error("Error: mip level out of range");
+    return std::max(uint32_t(textureStructs[id].height) >> level, 1u);
+}
+
+std::vector<u8vec4> Texture::getMipLevelByteTexels(uint32_t level)
+{
+    if (level >= getMipLevelCount()) throw std::runtime_error("Error: mip level out of range");
+    if (level == 0) return getByteTexels();
+    if (compression != TEXTURE_COMPRESSION_NONE) return decompressLevel(level);
+    size_t count = size_t(getMipLevelWidth(level)) * getMipLevelHeight(level);
+    size_t offset = mipOffsets[level - 1];
+    if (byteMipTexels.size() > 0) return std::vector<u8vec4>(byteMipTexels.begin() + offset, byteMipTexels.begin() + offset + count);
+    std::vector<u8vec4> texels8(count);
+    for (size_t i = 0; i < count; ++i) texels8[i] = u8vec4(clamp(floatMipTexels[offset + i], vec4(0.f), vec4(1.f)) * 255.f + .5f);
+    return texels8;
+}
+
+std::vector<vec4> Texture::getMipLevelFloatTexels(uint32_t level)
+{
+    if (level >= getMipLevelCount()) throw std::runtime_error("Error: mip level out of range");
+    if (level == 0) return getFloatTexels();
+    size_t count = size_t(getMipLevelWidth(level)) * getMipLevelHeight(level);
+    if (floatMipTexels.size() > 0) {
+        size_t offset = mipOffsets[level - 1];
+        return std::vector<vec4>(floatMipTexels.begin() + offset, floatMipTexels.begin() + offset + count);
+    }
+    std::vector<u8vec4> texels8 = getMipLevelByteTexels(level);
+    std::vector<vec4> texels(count);
+    for (size_t i = 0; i < count; ++i) texels[i] = vec4(texels8[i]) / 255.0f;
+    return texels;
+}
+
+/* CPU texture sampling.
+ * A TextureSampler records where the texels of each mip level live, along with the filter and 
+ * wrap modes parsed once up front, so that batches of coordinates only pay for the texel fetches. 
+ * Texel coordinates follow the renderer: texel centers sit at (i + .5) / size, and v = 0 is the 
+ * first (bottom) row.
+ */
+
+static const size_t SAMPLES_PER_CHUNK = 1 << 12;
+
+enum TextureSampleFilter : uint32_t {
+    TEXTURE_SAMPLE_NEAREST = 0,
+    TEXTURE_SAMPLE_LINEAR,
+    TEXTURE_SAMPLE_TRILINEAR,
+};
+
+enum TextureSampleWrap : uint32_t {
+    TEXTURE_SAMPLE_REPEAT = 0,
+    TEXTURE_SAMPLE_CLAMP,
+    TEXTURE_SAMPLE_MIRROR,
+};
+
+/* The texels of one mip level. Exactly one of the texel pointers is set. */
+struct TextureSampleLevel {
+    const vec4* floatTexels = nullptr;
+    const u8vec4* byteTexels = nullptr;
+    const uint8_t* packedTexels = nullptr;
+    const uint8_t* compressedBlocks = nullptr;
+    uint32_t packedFormat = 0;
+    uint32_t compression = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
 
-        for (uint32_t y = 0; y < height; ++y) {
-            for (uint32_t x = 0; x < width; ++x) {
-                vec2 off = vec2(1 / float(width), 1 / float(height)); 
-                vec2 uv = vec2(x / float(width), y / float(height)) + .5f * off;
-                vec4 ac = a->sampleFloatTexels(uv);
-                vec4 bc = b->sampleFloatTexels(uv);
-                if (!a->isLinear()) ac = glm::convertSRGBToLinear(ac);
-                if (!b->isLinear()) bc = glm::convertSRGBToLinear(bc);
-                vec4 result = ac * bc;
-                if (!a->isLinear() && !b->isLinear()) result = glm::convertLinearToSRGB(result);
-                if (hdr) l->floatTexels[y * width + x] = result;
-                else l->byteTexels[y * width + x] = u8vec4(result * 255.f);
+struct TextureSampler {
+    std::vector<TextureSampleLevel> levels;
+    uint32_t filter = TEXTURE_SAMPLE_LINEAR;
+    uint32_t wrap = TEXTURE_SAMPLE_REPEAT;
+    float lod = 0.f;
+    bool decodeSRGB = false;
+    const SRGBTables *tables = nullptr;
+
+    /* Decompressed block compressed levels, when decompressing up front is cheaper than per texel */
+    std::vector<std::vector<u8vec4>> decompressed;
+};
+
+static uint32_t getSampleFilter(const std::string &filter)
+{
+    if (filter == "nearest") return TEXTURE_SAMPLE_NEAREST;
+    if (filter == "linear") return TEXTURE_SAMPLE_LINEAR;
+    if (filter == "trilinear") return TEXTURE_SAMPLE_TRILINEAR;
+    throw std::runtime_error("Error: unknown texture filter \"" + filter + "\". Expected \"nearest\", \"linear\", or \"trilinear\".");
+}
+
+static uint32_t getSampleWrap(const std::string &wrap)
+{
+    if (wrap == "repeat") return TEXTURE_SAMPLE_REPEAT;
+    if (wrap == "clamp") return TEXTURE_SAMPLE_CLAMP;
+    if (wrap == "mirror") return TEXTURE_SAMPLE_MIRROR;
+    throw std::runtime_error("Error: unknown texture wrap mode \"" + wrap + "\". Expected \"repeat\", \"clamp\", or \"mirror\".");
+}
+
+/* Reduces a texture coordinate to a bounded range, so that texel indices can't overflow */
+static inline float reduceCoordinate(float u, uint32_t wrap)
+{
+    if (!(u == u)) return 0.f; // NaN
+    if (wrap == TEXTURE_SAMPLE_REPEAT) return u - std::floor(u);
+    if (wrap == TEXTURE_SAMPLE_MIRROR) return u - 2.f * std::floor(u * .5f);
+    return clamp(u, -1.f, 2.f);
+}
+
+/* Maps a texel index that may fall outside of [0, size) back into the texture */
+static inline uint32_t wrapTexelIndex(int32_t i, uint32_t size, uint32_t wrap)
+{
+    int32_t n = int32_t(size);
+    if (wrap == TEXTURE_SAMPLE_CLAMP) return uint32_t(clamp(i, 0, n - 1));
+    if (wrap == TEXTURE_SAMPLE_REPEAT) {
+        i %= n;
+        return uint32_t((i < 0) ? i + n : i);
+    }
+    i %= 2 * n;
+    if (i < 0) i += 2 * n;
+    return uint32_t((i < n) ? i : 2 * n - 1 - i);
+}
+
+/* Fetches a single texel, normalizing 8-bit channels and optionally converting sRGB to linear */
+static inline vec4 fetchSampleTexel(const TextureSampler &sampler, const TextureSampleLevel &level, uint32_t x, uint32_t y)
+{
+    size_t i = size_t(y) * level.width + x;
+    vec4 c;
+    u8vec4 b;
+    if (level.floatTexels) c = level.floatTexels[i];
+    else if (level.packedTexels && isPackedFloat(level.packedFormat)) 
+        c = unpackTexel(level.packedFormat, &level.packedTexels[i * getPackedTexelSize(level.packedFormat)]);
+    else {
+        if (level.byteTexels) b = level.byteTexels[i];
+        else if (level.packedTexels) b = unpackByteTexel(level.packedFormat, &level.packedTexels[i * getPackedTexelSize(level.packedFormat)]);
+        else b = fetchCompressedTexel(level.compressedBlocks, level.compression, level.width, level.height, x, y);
+        if (!sampler.decodeSRGB) return vec4(b) * (1.f / 255.f);
+        return vec4(sampler.tables->decode[b.r], sampler.tables->decode[b.g], sampler.tables->decode[b.b], b.a * (1.f / 255.f));
+    }
+    return (sampler.decodeSRGB) ? glm::convertSRGBToLinear(c) : c;
+}
+
+static vec4 sampleLevel(const TextureSampler &sampler, const TextureSampleLevel &level, vec2 uv, bool bilinear)
+{
+    float u = reduceCoordinate(uv.x, sampler.wrap) * level.width;
+    float v = reduceCoordinate(uv.y, sampler.wrap) * level.height;
+    if (!bilinear) {
+        uint32_t x = wrapTexelIndex(int32_t(std::floor(u)), level.width, sampler.wrap);
+        uint32_t y = wrapTexelIndex(int32_t(std::floor(v)), level.height, sampler.wrap);
+        return fetchSampleTexel(sampler, level, x, y);
+    }
+
+    u -= .5f; 
+    v -= .5f;
+    float fu = std::floor(u), fv = std::floor(v);
+    float tx = u - fu, ty = v - fv;
+    uint32_t x0 = wrapTexelIndex(int32_t(fu), level.width, sampler.wrap);
+    uint32_t x1 = wrapTexelIndex(int32_t(fu) + 1, level.width, sampler.wrap);
+    uint32_t y0 = wrapTexelIndex(int32_t(fv), level.height, sampler.wrap);
+    uint32_t y1 = wrapTexelIndex(int32_t(fv) + 1, level.height, sampler.wrap);
+    vec4 bottom = mix(fetchSampleTexel(sampler, level, x0, y0), fetchSampleTexel(sampler, level, x1, y0), tx);
+    vec4 top = mix(fetchSampleTexel(sampler, level, x0, y1), fetchSampleTexel(sampler, level, x1, y1), tx);
+    return mix(bottom, top, ty);
+}
+
+static vec4 sampleTexture(const TextureSampler &sampler, vec2 uv)
+{
+    float maxLevel = float(sampler.levels.size() - 1);
+    float lod = clamp(sampler.lod, 0.f, maxLevel);
+    if (sampler.filter != TEXTURE_SAMPLE_TRILINEAR) {
+        uint32_t level = uint32_t(lod + .5f);
+        return sampleLevel(sampler, sampler.levels[level], uv, sampler.filter == TEXTURE_SAMPLE_LINEAR);
+    }
+    uint32_t level0 = uint32_t(lod);
+    uint32_t level1 = std::min(level0 + 1, uint32_t(maxLevel));
+    float t = lod - float(level0);
+    vec4 c0 = sampleLevel(sampler, sampler.levels[level0], uv, true);
+    if (t == 0.f || level0 == level1) return c0;
+    return mix(c0, sampleLevel(sampler, sampler.levels[level1], uv, true), t);
+}
+
+void Texture::initializeSampler(TextureSampler &sampler, std::string filter, std::string wrap, float lod, bool decodeSRGB, bool decompress)
+{
+    sampler.filter = getSampleFilter(filter);
+    sampler.wrap = getSampleWrap(wrap);
+    if (!(lod == lod)) throw std::runtime_error("Error: lod must be a number");
+    sampler.lod = lod;
+    sampler.decodeSRGB = decodeSRGB && !linear;
+    sampler.tables = &getSRGBTables();
+
+    // only fetch the levels that the filter can touch
+    uint32_t numLevels = getMipLevelCount();
+    float clampedLod = clamp(lod, 0.f, float(numLevels - 1));
+    uint32_t firstLevel = (sampler.filter == TEXTURE_SAMPLE_TRILINEAR) ? uint32_t(clampedLod) : uint32_t(clampedLod + .5f);
+    uint32_t lastLevel = std::min(firstLevel + 1, numLevels - 1);
+
+    sampler.levels.resize(numLevels);
+    sampler.decompressed.resize(numLevels);
+    for (uint32_t l = firstLevel; l <= lastLevel; ++l) {
+        TextureSampleLevel &level = sampler.levels[l];
+        level.width = getMipLevelWidth(l);
+        level.height = getMipLevelHeight(l);
+        if (compression != TEXTURE_COMPRESSION_NONE) {
+            if (decompress) {
+                sampler.decompressed[l] = decompressLevel(l);
+                level.byteTexels = sampler.decompressed[l].data();
+            } else {
+                level.compressedBlocks = compressedBlocks.data() + compressedLevelOffsets[l];
+                level.compression = compression;
             }
+        } else if (l == 0 && packedFormat != TEXTURE_PACKED_NONE) {
+            level.packedTexels = packedTexels.data();
+            level.packedFormat = packedFormat;
+        } else if (l == 0) {
+            if (floatTexels.size() > 0) level.floatTexels = floatTexels.data();
+            else level.byteTexels = byteTexels.data();
+        } else {
+            if (floatMipTexels.size() > 0) level.floatTexels = &floatMipTexels[mipOffsets[l - 1]];
+            else level.byteTexels = &byteMipTexels[mipOffsets[l - 1]];
         }
-        l->markDirty();
-    };
+    }
+}
 
-    try {
-        return StaticFactory::create<Texture>(editMutex, name, "Texture", lookupTable, textures.data(), textures.size(), create);
-    } catch (...) {
-		StaticFactory::removeIfExists(editMutex, name, "Texture", lookupTable, textures.data(), textures.size());
-		throw;
-	}
+vec4 Texture::sample(vec2 uv, std::string filter, std::string wrap, float lod, bool decode_srgb)
+{
+    TextureSampler sampler;
+    initializeSampler(sampler, filter, wrap, lod, decode_srgb, false);
+    return sampleTexture(sampler, uv);
 }
 
-vec4 Texture::sampleFloatTexels(vec2 uv) {
-    uint32_t width = textureStructs[id].width;
-    uint32_t height = textureStructs[id].height;
-    vec2 coord = uv * vec2(width-1, height-1);
-    ivec2 coord_floor = glm::ivec2(glm::floor(coord));
-    ivec2 coord_ceil = glm::ivec2(glm::ceil(coord));
+void Texture::sampleBatch(const float* uvs, int uv_count, int uv_components, float** samples, int* sample_count, int* sample_components, 
+    std::string filter, std::string wrap, float lod, bool decode_srgb)
+{
+    if (uv_components != 2) throw std::runtime_error("Error: texture coordinates must have two components per sample");
+    if (uv_count < 0) throw std::runtime_error("Error: invalid texture coordinate count");
+    TextureSampler sampler;
+    // Block compressed textures are decompressed once rather than once per texel fetch
+    initializeSampler(sampler, filter, wrap, lod, decode_srgb, (size_t(uv_count) * 4 > size_t(getWidth()) * getHeight() / 16));
+
+    float* out = (float*) malloc(std::max(size_t(uv_count), size_t(1)) * 4 * sizeof(float));
+    if (!out) throw std::runtime_error("Error: out of memory allocating texture samples");
+    Parallel::forRange(0, size_t(uv_count), SAMPLES_PER_CHUNK, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            vec4 c = sampleTexture(sampler, vec2(uvs[i * 2 + 0], uvs[i * 2 + 1]));
+            out[i * 4 + 0] = c.r; out[i * 4 + 1] = c.g; out[i * 4 + 2] = c.b; out[i * 4 + 3] = c.a;
+        }
+    });
+    *samples = out;
+    *sample_count = uv_count;
+    *sample_components = 4;
+}
 
-    // todo, interpolate four surrouding pixels
-    if (floatTexels.size() > 0)
-        return floatTexels[coord_floor.y * width + coord_floor.x]; 
-    else 
-        return vec4(byteTexels[coord_floor.y * width + coord_floor.x]) / 255.f; 
+vec4 Texture::sampleFloatTexels(vec2 uv) {
+    return sample(uv, "linear", "clamp");
 }
 
 u8vec4 Texture::sampleByteTexels(vec2 uv) {
-    uint32_t width = textureStructs[id].width;
-    uint32_t height = textureStructs[id].height;
-    vec2 coord = uv * vec2(width-1, height-1);
-    ivec2 coord_floor = glm::ivec2(glm::floor(coord));
-    ivec2 coord_ceil = glm::ivec2(glm::ceil(coord));
-    // todo, interpolate four surrouding pixels
-    if (byteTexels.size() > 0)
-        return floatTexels[coord_floor.y * width + coord_floor.x]; 
-    else 
-        return u8vec4(floatTexels[coord_floor.y * width + coord_floor.x] * 255.f); 
+    return u8vec4(clamp(sample(uv, "linear", "clamp"), vec4(0.f), vec4(1.f)) * 255.f + .5f);
 }
 
 std::shared_ptr<std::recursive_mutex> Texture::getEditMutex()
@@ -651,6 +1778,10 @@ void Texture::remove(std::string name) {
 	if (!t) return;
     std::vector<glm::vec4>().swap(t->floatTexels);
     std::vector<glm::u8vec4>().swap(t->byteTexels);
+    std::vector<glm::vec4>().swap(t->floatMipTexels);
+    std::vector<glm::u8vec4>().swap(t->byteMipTexels);
+    std::vector<uint8_t>().swap(t->compressedBlocks);
+    std::vector<uint8_t>().swap(t->packedTexels);
     int32_t oldID = t->getId();
 	StaticFactory::remove(editMutex, name, "Texture", lookupTable, textures.data(), textures.size());
 	dirtyTextures.insert(&textures[oldID]);
@@ -685,7 +1816,7 @@ int32_t Texture::getAddress()
 
 std::map<std::string, uint32_t> Texture::getNameToIdMap()
 {
-	return lookupTable;
+	return lookupTable.toMap();
 }
 
 };
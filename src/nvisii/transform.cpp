@@ -1,21 +1,42 @@
 #include <nvisii/transform.h>
 #include <nvisii/entity.h>
+#include <nvisii/utilities/parallel.h>
 #include <glm/gtx/matrix_decompose.hpp>
 
+#include <algorithm>
+
 namespace nvisii {
 
 std::vector<Transform> Transform::transforms;
 std::vector<TransformStruct> Transform::transformStructs;
-std::map<std::string, uint32_t> Transform::lookupTable;
+LookupTable Transform::lookupTable;
 std::shared_ptr<std::recursive_mutex> Transform::editMutex;
 bool Transform::factoryInitialized = false;
 std::set<Transform*> Transform::dirtyTransforms;
+std::vector<Transform*> Transform::staleTransforms;
+std::atomic<bool> Transform::anyStale(false);
+std::vector<glm::vec3> Transform::localScales;
+std::vector<glm::vec3> Transform::localPositions;
+std::vector<glm::quat> Transform::localRotations;
+std::vector<glm::vec3> Transform::prevLocalScales;
+std::vector<glm::vec3> Transform::prevLocalPositions;
+std::vector<glm::quat> Transform::prevLocalRotations;
+std::vector<glm::mat4> Transform::worldToLocalMatrices;
+std::vector<glm::mat4> Transform::prevWorldToLocalMatrices;
 
 void Transform::initializeFactory(uint32_t max_components)
 {
 	if (isFactoryInitialized()) return;
 	transforms.resize(max_components);
 	transformStructs.resize(max_components);
+	localScales.resize(max_components, glm::vec3(1.f));
+	localPositions.resize(max_components, glm::vec3(0.f));
+	localRotations.resize(max_components, glm::quat(1.f, 0.f, 0.f, 0.f));
+	prevLocalScales.resize(max_components, glm::vec3(1.f));
+	prevLocalPositions.resize(max_components, glm::vec3(0.f));
+	prevLocalRotations.resize(max_components, glm::quat(1.f, 0.f, 0.f, 0.f));
+	worldToLocalMatrices.resize(max_components, glm::mat4(1.f));
+	prevWorldToLocalMatrices.resize(max_components, glm::mat4(1.f));
 	editMutex = std::make_shared<std::recursive_mutex>();
 	factoryInitialized = true;
 }
@@ -31,25 +52,89 @@ bool Transform::isInitialized()
 }
 
 bool Transform::areAnyDirty() {
-	return dirtyTransforms.size() > 0;
+	return (dirtyTransforms.size() > 0) || anyStale;
 };
 
 std::set<Transform*> Transform::getDirtyTransforms()
 {
+	updateWorldMatrices();
 	return dirtyTransforms;
 }
 
-void Transform::updateComponents() 
+void Transform::updateWorldMatrices()
 {
-	if (dirtyTransforms.size() == 0) return;
-	for (auto &t : dirtyTransforms) {
-		if (!t->isInitialized()) continue;
-		transformStructs[t->id].localToWorld = t->getLocalToWorldMatrix(false);
-		transformStructs[t->id].localToWorldPrev = t->getLocalToWorldMatrix(true);
+	if (!anyStale) return;
+	std::lock_guard<std::recursive_mutex> lock(*editMutex.get());
+	if (staleTransforms.empty()) return;
+
+	// Find the roots of the stale subtrees, skipping transforms whose ancestors 
+	// are also stale, since those will be visited when traversing the ancestor.
+	std::vector<Transform*> roots;
+	for (auto &t : staleTransforms) {
+		if (!t->initialized || !t->worldMatrixStale) continue;
+		bool ancestorStale = false;
+		for (Transform* p = t->getParent(); p != nullptr; p = p->getParent()) {
+			if (p->worldMatrixStale) { ancestorStale = true; break; }
+		}
+		if (!ancestorStale) roots.push_back(t);
+	}
+	std::sort(roots.begin(), roots.end());
+	roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+	staleTransforms.clear();
+	anyStale = false;
+
+	// Resolve each subtree top down, so that every parent is up to date before its children.
+	// Subtrees are disjoint, so they can be processed in parallel.
+	std::vector<std::vector<Transform*>> updated(roots.size());
+	Parallel::forEach(0, roots.size(), 256, [&roots, &updated] (size_t r) {
+		std::vector<Transform*> stack = {roots[r]};
+		while (!stack.empty()) {
+			Transform* t = stack.back();
+			stack.pop_back();
+			t->updateWorldMatrix();
+			t->worldMatrixStale = false;
+			updated[r].push_back(t);
+			for (auto &c : t->children) {
+				if ((c < 0) || (c >= transforms.size()) || (!transforms[c].initialized)) continue;
+				stack.push_back(&transforms[c]);
+			}
+		}
+	});
+
+	// Entity updates touch shared state, so they happen serially, and only once per transform
+	auto entityPointers = Entity::getFront();
+	for (auto &subtree : updated) {
+		for (auto &t : subtree) {
+			dirtyTransforms.insert(t);
+			for (auto &eid : t->entities) {
+				entityPointers[eid].markDirty();
+			}
+		}
 	}
+}
+
+void Transform::updateComponents() 
+{
+	// World matrices are stored directly in transformStructs, so there's nothing to copy
+	updateWorldMatrices();
 	dirtyTransforms.clear();
 }
 
+void Transform::resetStorage(int32_t id)
+{
+	if ((id < 0) || (id >= transformStructs.size())) return;
+	localScales[id] = glm::vec3(1.f);
+	localPositions[id] = glm::vec3(0.f);
+	localRotations[id] = glm::quat(1.f, 0.f, 0.f, 0.f);
+	prevLocalScales[id] = glm::vec3(1.f);
+	prevLocalPositions[id] = glm::vec3(0.f);
+	prevLocalRotations[id] = glm::quat(1.f, 0.f, 0.f, 0.f);
+	worldToLocalMatrices[id] = glm::mat4(1.f);
+	prevWorldToLocalMatrices[id] = glm::mat4(1.f);
+	transformStructs[id].localToWorld = glm::mat4(1.f);
+	transformStructs[id].localToWorldPrev = glm::mat4(1.f);
+}
+
 void Transform::clearAll() 
 {
 	if (!isFactoryInitialized()) return;
@@ -97,6 +182,74 @@ Transform* Transform::createFromMatrix(std::string name, mat4 xfm)
 	}
 }
 
+std::vector<Transform*> Transform::createMany(std::vector<std::string> names, 
+	std::vector<float> scales, std::vector<float> rotations, std::vector<float> positions)
+{
+	// Validate list lengths before creating anything
+	size_t count = names.size();
+	if (scales.size() > 0) getBatchOffset(scales, 3, count, 0, "scales");
+	if (rotations.size() > 0) getBatchOffset(rotations, 4, count, 0, "rotations");
+	if (positions.size() > 0) getBatchOffset(positions, 3, count, 0, "positions");
+
+	auto createTransform = [&] (Transform* transform, size_t i) {
+		if (scales.size() > 0) {
+			const float* s = &scales[getBatchOffset(scales, 3, count, i, "scales")];
+			localScales[transform->id] = vec3(s[0], s[1], s[2]);
+		}
+		if (rotations.size() > 0) {
+			const float* r = &rotations[getBatchOffset(rotations, 4, count, i, "rotations")];
+			localRotations[transform->id] = glm::normalize(quat(r[3], r[0], r[1], r[2]));
+		}
+		if (positions.size() > 0) {
+			const float* p = &positions[getBatchOffset(positions, 3, count, i, "positions")];
+			localPositions[transform->id] = vec3(p[0], p[1], p[2]);
+		}
+		// Only compute the final matrices once per transform
+		transform->updateMatrix();
+	};
+
+	return StaticFactory::createMany<Transform>(editMutex, names, "Transform", lookupTable, transforms.data(), transforms.size(), createTransform);
+}
+
+void Transform::setMany(std::vector<Transform*> transforms_, 
+	std::vector<float> scales, std::vector<float> rotations, std::vector<float> positions)
+{
+	// Validate everything before modifying anything
+	size_t count = transforms_.size();
+	if (scales.size() > 0) getBatchOffset(scales, 3, count, 0, "scales");
+	if (rotations.size() > 0) getBatchOffset(rotations, 4, count, 0, "rotations");
+	if (positions.size() > 0) getBatchOffset(positions, 3, count, 0, "positions");
+	std::vector<bool> seen(transforms.size(), false);
+	for (auto &t : transforms_) {
+		if (!t) throw std::runtime_error(std::string("Error: transform is empty"));
+		if (!t->isInitialized()) throw std::runtime_error(std::string("Error: transform is uninitialized"));
+		if (seen[t->id]) throw std::runtime_error(std::string("Error: transform \"" + t->name + "\" appears more than once"));
+		seen[t->id] = true;
+	}
+
+	std::lock_guard<std::recursive_mutex> lock(*editMutex.get());
+
+	// Each transform is handled by exactly one thread, which only writes to that transform's rows
+	Parallel::forEach(0, count, 1024, [&] (size_t i) {
+		Transform* transform = transforms_[i];
+		if (scales.size() > 0) {
+			const float* s = &scales[getBatchOffset(scales, 3, count, i, "scales")];
+			localScales[transform->id] = vec3(s[0], s[1], s[2]);
+		}
+		if (rotations.size() > 0) {
+			const float* r = &rotations[getBatchOffset(rotations, 4, count, i, "rotations")];
+			localRotations[transform->id] = glm::normalize(quat(r[3], r[0], r[1], r[2]));
+		}
+		if (positions.size() > 0) {
+			const float* p = &positions[getBatchOffset(positions, 3, count, i, "positions")];
+			localPositions[transform->id] = vec3(p[0], p[1], p[2]);
+		}
+		transform->updateLocalMatrices();
+	});
+
+	for (auto &t : transforms_) t->markDirty();
+}
+
 std::shared_ptr<std::recursive_mutex> Transform::getEditMutex()
 {
 	return editMutex;
@@ -111,6 +264,7 @@ void Transform::remove(std::string name) {
 	if (!t) return;
 	int32_t oldID = t->getId();
 	StaticFactory::remove(editMutex, name, "Transform", lookupTable, transforms.data(), transforms.size());
+	resetStorage(oldID);
 	dirtyTransforms.insert(&transforms[oldID]);
 }
 
@@ -144,7 +298,7 @@ int32_t Transform::getAddress()
 
 std::map<std::string, uint32_t> Transform::getNameToIdMap()
 {
-	return lookupTable;
+	return lookupTable.toMap();
 }
 
 void Transform::markDirty() {
@@ -152,11 +306,11 @@ void Transform::markDirty() {
         throw std::runtime_error("Error, transform not allocated in list");
     }
 
-	dirtyTransforms.insert(this);
-	auto entityPointers = Entity::getFront();
-	for (auto &eid : entities) {
-		entityPointers[eid].markDirty();
-	}
+	std::lock_guard<std::recursive_mutex> lock(*editMutex.get());
+	if (worldMatrixStale) return;
+	worldMatrixStale = true;
+	staleTransforms.push_back(this);
+	anyStale = true;
 };
 
 Transform::Transform() { 
@@ -165,6 +319,7 @@ Transform::Transform() {
 
 Transform::Transform(std::string name, uint32_t id) {
 	initialized = true; this->name = name; this->id = id;
+	resetStorage(id);
 }
 
 std::string Transform::toString()
@@ -248,7 +403,7 @@ void Transform::lookAt(vec3 at, vec3 up, vec3 eye, bool previous)
 		useRelativeAngularMotionBlur = false;
 	}
 	if (glm::any(glm::isnan(eye))) {
-		eye = (previous) ? this->prevPosition : this->position;
+		eye = (previous) ? prevLocalPositions[id] : localPositions[id];
 	} else {
 		if (previous) {
 			useRelativeLinearMotionBlur = false;
@@ -272,7 +427,7 @@ void Transform::lookAt(vec3 at, vec3 up, vec3 eye, bool previous)
 	
 
 // 	nextWorldToLocalMatrix = glm::lookAt(eye, at, up);
-// 	glm::mat4 dNext = nextWorldToLocalMatrix * localToWorldMatrix;
+// 	glm::mat4 dNext = nextWorldToLocalMatrix * transformStructs[id].localToWorld;
 // 	glm::quat rot = glm::quat_cast(dNext);
 // 	glm::vec4 vel = glm::column(dNext, 3);
 
@@ -311,8 +466,8 @@ void Transform::rotateAround(vec3 point, glm::quat rot, bool previous)
 	glm::quat newRotation = rot * getRotation(previous);
 	newPosition = newPosition - direction * glm::inverse(rot);
 
-	glm::quat &r = (previous) ? prevRotation : rotation;
-	glm::vec3 &t = (previous) ? prevPosition : position;
+	glm::quat &r = (previous) ? prevLocalRotations[id] : localRotations[id];
+	glm::vec3 &t = (previous) ? prevLocalPositions[id] : localPositions[id];
 
 	// glm::mat4 &ltpr = (previous) ? prevLocalToParentRotation : localToParentRotation;
 	// glm::mat4 &ptlr = (previous) ? prevParentToLocalRotation : parentToLocalRotation;
@@ -414,14 +569,14 @@ void Transform::setTransform(glm::mat4 transformation, bool decompose, bool prev
 
 quat Transform::getRotation(bool previous)
 {
-	if (previous) return prevRotation;
-	else return rotation;
+	if (previous) return prevLocalRotations[id];
+	else return localRotations[id];
 }
 
 void Transform::setRotation(quat newRotation, bool previous)
 {
 	if (previous) useRelativeAngularMotionBlur = false;
-	auto &r = (previous) ? prevRotation : rotation;
+	auto &r = (previous) ? prevLocalRotations[id] : localRotations[id];
 	r = glm::normalize(newRotation);
 	updateRotation();
 	markDirty();
@@ -462,8 +617,8 @@ void Transform::updateRotation()
 
 vec3 Transform::getPosition(bool previous)
 {
-	if (previous) return prevPosition;
-	else return position;
+	if (previous) return prevLocalPositions[id];
+	else return localPositions[id];
 }
 
 vec3 Transform::getRight(bool previous)
@@ -486,32 +641,36 @@ vec3 Transform::getForward(bool previous)
 
 vec3 Transform::getWorldPosition(bool previous)
 {
-	if (previous) return glm::vec3(glm::column(prevLocalToWorldMatrix, 3)); 
-	else return glm::vec3(glm::column(localToWorldMatrix, 3)); 
+	updateWorldMatrices();
+	if (previous) return glm::vec3(glm::column(transformStructs[id].localToWorldPrev, 3)); 
+	else return glm::vec3(glm::column(transformStructs[id].localToWorld, 3)); 
 }
 
 vec3 Transform::getWorldRight(bool previous)
 {
-	if (previous) return glm::normalize(glm::vec3(glm::column(prevLocalToWorldMatrix, 0))); 
-	else return glm::normalize(glm::vec3(glm::column(localToWorldMatrix, 0))); 
+	updateWorldMatrices();
+	if (previous) return glm::normalize(glm::vec3(glm::column(transformStructs[id].localToWorldPrev, 0))); 
+	else return glm::normalize(glm::vec3(glm::column(transformStructs[id].localToWorld, 0))); 
 }
 
 vec3 Transform::getWorldUp(bool previous)
 {
-	if (previous) return glm::normalize(glm::vec3(glm::column(prevLocalToWorldMatrix, 1))); 
-	else return glm::normalize(glm::vec3(glm::column(localToWorldMatrix, 1))); 
+	updateWorldMatrices();
+	if (previous) return glm::normalize(glm::vec3(glm::column(transformStructs[id].localToWorldPrev, 1))); 
+	else return glm::normalize(glm::vec3(glm::column(transformStructs[id].localToWorld, 1))); 
 }
 
 vec3 Transform::getWorldForward(bool previous)
 {
-	if (previous) return glm::normalize(glm::vec3(glm::column(prevLocalToWorldMatrix, 2))); 
-	else return glm::normalize(glm::vec3(glm::column(localToWorldMatrix, 2))); 
+	updateWorldMatrices();
+	if (previous) return glm::normalize(glm::vec3(glm::column(transformStructs[id].localToWorldPrev, 2))); 
+	else return glm::normalize(glm::vec3(glm::column(transformStructs[id].localToWorld, 2))); 
 }
 
 void Transform::setPosition(vec3 newPosition, bool previous)
 {
 	if (previous) useRelativeLinearMotionBlur = false;
-	auto &p = (previous) ? prevPosition : position;
+	auto &p = (previous) ? prevLocalPositions[id] : localPositions[id];
 	p = newPosition;
 	updatePosition();
 	markDirty();
@@ -598,14 +757,14 @@ void Transform::updatePosition()
 
 vec3 Transform::getScale(bool previous)
 {
-	if (previous) return prevScale;
-	else return scale;
+	if (previous) return prevLocalScales[id];
+	else return localScales[id];
 }
 
 void Transform::setScale(vec3 newScale, bool previous)
 {
 	if (previous) useRelativeScalarMotionBlur = false;
-	auto &s = (previous) ? prevScale : scale;
+	auto &s = (previous) ? prevLocalScales[id] : localScales[id];
 	s = newScale;
 	updateScale();
 	markDirty();
@@ -660,6 +819,12 @@ void Transform::updateScale()
 }
 
 void Transform::updateMatrix()
+{
+	updateLocalMatrices();
+	markDirty();
+}
+
+void Transform::updateLocalMatrices()
 {
 	localToParentMatrix = (localToParentTransform * getLocalToParentTranslationMatrix(false) * getLocalToParentRotationMatrix(false) * getLocalToParentScaleMatrix(false));
 	parentToLocalMatrix = (getParentToLocalScaleMatrix(false) * getParentToLocalRotationMatrix(false) * getParentToLocalTranslationMatrix(false) * glm::inverse(localToParentTransform));
@@ -676,19 +841,6 @@ void Transform::updateMatrix()
 	// prevUp = glm::vec3(prevLocalToParentMatrix[1]);
 	// prevForward = glm::vec3(prevLocalToParentMatrix[2]);
 	// prevPosition = glm::vec3(prevLocalToParentMatrix[3]);
-
-	updateChildren();
-	markDirty();
-}
-
-glm::mat4 Transform::computeWorldToLocalMatrix(bool previous)
-{
-	glm::mat4 parentMatrix = glm::mat4(1.0);
-	if (parent != -1) {
-		parentMatrix = transforms[parent].computeWorldToLocalMatrix(previous);
-		return getParentToLocalMatrix(previous) * parentMatrix;
-	}
-	else return getParentToLocalMatrix(previous);
 }
 
 // glm::mat4 Transform::computeNextWorldToLocalMatrix(bool previous)
@@ -703,33 +855,21 @@ glm::mat4 Transform::computeWorldToLocalMatrix(bool previous)
 
 void Transform::updateWorldMatrix()
 {
-	if (parent == -1) {
-		worldToLocalMatrix = parentToLocalMatrix;
-		localToWorldMatrix = localToParentMatrix;
-		prevWorldToLocalMatrix = prevParentToLocalMatrix;
-		prevLocalToWorldMatrix = prevLocalToParentMatrix;
-
-		// worldScale = scale;
-		// worldTranslation = position;
-		// worldRotation = rotation;
-		// worldSkew = glm::vec3(0.f, 0.f, 0.f);
-		// worldPerspective = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f); // not sure what this should default to...
-
-		// prevWorldScale = prevScale;
-		// prevWorldTranslation = prevPosition;
-		// prevWorldRotation = prevRotation;
-		// prevWorldSkew = glm::vec3(0.f, 0.f, 0.f);
-		// prevWorldPerspective = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f); // not sure what this should default to...
+	auto &transformStruct = transformStructs[id];
+	if ((parent < 0) || (parent >= transforms.size())) {
+		worldToLocalMatrices[id] = parentToLocalMatrix;
+		transformStruct.localToWorld = localToParentMatrix;
+		prevWorldToLocalMatrices[id] = prevParentToLocalMatrix;
+		transformStruct.localToWorldPrev = prevLocalToParentMatrix;
 	} else {
-		worldToLocalMatrix = computeWorldToLocalMatrix(/*previous=*/false);
-		prevWorldToLocalMatrix = computeWorldToLocalMatrix(/*previous=*/true);
-		localToWorldMatrix = glm::inverse(worldToLocalMatrix); 
-		prevLocalToWorldMatrix = glm::inverse(prevWorldToLocalMatrix); 
-		// glm::decompose(localToWorldMatrix, worldScale, worldRotation, worldTranslation, worldSkew, worldPerspective);
-		// glm::decompose(prevLocalToWorldMatrix, prevWorldScale, prevWorldRotation, prevWorldTranslation, prevWorldSkew, prevWorldPerspective);
-		// glm::decompose(nextLocalToWorldMatrix, worldScale, worldRotation, worldTranslation, worldSkew, worldPerspective);
+		// The parent's world matrices are already up to date, so compose with those 
+		// rather than walking up through every ancestor and inverting the result.
+		auto &parentStruct = transformStructs[parent];
+		worldToLocalMatrices[id] = parentToLocalMatrix * worldToLocalMatrices[parent];
+		prevWorldToLocalMatrices[id] = prevParentToLocalMatrix * prevWorldToLocalMatrices[parent];
+		transformStruct.localToWorld = parentStruct.localToWorld * localToParentMatrix;
+		transformStruct.localToWorldPrev = parentStruct.localToWorldPrev * prevLocalToParentMatrix;
 	}
-	markDirty();
 }
 
 glm::mat4 Transform::getParentToLocalMatrix(bool previous)
@@ -756,44 +896,44 @@ glm::mat4 Transform::getLocalToParentMatrix(bool previous)
 
 glm::mat4 Transform::getLocalToParentTranslationMatrix(bool previous)
 {
-	if ((previous) && (useRelativeLinearMotionBlur)) return glm::translate(glm::mat4(1.0), position - linearMotion);
-	else if (previous) return glm::translate(glm::mat4(1.0), prevPosition);
-	else return glm::translate(glm::mat4(1.0), position);
+	if ((previous) && (useRelativeLinearMotionBlur)) return glm::translate(glm::mat4(1.0), localPositions[id] - linearMotion);
+	else if (previous) return glm::translate(glm::mat4(1.0), prevLocalPositions[id]);
+	else return glm::translate(glm::mat4(1.0), localPositions[id]);
 }
 
 glm::mat4 Transform::getLocalToParentScaleMatrix(bool previous)
 {
-	if ((previous) && (useRelativeScalarMotionBlur)) return glm::scale(glm::mat4(1.0), scale - scalarMotion);
-	else if (previous) return glm::scale(glm::mat4(1.0), prevScale);
-	else return glm::scale(glm::mat4(1.0), scale);
+	if ((previous) && (useRelativeScalarMotionBlur)) return glm::scale(glm::mat4(1.0), localScales[id] - scalarMotion);
+	else if (previous) return glm::scale(glm::mat4(1.0), prevLocalScales[id]);
+	else return glm::scale(glm::mat4(1.0), localScales[id]);
 }
 
 glm::mat4 Transform::getLocalToParentRotationMatrix(bool previous)
 {
-	if ((previous) && (useRelativeAngularMotionBlur)) return glm::toMat4(angularMotion * rotation);
-	else if (previous) return glm::toMat4(prevRotation);
-	else return glm::toMat4(rotation);
+	if ((previous) && (useRelativeAngularMotionBlur)) return glm::toMat4(angularMotion * localRotations[id]);
+	else if (previous) return glm::toMat4(prevLocalRotations[id]);
+	else return glm::toMat4(localRotations[id]);
 }
 
 glm::mat4 Transform::getParentToLocalTranslationMatrix(bool previous)
 {
-	if ((previous) && (useRelativeLinearMotionBlur)) return glm::translate(glm::mat4(1.0), -(position - linearMotion));
-	else if (previous) return glm::translate(glm::mat4(1.0), -prevPosition);
-	else return glm::translate(glm::mat4(1.0), -position);
+	if ((previous) && (useRelativeLinearMotionBlur)) return glm::translate(glm::mat4(1.0), -(localPositions[id] - linearMotion));
+	else if (previous) return glm::translate(glm::mat4(1.0), -prevLocalPositions[id]);
+	else return glm::translate(glm::mat4(1.0), -localPositions[id]);
 }
 
 glm::mat4 Transform::getParentToLocalScaleMatrix(bool previous)
 {
-	if ((previous) && (useRelativeScalarMotionBlur)) return glm::scale(glm::mat4(1.0), glm::vec3(1.0 / (scale - scalarMotion).x, 1.0 / (scale - scalarMotion).y, 1.0 / (scale - scalarMotion).z));
-	else if (previous) return glm::scale(glm::mat4(1.0), glm::vec3(1.0 / prevScale.x, 1.0 / prevScale.y, 1.0 / prevScale.z));
-	else return glm::scale(glm::mat4(1.0), glm::vec3(1.0 / scale.x, 1.0 / scale.y, 1.0 / scale.z));
+	if ((previous) && (useRelativeScalarMotionBlur)) return glm::scale(glm::mat4(1.0), glm::vec3(1.0 / (localScales[id] - scalarMotion).x, 1.0 / (localScales[id] - scalarMotion).y, 1.0 / (localScales[id] - scalarMotion).z));
+	else if (previous) return glm::scale(glm::mat4(1.0), glm::vec3(1.0 / prevLocalScales[id].x, 1.0 / prevLocalScales[id].y, 1.0 / prevLocalScales[id].z));
+	else return glm::scale(glm::mat4(1.0), glm::vec3(1.0 / localScales[id].x, 1.0 / localScales[id].y, 1.0 / localScales[id].z));
 }
 
 glm::mat4 Transform::getParentToLocalRotationMatrix(bool previous)
 {
-	if ((previous) && (useRelativeAngularMotionBlur)) return glm::toMat4(glm::inverse(angularMotion * rotation));
-	else if (previous) return glm::toMat4(glm::inverse(prevRotation));
-	else return glm::toMat4(glm::inverse(rotation));
+	if ((previous) && (useRelativeAngularMotionBlur)) return glm::toMat4(glm::inverse(angularMotion * localRotations[id]));
+	else if (previous) return glm::toMat4(glm::inverse(prevLocalRotations[id]));
+	else return glm::toMat4(glm::inverse(localRotations[id]));
 }
 
 Transform* Transform::getParent() {
@@ -832,7 +972,6 @@ void Transform::setParent(Transform *parent) {
 
 	this->parent = parent->getId();
 	transforms[parent->getId()].children.insert(this->id);
-	updateChildren();
 	markDirty();
 }
 
@@ -845,7 +984,6 @@ void Transform::clearParent()
 	
 	transforms[parent].children.erase(this->id);
 	this->parent = -1;
-	updateChildren();
 	markDirty();
 }
 
@@ -874,18 +1012,19 @@ void Transform::removeChild(Transform *object) {
 
 	children.erase(object->getId());
 	transforms[object->getId()].parent = -1;
-	transforms[object->getId()].updateWorldMatrix();
 	transforms[object->getId()].markDirty();
 }
 
 glm::mat4 Transform::getWorldToLocalMatrix(bool previous) {
-	if (previous) return prevWorldToLocalMatrix;
-	else return worldToLocalMatrix;
+	updateWorldMatrices();
+	if (previous) return prevWorldToLocalMatrices[id];
+	else return worldToLocalMatrices[id];
 }
 
 glm::mat4 Transform::getLocalToWorldMatrix(bool previous) {
-	if (previous) return prevLocalToWorldMatrix;
-	else return localToWorldMatrix;
+	updateWorldMatrices();
+	if (previous) return transformStructs[id].localToWorldPrev;
+	else return transformStructs[id].localToWorld;
 }
 
 // glm::mat4 Transform::getNextWorldToLocalMatrix() {
@@ -951,17 +1090,6 @@ glm::mat4 Transform::getLocalToWorldMatrix(bool previous) {
 // }
 
 
-void Transform::updateChildren()
-{
-	for (auto &c : children) {
-		auto &t = transforms[c];
-		t.updateChildren();
-	}
-
-	updateWorldMatrix();
-	markDirty();
-}
-
 TransformStruct &Transform::getStruct()
 {
 	return transformStructs[id];
@@ -14,7 +14,7 @@ namespace nvisii {
 
 std::vector<Volume> Volume::volumes;
 std::vector<VolumeStruct> Volume::volumeStructs;
-std::map<std::string, uint32_t> Volume::lookupTable;
+LookupTable Volume::lookupTable;
 std::shared_ptr<std::recursive_mutex> Volume::editMutex;
 bool Volume::factoryInitialized = false;
 std::set<Volume*> Volume::dirtyVolumes;
@@ -307,7 +307,7 @@ int32_t Volume::getAddress()
 
 std::map<std::string, uint32_t> Volume::getNameToIdMap()
 {
-	return lookupTable;
+	return lookupTable.toMap();
 }
 
 std::string Volume::getGridType()
@@ -0,0 +1,52 @@
+#include <nvisii/entity.h>
+
+#include <string>
+#include <vector>
+
+#include "test_utils.h"
+
+using namespace nvisii;
+
+/* Measures the per operation cost of creating, finding and removing components through the
+   StaticFactory slot allocator and name index. Usage: bench_component_factory [count], where
+   count defaults to one million entities. */
+int main(int argc, char** argv)
+{
+    size_t count = getBenchSize(argc, argv, 1000000);
+    Entity::initializeFactory(uint32_t(count));
+
+    std::vector<std::string> names(count);
+    for (size_t i = 0; i < count; ++i) names[i] = "entity_" + std::to_string(i);
+    std::cout << "Components: " << count << std::endl;
+
+    BenchTimer timer;
+    for (size_t i = 0; i < count; ++i) Entity::create(names[i]);
+    reportBench("create", timer.seconds(), count);
+
+    timer.reset();
+    size_t found = 0;
+    for (size_t i = 0; i < count; ++i) found += (Entity::get(names[i]) != nullptr);
+    reportBench("get", timer.seconds(), count);
+    CHECK(found == count);
+
+    // Free every other slot, then fill the holes again, so that creation has to search for free ids
+    timer.reset();
+    for (size_t i = 0; i < count; i += 2) Entity::remove(names[i]);
+    for (size_t i = 0; i < count; i += 2) Entity::create(names[i]);
+    reportBench("remove + create, every other slot", timer.seconds(), count);
+
+    timer.reset();
+    for (size_t i = 0; i < count; ++i) Entity::remove(names[i]);
+    reportBench("remove", timer.seconds(), count);
+
+    timer.reset();
+    Entity::createMany(names);
+    reportBench("createMany", timer.seconds(), count);
+    CHECK(Entity::get(names[count - 1]) != nullptr);
+
+    // The table is full, so one more component must be rejected
+    CHECK_THROWS(Entity::create("one_too_many"));
+
+    Entity::clearAll();
+    return finishTest("bench_component_factory");
+}
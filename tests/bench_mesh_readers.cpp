@@ -0,0 +1,135 @@
+#include <nvisii/utilities/mesh_readers.h>
+
+#include <assimp/cimport.h>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "test_utils.h"
+
+/* Compares the native OBJ and PLY readers used by Mesh::createFromFile against the assimp import
+   they replaced, on a wavy grid written as OBJ, binary PLY and ASCII PLY. Usage: bench_mesh_readers
+   [triangles], where triangles defaults to eight million. The files are written to the working directory. */
+
+struct Grid {
+    std::vector<float> positions, texCoords;
+    std::vector<uint32_t> indices;
+};
+
+static Grid makeGrid(size_t numTriangles)
+{
+    uint32_t side = uint32_t(std::ceil(std::sqrt(double(numTriangles) / 2.0))) + 1;
+    Grid grid;
+    for (uint32_t y = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x) {
+            float u = float(x) / float(side - 1), v = float(y) / float(side - 1);
+            grid.positions.insert(grid.positions.end(), {u, v, 0.05f * std::sin(20.f * u) * std::cos(20.f * v)});
+            grid.texCoords.insert(grid.texCoords.end(), {u, v});
+        }
+    }
+    for (uint32_t y = 0; y + 1 < side; ++y) {
+        for (uint32_t x = 0; x + 1 < side; ++x) {
+            uint32_t i = y * side + x;
+            grid.indices.insert(grid.indices.end(), {i, i + 1, i + side + 1, i, i + side + 1, i + side});
+        }
+    }
+    return grid;
+}
+
+static void writeObj(const std::string &path, const Grid &grid)
+{
+    std::ofstream file(path);
+    char line[128];
+    for (size_t i = 0; i < grid.positions.size(); i += 3) {
+        snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", grid.positions[i], grid.positions[i + 1], grid.positions[i + 2]);
+        file << line;
+    }
+    for (size_t i = 0; i < grid.texCoords.size(); i += 2) {
+        snprintf(line, sizeof(line), "vt %.6f %.6f\n", grid.texCoords[i], grid.texCoords[i + 1]);
+        file << line;
+    }
+    for (size_t i = 0; i < grid.indices.size(); i += 3) {
+        uint32_t a = grid.indices[i] + 1, b = grid.indices[i + 1] + 1, c = grid.indices[i + 2] + 1;
+        file << "f " << a << "/" << a << " " << b << "/" << b << " " << c << "/" << c << "\n";
+    }
+}
+
+static void writePly(const std::string &path, const Grid &grid, bool binary)
+{
+    size_t numVertices = grid.positions.size() / 3, numFaces = grid.indices.size() / 3;
+    std::ofstream file(path, std::ios::binary);
+    file << "ply\nformat " << ((binary) ? "binary_little_endian" : "ascii") << " 1.0\n"
+        << "element vertex " << numVertices << "\nproperty float x\nproperty float y\nproperty float z\n"
+        << "property float u\nproperty float v\n"
+        << "element face " << numFaces << "\nproperty list uchar int vertex_indices\nend_header\n";
+    char line[128];
+    for (size_t v = 0; v < numVertices; ++v) {
+        float vertex[5] = {grid.positions[v * 3], grid.positions[v * 3 + 1], grid.positions[v * 3 + 2],
+            grid.texCoords[v * 2], grid.texCoords[v * 2 + 1]};
+        if (binary) file.write((const char*) vertex, sizeof(vertex));
+        else {
+            snprintf(line, sizeof(line), "%.6f %.6f %.6f %.6f %.6f\n", vertex[0], vertex[1], vertex[2], vertex[3], vertex[4]);
+            file << line;
+        }
+    }
+    for (size_t f = 0; f < numFaces; ++f) {
+        const uint32_t* face = &grid.indices[f * 3];
+        if (binary) {
+            uint8_t count = 3;
+            file.write((const char*) &count, 1);
+            file.write((const char*) face, 3 * sizeof(uint32_t));
+        }
+        else file << "3 " << face[0] << " " << face[1] << " " << face[2] << "\n";
+    }
+}
+
+/* Reads a file with both readers, and checks that they agree on the number of triangles */
+static void benchFile(const std::string &label, const std::string &path, size_t numTriangles)
+{
+    BenchTimer timer;
+    MeshReaders::MeshData mesh;
+    MeshReaders::read(path, mesh);
+    reportBench(label + ", native reader", timer.seconds(), numTriangles);
+    CHECK(mesh.triangleIndices.size() == numTriangles * 3);
+
+    // the same import Mesh::createFromFile uses for formats without a native reader
+    timer.reset();
+    const aiScene* scene = aiImportFile(path.c_str(),
+        aiProcessPreset_TargetRealtime_Fast | aiProcess_Triangulate | aiProcess_PreTransformVertices);
+    reportBench(label + ", assimp", timer.seconds(), numTriangles);
+    CHECK(scene != nullptr);
+    if (!scene) return;
+    size_t importedTriangles = 0;
+    for (uint32_t m = 0; m < scene->mNumMeshes; ++m) importedTriangles += scene->mMeshes[m]->mNumFaces;
+    CHECK(importedTriangles == numTriangles);
+    aiReleaseImport(scene);
+}
+
+int main(int argc, char** argv)
+{
+    size_t requested = getBenchSize(argc, argv, 8000000);
+    Grid grid = makeGrid(requested);
+    size_t numTriangles = grid.indices.size() / 3;
+    std::cout << "Triangles: " << numTriangles << ", vertices: " << (grid.positions.size() / 3) << std::endl;
+
+    const std::string obj = "bench_mesh_readers.obj";
+    const std::string binaryPly = "bench_mesh_readers_binary.ply";
+    const std::string asciiPly = "bench_mesh_readers_ascii.ply";
+    writeObj(obj, grid);
+    writePly(binaryPly, grid, true);
+    writePly(asciiPly, grid, false);
+
+    benchFile("OBJ", obj, numTriangles);
+    benchFile("binary PLY", binaryPly, numTriangles);
+    benchFile("ASCII PLY", asciiPly, numTriangles);
+
+    std::remove(obj.c_str());
+    std::remove(binaryPly.c_str());
+    std::remove(asciiPly.c_str());
+    return finishTest("bench_mesh_readers");
+}
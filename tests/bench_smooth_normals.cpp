@@ -0,0 +1,136 @@
+#include <nvisii/mesh.h>
+
+#include <glm/gtx/vector_angle.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "test_utils.h"
+
+using namespace nvisii;
+
+/* Compares Mesh::generateSmoothNormals and Mesh::generateSmoothTangents against the per vertex
+   list implementation they replaced, on a displaced grid. Usage: bench_smooth_normals [triangles],
+   where triangles defaults to five million. */
+
+/* The previous implementation, which kept one heap allocated list of weighted vectors per vertex. */
+static void referenceSmoothVectors(
+    const std::vector<std::array<float, 3>> &positions, const std::vector<glm::vec2> &texCoords,
+    const std::vector<uint32_t> &triangleIndices, bool tangents, std::vector<glm::vec4> &output)
+{
+    auto compute_tangent = [] (
+        glm::vec3 A, glm::vec3 B, glm::vec3 C,
+        glm::vec2 H, glm::vec2 K, glm::vec2 L) -> glm::vec3
+    {
+        glm::vec3 D = B-A;
+        glm::vec3 E = C-A;
+        glm::vec2 F = K-H;
+        glm::vec2 G = L-H;
+        float f = 1.0f / (F.s * G.t - G.s * F.t);
+        glm::vec3 T;
+        T.x = f * (D.x * G.t - F.t * E.x);
+        T.y = f * (D.y * G.t - F.t * E.y);
+        T.z = f * (D.z * G.t - F.t * E.z);
+        return glm::normalize(T);
+    };
+
+    std::vector<std::vector<glm::vec4>> weighted(positions.size());
+    for (uint32_t f = 0; f < triangleIndices.size(); f += 3)
+    {
+        uint32_t i1 = triangleIndices[f + 0];
+        uint32_t i2 = triangleIndices[f + 1];
+        uint32_t i3 = triangleIndices[f + 2];
+        auto p1 = glm::vec3(positions[i1][0], positions[i1][1], positions[i1][2]);
+        auto p2 = glm::vec3(positions[i2][0], positions[i2][1], positions[i2][2]);
+        auto p3 = glm::vec3(positions[i3][0], positions[i3][1], positions[i3][2]);
+
+        auto n = (tangents)
+            ? compute_tangent(p1, p2, p3, texCoords[i1], texCoords[i2], texCoords[i3])
+            : glm::cross((p2 - p1), (p3 - p1));
+
+        auto a1 = glm::angle(glm::normalize(p2 - p1), glm::normalize(p3 - p1));
+        auto a2 = glm::angle(glm::normalize(p3 - p2), glm::normalize(p1 - p2));
+        auto a3 = glm::angle(glm::normalize(p1 - p3), glm::normalize(p2 - p3));
+
+        auto wn1 = n * a1;
+        auto wn2 = n * a2;
+        auto wn3 = n * a3;
+        weighted[i1].push_back(glm::vec4(wn1.x, wn1.y, wn1.z, 0.f));
+        weighted[i2].push_back(glm::vec4(wn2.x, wn2.y, wn2.z, 0.f));
+        weighted[i3].push_back(glm::vec4(wn3.x, wn3.y, wn3.z, 0.f));
+    }
+    output.resize(positions.size());
+    for (uint32_t v = 0; v < weighted.size(); v++)
+    {
+        glm::vec4 N = glm::vec4(0.0);
+        for (uint32_t n = 0; n < weighted[v].size(); n++) N += weighted[v][n];
+        output[v] = glm::normalize(glm::vec4(N.x, N.y, N.z, 0.0f));
+    }
+}
+
+/* Returns the largest angle, in degrees, between corresponding vectors of two lists */
+static double maxAngleDifference(const std::vector<glm::vec4> &a, const std::vector<glm::vec4> &b)
+{
+    double minDot = 1.0;
+    for (size_t i = 0; i < a.size(); ++i) minDot = std::min(minDot, double(glm::dot(a[i], b[i])));
+    return std::acos(std::max(-1.0, minDot)) * 180.0 / 3.14159265358979;
+}
+
+int main(int argc, char** argv)
+{
+    size_t numTriangles = getBenchSize(argc, argv, 5000000);
+    uint32_t side = uint32_t(std::ceil(std::sqrt(double(numTriangles) / 2.0))) + 1;
+
+    // A gently displaced grid, so that neighboring faces disagree and the weighting matters
+    std::vector<float> positions, texcoords;
+    std::vector<uint32_t> indices;
+    positions.reserve(size_t(side) * side * 3);
+    texcoords.reserve(size_t(side) * side * 2);
+    for (uint32_t y = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x) {
+            float u = float(x) / float(side - 1), v = float(y) / float(side - 1);
+            positions.insert(positions.end(), {u, v, 0.05f * std::sin(40.f * u) * std::cos(30.f * v)});
+            texcoords.insert(texcoords.end(), {u, v});
+        }
+    }
+    indices.reserve(size_t(side - 1) * (side - 1) * 6);
+    for (uint32_t y = 0; y + 1 < side; ++y) {
+        for (uint32_t x = 0; x + 1 < side; ++x) {
+            uint32_t i = y * side + x;
+            indices.insert(indices.end(), {i, i + 1, i + side, i + 1, i + side + 1, i + side});
+        }
+    }
+    size_t count = indices.size() / 3;
+    std::cout << "Triangles: " << count << ", vertices: " << (positions.size() / 3) << std::endl;
+
+    Mesh::initializeFactory(1);
+    Mesh* mesh = Mesh::createFromData("grid", positions, 3, {}, 3, {}, 3, {}, 4, texcoords, 2, indices);
+
+    std::vector<glm::vec4> referenceNormals, referenceTangents;
+    BenchTimer timer;
+    referenceSmoothVectors(mesh->getVertices(), mesh->getTexCoords(), mesh->getTriangleIndices(), false, referenceNormals);
+    reportBench("normals, per vertex lists", timer.seconds(), count);
+
+    timer.reset();
+    mesh->generateSmoothNormals();
+    reportBench("normals, Mesh::generateSmoothNormals", timer.seconds(), count);
+
+    timer.reset();
+    referenceSmoothVectors(mesh->getVertices(), mesh->getTexCoords(), mesh->getTriangleIndices(), true, referenceTangents);
+    reportBench("tangents, per vertex lists", timer.seconds(), count);
+
+    timer.reset();
+    mesh->generateSmoothTangents();
+    reportBench("tangents, Mesh::generateSmoothTangents", timer.seconds(), count);
+
+    // The approximate acos used for the weights is accurate to about 7e-5 radians
+    double normalError = maxAngleDifference(mesh->getNormals(), referenceNormals);
+    double tangentError = maxAngleDifference(mesh->getTangents(), referenceTangents);
+    std::cout << "max difference: normals " << normalError << " degrees, tangents " << tangentError << " degrees" << std::endl;
+    CHECK(normalError < 0.05);
+    CHECK(tangentError < 0.05);
+
+    Mesh::remove("grid");
+    return finishTest("bench_smooth_normals");
+}
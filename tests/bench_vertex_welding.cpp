@@ -0,0 +1,120 @@
+#include <nvisii/mesh.h>
+#include <nvisii/utilities/hash_combiner.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include "test_utils.h"
+
+using namespace nvisii;
+
+/* Compares the vertex welding done by Mesh::createFromData, when no indices are given, against
+   the unordered_map of array of structure vertices it replaced, on a triangle soup where every
+   triangle has its own three vertices. Usage: bench_vertex_welding [vertices], where vertices
+   defaults to ten million. */
+
+/* The vertex layout and hash previously used for welding */
+struct ReferenceVertex {
+    glm::vec4 point = glm::vec4(0.0);
+    glm::vec4 color = glm::vec4(1, 0, 1, 1);
+    glm::vec4 normal = glm::vec4(0.0);
+    glm::vec4 tangent = glm::vec4(0.0);
+    glm::vec2 texcoord = glm::vec2(0.0);
+
+    bool operator==(const ReferenceVertex &other) const
+    {
+        return (point == other.point && color == other.color && normal == other.normal && texcoord == other.texcoord);
+    }
+};
+
+struct ReferenceVertexHash {
+    size_t operator()(const ReferenceVertex &k) const
+    {
+        std::size_t h = 0;
+        hash_combine(h, k.point.x, k.point.y, k.point.z,
+                     k.color.x, k.color.y, k.color.z, k.color.a,
+                     k.normal.x, k.normal.y, k.normal.z,
+                     k.tangent.x, k.tangent.y, k.tangent.z,
+                     k.texcoord.x, k.texcoord.y);
+        return h;
+    }
+};
+
+/* The previous implementation: build array of structure vertices, then bin them through an unreserved map */
+static size_t referenceWeld(const std::vector<float> &positions, const std::vector<float> &normals,
+    const std::vector<float> &texcoords, std::vector<uint32_t> &indices)
+{
+    std::vector<ReferenceVertex> vertices;
+    for (size_t i = 0; i < positions.size() / 3; ++i) {
+        ReferenceVertex vertex;
+        vertex.point = glm::vec4(positions[i * 3 + 0], positions[i * 3 + 1], positions[i * 3 + 2], 1.f);
+        vertex.normal = glm::vec4(normals[i * 3 + 0], normals[i * 3 + 1], normals[i * 3 + 2], 0.f);
+        vertex.texcoord = glm::vec2(texcoords[i * 2 + 0], texcoords[i * 2 + 1]);
+        vertices.push_back(vertex);
+    }
+
+    std::unordered_map<ReferenceVertex, uint32_t, ReferenceVertexHash> uniqueVertexMap;
+    std::vector<ReferenceVertex> uniqueVertices;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const ReferenceVertex &vertex = vertices[i];
+        if (uniqueVertexMap.count(vertex) == 0) {
+            uniqueVertexMap[vertex] = static_cast<uint32_t>(uniqueVertices.size());
+            uniqueVertices.push_back(vertex);
+        }
+        indices.push_back(uniqueVertexMap[vertex]);
+    }
+    return uniqueVertices.size();
+}
+
+int main(int argc, char** argv)
+{
+    size_t numVertices = getBenchSize(argc, argv, 10000000);
+    size_t numTriangles = std::max(numVertices / 3, size_t(2));
+    uint32_t side = uint32_t(std::ceil(std::sqrt(double(numTriangles) / 2.0))) + 1;
+
+    // A triangle soup cut from a grid, so that each grid point is shared by up to six triangles. 
+    // Grid points are spaced much further apart than the weld epsilon used below.
+    std::vector<float> positions, normals, tangents, texcoords;
+    auto addVertex = [&] (uint32_t x, uint32_t y) {
+        float u = float(x) * 1e-3f, v = float(y) * 1e-3f;
+        positions.insert(positions.end(), {u, v, 0.f});
+        normals.insert(normals.end(), {0.f, 0.f, 1.f});
+        tangents.insert(tangents.end(), {1.f, 0.f, 0.f});
+        texcoords.insert(texcoords.end(), {u, v});
+    };
+    for (uint32_t y = 0; y + 1 < side && positions.size() / 9 < numTriangles; ++y) {
+        for (uint32_t x = 0; x + 1 < side && positions.size() / 9 < numTriangles; ++x) {
+            addVertex(x, y); addVertex(x + 1, y); addVertex(x, y + 1);
+            addVertex(x + 1, y); addVertex(x + 1, y + 1); addVertex(x, y + 1);
+        }
+    }
+    size_t count = positions.size() / 3;
+    std::cout << "Vertices: " << count << std::endl;
+
+    BenchTimer timer;
+    std::vector<uint32_t> referenceIndices;
+    size_t referenceUnique = referenceWeld(positions, normals, texcoords, referenceIndices);
+    reportBench("weld, unordered_map of vertices", timer.seconds(), count);
+
+    Mesh::initializeFactory(2);
+    timer.reset();
+    Mesh* exact = Mesh::createFromData("exact", positions, 3, normals, 3, tangents, 3, {}, 4, texcoords, 2);
+    reportBench("weld, Mesh::createFromData", timer.seconds(), count);
+
+    // Nudge every position by much less than the weld epsilon, so that only the epsilon weld merges them
+    for (size_t i = 0; i < positions.size(); ++i) positions[i] += float(int(i % 7) - 3) * 1e-7f;
+    timer.reset();
+    Mesh* nearby = Mesh::createFromData("nearby", positions, 3, normals, 3, tangents, 3, {}, 4, texcoords, 2, {}, 1e-5f);
+    reportBench("weld, Mesh::createFromData with weld_epsilon", timer.seconds(), count);
+
+    std::cout << "unique vertices: " << exact->getVertices().size() << std::endl;
+    CHECK(exact->getVertices().size() == referenceUnique);
+    CHECK(exact->getTriangleIndices().size() == referenceIndices.size());
+    CHECK(nearby->getVertices().size() == referenceUnique);
+
+    Mesh::remove("exact");
+    Mesh::remove("nearby");
+    return finishTest("bench_vertex_welding");
+}
@@ -0,0 +1,152 @@
+#include <nvisii/utilities/environment_sampling.h>
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#include "test_utils.h"
+
+/* Tests that the dome light sampling tables describe a proper density over the sphere, and that
+   the alias table picks each cell as often as the CDFs do. */
+
+/* Returns width * height RGBA texels, each set to the luminance returned by f(x, y) */
+template<class F>
+static std::vector<float> makeMap(uint32_t width, uint32_t height, F f)
+{
+    std::vector<float> texels(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            float l = f(x, y);
+            float* texel = &texels[(size_t(y) * width + x) * 4];
+            texel[0] = texel[1] = texel[2] = l;
+            texel[3] = 1.f;
+        }
+    }
+    return texels;
+}
+
+/* Integrates getEnvironmentPdf over the sphere with the midpoint rule, where dw = 2 pi^2 sin(theta) du dv */
+static double integratePdf(const EnvironmentSampling &sampling, uint32_t steps)
+{
+    const double pi = ENVIRONMENT_SAMPLING_PI;
+    double du = 1.0 / (2 * steps), dv = 1.0 / steps;
+    double integral = 0.0;
+    for (uint32_t j = 0; j < steps; ++j) {
+        double v = (j + .5) * dv;
+        double jacobian = 2.0 * pi * pi * std::sin(pi * v);
+        for (uint32_t i = 0; i < 2 * steps; ++i) {
+            double u = (i + .5) * du;
+            integral += getEnvironmentPdf(sampling, float(u), float(v)) * jacobian * du * dv;
+        }
+    }
+    return integral;
+}
+
+/* Checks that the cells sum to one, and that the alias table gives each cell its probability */
+static void checkCells(const EnvironmentSampling &sampling)
+{
+    size_t count = size_t(sampling.width) * sampling.height;
+    std::vector<float> probabilities(count);
+    double total = 0.0;
+    for (uint32_t y = 0; y < sampling.height; ++y) {
+        for (uint32_t x = 0; x < sampling.width; ++x) {
+            float p = getEnvironmentCellProbability(sampling, x, y);
+            CHECK(p >= 0.f);
+            probabilities[size_t(y) * sampling.width + x] = p;
+            total += p;
+        }
+    }
+    CHECK_NEAR(total, 1.0, 1e-4);
+
+    if (sampling.aliasTable.empty()) return;
+    CHECK(sampling.aliasTable.size() == count);
+    std::vector<double> mass(count, 0.0);
+    for (size_t i = 0; i < count; ++i) {
+        const EnvironmentAliasStruct &entry = sampling.aliasTable[i];
+        CHECK(entry.alias < count);
+        CHECK(entry.probability >= 0.f && entry.probability <= 1.f);
+        CHECK_NEAR(entry.cellProbability, probabilities[i], 1e-6f);
+        mass[i] += double(entry.probability) / count;
+        mass[entry.alias] += (1.0 - entry.probability) / count;
+    }
+    for (size_t i = 0; i < count; ++i) CHECK_NEAR(mass[i], probabilities[i], 1e-5);
+}
+
+static void testUniformMap()
+{
+    auto texels = makeMap(64, 32, [] (uint32_t, uint32_t) { return 1.f; });
+    EnvironmentSampling sampling = buildEnvironmentSampling(texels.data(), 64, 32, 0, true);
+    CHECK(sampling.width == 64 && sampling.height == 32);
+    CHECK_NEAR(integratePdf(sampling, 256), 1.0, 1e-3);
+    checkCells(sampling);
+
+    // A constant map is sampled uniformly over the sphere
+    CHECK_NEAR(getEnvironmentPdf(sampling, .3f, .5f), 1.f / (4.f * float(ENVIRONMENT_SAMPLING_PI)), 1e-3f);
+}
+
+static void testHotSpot()
+{
+    auto texels = makeMap(128, 64, [] (uint32_t x, uint32_t y) {
+        return (x >= 40 && x < 44 && y >= 20 && y < 23) ? 1000.f : .1f;
+    });
+    EnvironmentSampling sampling = buildEnvironmentSampling(texels.data(), 128, 64, 0, true);
+    CHECK_NEAR(integratePdf(sampling, 512), 1.0, 1e-3);
+    checkCells(sampling);
+    CHECK(getEnvironmentPdf(sampling, 41.5f / 128, 21.5f / 64) > getEnvironmentPdf(sampling, .9f, 21.5f / 64));
+}
+
+static void testCoarseGrid()
+{
+    // Odd sizes, so that grid cells cover uneven numbers of texels
+    auto texels = makeMap(203, 101, [] (uint32_t x, uint32_t y) { return float((x * 7 + y * 13) % 17); });
+    EnvironmentSampling sampling = buildEnvironmentSampling(texels.data(), 203, 101, 32, true);
+    CHECK(sampling.width == 32);
+    CHECK(sampling.height == 15);
+    CHECK_NEAR(integratePdf(sampling, 15 * 32), 1.0, 1e-3); // steps aligned with the cell edges
+    checkCells(sampling);
+}
+
+static void testEmptyMaps()
+{
+    // Maps with no energy to sample, including negative and NaN texels, fall back to uniform sampling
+    auto black = makeMap(16, 8, [] (uint32_t, uint32_t) { return 0.f; });
+    CHECK(buildEnvironmentSampling(black.data(), 16, 8).width == 0);
+    auto invalid = makeMap(16, 8, [] (uint32_t x, uint32_t) { return (x % 2) ? -1.f : std::nanf(""); });
+    CHECK(buildEnvironmentSampling(invalid.data(), 16, 8, 0, true).width == 0);
+    CHECK(getEnvironmentPdf(EnvironmentSampling(), .5f, .5f) == 0.f);
+    CHECK(buildEnvironmentSampling(nullptr, 16, 8).width == 0);
+}
+
+static void testCancelled()
+{
+    auto texels = makeMap(64, 32, [] (uint32_t, uint32_t) { return 1.f; });
+    std::atomic<bool> cancelled(true);
+    EnvironmentSampling sampling = buildEnvironmentSampling(texels.data(), 64, 32, 0, true, &cancelled);
+    CHECK(sampling.width == 0);
+    CHECK(sampling.aliasTable.empty());
+}
+
+static void testAliasTable()
+{
+    std::vector<float> probabilities = {.5f, .25f, .125f, .125f, 0.f};
+    auto table = buildAliasTable(probabilities);
+    CHECK(table.size() == probabilities.size());
+    std::vector<double> mass(table.size(), 0.0);
+    for (size_t i = 0; i < table.size(); ++i) {
+        mass[i] += double(table[i].probability) / table.size();
+        mass[table[i].alias] += (1.0 - table[i].probability) / table.size();
+    }
+    for (size_t i = 0; i < table.size(); ++i) CHECK_NEAR(mass[i], probabilities[i], 1e-6);
+    CHECK(table[4].probability == 0.f);
+}
+
+int main()
+{
+    testUniformMap();
+    testHotSpot();
+    testCoarseGrid();
+    testEmptyMaps();
+    testCancelled();
+    testAliasTable();
+    return finishTest("test_environment_sampling");
+}
@@ -0,0 +1,175 @@
+#include <nvisii/utilities/instance_update.h>
+
+#include <map>
+#include <vector>
+
+#include "test_utils.h"
+
+/* Tests the refit or rebuild decisions for the instance acceleration structure against a
+   mock backend, which records what would have been sent to the ray tracing API. */
+
+struct MockTransform { float m[12]; };
+
+struct MockGroup {
+    std::vector<int> children;
+    size_t numInstances = 0;
+    int builds = 0;
+    int refits = 0;
+};
+
+/* Group handles are ints, where 0 is "no group". Like owl, released handles can be handed out again. */
+struct MockBackend {
+    std::map<int, MockGroup> groups;
+    std::vector<int> freeHandles;
+    int nextHandle = 1;
+    int commits = 0;
+    int releases = 0;
+
+    int create(size_t count)
+    {
+        int handle = nextHandle;
+        if (!freeHandles.empty()) { handle = freeHandles.back(); freeHandles.pop_back(); }
+        else nextHandle++;
+        groups[handle] = MockGroup();
+        groups[handle].children.resize(count, 0);
+        return handle;
+    }
+    void setChild(int group, size_t index, int child) { groups.at(group).children.at(index) = child; }
+    void setInstances(int group, const std::vector<MockTransform> &t0, const std::vector<MockTransform> &t1,
+        const InstanceLayout<int> &layout)
+    {
+        CHECK(t0.size() == layout.size());
+        CHECK(t1.size() == layout.size());
+        groups.at(group).numInstances = layout.size();
+    }
+    void build(int group) { groups.at(group).builds++; }
+    void refit(int group) { groups.at(group).refits++; }
+    void release(int group) { groups.erase(group); freeHandles.push_back(group); releases++; }
+    void commit(int) { commits++; }
+};
+
+/* Fills a layout with one instance per child */
+static void fillLayout(InstanceLayout<int> &layout, std::vector<int> children, uint8_t mask = 0xFF)
+{
+    layout.clear();
+    for (size_t i = 0; i < children.size(); ++i) {
+        layout.children.push_back(children[i]);
+        layout.masks.push_back(mask);
+        layout.instanceToEntity.push_back(uint32_t(i));
+    }
+}
+
+static void testChooseInstanceUpdate()
+{
+    InstanceLayout<int> a, b;
+    fillLayout(a, {1, 2, 3});
+    fillLayout(b, {1, 2, 3});
+    CHECK(chooseInstanceUpdate(a, b, true, false, true, 0, 8) == InstanceUpdate::Refit);
+    CHECK(chooseInstanceUpdate(a, b, false, false, true, 0, 8) == InstanceUpdate::Rebuild);
+    CHECK(chooseInstanceUpdate(a, b, true, true, true, 0, 8) == InstanceUpdate::Rebuild);
+    CHECK(chooseInstanceUpdate(a, b, true, false, false, 0, 8) == InstanceUpdate::Rebuild);
+    CHECK(chooseInstanceUpdate(a, b, true, false, true, 8, 8) == InstanceUpdate::Rebuild);
+
+    fillLayout(b, {1, 2, 4});
+    CHECK(chooseInstanceUpdate(a, b, true, false, true, 0, 8) == InstanceUpdate::Rebuild);
+    fillLayout(b, {1, 2, 3}, 0x01);
+    CHECK(chooseInstanceUpdate(a, b, true, false, true, 0, 8) == InstanceUpdate::Rebuild);
+    fillLayout(b, {1, 2, 3});
+    b.instanceToEntity[2] = 7;
+    CHECK(chooseInstanceUpdate(a, b, true, false, true, 0, 8) == InstanceUpdate::Rebuild);
+
+    InstanceLayout<int> empty;
+    CHECK(chooseInstanceUpdate(empty, empty, true, false, true, 0, 8) == InstanceUpdate::Rebuild);
+}
+
+static void testRefitAndRebuild()
+{
+    MockBackend backend;
+    InstanceAccelState<int, int> state;
+    state.setRefitEnabled(true);
+    state.setMaxRefits(2);
+    std::vector<MockTransform> t(3);
+    const int placeholder = 100;
+
+    // The first update always builds
+    fillLayout(state.getPendingLayout(), {10, 11, 12});
+    CHECK(state.update(backend, t, t, placeholder) == InstanceUpdate::Rebuild);
+    int group = state.getGroup();
+    CHECK(backend.groups.at(group).children == std::vector<int>({10, 11, 12}));
+    CHECK(backend.groups.at(group).builds == 1);
+    CHECK(backend.commits == 1);
+
+    // Transform only edits refit the same group, without rebuilding the SBT
+    fillLayout(state.getPendingLayout(), {10, 11, 12});
+    CHECK(state.update(backend, t, t, placeholder) == InstanceUpdate::Refit);
+    fillLayout(state.getPendingLayout(), {10, 11, 12});
+    CHECK(state.update(backend, t, t, placeholder) == InstanceUpdate::Refit);
+    CHECK(state.getGroup() == group);
+    CHECK(backend.groups.at(group).refits == 2);
+    CHECK(backend.commits == 1);
+
+    // After maxRefits refits, a rebuild is forced, and the old group is released
+    fillLayout(state.getPendingLayout(), {10, 11, 12});
+    CHECK(state.update(backend, t, t, placeholder) == InstanceUpdate::Rebuild);
+    CHECK(backend.commits == 2);
+    CHECK(backend.releases == 1);
+    CHECK(backend.groups.size() == 1);
+
+    // Changing a child rebuilds
+    fillLayout(state.getPendingLayout(), {10, 11, 13});
+    CHECK(state.update(backend, t, t, placeholder) == InstanceUpdate::Rebuild);
+    CHECK(backend.groups.at(state.getGroup()).children == std::vector<int>({10, 11, 13}));
+
+    // An empty layout instances the placeholder
+    std::vector<MockTransform> none;
+    state.getPendingLayout().clear();
+    CHECK(state.update(backend, none, none, placeholder) == InstanceUpdate::Rebuild);
+    CHECK(backend.groups.at(state.getGroup()).children == std::vector<int>({placeholder}));
+    state.getPendingLayout().clear();
+    CHECK(state.update(backend, none, none, placeholder) == InstanceUpdate::Rebuild);
+}
+
+static void testRecreatedChildren()
+{
+    MockBackend backend;
+    InstanceAccelState<int, int> state;
+    state.setRefitEnabled(true);
+    std::vector<MockTransform> t(2);
+
+    fillLayout(state.getPendingLayout(), {10, 11});
+    CHECK(state.update(backend, t, t, 0) == InstanceUpdate::Rebuild);
+
+    // A child was released and recreated with the same handle. The layout is identical,
+    // but the geometry behind it is not, so the group and SBT must be rebuilt.
+    state.invalidateChildren();
+    fillLayout(state.getPendingLayout(), {10, 11});
+    CHECK(state.update(backend, t, t, 0) == InstanceUpdate::Rebuild);
+    CHECK(backend.commits == 2);
+
+    // Once rebuilt, transform only edits refit again
+    fillLayout(state.getPendingLayout(), {10, 11});
+    CHECK(state.update(backend, t, t, 0) == InstanceUpdate::Refit);
+    CHECK(backend.commits == 2);
+}
+
+static void testRefitDisabled()
+{
+    MockBackend backend;
+    InstanceAccelState<int, int> state;
+    std::vector<MockTransform> t(1);
+    for (int i = 0; i < 3; ++i) {
+        fillLayout(state.getPendingLayout(), {10});
+        CHECK(state.update(backend, t, t, 0) == InstanceUpdate::Rebuild);
+    }
+    CHECK(backend.commits == 3);
+    CHECK(backend.releases == 2);
+}
+
+int main()
+{
+    testChooseInstanceUpdate();
+    testRefitAndRebuild();
+    testRecreatedChildren();
+    testRefitDisabled();
+    return finishTest("test_instance_update");
+}
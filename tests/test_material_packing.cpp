@@ -0,0 +1,131 @@
+#include <nvisii/material.h>
+#include <nvisii/texture.h>
+
+#include <vector>
+
+#include "test_utils.h"
+
+using namespace nvisii;
+
+/* Tests how Material setters pack constants and texture bindings into MaterialStruct, which is
+   copied as is to the device. */
+
+static void testDefaults()
+{
+    Material* mat = Material::create("defaults");
+    const MaterialStruct &s = mat->getStruct();
+    CHECK_NEAR(s.base_color.r, .8f, 1e-6f);
+    CHECK_NEAR(s.base_color.a, 1.f, 1e-6f);
+    CHECK_NEAR(s.roughness, .5f, 1e-6f);
+    CHECK_NEAR(s.specular, .5f, 1e-6f);
+    CHECK_NEAR(s.sheen_tint, .5f, 1e-6f);
+    CHECK_NEAR(s.clearcoat_roughness, .03f, 1e-6f);
+    CHECK_NEAR(s.ior, 1.45f, 1e-6f);
+    CHECK_NEAR(s.subsurface_radius.g, .2f, 1e-6f);
+    CHECK(s.base_color_texture_id == -1);
+    CHECK(s.roughness_texture_id == -1);
+    CHECK(s.transmission_roughness_texture_id == -1);
+    CHECK(s.sheen_tint_texture_id == -1);
+    Material::remove("defaults");
+}
+
+static void testConstants()
+{
+    Material* mat = Material::create("constants");
+    mat->setBaseColor(glm::vec3(.1f, .2f, .3f));
+    mat->setAlpha(.4f);
+    mat->setRoughness(.25f);
+    mat->setMetallic(.75f);
+    mat->setTransmission(.6f);
+    mat->setIor(1.33f);
+    mat->setSubsurfaceRadius(glm::vec3(3.f, 2.f, 1.f));
+    const MaterialStruct &s = mat->getStruct();
+    CHECK_NEAR(s.base_color.r, .1f, 1e-6f);
+    CHECK_NEAR(s.base_color.g, .2f, 1e-6f);
+    CHECK_NEAR(s.base_color.b, .3f, 1e-6f);
+    CHECK_NEAR(s.base_color.a, .4f, 1e-6f);
+    CHECK_NEAR(s.roughness, .25f, 1e-6f);
+    CHECK_NEAR(s.metallic, .75f, 1e-6f);
+    CHECK_NEAR(s.transmission, .6f, 1e-6f);
+    CHECK_NEAR(s.ior, 1.33f, 1e-6f);
+    CHECK_NEAR(s.subsurface_radius.x, 3.f, 1e-6f);
+    CHECK_NEAR(mat->getRoughness(), .25f, 1e-6f);
+    CHECK_NEAR(mat->getAlpha(), .4f, 1e-6f);
+    Material::remove("constants");
+}
+
+static void testTextures()
+{
+    std::vector<float> texel = {1.f, .5f, .25f, 1.f};
+    Texture* texture = Texture::createFromData("texture", 1, 1, texel.data(), uint32_t(texel.size()));
+    Material* mat = Material::create("textured");
+
+    mat->setBaseColorTexture(texture);
+    mat->setRoughnessTexture(texture, 2);
+    mat->setMetallicTexture(texture, 9);
+    const MaterialStruct &s = mat->getStruct();
+    CHECK(s.base_color_texture_id == texture->getId());
+    CHECK(s.roughness_texture_id == texture->getId());
+    CHECK(s.roughness_texture_channel == 2);
+    CHECK(s.metallic_texture_channel == 3); // channels are clamped to [0, 3]
+
+    // Binding a texture leaves the constant in place, as the fallback once the texture is cleared
+    mat->setRoughness(.125f);
+    mat->clearRoughnessTexture();
+    CHECK(s.roughness_texture_id == -1);
+    CHECK_NEAR(s.roughness, .125f, 1e-6f);
+    mat->clearBaseColorTexture();
+    CHECK(s.base_color_texture_id == -1);
+    CHECK(s.metallic_texture_id == texture->getId());
+
+    // A material created in a freed slot must not inherit the previous material's bindings
+    int32_t id = mat->getId();
+    Material::remove("textured");
+    Material* reused = Material::create("reused");
+    CHECK(reused->getId() == id);
+    CHECK(reused->getStruct().metallic_texture_id == -1);
+    CHECK(reused->getStruct().metallic_texture_channel == MaterialStruct().metallic_texture_channel);
+    Material::remove("reused");
+    Texture::remove("texture");
+}
+
+static void testRemoved()
+{
+    // Constants live in the struct table, so a removed material has none to read or write
+    Material* mat = Material::create("removed");
+    Material::remove("removed");
+    CHECK(!mat->isInitialized());
+    CHECK_THROWS(mat->getStruct());
+    CHECK_THROWS(mat->getRoughness());
+    CHECK_THROWS(mat->getBaseColor());
+    CHECK_THROWS(mat->setMetallic(.5f));
+}
+
+static void testCreateMany()
+{
+    std::vector<Material*> mats = Material::createMany({"a", "b"}, {.1f, .2f, .3f, .4f, .5f, .6f}, {.9f}, {});
+    CHECK(mats.size() == 2);
+    CHECK_NEAR(mats[0]->getStruct().base_color.r, .1f, 1e-6f);
+    CHECK_NEAR(mats[1]->getStruct().base_color.b, .6f, 1e-6f);
+    CHECK_NEAR(mats[0]->getStruct().roughness, .9f, 1e-6f);
+    CHECK_NEAR(mats[1]->getStruct().roughness, .9f, 1e-6f);
+    CHECK_NEAR(mats[1]->getStruct().metallic, 0.f, 1e-6f);
+
+    // A malformed list is rejected before anything is created
+    CHECK_THROWS((Material::createMany({"c", "d"}, {.1f, .2f})));
+    CHECK(Material::get("c") == nullptr);
+    Material::remove("a");
+    Material::remove("b");
+}
+
+int main()
+{
+    Material::initializeFactory(4);
+    Texture::initializeFactory(4);
+    testDefaults();
+    testConstants();
+    testTextures();
+    testRemoved();
+    testCreateMany();
+    return finishTest("test_material_packing");
+}
@@ -0,0 +1,119 @@
+#include <nvisii/utilities/mesh_readers.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "test_utils.h"
+
+/* Tests the native OBJ and PLY readers on small files, in particular ASCII PLY files whose rows
+   don't follow the one row per line layout most writers use. */
+
+static void writeFile(const std::string &path, const std::string &text)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+}
+
+static std::string asciiPlyHeader(size_t numVertices, size_t numFaces)
+{
+    return "ply\nformat ascii 1.0\n"
+        "element vertex " + std::to_string(numVertices) + "\nproperty float x\nproperty float y\nproperty float z\n"
+        "element face " + std::to_string(numFaces) + "\nproperty list uchar int vertex_indices\nend_header\n";
+}
+
+/* Checks that a mesh is the unit square made of triangles (0, 1, 2) and (0, 2, 3) */
+static void checkSquare(const MeshReaders::MeshData &mesh)
+{
+    CHECK(mesh.positions.size() == 4);
+    if (mesh.positions.size() != 4) return;
+    CHECK(mesh.positions[1][0] == 1.f && mesh.positions[1][1] == 0.f);
+    CHECK(mesh.positions[2][0] == 1.f && mesh.positions[2][1] == 1.f);
+    CHECK(mesh.positions[3][0] == 0.f && mesh.positions[3][1] == 1.f);
+    CHECK((mesh.triangleIndices == std::vector<uint32_t>{0, 1, 2, 0, 2, 3}));
+}
+
+static void testAsciiPlyLayouts()
+{
+    const char* path = "test_mesh_readers.ply";
+    const char* bodies[] = {
+        "0 0 0\n1 0 0\n1 1 0\n0 1 0\n3 0 1 2\n3 0 2 3\n",    // one row per line
+        "0 0 0 1 0 0 1 1 0 0 1 0 3 0 1 2 3 0 2 3",            // every row on one line
+        "0 0\n0 1 0\n0 1\n1 0 0 1 0\n3 0 1\n2 3\n0 2 3",      // rows wrapped over several lines
+        "\n  0 0 0\t1 0 0\r\n1 1 0 0 1 0 \n\n3 0 1 2 3 0 2 3 \n", // stray whitespace
+    };
+    for (auto body : bodies) {
+        writeFile(path, asciiPlyHeader(4, 2) + body);
+        MeshReaders::MeshData mesh;
+        MeshReaders::read(path, mesh);
+        checkSquare(mesh);
+    }
+
+    // A quad, split into a fan, followed by an element the reader skips
+    writeFile(path, "ply\nformat ascii 1.0\n"
+        "element vertex 4\nproperty float x\nproperty list uchar float extra\nproperty float y\nproperty float z\n"
+        "element face 1\nproperty list uchar int vertex_indices\nproperty uchar flag\n"
+        "element edge 1\nproperty int a\nproperty int b\nend_header\n"
+        "0 2 9 9 0 0 1 0 0 0 1 0\n1 0 0 1 5 1\n0 4 0 1 2 3 7 0 1");
+    MeshReaders::MeshData quad;
+    MeshReaders::read(path, quad);
+    checkSquare(quad);
+
+    // Running out of values partway through a row is an error, rather than a silently shorter mesh
+    writeFile(path, asciiPlyHeader(4, 2) + "0 0 0\n1 0 0\n1 1 0\n0 1 0\n3 0 1 2\n3 0 2");
+    MeshReaders::MeshData truncated;
+    CHECK_THROWS(MeshReaders::read(path, truncated));
+    std::remove(path);
+}
+
+static void testManyRows()
+{
+    // Enough rows for several parallel blocks, with rows packed and wrapped at varying places
+    const char* path = "test_mesh_readers_rows.ply";
+    const size_t count = 3 * MeshReaders::TEXT_BLOCK_ROWS + 17;
+    std::string body;
+    for (size_t i = 0; i < count; ++i) {
+        body += std::to_string(i) + ((i % 3 == 0) ? "\n" : " ") + "0.5 " + std::to_string(i % 7) + ((i % 5 == 0) ? " " : "\n");
+    }
+    for (size_t i = 0; i + 2 < count; ++i) {
+        body += "3 " + std::to_string(i) + " " + std::to_string(i + 1) + ((i % 4 == 0) ? "\n" : " ") + std::to_string(i + 2) + ((i % 2) ? " " : "\n");
+    }
+    writeFile(path, asciiPlyHeader(count, count - 2) + body);
+    MeshReaders::MeshData mesh;
+    MeshReaders::read(path, mesh);
+    CHECK(mesh.positions.size() == count);
+    CHECK(mesh.triangleIndices.size() == (count - 2) * 3);
+    size_t mismatches = 0;
+    for (size_t i = 0; (i < count) && (i < mesh.positions.size()); ++i) {
+        if ((mesh.positions[i][0] != float(i)) || (mesh.positions[i][1] != .5f) || (mesh.positions[i][2] != float(i % 7))) mismatches++;
+    }
+    for (size_t f = 0; f * 3 + 2 < mesh.triangleIndices.size(); ++f) {
+        if ((mesh.triangleIndices[f * 3] != f) || (mesh.triangleIndices[f * 3 + 2] != f + 2)) mismatches++;
+    }
+    CHECK(mismatches == 0);
+    std::remove(path);
+}
+
+static void testEmptyFiles()
+{
+    // Empty files are reported as such, rather than as files that couldn't be mapped
+    const char* paths[] = {"test_mesh_readers_empty.obj", "test_mesh_readers_empty.ply"};
+    for (auto path : paths) {
+        writeFile(path, "");
+        MeshReaders::MeshData mesh;
+        bool empty = false;
+        try { MeshReaders::read(path, mesh); }
+        catch (std::runtime_error &e) { empty = std::string(e.what()).find("is empty") != std::string::npos; }
+        CHECK(empty);
+        std::remove(path);
+    }
+}
+
+int main()
+{
+    testAsciiPlyLayouts();
+    testManyRows();
+    testEmptyFiles();
+    return finishTest("test_mesh_readers");
+}
@@ -0,0 +1,149 @@
+#include <nvisii/texture.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "test_utils.h"
+
+using namespace nvisii;
+
+/* Tests the CPU texture sampler: filters, wrap modes, sRGB decoding, and that batches of
+   coordinates give the same samples as sampling them one at a time. */
+
+/* A 2x2 float texture whose red channel holds the texel index, 0 and 1 on the bottom row, 2 and 3 on the top */
+static Texture* createIndexTexture(std::string name)
+{
+    std::vector<float> data = {
+        0.f, 0.f, 0.f, 1.f,   1.f, 0.f, 0.f, 1.f,
+        2.f, 0.f, 0.f, 1.f,   3.f, 0.f, 0.f, 1.f,
+    };
+    return Texture::createFromData(name, 2, 2, data.data(), uint32_t(data.size()), true, true);
+}
+
+static void testFilters()
+{
+    Texture* texture = createIndexTexture("filters");
+    CHECK_NEAR(texture->sample(vec2(.25f, .25f), "nearest").r, 0.f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(.75f, .25f), "nearest").r, 1.f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(.25f, .75f), "nearest").r, 2.f, 1e-6f);
+
+    // Texel centers return the texel itself, and the middle of the texture blends all four
+    CHECK_NEAR(texture->sample(vec2(.75f, .75f)).r, 3.f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(.5f, .5f)).r, 1.5f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(.5f, .25f)).r, .5f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(.25f, .5f)).r, 1.f, 1e-6f);
+
+    // HDR values are returned as is
+    CHECK_NEAR(texture->sampleFloatTexels(vec2(.75f, .75f)).r, 3.f, 1e-6f);
+
+    CHECK_THROWS(texture->sample(vec2(.5f), "cubic"));
+    CHECK_THROWS(texture->sample(vec2(.5f), "linear", "border"));
+    Texture::remove("filters");
+}
+
+static void testWrapModes()
+{
+    Texture* texture = createIndexTexture("wrap");
+
+    // On the left edge, halfway between texel centers
+    CHECK_NEAR(texture->sample(vec2(0.f, .25f), "linear", "clamp").r, 0.f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(0.f, .25f), "linear", "repeat").r, .5f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(0.f, .25f), "linear", "mirror").r, 0.f, 1e-6f);
+
+    // Outside of [0, 1]
+    CHECK_NEAR(texture->sample(vec2(1.25f, .25f), "nearest", "repeat").r, 0.f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(1.25f, .25f), "nearest", "mirror").r, 1.f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(-.25f, .25f), "nearest", "mirror").r, 0.f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(5.f, -3.f), "nearest", "clamp").r, 1.f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(-1e30f, 1e30f), "nearest", "repeat").r,
+               texture->sample(vec2(0.f, 0.f), "nearest", "repeat").r, 1e-6f);
+    Texture::remove("wrap");
+}
+
+static void testTrilinear()
+{
+    Texture* texture = createIndexTexture("trilinear");
+    texture->generateMipmaps();
+    CHECK(texture->getMipLevelCount() == 2);
+
+    // The 1x1 level averages the four texels
+    CHECK_NEAR(texture->sample(vec2(.25f, .25f), "linear", "repeat", 1.f).r, 1.5f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(.25f, .25f), "trilinear", "repeat", .5f).r, .75f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(.25f, .25f), "trilinear", "repeat", 0.f).r, 0.f, 1e-6f);
+
+    // lod is clamped to the available levels
+    CHECK_NEAR(texture->sample(vec2(.25f, .25f), "trilinear", "repeat", 8.f).r, 1.5f, 1e-6f);
+    CHECK_NEAR(texture->sample(vec2(.25f, .25f), "linear", "repeat", -2.f).r, 0.f, 1e-6f);
+    Texture::remove("trilinear");
+}
+
+static void testSRGB()
+{
+    std::vector<float> data = {.5f, .5f, .5f, .5f};
+    Texture* srgb = Texture::createFromData("srgb", 1, 1, data.data(), uint32_t(data.size()), false, false);
+    vec4 encoded = srgb->sample(vec2(.5f));
+    vec4 decoded = srgb->sample(vec2(.5f), "linear", "repeat", 0.f, true);
+    float byte = std::floor(.5f * 255.f) / 255.f;
+    CHECK_NEAR(encoded.r, byte, 1e-6f);
+    CHECK_NEAR(decoded.r, std::pow((byte + .055f) / 1.055f, 2.4f), 1e-3f);
+    CHECK_NEAR(decoded.a, byte, 1e-6f); // alpha is never decoded
+
+    // Linear textures ignore decode_srgb
+    Texture* linear = Texture::createFromData("linear", 1, 1, data.data(), uint32_t(data.size()), true, false);
+    CHECK_NEAR(linear->sample(vec2(.5f), "linear", "repeat", 0.f, true).r, byte, 1e-6f);
+    Texture::remove("srgb");
+    Texture::remove("linear");
+}
+
+static void testBatch()
+{
+    // A larger byte texture, so that the batch is split across several chunks
+    const uint32_t size = 37;
+    std::vector<float> data(size * size * 4);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = float((i * 37) % 101) / 100.f;
+    Texture* texture = Texture::createFromData("batch", size, size, data.data(), uint32_t(data.size()), false, false);
+    texture->generateMipmaps();
+
+    const int count = 20000;
+    std::vector<float> uvs(count * 2);
+    for (int i = 0; i < count * 2; ++i) uvs[i] = float((i * 7919) % 3001) / 1000.f - 1.f;
+
+    const char* filters[] = {"nearest", "linear", "trilinear"};
+    const char* wraps[] = {"repeat", "clamp", "mirror"};
+    for (auto filter : filters) {
+        for (auto wrap : wraps) {
+            float* samples = nullptr;
+            int sampleCount = 0, sampleComponents = 0;
+            texture->sampleBatch(uvs.data(), count, 2, &samples, &sampleCount, &sampleComponents, filter, wrap, 1.3f, true);
+            CHECK(sampleCount == count);
+            CHECK(sampleComponents == 4);
+            int mismatches = 0;
+            for (int i = 0; i < count; ++i) {
+                vec4 c = texture->sample(vec2(uvs[i * 2 + 0], uvs[i * 2 + 1]), filter, wrap, 1.3f, true);
+                for (int j = 0; j < 4; ++j) if (samples[i * 4 + j] != c[j]) mismatches++;
+            }
+            CHECK(mismatches == 0);
+            free(samples);
+        }
+    }
+
+    float* samples = nullptr;
+    int sampleCount = 0, sampleComponents = 0;
+    CHECK_THROWS(texture->sampleBatch(uvs.data(), count / 2, 4, &samples, &sampleCount, &sampleComponents));
+    texture->sampleBatch(uvs.data(), 0, 2, &samples, &sampleCount, &sampleComponents);
+    CHECK(sampleCount == 0);
+    free(samples);
+    Texture::remove("batch");
+}
+
+int main()
+{
+    Texture::initializeFactory(4);
+    testFilters();
+    testWrapModes();
+    testTrilinear();
+    testSRGB();
+    testBatch();
+    return finishTest("test_texture_sampler");
+}
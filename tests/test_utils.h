@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+/* Small helpers shared by the unit tests and benchmarks in this directory. */
+
+static int testFailures = 0;
+
+/* Reports a failure, without stopping the test, if the condition does not hold. */
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #condition << std::endl; \
+        testFailures++; \
+    } \
+} while (0)
+
+/* Reports a failure if a and b differ by more than the given tolerance. */
+#define CHECK_NEAR(a, b, tolerance) do { \
+    double checkA = double(a), checkB = double(b); \
+    if (!(std::fabs(checkA - checkB) <= double(tolerance))) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #a << " (" << checkA << ") != " \
+            << #b << " (" << checkB << "), tolerance " << (tolerance) << std::endl; \
+        testFailures++; \
+    } \
+} while (0)
+
+/* Reports a failure if the statement does not throw. */
+#define CHECK_THROWS(statement) do { \
+    bool checkThrew = false; \
+    try { statement; } catch (...) { checkThrew = true; } \
+    if (!checkThrew) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #statement << " did not throw" << std::endl; \
+        testFailures++; \
+    } \
+} while (0)
+
+/* Prints a summary and returns the exit code for main. */
+inline int finishTest(std::string testName)
+{
+    if (testFailures == 0) std::cout << testName << ": passed" << std::endl;
+    else std::cout << testName << ": " << testFailures << " check(s) failed" << std::endl;
+    return (testFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Returns the benchmark problem size, given as the first argument, or the default if there is none. */
+inline size_t getBenchSize(int argc, char** argv, size_t defaultSize)
+{
+    if (argc < 2) return defaultSize;
+    return (size_t) std::strtoull(argv[1], nullptr, 10);
+}
+
+/* Measures wall clock time from construction or from the last call to reset. */
+class BenchTimer {
+    public:
+    BenchTimer() { reset(); }
+
+    void reset() { start = std::chrono::high_resolution_clock::now(); }
+
+    /* Returns the elapsed time in seconds. */
+    double seconds() const
+    {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+/* Prints one benchmark result line, with the per operation latency in nanoseconds. */
+inline void reportBench(std::string label, double seconds, size_t operations)
+{
+    std::cout << label << ": " << (seconds * 1000.0) << " ms";
+    if (operations > 0) std::cout << ", " << (seconds * 1e9 / double(operations)) << " ns/op";
+    std::cout << std::endl;
+}
@@ -0,0 +1,58 @@
+#include <nvisii/mesh.h>
+
+#include <vector>
+
+#include "test_utils.h"
+
+using namespace nvisii;
+
+/* Tests which vertices Mesh::createFromData welds together when no indices are given. */
+
+/* Two triangles whose first corners are at the given x coordinates, and whose other corners are far apart */
+static std::vector<float> twoTriangles(float x0, float x1)
+{
+    return {
+        x0, 0.f, 0.f,   1.f, 0.f, 0.f,   0.f, 1.f, 0.f,
+        x1, 0.f, 0.f,   0.f, 0.f, 1.f,   1.f, 1.f, 1.f,
+    };
+}
+
+static size_t countVertices(std::vector<float> positions, float epsilon, std::vector<float> texcoords = {})
+{
+    Mesh* mesh = Mesh::createFromData("welded", positions, 3, {}, 3, {}, 3, {}, 4, texcoords, 2, {}, epsilon);
+    size_t count = mesh->getVertices().size();
+    Mesh::remove("welded");
+    return count;
+}
+
+int main()
+{
+    Mesh::initializeFactory(1);
+    const float epsilon = 1e-3f;
+
+    // Exact welding only merges identical vertices
+    CHECK(countVertices(twoTriangles(.5f, .5f), 0.f) == 5);
+    CHECK(countVertices(twoTriangles(.5f, .5f + 1e-6f), 0.f) == 6);
+
+    // Vertices closer than epsilon weld even when they straddle a cell of the hash grid,
+    // whose cells are 2 * epsilon wide
+    CHECK(countVertices(twoTriangles(1.99e-3f, 2.01e-3f), epsilon) == 5);
+    CHECK(countVertices(twoTriangles(-1e-4f, 1e-4f), epsilon) == 5);
+    CHECK(countVertices(twoTriangles(.5f, .5f + .9f * epsilon), epsilon) == 5);
+
+    // Vertices in neighboring cells but further apart than epsilon don't
+    CHECK(countVertices(twoTriangles(1.5e-3f, 3.1e-3f), epsilon) == 6);
+
+    // Every attribute must be within epsilon, not just the position
+    std::vector<float> texcoords(12, 0.f);
+    texcoords[6] = 2.f * epsilon;
+    CHECK(countVertices(twoTriangles(.5f, .5f), epsilon, texcoords) == 6);
+    texcoords[6] = .5f * epsilon;
+    CHECK(countVertices(twoTriangles(.5f, .5f), epsilon, texcoords) == 5);
+
+    // An epsilon too small for the range of the positions is rejected rather than overflowing the grid
+    CHECK_THROWS(countVertices(twoTriangles(1e10f, 1e10f), 1e-10f));
+    CHECK(Mesh::get("welded") == nullptr);
+
+    return finishTest("test_vertex_welding");
+}